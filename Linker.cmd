@@ -68,7 +68,10 @@
 
 MEMORY
 {
-        DDR_MEM        : org = 0x80000000  len = 0x7FFFFFF           /* RAM */
+        DDR_MEM        : org = 0x80000000  len = 0x7E00000           /* RAM */
+        DDR_DMA        : org = 0x87E00000  len = 0x100000            /* RAM, UNCACHED, SEE orbis_memory.c */
+        DDR_STACK      : org = 0x87F00000  len = 0x100000            /* RAM */
+        OCMC_RAM       : org = 0x40300000  len = 0xFC00              /* ON-CHIP RAM, UP TO THE VECTORS */
 }
 
 /* SPECIFY THE SECTIONS ALLOCATION INTO MEMORY */
@@ -84,6 +87,21 @@ SECTIONS
                     RUN_START(bss_start)
                     RUN_END(bss_end)
     .const   : load > DDR_MEM              /* GLOBAL CONSTANTS              */
+    .orbis_noinit : load > DDR_MEM, type = NOINIT /* KEPT OVER A WARM RESET     */
+
+    /* PERFORMANCE BUILD PROFILE (ORBIS_PERFORMANCE), SEE orbis_memory.c. THE HOT */
+    /* PATH IS LOADED WITH THE IMAGE AND COPIED TO OCMC RAM BY OrbisMemorySetup() */
+    GROUP    : load = DDR_MEM, run = OCMC_RAM
+                    LOAD_START(orbisFastLoad)
+                    RUN_START(orbisFastRun)
+                    SIZE(orbisFastSize)
+    {
+        .orbis_fast_text
+        .orbis_fast_const
+    }
+    .orbis_dma : load > DDR_DMA, type = NOINIT /* CLEARED BY OrbisMemorySetup() */
+                    RUN_START(orbisDMAStart)
+                    SIZE(orbisDMASize)
     .stack   : load > 0x87FFFFF0           /* SOFTWARE SYSTEM STACK         */
 }
 
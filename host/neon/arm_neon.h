@@ -0,0 +1,77 @@
+/*
+ * arm_neon.h
+ * Host stand-in for the compiler header of the same name.
+ *
+ * Only the NEON intrinsics used by orbis_crc.c are there, done a lane at a time in C, so that
+ * the NEON path of OrbisCRCValidateBatch() is built and checked on the host. It says nothing
+ * about its speed on the target.
+ */
+#ifndef _ARM_NEON_H_
+#define _ARM_NEON_H_
+
+#include <stdint.h>
+
+typedef struct {
+    uint8_t lane[8];
+} uint8x8_t;
+
+typedef struct {
+    uint8x8_t val[2];
+} uint8x8x2_t;
+
+static inline uint8x8_t vld1_u8(const uint8_t* p)
+{
+    uint8x8_t r;
+
+    for (int i = 0; i < 8; i++)
+        r.lane[i] = p[i];
+    return r;
+}
+
+static inline void vst1_u8(uint8_t* p, uint8x8_t a)
+{
+    for (int i = 0; i < 8; i++)
+        p[i] = a.lane[i];
+}
+
+static inline uint8x8_t vdup_n_u8(uint8_t value)
+{
+    uint8x8_t r;
+
+    for (int i = 0; i < 8; i++)
+        r.lane[i] = value;
+    return r;
+}
+
+static inline uint8x8_t veor_u8(uint8x8_t a, uint8x8_t b)
+{
+    for (int i = 0; i < 8; i++)
+        a.lane[i] ^= b.lane[i];
+    return a;
+}
+
+static inline uint8x8_t vshl_n_u8(uint8x8_t a, int n)
+{
+    for (int i = 0; i < 8; i++)
+        a.lane[i] = (uint8_t) (a.lane[i] << n);
+    return a;
+}
+
+static inline uint8x8_t vshr_n_u8(uint8x8_t a, int n)
+{
+    for (int i = 0; i < 8; i++)
+        a.lane[i] = (uint8_t) (a.lane[i] >> n);
+    return a;
+}
+
+// Looks the lanes of index up in the 16 bytes of table; an index out of the table gives 0
+static inline uint8x8_t vtbl2_u8(uint8x8x2_t table, uint8x8_t index)
+{
+    uint8x8_t r;
+
+    for (int i = 0; i < 8; i++)
+        r.lane[i] = (index.lane[i] < 16) ? table.val[index.lane[i] / 8].lane[index.lane[i] % 8] : 0;
+    return r;
+}
+
+#endif
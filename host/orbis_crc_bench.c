@@ -0,0 +1,213 @@
+/*
+ * orbis_crc_bench.c
+ * Times the CRC strategy of the build on the host, and checks the batch validation against
+ * the single frame one
+ *
+ * The strategy is chosen at compile time, ORBIS_CRC_STRATEGY and ORBIS_CRC_USE_NEON in
+ * orbis_crc.h, so there is a build of this for each of them, see the Makefile. The NEON path
+ * is built against a stand-in for arm_neon.h which does the lanes in C, so its times say
+ * nothing about the target; it is there so that the path is built and checked.
+ *
+ * Without -S it prints, for frames of the lengths of the Orbis responses and for longer
+ * blocks, the host time a frame takes with OrbisCRC() on plain memory, with OrbisFrameValidate()
+ * as the driver checks its frames, with the reference OrbisCRC_Buffer(), and with
+ * OrbisCRCValidateBatch() over many frames.
+ *
+ * Usage: orbis-crc-bench [options]
+ *   -n <count>     frames to time each way (1000000)
+ *   -S             check that OrbisCRCValidateBatch() gives the verdict of OrbisFrameValidate()
+ *                  and of a bit at a time CRC, for every frame, length, stride and batch size
+ *   -q             quiet, print the summary only
+ *
+ * Exits with 1 if a check fails.
+ *
+ *  Created on: 16 Oct 2026
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "orbis_protocol.h"
+#include "orbis_crc.h"
+
+// Longest frame and most frames in a batch, of the check and the benchmark
+#define FRAME_MAX               64u
+#define BATCH_MAX               1024u
+
+static const char* const strategyNames[] = { "table", "slice4", "slice8", "nibble" };
+
+static uint8_t frames[BATCH_MAX * (FRAME_MAX + 3)];
+static uint8_t results[BATCH_MAX];
+static uint32_t count = 1000000;
+static int quiet;
+static uint32_t seed = 1;
+
+// Reproducible contents, independent of the C library
+static uint8_t Random(void)
+{
+    seed = seed * 1103515245u + 12345u;
+    return (uint8_t) (seed >> 16);
+}
+
+// The CRC by its definition, a bit at a time
+static uint8_t ReferenceCRC(const uint8_t* data, uint32_t length)
+{
+    uint8_t crc = 0;
+
+    for (uint32_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (uint32_t b = 0; b < 8; b++)
+            crc = (crc & 0x80u) ? (uint8_t) ((crc << 1) ^ 0x97u) : (uint8_t) (crc << 1);
+    }
+
+    return crc;
+}
+
+//
+// Fill frameCount frames of length bytes, stride bytes apart, with random contents and their
+// CRC, and spoil about one in three of them: a flipped bit or a wrong CRC byte.
+//
+static void FramesMake(uint32_t length, uint32_t stride, uint32_t frameCount)
+{
+    for (uint32_t i = 0; i < frameCount; i++) {
+        uint8_t* frame = &frames[i * stride];
+
+        for (uint32_t k = 0; k < stride; k++)
+            frame[k] = Random();
+        frame[length - 1] = (uint8_t) ~ReferenceCRC(frame, length - 1);
+
+        if (Random() % 3 == 0)
+            frame[Random() % length] ^= (uint8_t) (1u << (Random() % 8));
+    }
+}
+
+static double HostNanoseconds(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec * 1e9 + (double) ts.tv_nsec;
+}
+
+static int RunSelfTest(void)
+{
+    static const uint32_t batches[] = { 1, 7, 8, 9, 16, 63, 1024 };
+    uint32_t cases = 0, failures = 0;
+
+    if (OrbisCRCSelfTest() != ORBIS_CRC_OK) {
+        printf("OrbisCRCSelfTest() failed\n");
+        return 1;
+    }
+
+    for (uint32_t length = 2; length <= FRAME_MAX; length++) {
+        for (uint32_t pad = 0; pad < 4; pad += 3) {
+            for (uint32_t b = 0; b < sizeof(batches) / sizeof(batches[0]); b++) {
+                uint32_t stride = length + pad, frameCount = batches[b];
+                uint32_t failed = 0, reported;
+
+                FramesMake(length, stride, frameCount);
+                memset(results, 0xFF, sizeof(results));
+                reported = OrbisCRCValidateBatch(frames, stride, length, frameCount, results);
+
+                for (uint32_t i = 0; i < frameCount; i++) {
+                    const uint8_t* frame = &frames[i * stride];
+                    uint8_t receivedCRC = (uint8_t) ~frame[length - 1];
+                    uint8_t expected = (receivedCRC == ReferenceCRC(frame, length - 1)) ? ORBIS_CRC_OK : ORBIS_CRC_FAIL;
+
+                    failed += expected;
+                    if (results[i] != expected || OrbisFrameValidate(frame, length) != expected) {
+                        failures++;
+                        if (!quiet)
+                            printf("length %u, stride %u, batch of %u: frame %u is %s, batch says %u,"
+                                   " single %u\n", length, stride, frameCount, i,
+                                   expected == ORBIS_CRC_OK ? "good" : "bad", results[i],
+                                   OrbisFrameValidate(frame, length));
+                    }
+                }
+
+                if (reported != failed)
+                    failures++;
+                if (OrbisCRCValidateBatch(frames, stride, length, frameCount, NULL) != failed)
+                    failures++;
+                cases++;
+            }
+        }
+    }
+
+    printf("CRC %s%s: %u batches checked against single frames, %u failures\n",
+           strategyNames[ORBIS_CRC_STRATEGY], ORBIS_CRC_USE_NEON ? " with NEON" : "", cases, failures);
+
+    return (failures == 0) ? 0 : 1;
+}
+
+static void RunBenchmark(void)
+{
+    static const uint32_t lengths[] = {
+        ORBIS_LENGTH_POSITION, ORBIS_LENGTH_SPEED, ORBIS_LENGTH_SERIAL, 32, FRAME_MAX
+    };
+    volatile uint8_t sink = 0;
+
+    printf("CRC %s%s, ns a frame:\n", strategyNames[ORBIS_CRC_STRATEGY],
+           ORBIS_CRC_USE_NEON ? " with NEON" : "");
+    printf("  bytes  OrbisCRC  FrameValidate  CRC_Buffer  ValidateBatch\n");
+
+    for (uint32_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++) {
+        uint32_t length = lengths[l];
+        uint32_t rounds = (count + BATCH_MAX - 1) / BATCH_MAX;
+        double t0, crc, validate, reference, batch;
+
+        FramesMake(length, length, BATCH_MAX);
+
+        t0 = HostNanoseconds();
+        for (uint32_t r = 0; r < rounds; r++)
+            for (uint32_t i = 0; i < BATCH_MAX; i++)
+                sink ^= OrbisCRC(&frames[i * length], length - 1);
+        crc = (HostNanoseconds() - t0) / (rounds * BATCH_MAX);
+
+        t0 = HostNanoseconds();
+        for (uint32_t r = 0; r < rounds; r++)
+            for (uint32_t i = 0; i < BATCH_MAX; i++)
+                sink ^= OrbisFrameValidate(&frames[i * length], length);
+        validate = (HostNanoseconds() - t0) / (rounds * BATCH_MAX);
+
+        t0 = HostNanoseconds();
+        for (uint32_t r = 0; r < rounds; r++)
+            for (uint32_t i = 0; i < BATCH_MAX; i++)
+                sink ^= OrbisCRC_Buffer(&frames[i * length], length - 1);
+        reference = (HostNanoseconds() - t0) / (rounds * BATCH_MAX);
+
+        t0 = HostNanoseconds();
+        for (uint32_t r = 0; r < rounds; r++)
+            sink ^= (uint8_t) OrbisCRCValidateBatch(frames, length, length, BATCH_MAX, results);
+        batch = (HostNanoseconds() - t0) / (rounds * BATCH_MAX);
+
+        printf("  %5u  %8.1f  %13.1f  %10.1f  %13.1f\n", length, crc, validate, reference, batch);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    int opt;
+    int selfTest = 0;
+
+    while ((opt = getopt(argc, argv, "n:Sq")) != -1) {
+        switch (opt) {
+        case 'n': count = (uint32_t) strtoul(optarg, NULL, 0); break;
+        case 'S': selfTest = 1; break;
+        case 'q': quiet = 1; break;
+        default:
+            fprintf(stderr, "usage: %s [-n count] [-S] [-q]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    OrbisCRCInit();
+
+    if (selfTest)
+        return RunSelfTest();
+
+    RunBenchmark();
+    return 0;
+}
@@ -0,0 +1,318 @@
+/*
+ * orbis_decode.c
+ * Decodes the binary telemetry stream of the Orbis driver back into records
+ *
+ * The stream is the one sent over UART0 by orbis_telemetry.c, as captured on the host
+ * side of the serial line (or written by orbis-sim -T). The decoder looks for the sync
+ * bytes, checks the frame length and checksum, and starts looking again one byte on
+ * if either is wrong, so it picks the frames up again after noise or a lost byte.
+ * Missing sequence numbers and the records dropped on the target are reported.
+ *
+ * Usage: orbis-decode [options] [file]
+ *   -q             quiet, print the summary only
+ *   -c <count>     exit with 1 unless exactly count records are decoded from a clean stream
+ *   -S             decode synthetic streams, clean and damaged, and check the results
+ *
+ * Prints one record per line: timestamp, value (hex), capture result and encoder.
+ * Reads the standard input if no file is given.
+ *
+ *  Created on: 16 Oct 2026
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "orbis_telemetry.h"
+
+typedef struct {
+    uint32_t timestamp;
+    uint32_t value;
+    uint8_t status;
+} Record;
+
+typedef struct {
+    uint32_t frames;
+    uint32_t records;
+    uint32_t badFrames;             // sync found but the length or checksum was wrong
+    uint32_t skipped;               // bytes outside any good frame
+    uint32_t missingFrames;         // by the sequence numbers
+    uint32_t dropped;               // records dropped on the target, as reported in the frames
+    uint32_t truncated;             // bytes of an incomplete frame at the end
+} DecodeStats;
+
+typedef void (*RecordHandler)(const Record* record, void* context);
+
+static uint32_t GetWord(const uint8_t* p)
+{
+    return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+// Fletcher-16, written out again rather than taken from the target code
+static uint16_t Checksum(const uint8_t* data, size_t length)
+{
+    uint32_t sum1 = 0, sum2 = 0;
+
+    for (size_t i = 0; i < length; i++) {
+        sum1 = (sum1 + data[i]) % 255;
+        sum2 = (sum2 + sum1) % 255;
+    }
+
+    return (uint16_t) ((sum2 << 8) | sum1);
+}
+
+static void Decode(const uint8_t* data, size_t length, DecodeStats* stats,
+                   RecordHandler handler, void* context)
+{
+    size_t i = 0;
+    int haveSequence = 0;
+    uint8_t expected = 0;
+
+    memset(stats, 0, sizeof(*stats));
+
+    while (i < length) {
+        size_t frameLength;
+        uint8_t count;
+
+        if (data[i] != ORBIS_TELEMETRY_SYNC0 || i + 1 >= length || data[i + 1] != ORBIS_TELEMETRY_SYNC1) {
+            if (i + 1 < length || data[i] != ORBIS_TELEMETRY_SYNC0)
+                stats->skipped++;
+            else
+                stats->truncated++;
+            i++;
+            continue;
+        }
+
+        if (i + ORBIS_TELEMETRY_HEADER_SIZE > length) {
+            stats->truncated += (uint32_t) (length - i);
+            break;
+        }
+
+        count = data[i + 3];
+        frameLength = ORBIS_TELEMETRY_HEADER_SIZE + (size_t) count * ORBIS_TELEMETRY_RECORD_SIZE
+                    + ORBIS_TELEMETRY_CHECKSUM_SIZE;
+
+        if (count == 0 || count > ORBIS_TELEMETRY_BATCH) {
+            stats->badFrames++;
+            stats->skipped++;
+            i++;
+            continue;
+        }
+
+        if (i + frameLength > length) {
+            stats->truncated += (uint32_t) (length - i);
+            break;
+        }
+
+        if (Checksum(&data[i + 2], frameLength - 2 - ORBIS_TELEMETRY_CHECKSUM_SIZE) !=
+            (uint16_t) (data[i + frameLength - 2] | (data[i + frameLength - 1] << 8))) {
+            stats->badFrames++;
+            stats->skipped++;
+            i++;
+            continue;
+        }
+
+        if (haveSequence && data[i + 2] != expected)
+            stats->missingFrames += (uint8_t) (data[i + 2] - expected);
+        expected = (uint8_t) (data[i + 2] + 1);
+        haveSequence = 1;
+
+        stats->frames++;
+        stats->dropped += data[i + 4] | (data[i + 5] << 8);
+
+        for (uint32_t r = 0; r < count; r++) {
+            const uint8_t* p = &data[i + ORBIS_TELEMETRY_HEADER_SIZE + r * ORBIS_TELEMETRY_RECORD_SIZE];
+            Record record = { GetWord(&p[0]), GetWord(&p[4]), p[8] };
+
+            stats->records++;
+            if (handler != NULL)
+                handler(&record, context);
+        }
+
+        i += frameLength;
+    }
+}
+
+static void PrintRecord(const Record* record, void* context)
+{
+    printf("%10u %08x %u %u\n", record->timestamp, record->value,
+           ORBIS_TELEMETRY_RESULT(record->status), ORBIS_TELEMETRY_SOURCE(record->status));
+}
+
+static void PrintStats(const DecodeStats* stats)
+{
+    printf("frames:             %u (%u bad, %u missing)\n", stats->frames, stats->badFrames, stats->missingFrames);
+    printf("records:            %u (%u dropped on the target)\n", stats->records, stats->dropped);
+    printf("bytes skipped:      %u (%u truncated at the end)\n", stats->skipped, stats->truncated);
+}
+
+//
+// Synthetic streams for -S. The frames are built here the way the target builds them,
+// from records whose fields follow from their index, so the decoded ones can be checked.
+//
+static uint8_t synthetic[1 << 16];
+static size_t syntheticLength;
+
+static Record SyntheticRecord(uint32_t index)
+{
+    // The sync bytes turn up inside the records as well, to catch false frame starts
+    Record record = { index * 2400u, 0x5AA50000u | index, ORBIS_TELEMETRY_STATUS(index % 3, index % 4) };
+    return record;
+}
+
+static void SyntheticFrame(uint8_t sequence, uint32_t first, uint32_t count, uint16_t dropped)
+{
+    uint8_t* frame = &synthetic[syntheticLength];
+    size_t length = ORBIS_TELEMETRY_HEADER_SIZE + count * ORBIS_TELEMETRY_RECORD_SIZE;
+    uint16_t checksum;
+
+    frame[0] = ORBIS_TELEMETRY_SYNC0;
+    frame[1] = ORBIS_TELEMETRY_SYNC1;
+    frame[2] = sequence;
+    frame[3] = (uint8_t) count;
+    frame[4] = (uint8_t) dropped;
+    frame[5] = (uint8_t) (dropped >> 8);
+
+    for (uint32_t r = 0; r < count; r++) {
+        Record record = SyntheticRecord(first + r);
+        uint8_t* p = &frame[ORBIS_TELEMETRY_HEADER_SIZE + r * ORBIS_TELEMETRY_RECORD_SIZE];
+
+        for (uint32_t b = 0; b < 4; b++) {
+            p[b] = (uint8_t) (record.timestamp >> (8 * b));
+            p[4 + b] = (uint8_t) (record.value >> (8 * b));
+        }
+        p[8] = record.status;
+    }
+
+    checksum = Checksum(&frame[2], length - 2);
+    frame[length] = (uint8_t) checksum;
+    frame[length + 1] = (uint8_t) (checksum >> 8);
+
+    syntheticLength += length + ORBIS_TELEMETRY_CHECKSUM_SIZE;
+}
+
+typedef struct {
+    uint32_t next;                  // index of the record expected next
+    uint32_t mismatches;
+} SyntheticCheck;
+
+// The records must come in order, but whole frames of them may be missing
+static void CheckRecord(const Record* record, void* context)
+{
+    SyntheticCheck* check = context;
+    uint32_t index = record->value & 0xFFFFu;
+    Record expected = SyntheticRecord(index);
+
+    if (index < check->next || record->timestamp != expected.timestamp ||
+        record->value != expected.value || record->status != expected.status)
+        check->mismatches++;
+
+    check->next = index + 1;
+}
+
+//
+// Build 40 frames of 16 records and one of 5, damage them as asked, and check the decoding.
+// How many false frame starts the decoder runs into on the way depends on the data, so only
+// the least number of bad frames is given.
+//
+static int SyntheticCase(const char* name, int garbage, int flip, int lose, int truncate,
+                         uint32_t frames, uint32_t records, uint32_t bad, uint32_t missing)
+{
+    DecodeStats stats;
+    SyntheticCheck check = { 0, 0 };
+    int ok;
+
+    syntheticLength = 0;
+    for (uint32_t f = 0; f <= 40; f++) {
+        size_t start = syntheticLength;
+
+        if (garbage) {
+            // Noise, with sync bytes and an impossible count in it
+            const uint8_t noise[] = { 0x00, 0xA5, 0xA5, 0x5A, 0x07, 0xFF, 0x5A, 0xA5 };
+            memcpy(&synthetic[syntheticLength], noise, sizeof(noise));
+            syntheticLength += sizeof(noise);
+            start = syntheticLength;
+        }
+
+        SyntheticFrame((uint8_t) f, f * 16, (f < 40) ? 16 : 5, (uint16_t) (f == 7 ? 3 : 0));
+
+        if (flip && f == 10)
+            synthetic[start + 20] ^= 0x10;
+        if (lose && f == 20)
+            syntheticLength = start;
+    }
+
+    if (truncate)
+        syntheticLength -= 7;
+
+    Decode(synthetic, syntheticLength, &stats, CheckRecord, &check);
+
+    ok = stats.frames == frames && stats.records == records && stats.badFrames >= bad &&
+         stats.missingFrames == missing && stats.dropped == 3 && check.mismatches == 0;
+
+    // Nothing but good frames, there is nothing to skip
+    if (!garbage && !flip && (stats.badFrames != 0 || stats.skipped != 0))
+        ok = 0;
+
+    printf("%-20s %s (%u frames, %u records, %u bad, %u missing, %u skipped)\n", name, ok ? "ok" : "FAILED",
+           stats.frames, stats.records, stats.badFrames, stats.missingFrames, stats.skipped);
+
+    return ok ? 0 : 1;
+}
+
+static int SyntheticTest(void)
+{
+    int failures = 0;
+
+    failures += SyntheticCase("clean",           0, 0, 0, 0, 41, 645, 0, 0);
+    failures += SyntheticCase("noise",           1, 0, 0, 0, 41, 645, 41, 0);
+    failures += SyntheticCase("bit flip",        0, 1, 0, 0, 40, 629, 1, 1);
+    failures += SyntheticCase("lost frame",      0, 0, 1, 0, 40, 629, 0, 1);
+    failures += SyntheticCase("truncated",       0, 0, 0, 1, 40, 640, 0, 0);
+    failures += SyntheticCase("all of it",       1, 1, 1, 1, 38, 608, 41 + 1, 2);
+
+    return failures ? 1 : 0;
+}
+
+int main(int argc, char* argv[])
+{
+    static uint8_t stream[64 << 20];
+    DecodeStats stats;
+    FILE* input = stdin;
+    size_t length;
+    long expected = -1;
+    int quiet = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "qc:S")) != -1) {
+        switch (opt) {
+        case 'q': quiet = 1; break;
+        case 'c': expected = strtol(optarg, NULL, 0); break;
+        case 'S': return SyntheticTest();
+        default:
+            fprintf(stderr, "usage: %s [-q] [-c count] [-S] [file]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if (optind < argc) {
+        input = fopen(argv[optind], "rb");
+        if (input == NULL) {
+            perror(argv[optind]);
+            return 2;
+        }
+    }
+
+    length = fread(stream, 1, sizeof(stream), input);
+    if (input != stdin)
+        fclose(input);
+
+    Decode(stream, length, &stats, quiet ? NULL : PrintRecord, NULL);
+    PrintStats(&stats);
+
+    if (expected >= 0 && (stats.records != (uint32_t) expected || stats.badFrames || stats.skipped ||
+                          stats.missingFrames || stats.dropped || stats.truncated))
+        return 1;
+
+    return 0;
+}
@@ -0,0 +1,323 @@
+/*
+ * orbis_edma_sim.c
+ * Checks the EDMA3 receive path of the driver against the EDMA3 model
+ *
+ * orbis_edma.c is built with the EDMA3 model of sim_edma.c and with nothing else of the
+ * driver or of the simulation. This program stands in for the rest, at the register level:
+ * the McSPI0 channel 0 Rx register, whose FIFO EDMA3 reads, the Rx DMA request, which it
+ * raises once a frame is in the FIFO, as McSPI does at the RX_FULL level, and the line of
+ * the EDMA3 completion interrupt. The capture completion of the driver is only counted.
+ *
+ * The PaRAM set OrbisEDMARxParamBuild() fills in is checked field by field for every frame
+ * length. Then frames of every length, with bytes of their own, are armed with OrbisEDMARxArm()
+ * and received: each must land in its buffer, and nowhere past it, with one completion
+ * interrupt, which orbisEDMACompletionIsr() turns into one capture completion, and the Rx DMA
+ * request must be off afterwards. Last, a completion left pending while the capture is
+ * abandoned must complete neither that capture nor the one armed after it.
+ *
+ * Usage: orbis-edma-sim [options]
+ *   -n <count>     frames to receive (1000)
+ *   -q             quiet, print the summary only
+ *
+ * Exits with 1 if a check fails.
+ *
+ *  Created on: 16 Oct 2026
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "hw_types.h"
+#include "soc_AM335x.h"
+#include "interrupt.h"
+#include "hw_mcspi.h"
+#include "mcspi.h"
+#include "edma.h"
+#include "hw_edma3cc.h"
+#include "orbis.h"
+#include "orbis_edma.h"
+#include "orbis_load.h"
+#include "sim.h"
+
+// The buffer of a frame, with room past its end that must stay untouched
+#define GUARD           8u
+#define UNTOUCHED       0xEEu
+
+static uint32_t count = 1000;
+static int quiet;
+
+// EDMA3 needs a buffer with a 32 bit address, see sim_edma.c
+static uint8_t buffer[ORBIS_SIZE_BUFFER + GUARD];
+
+// The stand-ins: the McSPI0 channel 0 Rx FIFO and DMA request, the completion interrupt line
+static uint8_t rxFifo[ORBIS_SIZE_BUFFER];
+static uint32_t rxHead, rxCount, rxLast;
+static int dmaRequestEnabled;
+static int completionRaised;
+
+// Captures the driver has completed, and the last one
+static uint32_t completions;
+static OrbisEncoder* completed;
+
+static OrbisEncoder encoder;
+
+OrbisBus orbisBus[ORBIS_BUS_COUNT];
+
+// A register file for the accesses orbis_edma.c makes with HWREG(), the timer reads of ORBIS_LATENCY
+volatile unsigned int* SimRegister(unsigned int address)
+{
+    static unsigned int registers[64];
+
+    return &registers[(address >> 2) % 64u];
+}
+
+void SimInterruptRaise(unsigned int intrNum)
+{
+    if (intrNum == SYS_INT_EDMACOMPINT)
+        completionRaised = 1;
+}
+
+void SimInterruptLower(unsigned int intrNum)
+{
+    if (intrNum == SYS_INT_EDMACOMPINT)
+        completionRaised = 0;
+}
+
+// EDMA3 reads the Rx register, which takes a word off the FIFO, or gives the last one again
+int SimMcSPIDMARead(unsigned int address, uint32_t* word)
+{
+    if (address != SOC_SPI_0_REGS + MCSPI_CHRX(ORBIS_SPI_CHANNEL))
+        return 0;
+
+    if (rxCount > 0) {
+        rxLast = rxFifo[rxHead++];
+        rxCount--;
+    }
+
+    *word = rxLast;
+    return 1;
+}
+
+void McSPIDMAEnable(unsigned int baseAdd, unsigned int dmaFlags, unsigned int chNum)
+{
+    if (baseAdd == SOC_SPI_0_REGS && chNum == ORBIS_SPI_CHANNEL && (dmaFlags & MCSPI_DMA_RX_EVENT))
+        dmaRequestEnabled = 1;
+}
+
+void McSPIDMADisable(unsigned int baseAdd, unsigned int dmaFlags, unsigned int chNum)
+{
+    if (baseAdd == SOC_SPI_0_REGS && chNum == ORBIS_SPI_CHANNEL && (dmaFlags & MCSPI_DMA_RX_EVENT))
+        dmaRequestEnabled = 0;
+}
+
+void EDMAModuleClkConfig(void)
+{
+}
+
+#if ORBIS_LOAD
+void OrbisLoadIsrEnter(void)
+{
+}
+
+void OrbisLoadIsrExit(void)
+{
+}
+#endif
+
+void OrbisCaptureComplete(OrbisEncoder* captured)
+{
+    completions++;
+    completed = captured;
+
+    captured->captureState = ORBIS_CAPTURE_DONE;
+    orbisBus[0].active = NULL;
+}
+
+// The frame comes into the Rx FIFO, which raises the DMA request, if it is enabled
+static void Receive(const uint8_t* frame, uint32_t length)
+{
+    memcpy(rxFifo, frame, length);
+    rxHead = 0;
+    rxCount = length;
+
+    if (dmaRequestEnabled)
+        SimEDMAEvent(ORBIS_EDMA_RX_EVENT);
+}
+
+// A capture of the encoder on McSPI0 channel 0, in progress
+static void Start(uint32_t length)
+{
+    encoder.captureState = ORBIS_CAPTURE_BUSY;
+    orbisBus[0].active = &encoder;
+
+    memset(buffer, UNTOUCHED, sizeof(buffer));
+    OrbisEDMARxArm(&encoder, buffer, length);
+}
+
+static void Frame(uint8_t* frame, uint32_t length, uint32_t seed)
+{
+    for (uint32_t j = 0; j < length; j++)
+        frame[j] = (uint8_t) (seed * 37u + j * 11u + 1u);
+}
+
+// The PaRAM set of every frame length. Returns the number of failures.
+static uint32_t CheckParam(void)
+{
+    const uint32_t src = SOC_SPI_0_REGS + MCSPI_CHRX(ORBIS_SPI_CHANNEL);
+    const uint32_t dst = (uint32_t) (uintptr_t) buffer;
+    const uint32_t opt = EDMA3CC_OPT_SYNCDIM | EDMA3CC_OPT_STATIC
+                       | ((ORBIS_EDMA_RX_TCC << EDMA3CC_OPT_TCC_SHIFT) & EDMA3CC_OPT_TCC)
+                       | (1u << EDMA3CC_OPT_TCINTEN_SHIFT);
+    uint32_t failures = 0;
+
+    for (uint32_t length = 1; length <= ORBIS_SIZE_BUFFER; length++) {
+        EDMA3CCPaRAMEntry param;
+
+        memset(&param, 0xA5, sizeof(param));
+        OrbisEDMARxParamBuild(&param, src, dst, length);
+
+        if (param.srcAddr != src || param.destAddr != dst || param.aCnt != 1 || param.bCnt != length ||
+            param.cCnt != 1 || param.srcBIdx != 0 || param.destBIdx != 1 || param.bCntReload != 0 ||
+            param.linkAddr != 0xFFFFu || param.opt != opt) {
+            printf("PaRAM set of a frame of %u: src 0x%08x, dst 0x%08x, a %u, b %u, c %u, b index %d/%d,"
+                   " link 0x%04x, opt 0x%08x\n", length, param.srcAddr, param.destAddr, param.aCnt,
+                   param.bCnt, param.cCnt, param.srcBIdx, param.destBIdx, param.linkAddr, param.opt);
+            failures++;
+        }
+    }
+
+    return failures;
+}
+
+// Frames of every length, one after the other. Returns the number of failures.
+static uint32_t CheckFrames(void)
+{
+    uint32_t failures = 0;
+
+    for (uint32_t i = 0; i < count && failures < 10; i++) {
+        uint32_t length = 1 + i % ORBIS_SIZE_BUFFER;
+        uint32_t transfers = simEDMATransfers;
+        uint32_t before = completions;
+        uint8_t frame[ORBIS_SIZE_BUFFER];
+
+        Frame(frame, length, i);
+        Start(length);
+
+        if (!dmaRequestEnabled || completionRaised) {
+            printf("frame %u: armed with the DMA request %s, the completion %s\n", i,
+                   dmaRequestEnabled ? "on" : "off", completionRaised ? "raised" : "not raised");
+            failures++;
+            continue;
+        }
+
+        Receive(frame, length);
+
+        if (simEDMATransfers - transfers != 1 || !completionRaised) {
+            printf("frame %u: %u transfers, completion %s\n", i, simEDMATransfers - transfers,
+                   completionRaised ? "raised" : "not raised");
+            failures++;
+            continue;
+        }
+
+        orbisEDMACompletionIsr();
+
+        if (completions - before != 1 || completed != &encoder || completionRaised || dmaRequestEnabled) {
+            printf("frame %u: %u completions, completion %s, DMA request %s\n", i, completions - before,
+                   completionRaised ? "still raised" : "cleared", dmaRequestEnabled ? "still on" : "off");
+            failures++;
+        }
+
+        if (memcmp(buffer, frame, length) != 0 || buffer[length] != UNTOUCHED ||
+            buffer[length + GUARD - 1] != UNTOUCHED) {
+            printf("frame %u of %u bytes: not where it belongs in the buffer\n", i, length);
+            failures++;
+        }
+    }
+
+    if (!quiet)
+        printf("frames:             %u received, %u transfers, %u completions\n", count, simEDMATransfers,
+               completions);
+
+    return failures;
+}
+
+//
+// A capture abandoned, as OrbisBusPoll() does on a timeout, after its frame is in and its
+// completion raised but not yet taken. Returns the number of failures.
+//
+static uint32_t CheckAbandoned(void)
+{
+    uint32_t failures = 0;
+    uint32_t before;
+    uint8_t frame[ORBIS_SIZE_BUFFER];
+
+    // The completion is taken after the capture is abandoned
+    Frame(frame, ORBIS_SIZE_BUFFER, 1);
+    Start(ORBIS_SIZE_BUFFER);
+    Receive(frame, ORBIS_SIZE_BUFFER);
+    encoder.captureState = ORBIS_CAPTURE_TIMEOUT;
+    orbisBus[0].active = NULL;
+
+    before = completions;
+    orbisEDMACompletionIsr();
+    if (completions != before || completionRaised) {
+        printf("abandoned capture: %u completions, completion %s\n", completions - before,
+               completionRaised ? "still raised" : "cleared");
+        failures++;
+    }
+
+    // The completion is still pending when the next capture is armed
+    Start(ORBIS_SIZE_BUFFER);
+    Receive(frame, ORBIS_SIZE_BUFFER);
+    encoder.captureState = ORBIS_CAPTURE_TIMEOUT;
+    orbisBus[0].active = NULL;
+
+    Frame(frame, ORBIS_SIZE_BUFFER, 2);
+    Start(ORBIS_SIZE_BUFFER);
+    if (completionRaised) {
+        printf("abandoned capture: its completion is still raised when the next one is armed\n");
+        failures++;
+    }
+
+    before = completions;
+    Receive(frame, ORBIS_SIZE_BUFFER);
+    orbisEDMACompletionIsr();
+    if (completions - before != 1 || memcmp(buffer, frame, ORBIS_SIZE_BUFFER) != 0) {
+        printf("capture after the abandoned one: %u completions, %s frame\n", completions - before,
+               memcmp(buffer, frame, ORBIS_SIZE_BUFFER) ? "wrong" : "right");
+        failures++;
+    }
+
+    return failures;
+}
+
+int main(int argc, char* argv[])
+{
+    int opt;
+    uint32_t failures = 0;
+
+    while ((opt = getopt(argc, argv, "n:q")) != -1) {
+        switch (opt) {
+        case 'n': count = (uint32_t) strtoul(optarg, NULL, 0); break;
+        case 'q': quiet = 1; break;
+        default:
+            fprintf(stderr, "usage: %s [-n count] [-q]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    encoder.bus = &orbisBus[0];
+    encoder.channel = ORBIS_SPI_CHANNEL;
+
+    OrbisEDMASetup();
+
+    failures += CheckParam();
+    failures += CheckFrames();
+    failures += CheckAbandoned();
+
+    printf("EDMA3 receive path: PaRAM set, %u frames and an abandoned capture checked, %u failures\n",
+           count, failures);
+
+    return (failures == 0) ? 0 : 1;
+}
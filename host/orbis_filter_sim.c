@@ -0,0 +1,412 @@
+/*
+ * orbis_filter_sim.c
+ * Runs the oversampling filter on synthetic noisy trajectories, and shows what it buys
+ *
+ * The frames are built here as the encoder sends them, CRC included, from a trajectory of
+ * a constant velocity and a sine on top of it, sampled every period. The position is rounded
+ * to a count after Gaussian noise is added, the way a real encoder dithers, and some frames are
+ * made to pass the CRC check with the position far off: spikes. The frames go through the driver's
+ * own OrbisFilterUpdate(), as built for the target, with the filter set up by method and
+ * decimation, and every output is compared with the trajectory:
+ *
+ *   - at the output's timestamp, which is the resolution: the RMS error, in counts and as
+ *     the bits of an ideal encoder with that error
+ *   - at the time the output is made, the last frame of its window, which includes the error
+ *     from the output being late on a moving trajectory
+ *
+ * along with its latency, from its timestamp to the time it is made, and the spikes that have
+ * got through and the good frames rejected.
+ *
+ * Without -S it prints the trade-off for the trajectory of the options: a line for each method
+ * and each decimation from 1 to ORBIS_FILTER_WINDOW.
+ *
+ * Usage: orbis-filter-sim [options]
+ *   -n <count>     frames (20000)
+ *   -p <us>        period of the frames (10)
+ *   -N <counts>    RMS noise, counts of the ORBIS_RESOLUTION bit position (0.5)
+ *   -v <counts/s>  velocity (0)
+ *   -A <counts>    amplitude of the sine (0)
+ *   -f <Hz>        frequency of the sine (50)
+ *   -k <n>         a spike every n frames (never)
+ *   -t <n>         frames dropped from either end for the trimmed mean (a quarter of the window)
+ *   -j <counts>    outlier rejection limit (ORBIS_FILTER_MAX_JUMP)
+ *   -r <seed>      random seed (1)
+ *   -S             run the filter on known trajectories, and check the results
+ *
+ * Exits with 1 if a check fails.
+ *
+ *  Created on: 16 Oct 2026
+ */
+#include <stdint.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "orbis.h"
+#include "orbis_crc.h"
+#include "orbis_filter.h"
+#include "util.h"
+
+// The position modulus: the single-turn position, or the turn count and the position
+#define MODULUS                 ((double) ((uint64_t) 1 << (ORBIS_RESOLUTION + ORBIS_TURN_BITS)))
+
+// Counts of a turn, and the RMS error of an ideal encoder, the quantisation of a count
+#define TURN                    ((double) (1 << ORBIS_RESOLUTION))
+#define QUANTISATION            0.28867513
+
+// The timestamps wrap round on the way
+#define START_TIME              0xFFF00000u
+
+#define PI                      3.14159265358979323846
+
+typedef struct {
+    uint32_t frames;
+    uint32_t period;                // DMTimer4 ticks
+    double start;                   // counts at the first frame
+    double noise;                   // RMS counts
+    double velocity;                // counts per second
+    double amplitude;               // counts
+    double frequency;               // Hz
+    uint32_t spikeEvery;            // frames, 0 for none
+    uint32_t outlierEvery;          // frames, 0 for none: off by outlier counts, within the limit
+    double outlier;
+    uint32_t stepAt;                // frame the trajectory steps by a quarter of a turn at, 0 for none
+} Trajectory;
+
+typedef struct {
+    uint32_t outputs;
+    double errorSquares;            // against the trajectory at the output's timestamp
+    double lagSquares;              // against the trajectory when the output is made
+    double latencySum;              // DMTimer4 ticks
+    uint32_t latencyMin;
+    uint32_t latencyMax;
+    uint32_t frames;
+    double rawSquares;              // of the frames that are not spikes
+    uint32_t spikes;
+    uint32_t spikesAccepted;
+    uint32_t goodRejected;
+    uint32_t restarts;
+} FilterResult;
+
+static uint64_t randomState = 1;
+
+static double Uniform(void)
+{
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 7;
+    randomState ^= randomState << 17;
+    return ((randomState >> 11) + 0.5) / 9007199254740992.0;
+}
+
+static double Gaussian(void)
+{
+    return sqrt(-2.0 * log(Uniform())) * cos(2.0 * PI * Uniform());
+}
+
+// The trajectory at the time, in counts
+static double TruePosition(const Trajectory* trajectory, uint32_t frame, double seconds)
+{
+    double x = trajectory->start + trajectory->velocity * seconds +
+               trajectory->amplitude * sin(2.0 * PI * trajectory->frequency * seconds);
+
+    if (trajectory->stepAt != 0 && frame >= trajectory->stepAt)
+        x += TURN / 4;
+
+    return x;
+}
+
+// The difference of the positions, the shortest way round
+static double Wrap(double difference)
+{
+    return difference - MODULUS * floor(difference / MODULUS + 0.5);
+}
+
+// The response of the encoder at the position, with the CRC
+static void Response(uint8_t* response, double counts)
+{
+    uint64_t reported = (uint64_t) (int64_t) floor(counts - MODULUS * floor(counts / MODULUS) + 0.5);
+    uint32_t position = (uint32_t) (reported & ((1u << ORBIS_RESOLUTION) - 1u));
+    uint16_t word = (uint16_t) ((position << ORBIS_POSITION_SHIFT) | ORBIS_WARNING_MASK | ORBIS_ERROR_MASK);
+
+#if ORBIS_MULTITURN
+    response[0] = (uint8_t) (reported >> (ORBIS_RESOLUTION + 8));
+    response[1] = (uint8_t) (reported >> ORBIS_RESOLUTION);
+#endif
+    response[ORBIS_SIZE_TURNS] = (uint8_t) (word >> 8);
+    response[ORBIS_SIZE_TURNS + 1] = (uint8_t) word;
+    response[ORBIS_SIZE_HEADER] = (uint8_t) ~OrbisCRC_Buffer(response, ORBIS_SIZE_HEADER);
+}
+
+// Run the trajectory through the filter set up the way given
+static void FilterRun(const Trajectory* trajectory, uint8_t method, uint32_t decimation, uint32_t trim,
+                      uint32_t maxJump, uint64_t seed, FilterResult* result)
+{
+    static OrbisFilter filter;
+    uint8_t response[ORBIS_SIZE_BUFFER];
+    uint32_t sequence = 0;
+    uint32_t settle = (trajectory->stepAt == 0) ? 0 : trajectory->stepAt + 2 * ORBIS_FILTER_WINDOW + ORBIS_FILTER_MAX_REJECTS;
+
+    memset(result, 0, sizeof(*result));
+    result->latencyMin = UINT32_MAX;
+    randomState = seed;
+
+    OrbisFilterInit(&filter, method, decimation, trim, maxJump);
+
+    for (uint32_t k = 0; k < trajectory->frames; k++) {
+        uint32_t timestamp = START_TIME + k * trajectory->period;
+        double x = TruePosition(trajectory, k, (double) k * trajectory->period / TIMER_MASTER_FREQ);
+        double reported = x + trajectory->noise * Gaussian();
+        uint8_t spike = trajectory->spikeEvery != 0 && k % trajectory->spikeEvery == trajectory->spikeEvery - 1;
+        uint8_t verdict;
+
+        if (spike) {
+            reported += (Uniform() < 0.5) ? -TURN / 8 : TURN / 8;
+            result->spikes++;
+        } else {
+            if (trajectory->outlierEvery != 0 && k % trajectory->outlierEvery == 0)
+                reported += (Uniform() < 0.5) ? -trajectory->outlier : trajectory->outlier;
+            result->rawSquares += pow(Wrap(floor(reported + 0.5) - x), 2);
+            result->frames++;
+        }
+
+        Response(response, reported);
+        verdict = OrbisFilterUpdate(&filter, timestamp, response);
+
+        if (ORBIS_FILTER_REJECTED == verdict && !spike)
+            result->goodRejected++;
+        if (ORBIS_FILTER_REJECTED != verdict && spike)
+            result->spikesAccepted++;
+
+        if (filter.output.sequence != sequence && k >= settle) {
+            uint32_t latency = timestamp - filter.output.timestamp;
+            double at = (double) (uint32_t) (filter.output.timestamp - START_TIME) / TIMER_MASTER_FREQ;
+            double output = (double) filter.output.counts / 65536.0;
+            double error = Wrap(output - TruePosition(trajectory, k, at));
+            double lag = Wrap(output - x);
+
+            result->outputs++;
+            result->errorSquares += error * error;
+            result->lagSquares += lag * lag;
+            result->latencySum += latency;
+            if (latency < result->latencyMin)
+                result->latencyMin = latency;
+            if (latency > result->latencyMax)
+                result->latencyMax = latency;
+        }
+        sequence = filter.output.sequence;
+    }
+
+    result->restarts = filter.restarts;
+}
+
+static double Rms(double squares, uint32_t n)
+{
+    return (n == 0) ? 0.0 : sqrt(squares / n);
+}
+
+// Bits of an ideal encoder with the RMS error
+static double EffectiveBits(double rms)
+{
+    return (rms == 0.0) ? 99.0 : ORBIS_RESOLUTION + log2(QUANTISATION / rms);
+}
+
+static const char* MethodName(uint8_t method)
+{
+    switch (method) {
+    case ORBIS_FILTER_MEAN: return "mean";
+    case ORBIS_FILTER_MEDIAN: return "median";
+    default: return "trimmed";
+    }
+}
+
+static void PrintResult(uint8_t method, uint32_t decimation, uint32_t period, const FilterResult* result)
+{
+    double rms = Rms(result->errorSquares, result->outputs);
+
+    printf("%-8s %4u %9.0f %9.4f %6.2f %9.2f %9.4f %7u %7u %7u %7u\n",
+           MethodName(method), decimation, (double) TIMER_MASTER_FREQ / ((double) period * decimation),
+           rms, EffectiveBits(rms), (result->outputs == 0) ? 0.0 : result->latencySum / result->outputs / TIMER_1US,
+           Rms(result->lagSquares, result->outputs), result->spikes, result->spikesAccepted,
+           result->goodRejected, result->restarts);
+}
+
+// The trade-off for the trajectory: every method at every decimation
+static void TradeOff(const Trajectory* trajectory, int trim, uint32_t maxJump, uint64_t seed)
+{
+    FilterResult result;
+
+    printf("trajectory: %u frames every %.2f us, noise %.2f counts RMS, velocity %.0f counts/s, sine %.0f counts at %.0f Hz\n",
+           trajectory->frames, (double) trajectory->period / TIMER_1US, trajectory->noise, trajectory->velocity,
+           trajectory->amplitude, trajectory->frequency);
+
+    // The frames themselves, whatever the filter
+    FilterRun(trajectory, ORBIS_FILTER_MEAN, 1, 0, maxJump, seed, &result);
+    printf("frames:  RMS error %.4f counts, %.2f bits\n", Rms(result.rawSquares, result.frames),
+           EffectiveBits(Rms(result.rawSquares, result.frames)));
+    printf("method      n   out/s   RMS err   bits  latency us  made err  spikes  passed  good rj restarts\n");
+
+    for (uint8_t method = ORBIS_FILTER_MEAN; method <= ORBIS_FILTER_TRIMMED; method++) {
+        for (uint32_t decimation = 1; decimation <= ORBIS_FILTER_WINDOW; decimation *= 2) {
+            FilterRun(trajectory, method, decimation, (trim < 0) ? decimation / 4 : (uint32_t) trim, maxJump, seed, &result);
+            PrintResult(method, decimation, trajectory->period, &result);
+        }
+    }
+}
+
+//
+// Checks for -S. Each case runs a trajectory through the filter and checks a result against
+// a bound, and prints the result either way.
+//
+static int Check(const char* name, int ok, const char* format, double a, double b)
+{
+    printf("%-36s %s (", name, ok ? "ok" : "FAILED");
+    printf(format, a, b);
+    printf(")\n");
+
+    return ok ? 0 : 1;
+}
+
+static const Trajectory selfTestBase = {
+    .frames = 20000, .period = 10 * TIMER_1US, .start = 1000.3, .noise = 0.5, .frequency = 50
+};
+
+static int SelfTest(void)
+{
+    Trajectory trajectory;
+    FilterResult one, result, mean, median, trimmed;
+    double rms1, rms16, rms64;
+    uint32_t maxJump = ORBIS_FILTER_MAX_JUMP;
+    int failures = 0;
+
+    // Averaging a dithered position resolves it below a count, about sqrt(n) better
+    trajectory = selfTestBase;
+    FilterRun(&trajectory, ORBIS_FILTER_MEAN, 1, 0, maxJump, 1, &one);
+    FilterRun(&trajectory, ORBIS_FILTER_MEAN, 16, 0, maxJump, 1, &result);
+    rms1 = Rms(one.errorSquares, one.outputs);
+    rms16 = Rms(result.errorSquares, result.outputs);
+    failures += Check("mean of 16, dithered", rms16 < rms1 / 3,
+                      "RMS error %.4f counts, %.4f from single frames", rms16, rms1);
+    FilterRun(&trajectory, ORBIS_FILTER_MEAN, 64, 0, maxJump, 1, &result);
+    rms64 = Rms(result.errorSquares, result.outputs);
+    failures += Check("mean of 64, dithered", rms64 < rms16 / 1.5 && EffectiveBits(rms64) > ORBIS_RESOLUTION + 2,
+                      "RMS error %.4f counts, %.2f bits", rms64, EffectiveBits(rms64));
+
+    // The output stands for the middle of its window, (n - 1) / 2 periods behind the last frame
+    for (uint32_t decimation = 1; decimation <= ORBIS_FILTER_WINDOW; decimation *= 4) {
+        char name[40];
+        double expected = (decimation - 1) * (double) trajectory.period / 2;
+
+        FilterRun(&trajectory, ORBIS_FILTER_MEAN, decimation, 0, maxJump, 1, &result);
+        snprintf(name, sizeof(name), "latency of %u", decimation);
+        failures += Check(name, result.latencyMax - result.latencyMin <= 1 && fabs(result.latencyMin - expected) <= 1 &&
+                                result.outputs == trajectory.frames / decimation,
+                          "%.2f us, expected %.2f us", result.latencyMin / (double) TIMER_1US, expected / TIMER_1US);
+    }
+
+    // Spikes that pass the CRC check are kept out, and no good frame goes with them
+    trajectory = selfTestBase;
+    trajectory.spikeEvery = 37;
+    trajectory.velocity = 200000;
+    FilterRun(&trajectory, ORBIS_FILTER_MEAN, 16, 0, maxJump, 2, &result);
+    failures += Check("spikes, mean of 16", result.spikesAccepted == 0 && result.goodRejected == 0 &&
+                                            result.restarts == 0 && Rms(result.errorSquares, result.outputs) < 0.2,
+                      "%.0f spikes passed, RMS error %.4f counts", result.spikesAccepted, Rms(result.errorSquares, result.outputs));
+    FilterRun(&trajectory, ORBIS_FILTER_MEDIAN, 1, 0, maxJump, 2, &result);
+    failures += Check("spikes, single frames", result.spikesAccepted == 0 && result.goodRejected == 0 &&
+                                               result.restarts == 0,
+                      "%.0f spikes passed, %.0f good frames rejected", result.spikesAccepted, result.goodRejected);
+
+    // Across the wrap-around of the position, or of the turn count, fast, with the spikes. The median
+    // of whole counts resolves less than the means.
+    trajectory = selfTestBase;
+    trajectory.start = MODULUS - 500.5;
+    trajectory.velocity = 300000;
+    trajectory.spikeEvery = 101;
+    for (uint8_t method = ORBIS_FILTER_MEAN; method <= ORBIS_FILTER_TRIMMED; method++) {
+        char name[40];
+
+        FilterRun(&trajectory, method, 16, 4, maxJump, 3, &result);
+        snprintf(name, sizeof(name), "wrap-around, %s of 16", MethodName(method));
+        failures += Check(name, result.spikesAccepted == 0 && result.restarts == 0 &&
+                                Rms(result.errorSquares, result.outputs) < ((ORBIS_FILTER_MEDIAN == method) ? 0.4 : 0.25),
+                          "RMS error %.4f counts, %.0f restarts", Rms(result.errorSquares, result.outputs), result.restarts);
+    }
+
+    // Outliers within the limit get into the window, where the median and the trimmed mean deal with them
+    trajectory = selfTestBase;
+    trajectory.outlierEvery = 5;
+    trajectory.outlier = maxJump / 2;
+    FilterRun(&trajectory, ORBIS_FILTER_MEAN, 16, 0, maxJump, 4, &mean);
+    FilterRun(&trajectory, ORBIS_FILTER_MEDIAN, 16, 0, maxJump, 4, &median);
+    FilterRun(&trajectory, ORBIS_FILTER_TRIMMED, 16, 4, maxJump, 4, &trimmed);
+    failures += Check("outliers, median of 16", Rms(median.errorSquares, median.outputs) < Rms(mean.errorSquares, mean.outputs) / 2,
+                      "RMS error %.4f counts, %.4f for the mean", Rms(median.errorSquares, median.outputs),
+                      Rms(mean.errorSquares, mean.outputs));
+    failures += Check("outliers, trimmed mean of 16", Rms(trimmed.errorSquares, trimmed.outputs) < Rms(mean.errorSquares, mean.outputs) / 2,
+                      "RMS error %.4f counts, %.4f for the mean", Rms(trimmed.errorSquares, trimmed.outputs),
+                      Rms(mean.errorSquares, mean.outputs));
+
+    // A real step is taken for spikes at first, then the filter starts over and follows it
+    trajectory = selfTestBase;
+    trajectory.stepAt = 5000;
+    FilterRun(&trajectory, ORBIS_FILTER_MEAN, 16, 0, maxJump, 5, &result);
+    failures += Check("step of a quarter turn", result.restarts == 1 && result.goodRejected == ORBIS_FILTER_MAX_REJECTS &&
+                                                Rms(result.errorSquares, result.outputs) < 0.2,
+                      "%.0f restarts, RMS error after it %.4f counts", result.restarts, Rms(result.errorSquares, result.outputs));
+
+    // On a moving trajectory the output is late: made at the end of the window, the error grows with it
+    trajectory = selfTestBase;
+    trajectory.amplitude = 2000;
+    trajectory.frequency = 5;
+    FilterRun(&trajectory, ORBIS_FILTER_MEAN, 4, 0, maxJump, 6, &one);
+    FilterRun(&trajectory, ORBIS_FILTER_MEAN, 64, 0, maxJump, 6, &result);
+    failures += Check("sine, latency of 64", Rms(result.errorSquares, result.outputs) < 0.2 &&
+                                             Rms(result.lagSquares, result.outputs) > 4 * Rms(one.lagSquares, one.outputs),
+                      "%.4f counts behind when made, %.4f for 4", Rms(result.lagSquares, result.outputs),
+                      Rms(one.lagSquares, one.outputs));
+
+    return failures ? 1 : 0;
+}
+
+int main(int argc, char* argv[])
+{
+    Trajectory trajectory = selfTestBase;
+    uint32_t maxJump = ORBIS_FILTER_MAX_JUMP;
+    uint64_t seed = 1;
+    int trim = -1;
+    int opt;
+
+    OrbisCRCInit();
+
+    trajectory.start = 1000.3;
+
+    while ((opt = getopt(argc, argv, "n:p:N:v:A:f:k:t:j:r:S")) != -1) {
+        switch (opt) {
+        case 'n': trajectory.frames = (uint32_t) strtoul(optarg, NULL, 0); break;
+        case 'p': trajectory.period = (uint32_t) (strtod(optarg, NULL) * TIMER_1US); break;
+        case 'N': trajectory.noise = strtod(optarg, NULL); break;
+        case 'v': trajectory.velocity = strtod(optarg, NULL); break;
+        case 'A': trajectory.amplitude = strtod(optarg, NULL); break;
+        case 'f': trajectory.frequency = strtod(optarg, NULL); break;
+        case 'k': trajectory.spikeEvery = (uint32_t) strtoul(optarg, NULL, 0); break;
+        case 't': trim = atoi(optarg); break;
+        case 'j': maxJump = (uint32_t) strtoul(optarg, NULL, 0); break;
+        case 'r': seed = strtoull(optarg, NULL, 0); break;
+        case 'S': return SelfTest();
+        default:
+            fprintf(stderr, "usage: %s [-n count] [-p us] [-N counts] [-v counts/s] [-A counts] [-f Hz] [-k n] "
+                            "[-t n] [-j counts] [-r seed] [-S]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if (trajectory.period == 0)
+        trajectory.period = 1;
+    if (seed == 0)
+        seed = 1;
+
+    TradeOff(&trajectory, trim, maxJump, seed);
+
+    return 0;
+}
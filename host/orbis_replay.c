@@ -0,0 +1,694 @@
+/*
+ * orbis_replay.c
+ * Replays recordings of raw Orbis frames through the driver, and analyses them
+ *
+ * The recordings are the ones made by the capture recorder on the target, see orbis_record.c,
+ * dumped to the console and converted back to binary, or saved from the debugger, or written
+ * by orbis-sim -W. The file is mapped into memory and every frame goes through the driver's
+ * own OrbisValidateCRC() and OrbisPositionDecode(), in the order it was captured, so a
+ * recording of millions of frames takes a second or so.
+ *
+ * The replay reports
+ *
+ *   - frames whose CRC verdict on replay is not the one recorded, which is a driver bug
+ *   - bursts of failed captures, CRC errors and timeouts back to back, and how long they are
+ *   - position discontinuities: a position that is further than the jump threshold from
+ *     where the previous good positions say it should be, at the speed it was going
+ *   - the intervals between the captures, and the gaps longer than the gap threshold
+ *
+ * each encoder of the recording on its own.
+ *
+ * Usage: orbis-replay [options] [file...]
+ *   -q             quiet, print the summary only
+ *   -j <counts>    position jump threshold, counts of ORBIS_RESOLUTION bits (an eighth of a turn)
+ *   -g <us>        gap threshold (one and a half times the median interval)
+ *   -r <n>         replay every recording n times, to measure the replay rate (1)
+ *   -c <count>     exit with 1 unless exactly count frames are replayed from every recording,
+ *                  every verdict is the one recorded, and no frame is malformed
+ *   -S             replay synthetic recordings, with known faults in them, and check the results
+ *
+ * Prints the events, frame number and timestamp first, and a summary of every recording.
+ * Exits with 1 if a verdict is not the one recorded, 2 if a recording cannot be read.
+ *
+ *  Created on: 16 Oct 2026
+ */
+#include <stdint.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "orbis.h"
+#include "orbis_crc.h"
+#include "orbis_record.h"
+#include "util.h"
+
+#define SOURCES                 (ORBIS_BUS_COUNT * ORBIS_BUS_CHANNELS)
+
+// Burst lengths 1, 2, 3-4, 5-8, 9-16, 17-32 and longer
+#define BURST_BUCKETS           7u
+
+// Intervals looked at for the median, from the start of the recording
+#define MEDIAN_INTERVALS        4096u
+
+// Position modulus: the single-turn position, or the turn count and the position
+#if ORBIS_MULTITURN
+#define POSITION_MODULUS        ((int64_t) 1 << (16 + ORBIS_RESOLUTION))
+#else
+#define POSITION_MODULUS        ((int64_t) 1 << ORBIS_RESOLUTION)
+#endif
+
+// A recording mapped into memory, with the header read out
+typedef struct {
+    const uint8_t* frames;
+    uint32_t capacity;
+    uint32_t written;
+    uint32_t count;                 // frames in the recording
+    uint32_t first;                 // ring index of the oldest frame
+    uint32_t trigger;               // frame number of the trigger, counted from the oldest frame
+    uint8_t resolution;
+    uint8_t multiturn;
+    uint8_t mode;
+    uint8_t state;
+} Recording;
+
+typedef struct {
+    uint32_t jumpThreshold;         // counts of ORBIS_RESOLUTION bits
+    uint32_t gapThreshold;          // DMTimer4 ticks, 0 for the default
+    int events;                     // print the events as they are found
+} ReplayOptions;
+
+typedef struct {
+    uint32_t frames;
+    uint32_t ok;
+    uint32_t crcFail;
+    uint32_t timeouts;
+    uint32_t errorBits;             // good CRC, but the encoder reports an error
+    uint32_t malformed;             // bad length, source or verdict, not replayed
+    uint32_t mismatches;            // replayed verdict is not the one recorded
+    uint32_t bursts;
+    uint32_t burstLongest;
+    uint32_t burstLongestFrame;
+    uint32_t burstHistogram[BURST_BUCKETS];
+    uint32_t jumps;
+    uint32_t jumpLargest;
+    uint32_t jumpLargestFrame;
+    uint32_t intervals;
+    uint32_t intervalMin;
+    uint32_t intervalMax;
+    double intervalSum;
+    double intervalSumSquares;
+    uint32_t gapThreshold;          // DMTimer4 ticks, as used
+    uint32_t gaps;
+    uint32_t gapLongestFrame;
+    uint32_t sources;               // bit mask
+} ReplayStats;
+
+// What the replay knows about an encoder at the latest of its frames
+typedef struct {
+    uint8_t haveTime;
+    uint8_t havePosition;
+    uint8_t haveVelocity;
+    uint32_t lastTime;
+    uint32_t lastGoodTime;
+    int64_t lastPosition;
+    double velocity;                // counts per DMTimer4 tick
+    uint32_t burst;                 // failures in a row so far
+    uint32_t burstFrame;            // frame number of the first of them
+    uint32_t burstTime;             // and its timestamp
+} SourceState;
+
+static uint32_t GetWord(const uint8_t* p)
+{
+    return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static uint16_t GetHalf(const uint8_t* p)
+{
+    return (uint16_t) (p[0] | (p[1] << 8));
+}
+
+//
+// Read the header of the recording and check that it is one this build can replay.
+// Returns NULL if so, else what is wrong with it.
+//
+static const char* RecordingOpen(const uint8_t* image, size_t length, Recording* recording)
+{
+    if (length < ORBIS_RECORD_HEADER_SIZE || GetWord(&image[0]) != ORBIS_RECORD_MAGIC)
+        return "not an Orbis recording";
+    if (GetHalf(&image[4]) != ORBIS_RECORD_VERSION || GetHalf(&image[6]) != ORBIS_RECORD_FRAME_SIZE)
+        return "recording format version not supported";
+
+    recording->frames = &image[ORBIS_RECORD_HEADER_SIZE];
+    recording->capacity = GetWord(&image[8]);
+    recording->written = GetWord(&image[12]);
+    recording->resolution = image[20];
+    recording->multiturn = image[21];
+    recording->mode = image[22];
+    recording->state = image[23];
+
+    if (recording->capacity == 0)
+        return "recording of no capacity";
+    if (recording->resolution != ORBIS_RESOLUTION || recording->multiturn != ORBIS_MULTITURN)
+        return "recorded from another encoder variant, rebuild with its ORBIS_RESOLUTION and ORBIS_MULTITURN";
+
+    recording->count = (recording->written < recording->capacity) ? recording->written : recording->capacity;
+    recording->first = (recording->written < recording->capacity) ? 0 : recording->written % recording->capacity;
+
+    if ((length - ORBIS_RECORD_HEADER_SIZE) / ORBIS_RECORD_FRAME_SIZE < recording->count)
+        return "recording truncated";
+
+    // The trigger, if it is still in the recording
+    recording->trigger = GetWord(&image[16]);
+    if (recording->trigger != ORBIS_RECORD_NO_TRIGGER) {
+        uint32_t oldest = recording->written - recording->count;
+
+        recording->trigger = (recording->trigger - oldest < recording->count) ?
+                             recording->trigger - oldest : ORBIS_RECORD_NO_TRIGGER;
+    }
+
+    return NULL;
+}
+
+// The frame of the recording, counted from the oldest
+static const uint8_t* RecordingFrame(const Recording* recording, uint32_t n)
+{
+    uint32_t index = recording->first + n;
+
+    if (index >= recording->capacity)
+        index -= recording->capacity;
+
+    return &recording->frames[(size_t) index * ORBIS_RECORD_FRAME_SIZE];
+}
+
+// The encoder of the frame, or SOURCES if there is no such encoder
+static uint32_t FrameSource(const uint8_t* frame)
+{
+    uint32_t bus = ORBIS_RECORD_BUS(frame[6]);
+    uint32_t channel = ORBIS_RECORD_CHANNEL(frame[6]);
+
+    return (bus < ORBIS_BUS_COUNT && channel < ORBIS_BUS_CHANNELS) ? bus * ORBIS_BUS_CHANNELS + channel : SOURCES;
+}
+
+static int CompareIntervals(const void* a, const void* b)
+{
+    uint32_t x = *(const uint32_t*) a, y = *(const uint32_t*) b;
+
+    return (x > y) - (x < y);
+}
+
+// One and a half times the median interval between the frames of an encoder, from the start of the recording
+static uint32_t DefaultGapThreshold(const Recording* recording)
+{
+    static uint32_t intervals[MEDIAN_INTERVALS];
+    uint32_t lastTime[SOURCES];
+    uint8_t haveTime[SOURCES] = { 0 };
+    uint32_t n = 0;
+
+    for (uint32_t i = 0; i < recording->count && n < MEDIAN_INTERVALS; i++) {
+        const uint8_t* frame = RecordingFrame(recording, i);
+        uint32_t source = FrameSource(frame);
+        uint32_t timestamp = GetWord(&frame[0]);
+
+        if (source == SOURCES)
+            continue;
+        if (haveTime[source])
+            intervals[n++] = timestamp - lastTime[source];
+        lastTime[source] = timestamp;
+        haveTime[source] = 1;
+    }
+
+    if (n == 0)
+        return 0;
+
+    qsort(intervals, n, sizeof(intervals[0]), CompareIntervals);
+
+    return intervals[n / 2] + intervals[n / 2] / 2;
+}
+
+// A burst of failures of the encoder has ended, or the recording has
+static void BurstEnd(SourceState* state, ReplayStats* stats, const ReplayOptions* options)
+{
+    uint32_t bucket = 0;
+
+    if (state->burst == 0)
+        return;
+
+    while (bucket < BURST_BUCKETS - 1 && state->burst > (1u << bucket))
+        bucket++;
+
+    stats->bursts++;
+    stats->burstHistogram[bucket]++;
+    if (state->burst > stats->burstLongest) {
+        stats->burstLongest = state->burst;
+        stats->burstLongestFrame = state->burstFrame;
+    }
+
+    if (options->events)
+        printf("%8u %10u  burst of %u failed captures\n", state->burstFrame, state->burstTime, state->burst);
+
+    state->burst = 0;
+}
+
+// Position of the frame, turn count and all, in counts of ORBIS_RESOLUTION bits
+static int64_t FramePosition(const OrbisPosition* position)
+{
+    return ((int64_t) position->turns << ORBIS_RESOLUTION) | position->position;
+}
+
+// Replay the frame through the driver, and add it to the statistics
+static void ReplayFrame(const uint8_t* frame, uint32_t n, SourceState* sources, ReplayStats* stats,
+                        const ReplayOptions* options)
+{
+    uint32_t source = FrameSource(frame);
+    uint32_t timestamp = GetWord(&frame[0]);
+    uint8_t recorded = frame[4];
+    uint8_t length = frame[5];
+    SourceState* state;
+    OrbisPosition position;
+    uint8_t verdict;
+    int64_t delta;
+    double error;
+
+    stats->frames++;
+
+    if (source == SOURCES || recorded > ORBIS_TIMEOUT ||
+        (recorded == ORBIS_TIMEOUT) != (length == 0) || length > ORBIS_SIZE_BUFFER) {
+        stats->malformed++;
+        return;
+    }
+
+    state = &sources[source];
+    stats->sources |= 1u << source;
+
+    // The intervals between the captures of the encoder, failed or not
+    if (state->haveTime) {
+        uint32_t interval = timestamp - state->lastTime;
+
+        stats->intervals++;
+        stats->intervalSum += interval;
+        stats->intervalSumSquares += (double) interval * interval;
+        if (interval < stats->intervalMin)
+            stats->intervalMin = interval;
+        if (interval > stats->intervalMax) {
+            stats->intervalMax = interval;
+            stats->gapLongestFrame = n;
+        }
+
+        if (stats->gapThreshold != 0 && interval > stats->gapThreshold) {
+            stats->gaps++;
+            if (options->events)
+                printf("%8u %10u  gap of %u ticks\n", n, timestamp, interval);
+        }
+    }
+    state->lastTime = timestamp;
+    state->haveTime = 1;
+
+    if (ORBIS_TIMEOUT == recorded) {
+        stats->timeouts++;
+        if (state->burst++ == 0) {
+            state->burstFrame = n;
+            state->burstTime = timestamp;
+        }
+        return;
+    }
+
+    // Through the driver, just as the response came from the FIFO
+    for (uint32_t i = 0; i < length; i++)
+        orbisEncoder.dataRx[i] = frame[8 + i];
+    orbisEncoder.dataRxLength = length;
+
+    verdict = OrbisValidateCRC();
+
+    if (verdict != recorded) {
+        stats->mismatches++;
+        if (options->events)
+            printf("%8u %10u  recorded CRC verdict %u, %u on replay\n", n, timestamp, recorded, verdict);
+    }
+
+    if (verdict != ORBIS_CRC_OK) {
+        stats->crcFail++;
+        if (state->burst++ == 0) {
+            state->burstFrame = n;
+            state->burstTime = timestamp;
+        }
+        return;
+    }
+
+    stats->ok++;
+    BurstEnd(state, stats, options);
+
+    OrbisPositionDecode(orbisEncoder.dataRx, &position);
+    if (position.error) {
+        stats->errorBits++;
+        return;
+    }
+
+    if (!state->havePosition) {
+        state->lastPosition = FramePosition(&position);
+        state->lastGoodTime = timestamp;
+        state->havePosition = 1;
+        return;
+    }
+
+    // The shortest way round from the last good position, against where the speed would have taken it
+    delta = (FramePosition(&position) - state->lastPosition) & (POSITION_MODULUS - 1);
+    if (delta >= POSITION_MODULUS / 2)
+        delta -= POSITION_MODULUS;
+    error = (double) delta - (state->haveVelocity ? state->velocity * (double) (timestamp - state->lastGoodTime) : 0.0);
+    if (error < 0)
+        error = -error;
+
+    if (error > options->jumpThreshold) {
+        stats->jumps++;
+        if ((uint32_t) error > stats->jumpLargest) {
+            stats->jumpLargest = (uint32_t) error;
+            stats->jumpLargestFrame = n;
+        }
+        if (options->events)
+            printf("%8u %10u  position jump of %lld counts, %u counts off\n",
+                   n, timestamp, (long long) delta, (uint32_t) error);
+    } else if (timestamp != state->lastGoodTime) {
+        // The speed is only taken from where the position has gone smoothly
+        state->velocity = (double) delta / (double) (timestamp - state->lastGoodTime);
+        state->haveVelocity = 1;
+    }
+
+    state->lastPosition = FramePosition(&position);
+    state->lastGoodTime = timestamp;
+}
+
+// Replay the whole recording, oldest frame first
+static void Replay(const Recording* recording, const ReplayOptions* options, ReplayStats* stats)
+{
+    SourceState sources[SOURCES];
+
+    memset(sources, 0, sizeof(sources));
+    memset(stats, 0, sizeof(*stats));
+    stats->intervalMin = UINT32_MAX;
+    stats->gapThreshold = options->gapThreshold ? options->gapThreshold : DefaultGapThreshold(recording);
+
+    for (uint32_t n = 0; n < recording->count; n++)
+        ReplayFrame(RecordingFrame(recording, n), n, sources, stats, options);
+
+    for (uint32_t i = 0; i < SOURCES; i++)
+        BurstEnd(&sources[i], stats, options);
+}
+
+static void PrintStats(const Recording* recording, const ReplayStats* stats)
+{
+    static const char* const burstLabels[BURST_BUCKETS] = { "1", "2", "3-4", "5-8", "9-16", "17-32", ">32" };
+    double mean = stats->intervals ? stats->intervalSum / stats->intervals : 0.0;
+    double variance = stats->intervals ? stats->intervalSumSquares / stats->intervals - mean * mean : 0.0;
+    uint32_t encoders = 0;
+
+    for (uint32_t i = 0; i < SOURCES; i++)
+        encoders += (stats->sources >> i) & 1u;
+
+    printf("recording:          %u frames of %u written, %s", recording->count, recording->written,
+           (ORBIS_RECORD_TRIGGERED == recording->mode) ? "triggered" : "continuous");
+    if (recording->trigger != ORBIS_RECORD_NO_TRIGGER)
+        printf(", trigger at frame %u", recording->trigger);
+    printf(", %u encoder%s\n", encoders, (encoders == 1) ? "" : "s");
+    printf("frames:             %u (%u CRC OK, %u CRC fail, %u timeout, %u malformed)\n",
+           stats->frames, stats->ok, stats->crcFail, stats->timeouts, stats->malformed);
+    printf("  verdict mismatch: %u\n", stats->mismatches);
+    printf("  error bit:        %u\n", stats->errorBits);
+    printf("failure bursts:     %u, longest %u at frame %u, by length", stats->bursts,
+           stats->burstLongest, stats->burstLongestFrame);
+    for (uint32_t b = 0; b < BURST_BUCKETS; b++)
+        printf(" %s:%u", burstLabels[b], stats->burstHistogram[b]);
+    printf("\n");
+    printf("position jumps:     %u, largest %u counts off at frame %u\n",
+           stats->jumps, stats->jumpLargest, stats->jumpLargestFrame);
+    printf("intervals:          %.2f us mean, %.2f us std dev, %.2f to %.2f us\n",
+           mean / TIMER_1US, (variance > 0 ? sqrt(variance) : 0.0) / TIMER_1US,
+           (stats->intervals ? stats->intervalMin : 0) / (double) TIMER_1US,
+           stats->intervalMax / (double) TIMER_1US);
+    printf("  gaps:             %u over %.2f us, longest at frame %u\n",
+           stats->gaps, stats->gapThreshold / (double) TIMER_1US, stats->gapLongestFrame);
+}
+
+//
+// Synthetic recordings for -S. The frames are built here as the encoder sends them and
+// the recorder keeps them, from a trajectory of a quarter of a turn every 64 frames,
+// one frame every millisecond, with the faults of the case in it.
+//
+#define SYNTHETIC_SLOTS         1000u
+#define SYNTHETIC_PERIOD        TIMER_1MS
+#define SYNTHETIC_START         0xFFF00000u     // The timestamps wrap round on the way
+#define SYNTHETIC_VELOCITY      ((int64_t) 1 << (ORBIS_RESOLUTION - 6))
+#define SYNTHETIC_JUMP          ((int64_t) 3 << (ORBIS_RESOLUTION - 3))
+
+#define FAULT_BURSTS            0x01u       // CRC errors at 100, 200-202 and 300-309
+#define FAULT_TIMEOUTS          0x02u       // Timeouts at 400-401 and a CRC error at 402
+#define FAULT_JUMP              0x04u       // The position jumps by 3/8 of a turn at 500
+#define FAULT_GAP               0x08u       // No frames from 700 to 709
+#define FAULT_MISMATCH          0x10u       // A bad CRC recorded as good at 800
+#define FAULT_ERROR_BIT         0x20u       // The error bit set at 900
+#define FAULT_TWO_ENCODERS      0x40u       // A second encoder, on McSPI1, interleaved
+
+static uint8_t synthetic[ORBIS_RECORD_HEADER_SIZE + 2 * SYNTHETIC_SLOTS * ORBIS_RECORD_FRAME_SIZE];
+
+static void PutWord(uint8_t* p, uint32_t value)
+{
+    for (uint32_t b = 0; b < 4; b++)
+        p[b] = (uint8_t) (value >> (8 * b));
+}
+
+// The response of the encoder at the position, with the CRC, into the recorded frame
+static void SyntheticResponse(uint8_t* frame, int64_t counts, uint8_t error)
+{
+    uint8_t response[ORBIS_RECORD_DATA_SIZE];
+    uint32_t position = (uint32_t) (counts & ((1 << ORBIS_RESOLUTION) - 1));
+    uint16_t word = (uint16_t) ((position << ORBIS_POSITION_SHIFT) | ORBIS_WARNING_MASK |
+                                (error ? 0u : ORBIS_ERROR_MASK));
+    uint32_t length = ORBIS_SIZE_HEADER + ORBIS_SIZE_CRC;
+
+#if ORBIS_MULTITURN
+    response[0] = (uint8_t) (counts >> (ORBIS_RESOLUTION + 8));
+    response[1] = (uint8_t) (counts >> ORBIS_RESOLUTION);
+#endif
+    response[ORBIS_SIZE_TURNS] = (uint8_t) (word >> 8);
+    response[ORBIS_SIZE_TURNS + 1] = (uint8_t) word;
+    response[length - 1] = (uint8_t) ~OrbisCRC_Buffer(response, length - 1);
+
+    frame[5] = (uint8_t) length;
+    memcpy(&frame[8], response, length);
+}
+
+// Build the recording in a ring of the capacity, and return its length
+static size_t SyntheticRecording(uint32_t capacity, uint32_t faults)
+{
+    uint32_t encoders = (faults & FAULT_TWO_ENCODERS) ? 2 : 1;
+    uint32_t written = 0;
+
+    for (uint32_t slot = 0; slot < SYNTHETIC_SLOTS; slot++) {
+        if ((faults & FAULT_GAP) && slot >= 700 && slot < 710)
+            continue;
+
+        for (uint32_t e = 0; e < encoders; e++) {
+            uint8_t* frame = &synthetic[ORBIS_RECORD_HEADER_SIZE + (size_t) (written % capacity) * ORBIS_RECORD_FRAME_SIZE];
+            int64_t counts = (int64_t) slot * SYNTHETIC_VELOCITY + (int64_t) e * 5000;
+            uint8_t verdict = ORBIS_CRC_OK;
+
+            if ((faults & FAULT_JUMP) && slot >= 500)
+                counts += SYNTHETIC_JUMP;
+
+            memset(frame, 0, ORBIS_RECORD_FRAME_SIZE);
+            PutWord(&frame[0], SYNTHETIC_START + slot * SYNTHETIC_PERIOD + e * 20 * TIMER_1US);
+            frame[6] = ORBIS_RECORD_SOURCE(e, 0);
+            frame[7] = ORBIS_REQ_POSITION;
+            SyntheticResponse(frame, counts, (faults & FAULT_ERROR_BIT) && slot == 900);
+
+            if (((faults & FAULT_BURSTS) && (slot == 100 || (slot >= 200 && slot < 203) || (slot >= 300 && slot < 310))) ||
+                ((faults & FAULT_TIMEOUTS) && slot == 402) || ((faults & FAULT_MISMATCH) && slot == 800)) {
+                frame[9] ^= 0x04;
+                verdict = ((faults & FAULT_MISMATCH) && slot == 800) ? ORBIS_CRC_OK : ORBIS_CRC_FAIL;
+            }
+
+            if ((faults & FAULT_TIMEOUTS) && (slot == 400 || slot == 401)) {
+                frame[5] = 0;
+                memset(&frame[8], 0, ORBIS_RECORD_DATA_SIZE);
+                verdict = ORBIS_TIMEOUT;
+            }
+
+            frame[4] = verdict;
+            written++;
+        }
+    }
+
+    PutWord(&synthetic[0], ORBIS_RECORD_MAGIC);
+    synthetic[4] = (uint8_t) ORBIS_RECORD_VERSION;
+    synthetic[5] = 0;
+    synthetic[6] = (uint8_t) ORBIS_RECORD_FRAME_SIZE;
+    synthetic[7] = 0;
+    PutWord(&synthetic[8], capacity);
+    PutWord(&synthetic[12], written);
+    PutWord(&synthetic[16], ORBIS_RECORD_NO_TRIGGER);
+    synthetic[20] = ORBIS_RESOLUTION;
+    synthetic[21] = ORBIS_MULTITURN;
+    synthetic[22] = ORBIS_RECORD_CONTINUOUS;
+    synthetic[23] = ORBIS_RECORD_STOPPED;
+
+    return ORBIS_RECORD_HEADER_SIZE + (size_t) ((written < capacity) ? written : capacity) * ORBIS_RECORD_FRAME_SIZE;
+}
+
+// Replay the synthetic recording and check the findings
+static int SyntheticCase(const char* name, uint32_t capacity, uint32_t faults, uint32_t frames,
+                         uint32_t crcFail, uint32_t timeouts, uint32_t bursts, uint32_t longest,
+                         uint32_t jumps, uint32_t gaps, uint32_t mismatches, uint32_t errorBits)
+{
+    ReplayOptions options = { 1u << (ORBIS_RESOLUTION - 3), 0, 0 };
+    Recording recording;
+    ReplayStats stats;
+    const char* error;
+    int ok;
+
+    error = RecordingOpen(synthetic, SyntheticRecording(capacity, faults), &recording);
+    if (error != NULL) {
+        printf("%-20s FAILED (%s)\n", name, error);
+        return 1;
+    }
+
+    Replay(&recording, &options, &stats);
+
+    ok = stats.frames == frames && stats.crcFail == crcFail && stats.timeouts == timeouts &&
+         stats.bursts == bursts && stats.burstLongest == longest && stats.jumps == jumps &&
+         stats.gaps == gaps && stats.mismatches == mismatches && stats.errorBits == errorBits &&
+         stats.malformed == 0 && stats.intervalMin == SYNTHETIC_PERIOD;
+
+    printf("%-20s %s (%u frames, %u CRC fail, %u timeout, %u bursts up to %u, %u jumps, %u gaps, %u mismatches)\n",
+           name, ok ? "ok" : "FAILED", stats.frames, stats.crcFail, stats.timeouts, stats.bursts,
+           stats.burstLongest, stats.jumps, stats.gaps, stats.mismatches);
+
+    return ok ? 0 : 1;
+}
+
+static int SyntheticTest(void)
+{
+    uint32_t all = FAULT_BURSTS | FAULT_TIMEOUTS | FAULT_JUMP | FAULT_GAP | FAULT_ERROR_BIT;
+    int failures = 0;
+
+    //                                      capacity faults          frames crc tmo bursts longest jumps gaps mism err
+    failures += SyntheticCase("clean",           4096, 0,                 1000, 0,  0,  0,  0,     0,    0,   0,  0);
+    failures += SyntheticCase("bursts",          4096, FAULT_BURSTS,      1000, 14, 0,  3,  10,    0,    0,   0,  0);
+    failures += SyntheticCase("timeouts",        4096, FAULT_TIMEOUTS,    1000, 1,  2,  1,  3,     0,    0,   0,  0);
+    failures += SyntheticCase("jump",            4096, FAULT_JUMP,        1000, 0,  0,  0,  0,     1,    0,   0,  0);
+    failures += SyntheticCase("gap",             4096, FAULT_GAP,         990,  0,  0,  0,  0,     0,    1,   0,  0);
+    failures += SyntheticCase("mismatch",        4096, FAULT_MISMATCH,    1000, 1,  0,  1,  1,     0,    0,   1,  0);
+    failures += SyntheticCase("error bit",       4096, FAULT_ERROR_BIT,   1000, 0,  0,  0,  0,     0,    0,   0,  1);
+    failures += SyntheticCase("wrapped",         256,  0,                 256,  0,  0,  0,  0,     0,    0,   0,  0);
+    failures += SyntheticCase("two encoders",    4096, FAULT_TWO_ENCODERS | all,
+                                                                          1980, 30, 4,  8,  10,    2,    2,   0,  2);
+    failures += SyntheticCase("all of it wrapped", 256,  all,               256,  0,  0,  0,  0,     0,    0,   0,  1);
+    failures += SyntheticCase("all of it",       4096, all,               990,  15, 2,  4,  10,    1,    1,   0,  1);
+
+    return failures ? 1 : 0;
+}
+
+static double HostNanoseconds(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec * 1e9 + (double) ts.tv_nsec;
+}
+
+// Replay the recording in the file, repeats times. Returns 1 if the -c check fails, 2 if it cannot be read.
+static int ReplayFile(const char* path, const ReplayOptions* options, uint32_t repeats, long expected)
+{
+    ReplayOptions quietOptions = *options;
+    Recording recording;
+    ReplayStats stats;
+    struct stat st;
+    const uint8_t* image;
+    const char* error;
+    double t0, elapsed;
+    int fd;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        perror(path);
+        return 2;
+    }
+
+    image = (st.st_size == 0) ? NULL : mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (image == MAP_FAILED) {
+        perror(path);
+        return 2;
+    }
+
+    error = (image == NULL) ? "empty file" : RecordingOpen(image, (size_t) st.st_size, &recording);
+    if (error != NULL) {
+        fprintf(stderr, "%s: %s\n", path, error);
+        if (image != NULL)
+            munmap((void*) image, (size_t) st.st_size);
+        return 2;
+    }
+
+    // The events once, then as fast as it goes
+    quietOptions.events = 0;
+    t0 = HostNanoseconds();
+    for (uint32_t r = 0; r < repeats; r++)
+        Replay(&recording, (r == 0) ? options : &quietOptions, &stats);
+    elapsed = HostNanoseconds() - t0;
+
+    printf("%s:\n", path);
+    PrintStats(&recording, &stats);
+    if (stats.frames != 0) {
+        printf("replay:             %.1f ns per frame, %.2f M frames/s\n",
+               elapsed / ((double) stats.frames * repeats), (double) stats.frames * repeats / elapsed * 1e3);
+    }
+
+    munmap((void*) image, (size_t) st.st_size);
+
+    if (stats.mismatches != 0)
+        return 1;
+    if (expected >= 0 && (stats.frames != (uint32_t) expected || stats.malformed != 0))
+        return 1;
+
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    ReplayOptions options = { 1u << (ORBIS_RESOLUTION - 3), 0, 1 };
+    uint32_t repeats = 1;
+    long expected = -1;
+    int result = 0;
+    int opt;
+
+    OrbisCRCInit();
+
+    while ((opt = getopt(argc, argv, "qj:g:r:c:S")) != -1) {
+        switch (opt) {
+        case 'q': options.events = 0; break;
+        case 'j': options.jumpThreshold = (uint32_t) strtoul(optarg, NULL, 0); break;
+        case 'g': options.gapThreshold = (uint32_t) strtoul(optarg, NULL, 0) * TIMER_1US; break;
+        case 'r': repeats = (uint32_t) strtoul(optarg, NULL, 0); break;
+        case 'c': expected = strtol(optarg, NULL, 0); break;
+        case 'S': return SyntheticTest();
+        default:
+            fprintf(stderr, "usage: %s [-q] [-j counts] [-g us] [-r n] [-c count] [-S] [file...]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if (repeats == 0)
+        repeats = 1;
+
+    for (int i = optind; i < argc; i++) {
+        int r = ReplayFile(argv[i], &options, repeats, expected);
+
+        if (r > result)
+            result = r;
+    }
+
+    return result;
+}
@@ -0,0 +1,349 @@
+/*
+ * orbis_ring_sim.c
+ * Checks the sample ring buffer, alone and with an interrupt-like producer
+ *
+ * The ring is built into this program, rather than linked, so that its indices can be
+ * started anywhere, just short of 2^32 too, where they wrap around. Every sample carries
+ * its sequence number in all of its fields, so that a sample read out of order, twice,
+ * torn, or from a slot the producer has reused, does not go unnoticed.
+ *
+ * First the producer and the consumer take turns, in runs of random length, and the ring
+ * is checked against a model of it after every step: the count, the samples read, and the
+ * samples dropped, newest first, once it is full.
+ *
+ * Then the producer runs as the capture interrupt does on the target, preempting the consumer:
+ * in the middle of OrbisRingRead(), in between the slots it copies, and in between reads. It
+ * puts a burst of samples into the ring each time, which fills whatever slots the consumer has
+ * freed. Now and then the consumer stops reading long enough for the ring to overflow. The
+ * samples read must come in order, and the gaps between them must be the overruns counted.
+ * The interrupt is taken where the ring works out the slot of an index, see ORBIS_RING_MASK
+ * below, at random, so a run is the same every time.
+ *
+ * Usage: orbis-ring-sim [options]
+ *   -n <count>     samples the interrupt produces, in each of two runs (20000)
+ *   -p <n>         take the interrupt at one in n slots OrbisRingRead() copies (16)
+ *   -q             quiet, print the summary only
+ *
+ * Exits with 1 if a check fails.
+ *
+ *  Created on: 16 Oct 2026
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "orbis_ring.h"
+
+static void Interrupt(void);
+
+// The interrupt comes whenever the ring works out the slot of an index, if it is enabled
+#undef ORBIS_RING_MASK
+#define ORBIS_RING_MASK         (Interrupt(), ORBIS_RING_SIZE - 1u)
+
+#include "orbis_ring.c"
+
+// Most samples to produce or read in a step of the first check
+#define STEP_MAX        (ORBIS_RING_SIZE + 8u)
+
+// Steps of the first check, from each start index
+#define STEPS           4000u
+
+// Most samples the interrupt produces at a time
+#define PRODUCER_BURST_MAX  16u
+
+// The ring indices to start from: the first slot, and short of the wrap around at 2^32
+static const uint32_t starts[] = { 0u, 0u - ORBIS_RING_SIZE / 2u, 0u - 1u };
+
+static uint32_t count = 20000;
+static uint32_t preemptEvery = 16;
+static int quiet;
+static uint32_t seed = 1;
+
+// The interrupt-like producer: samples produced and dropped, of how many, whether it is at
+// work, whether the interrupt is enabled, and the interrupts that came in the middle of a read
+static uint32_t producerSequence;
+static uint32_t producerDropped;
+static uint32_t producerCount;
+static int producing;
+static int interruptEnabled;
+static int reading;
+static uint32_t preempted;
+
+static uint32_t Random(void)
+{
+    seed = seed * 1103515245u + 12345u;
+    return seed >> 16;
+}
+
+// The ring as it should be, with indices that do not wrap
+static uint32_t model[ORBIS_RING_SIZE];
+static uint64_t modelHead, modelTail;
+static uint32_t modelOverruns;
+
+static void RingStart(uint32_t index)
+{
+    OrbisRingReset();
+    orbisRingHead = index;
+    orbisRingTail = index;
+    modelHead = modelTail = 0;
+    modelOverruns = 0;
+}
+
+static void SampleFill(volatile OrbisSample* sample, uint32_t sequence)
+{
+    sample->timestamp = sequence;
+    sample->position = (uint16_t) ~sequence;
+    sample->turns = (uint16_t) (sequence >> 16);
+    sample->error = (uint8_t) ((sequence >> 1) & 1u);
+    sample->warning = (uint8_t) ((sequence >> 2) & 1u);
+    for (uint32_t j = 0; j < ORBIS_SIZE_BUFFER; j++)
+        sample->data[j] = (uint8_t) (sequence * 31u + j);
+    sample->length = (uint8_t) (1u + sequence % ORBIS_SIZE_BUFFER);
+    sample->crc = (uint8_t) (sequence & 1u);
+    sample->velocity = (int32_t) sequence;
+    sample->acceleration = -(int32_t) sequence;
+}
+
+// Whether all the fields of the sample are those of its sequence number
+static int SampleIntact(const OrbisSample* sample)
+{
+    uint32_t sequence = sample->timestamp;
+
+    if (sample->position != (uint16_t) ~sequence || sample->turns != (uint16_t) (sequence >> 16) ||
+        sample->error != (uint8_t) ((sequence >> 1) & 1u) || sample->warning != (uint8_t) ((sequence >> 2) & 1u) ||
+        sample->length != (uint8_t) (1u + sequence % ORBIS_SIZE_BUFFER) ||
+        sample->crc != (uint8_t) (sequence & 1u) || sample->velocity != (int32_t) sequence ||
+        sample->acceleration != -(int32_t) sequence)
+        return 0;
+
+    for (uint32_t j = 0; j < ORBIS_SIZE_BUFFER; j++)
+        if (sample->data[j] != (uint8_t) (sequence * 31u + j))
+            return 0;
+
+    return 1;
+}
+
+// As the capture interrupt does it. Returns 0 if the sample was dropped.
+static int Produce(uint32_t sequence)
+{
+    volatile OrbisSample* slot = OrbisRingSlotAcquire();
+
+    if (slot == NULL)
+        return 0;
+
+    SampleFill(slot, sequence);
+    OrbisRingSlotCommit();
+    return 1;
+}
+
+//
+// Producer and consumer in turns, from the start index, with the ring checked against the
+// model after every step. Returns the number of failures.
+//
+static uint32_t RunTurns(uint32_t start)
+{
+    static OrbisSample samples[STEP_MAX];
+    uint32_t failures = 0, sequence = 0;
+
+    RingStart(start);
+
+    for (uint32_t step = 0; step < STEPS && failures == 0; step++) {
+        uint32_t n = Random() % (STEP_MAX + 1);
+
+        if (Random() % 2) {
+            for (uint32_t i = 0; i < n; i++, sequence++) {
+                int full = (modelHead - modelTail == ORBIS_RING_SIZE);
+
+                if (Produce(sequence) == full) {
+                    if (!quiet)
+                        printf("start %u, step %u: sample %u %s with %u in the ring\n", start, step,
+                               sequence, full ? "taken" : "dropped", (uint32_t) (modelHead - modelTail));
+                    failures++;
+                    break;
+                }
+                if (full)
+                    modelOverruns++;
+                else
+                    model[modelHead++ % ORBIS_RING_SIZE] = sequence;
+            }
+        } else {
+            uint32_t expected = (uint32_t) (modelHead - modelTail), read;
+
+            if (expected > n)
+                expected = n;
+
+            read = OrbisRingRead(samples, n);
+            if (read != expected) {
+                if (!quiet)
+                    printf("start %u, step %u: %u samples read of %u asked, %u expected\n", start, step,
+                           read, n, expected);
+                failures++;
+            }
+
+            for (uint32_t i = 0; i < read && i < expected; i++) {
+                uint32_t wanted = model[modelTail++ % ORBIS_RING_SIZE];
+
+                if (samples[i].timestamp != wanted || !SampleIntact(&samples[i])) {
+                    if (!quiet)
+                        printf("start %u, step %u: sample %u read, %u expected\n", start, step,
+                               samples[i].timestamp, wanted);
+                    failures++;
+                    break;
+                }
+            }
+        }
+
+        if (OrbisRingCount() != modelHead - modelTail || orbisRingOverruns != modelOverruns) {
+            if (!quiet)
+                printf("start %u, step %u: %u in the ring and %u overruns, %u and %u expected\n", start,
+                       step, OrbisRingCount(), orbisRingOverruns, (uint32_t) (modelHead - modelTail),
+                       modelOverruns);
+            failures++;
+        }
+    }
+
+    if (!quiet)
+        printf("turns from %10u: %u samples, %u overruns, head at %u, %u failures\n", start, sequence,
+               orbisRingOverruns, orbisRingHead, failures);
+
+    return failures;
+}
+
+// A burst of 1 to PRODUCER_BURST_MAX samples, as burst captures make them
+static void ProducerBurst(void)
+{
+    uint32_t burst = 1 + Random() % PRODUCER_BURST_MAX;
+
+    producing = 1;
+    while (burst-- > 0 && producerSequence != producerCount) {
+        if (!Produce(producerSequence))
+            producerDropped++;
+        producerSequence++;
+    }
+    producing = 0;
+}
+
+static void Interrupt(void)
+{
+    if (!interruptEnabled || producing || Random() % preemptEvery != 0)
+        return;
+
+    ProducerBurst();
+    if (reading)
+        preempted++;
+}
+
+//
+// The producer in the interrupt, the consumer here, from the start index, until the producer
+// has produced its samples. Returns the number of failures.
+//
+static uint32_t RunInterleaved(uint32_t start)
+{
+    static OrbisSample samples[ORBIS_RING_SIZE];
+    uint32_t failures = 0, consumed = 0, gaps = 0, stalls = 0, reads = 0;
+    uint32_t next = 0;
+
+    RingStart(start);
+    producerSequence = 0;
+    producerDropped = 0;
+    producerCount = count;
+    preempted = 0;
+    interruptEnabled = 1;
+
+    for (;;) {
+        uint32_t done = (producerSequence == producerCount);
+        uint32_t level = 1 + Random() % (ORBIS_RING_SIZE + ORBIS_RING_SIZE / 8);
+        uint32_t until = producerSequence + level;
+
+        // Let the ring fill up, now and then past full, then drain it in batches of random sizes
+        while (producerSequence < until && producerSequence != producerCount)
+            ProducerBurst();
+        if (level > ORBIS_RING_SIZE && !done)
+            stalls++;
+
+        for (;;) {
+            uint32_t n;
+
+            reading = 1;
+            n = OrbisRingRead(samples, 1 + Random() % ORBIS_RING_SIZE);
+            reading = 0;
+
+            if (n == 0)
+                break;
+            reads++;
+
+            for (uint32_t i = 0; i < n; i++) {
+                uint32_t sequence = samples[i].timestamp;
+
+                if (sequence < next || sequence >= producerSequence || !SampleIntact(&samples[i])) {
+                    if (!quiet && failures < 10)
+                        printf("start %u: sample %u read, %u or later expected\n", start, sequence, next);
+                    failures++;
+                    continue;
+                }
+                gaps += sequence - next;
+                next = sequence + 1;
+                consumed++;
+            }
+        }
+
+        if (done)
+            break;
+    }
+
+    interruptEnabled = 0;
+
+    // The newest samples dropped at the end leave no gap behind them
+    gaps += producerCount - next;
+
+    if (gaps != orbisRingOverruns || producerDropped != orbisRingOverruns || consumed + orbisRingOverruns != producerCount) {
+        printf("start %u: %u samples read, %u missing, %u dropped, %u overruns counted\n", start, consumed,
+               gaps, producerDropped, orbisRingOverruns);
+        failures++;
+    }
+
+    // The point of this check is the interrupts in the middle of a read, so there have to be some
+    if (preempted == 0 || (stalls > 0 && orbisRingOverruns == 0)) {
+        printf("start %u: %u interrupts in %u reads, %u overruns after %u waits past full\n", start, preempted,
+               reads, orbisRingOverruns, stalls);
+        failures++;
+    }
+
+    if (!quiet)
+        printf("interleaved from %10u: %u samples read, %u overruns, %u interrupts in %u reads, %u failures\n",
+               start, consumed, orbisRingOverruns, preempted, reads, failures);
+
+    return failures;
+}
+
+int main(int argc, char* argv[])
+{
+    int opt;
+    uint32_t failures = 0;
+
+    while ((opt = getopt(argc, argv, "n:p:q")) != -1) {
+        switch (opt) {
+        case 'n': count = (uint32_t) strtoul(optarg, NULL, 0); break;
+        case 'p': preemptEvery = (uint32_t) strtoul(optarg, NULL, 0); break;
+        case 'q': quiet = 1; break;
+        default:
+            fprintf(stderr, "usage: %s [-n count] [-p n] [-q]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if (preemptEvery == 0)
+        preemptEvery = 1;
+
+    for (uint32_t i = 0; i < sizeof(starts) / sizeof(starts[0]); i++)
+        failures += RunTurns(starts[i]);
+
+    // From the first slot, and with the indices wrapping around halfway through
+    failures += RunInterleaved(0);
+    failures += RunInterleaved(0u - count / 2);
+
+    printf("ring of %u: checked in turns and with an interrupt at one in %u slots read, %u failures\n",
+           ORBIS_RING_SIZE, preemptEvery, failures);
+
+    return (failures == 0) ? 0 : 1;
+}
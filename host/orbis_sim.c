@@ -0,0 +1,1161 @@
+/*
+ * orbis_sim.c
+ * Runs the Orbis driver on the host against the simulated McSPI and Orbis encoder
+ *
+ * The driver is set up just as main.c does it on the target, then it captures the
+ * position over and over while the encoder model moves and misbehaves as asked.
+ * Every capture is checked against the position the model has sent, and the host
+ * time, McSPI calls and interrupts taken per capture are reported.
+ *
+ * With more than one encoder, they go on McSPI0 CS0, McSPI1 CS0, McSPI0 CS1 and
+ * McSPI1 CS1, in that order, and are captured all together in sweeps.
+ *
+ * Usage: orbis-sim [options]
+ *   -n <count>     number of captures (1000)
+ *   -v <counts/s>  encoder velocity, counts of the 14 bit position per second (1000)
+ *   -A <counts/s2> encoder acceleration (0)
+ *   -r <bits>      encoder resolution, 12 or 14 (14)
+ *   -e <n>         flip one bit in n (never)
+ *   -s <n>         stall every n-th frame (never)
+ *   -l <n>         respond late to every n-th frame (never)
+ *   -L <us>        how late (50)
+ *   -f <Hz>        fastest SPI clock the encoder follows (4000000)
+ *   -w <ticks>     McSPI raises EOW this many timer ticks before the last word is in (0)
+ *   -x <n>         set the error bit in every n-th frame (never)
+ *   -O <frames>    halfway through, the encoder stops responding for that many frames
+ *   -R             blocking captures only: go through the failure recovery, and check that
+ *                  only good positions come out, fresh or held, within the latency budget
+ *   -b <us>        latency budget of the recovery (50)
+ *   -S <us>        blocking captures only: run them as the 1 kHz task of the scheduler, with
+ *                  the estimator and a load task that takes this long every 10 ms, sleeping
+ *                  in between; check the tick count against the timer, the releases against
+ *                  the runs and overruns, the release jitter of the capture task, and the
+ *                  CPU load accounting against the time the tasks took
+ *   -B <frames>    blocking captures only: capture in bursts of that many frames, check every
+ *                  frame against the trajectory of the encoder, and the time CS is high in
+ *                  between them against ORBIS_BURST_GAP, and compare the McSPI calls a frame
+ *                  takes with those of as many polled single captures
+ *   -P <n>         blocking captures only: poll every n-th capture with IRQ disabled once its
+ *                  request is out, as from a critical section, until it times out, and check
+ *                  that its completion, pending or raised on the way, completes nothing after that
+ *   -I <us>        another interrupt handler that takes this long, every OTHER_PERIOD
+ *   -M <us>        check that no response waits longer than that in the Rx FIFO to be read,
+ *                  from the RX_FULL level, e.g. while -I holds the McSPI IRQ handler off
+ *   -c <calls>     blocking captures only: check that a capture takes no more McSPI calls than
+ *                  that on average, not counting the channel status reads a wait for a word
+ *                  takes, e.g. the count of the interrupt-driven backend, which has none
+ *   -a <us>        continuous acquisition with this period instead of blocking captures
+ *   -E <count>     number of encoders, up to 4 (1)
+ *   -C             calibrate the SPI clock and CS setup delay first, and run the watchdog
+ *   -D <Hz>        halfway through, the encoder can only follow this SPI clock
+ *   -T <file>      continuous acquisition only: send the samples as binary telemetry
+ *                  over the simulated UART0 and write the stream to the file
+ *   -W <file>      record every capture and write the recording to the file, see orbis-replay
+ *   -V             continuous acquisition only: estimate the velocity and acceleration
+ *                  and check them against the trajectory of the encoder, and so the
+ *                  position in between the samples
+ *   -q             quiet, print the summary only
+ *
+ * Exits with 1 if a corrupted position got past the CRC check, or the estimates are off,
+ * or the recovery hands out a wrong position or takes too long, or the scheduler is off,
+ * or the acquisition drops samples, or misses its period or the CRC with no fault injected,
+ * or CS is not high for ORBIS_BURST_GAP, give or take a few timer reads, between burst frames,
+ * or a capture completes after it has timed out, or a response waits too long to be read.
+ *
+ *  Created on: 16 Oct 2026
+ */
+#include <stdint.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "hw_types.h"
+#include "soc_AM335x.h"
+#include "beaglebone.h"
+#include "interrupt.h"
+#include "dmtimer.h"
+#include "orbis.h"
+#include "orbis_crc.h"
+#include "orbis_calib.h"
+#include "orbis_ring.h"
+#include "orbis_telemetry.h"
+#include "orbis_estimator.h"
+#include "orbis_recovery.h"
+#include "orbis_fiq.h"
+#include "orbis_sched.h"
+#include "orbis_load.h"
+#include "orbis_record.h"
+#if ORBIS_USE_EDMA
+#include "mcspi.h"
+#include "orbis_edma.h"
+#endif
+#include "util.h"
+#include "sim.h"
+
+#define ENCODERS_MAX    (ORBIS_BUS_COUNT * ORBIS_BUS_CHANNELS)
+
+static SimOrbis models[ENCODERS_MAX];
+static OrbisEncoder encoders[ENCODERS_MAX];
+static OrbisEncoder* handles[ENCODERS_MAX];
+
+// The model behind orbisEncoder, and the one whose configuration the options set
+#define encoder         models[0]
+
+static uint32_t encoderCount = 1;
+static uint32_t captures = 1000;
+static uint32_t acquisitionPeriod;
+static uint32_t degradedClockHz;
+static int calibrate;
+static int quiet;
+static OrbisWatchdog watchdog;
+static FILE* telemetry;
+static FILE* recording;
+static int estimate;
+static OrbisEstimator estimator;
+static int recover;
+static uint32_t recoveryBudget = ORBIS_RECOVERY_BUDGET_DEFAULT;
+static uint32_t outageFrames;
+static OrbisRecovery recovery;
+static int schedule;
+static uint32_t loadTicks;
+static uint32_t burstFrames;
+static uint32_t staleEvery;
+static uint32_t otherTicks;
+static double maxRxWait;
+static double maxCalls;
+
+// Samples for the estimator to settle before the estimates are checked, and how far off they
+// may be then: a fraction of the true value, plus a floor for each count of position quantisation.
+// The acceleration is off the most when the shaft moves close to a whole number of counts a
+// sample: the quantisation error then changes slowly, and the estimator takes it for acceleration.
+// That lasts longer the coarser the counts, so the floor is set for 12 bits, with a third to spare.
+#define ESTIMATOR_SETTLE                400u
+#define ESTIMATOR_VELOCITY_FLOOR        400.0
+#define ESTIMATOR_ACCELERATION_FLOOR    300000.0
+#define ESTIMATOR_RELATIVE              0.01
+#define ESTIMATOR_POSITION_FLOOR        2.0
+
+// How much longer than its budget a recovered capture may take: the attempt that runs out
+// of budget is only abandoned once its deadline is seen to have passed
+#define RECOVERY_SLACK                  (5 * TIMER_1US)
+
+// How much later than the longest task of lower priority the capture task may start: the
+// release is only seen when the tick deadline has been serviced
+#define SCHED_SLACK                     (2 * TIMER_1US)
+
+// How far off its period a sample may be: the capture starts when the timer interrupt is
+// taken, which waits for a handler that is running, or for interrupts to be enabled again
+#define ACQUISITION_SLACK               TIMER_1US
+
+// How much longer than ORBIS_BURST_GAP CS may stay high in between the frames of a burst: the
+// gap is timed from the timer read after CS is deasserted, it is seen to be over up to a read
+// late, and the next frame's timestamp is read before CS is asserted
+#define BURST_GAP_SLACK                 (3 * simPollTicks)
+
+// Period of the interrupt of the other handler, see -I, prime to the capture periods of the checks
+#define OTHER_PERIOD                    (37 * TIMER_1US)
+
+// Same as InterruptSetup() and TimerSetup() in main.c
+static void SetupAsTarget(void)
+{
+    IntMasterIRQEnable();
+    IntAINTCInit();
+
+    IntRegister(SYS_INT_SPI0INT, orbisMcSPIIsr);
+    IntPrioritySet(SYS_INT_SPI0INT, 0, AINTC_HOSTINT_ROUTE_IRQ);
+    IntSystemEnable(SYS_INT_SPI0INT);
+
+    IntRegister(SYS_INT_SPI1INT, orbisMcSPI1Isr);
+    IntPrioritySet(SYS_INT_SPI1INT, 0, AINTC_HOSTINT_ROUTE_IRQ);
+    IntSystemEnable(SYS_INT_SPI1INT);
+
+#if ORBIS_USE_EDMA
+    IntRegister(SYS_INT_EDMACOMPINT, orbisEDMACompletionIsr);
+    IntPrioritySet(SYS_INT_EDMACOMPINT, 0, AINTC_HOSTINT_ROUTE_IRQ);
+    IntSystemEnable(SYS_INT_EDMACOMPINT);
+#endif
+
+    IntRegister(ORBIS_TELEMETRY_UART_INT, orbisTelemetryIsr);
+    IntPrioritySet(ORBIS_TELEMETRY_UART_INT, 2, AINTC_HOSTINT_ROUTE_IRQ);
+    IntSystemEnable(ORBIS_TELEMETRY_UART_INT);
+
+    IntRegister(TIMER_DEADLINE_INT, timerDeadlineIsr);
+    IntPrioritySet(TIMER_DEADLINE_INT, 0, AINTC_HOSTINT_ROUTE_IRQ);
+    IntSystemEnable(TIMER_DEADLINE_INT);
+
+    IntRegister(ORBIS_TRIGGER_TIMER_INT, orbisTriggerIsr);
+    IntPrioritySet(ORBIS_TRIGGER_TIMER_INT, 1, AINTC_HOSTINT_ROUTE_IRQ);
+    IntSystemEnable(ORBIS_TRIGGER_TIMER_INT);
+
+    DMTimer4ModuleClkConfig();
+    DMTimerPreScalerClkDisable(SOC_DMTIMER_4_REGS);
+    DMTimerCounterSet(SOC_DMTIMER_4_REGS, 0);
+    DMTimerReloadSet(SOC_DMTIMER_4_REGS, 0);
+    DMTimerModeConfigure(SOC_DMTIMER_4_REGS, DMTIMER_AUTORLD_CMP_ENABLE);
+    DMTimerEnable(SOC_DMTIMER_4_REGS);
+
+    TimerCalibrate();
+    TimerDeadlineSetup();
+}
+
+static double HostNanoseconds(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec * 1e9 + (double) ts.tv_nsec;
+}
+
+// Whether the decoded response is what the model sent; the model works in counts of the 14 bit field
+static int PositionMatches(const OrbisResponse* response, const SimOrbis* orbis)
+{
+    if (response->position != orbis->lastPosition >> (14 - ORBIS_RESOLUTION))
+        return 0;
+
+    return !ORBIS_MULTITURN || response->turns == orbis->lastTurns;
+}
+
+// Interrupt handler of another peripheral, which keeps the IRQ handlers waiting for otherTicks
+static void OtherIsr(void)
+{
+    uint32_t start = TIME;
+
+    DMTimerIntStatusClear(SOC_DMTIMER_5_REGS, DMTIMER_INT_OVF_IT_FLAG);
+    while ((TIME - start) < otherTicks);
+}
+
+static void OtherSetup(void)
+{
+    IntRegister(SYS_INT_TINT5, OtherIsr);
+    IntPrioritySet(SYS_INT_TINT5, 0, AINTC_HOSTINT_ROUTE_IRQ);
+    IntSystemEnable(SYS_INT_TINT5);
+
+    DMTimerReloadSet(SOC_DMTIMER_5_REGS, 0u - OTHER_PERIOD);
+    DMTimerCounterSet(SOC_DMTIMER_5_REGS, 0u - OTHER_PERIOD);
+    DMTimerModeConfigure(SOC_DMTIMER_5_REGS, DMTIMER_AUTORLD_NOCMP_ENABLE);
+    DMTimerIntEnable(SOC_DMTIMER_5_REGS, DMTIMER_INT_OVF_EN_FLAG);
+    DMTimerEnable(SOC_DMTIMER_5_REGS);
+}
+
+//
+// A capture of orbisEncoder polled with IRQ disabled, from the time its request is out until it
+// times out. The completion interrupt is raised on the way, and is left pending, or taken from FIQ
+// and handed on to IRQ level. Returns 1 if anything completes the capture after it has timed out.
+//
+static int RunStaleCapture(void)
+{
+    uint32_t txWords = simMcSPITxWords;
+    unsigned char irq;
+
+    OrbisCaptureStart(ORBIS_CAPTURE_TIMEOUT_DEFAULT, NULL);
+    while (simMcSPITxWords == txWords && OrbisCapturePoll() == ORBIS_CAPTURE_BUSY);
+
+    irq = IntDisable();
+    while (OrbisCapturePoll() == ORBIS_CAPTURE_BUSY);
+    IntEnable(irq);
+
+    return orbisEncoder.captureState != ORBIS_CAPTURE_TIMEOUT;
+}
+
+// One blocking capture after another, every one checked against the encoder model
+static int RunCaptures(void)
+{
+    uint32_t ok = 0, crcFail = 0, timeouts = 0, undetected = 0, spurious = 0, stale = 0, late = 0;
+    uint32_t calls = simMcSPICalls, interrupts = simInterruptsTaken, txWords = simMcSPITxWords;
+    uint32_t statusReads = simMcSPIStatusReads;
+    uint64_t ticks = simTicks;
+    double t0 = HostNanoseconds();
+    double elapsed;
+
+    for (uint32_t i = 0; i < captures; i++) {
+        uint32_t bitErrors;
+        uint32_t violations;
+        uint8_t result;
+        OrbisResponse response;
+
+        if (degradedClockHz != 0 && i == captures / 2)
+            encoder.maxClockHz = degradedClockHz;
+
+        if (staleEvery != 0 && i % staleEvery == staleEvery - 1) {
+            stale++;
+            if (RunStaleCapture()) {
+                late++;
+                if (!quiet)
+                    printf("capture %u: timed out with IRQ disabled, then completed\n", i);
+            }
+            continue;
+        }
+
+        bitErrors = encoder.bitErrors;
+        violations = encoder.violations;
+        result = OrbisCaptureGet();
+
+        if (calibrate && OrbisWatchdogUpdate(&watchdog, result))
+            printf("capture %u: watchdog falls back to %u Hz, CS setup %u ticks\n",
+                   i, orbisEncoder.clockHz, orbisEncoder.csDelay);
+
+        if (ORBIS_TIMEOUT == result) {
+            timeouts++;
+            continue;
+        }
+
+        OrbisDecode(ORBIS_REQ_POSITION, orbisEncoder.dataRx, &response);
+
+        if (ORBIS_CRC_OK == result) {
+            ok++;
+            if (!PositionMatches(&response, &encoder)) {
+                undetected++;
+                if (!quiet)
+                    printf("capture %u: position %u passed the CRC, encoder sent %u\n",
+                           i, response.position, encoder.lastPosition);
+            }
+        } else {
+            crcFail++;
+            if (bitErrors == encoder.bitErrors && violations == encoder.violations)
+                spurious++;
+        }
+    }
+
+    elapsed = HostNanoseconds() - t0;
+
+    printf("captures:           %u\n", captures);
+    printf("  CRC OK:           %u\n", ok);
+    printf("  CRC fail:         %u (%u with no fault injected)\n", crcFail, spurious);
+    printf("  timeout:          %u\n", timeouts);
+    printf("  undetected:       %u\n", undetected);
+    if (staleEvery != 0)
+        printf("  with IRQ off:     %u timed out, %u of them completed after that\n", stale, late);
+    printf("encoder:            %u frames, %u bits flipped, %u stalls, %u late, %u timing violations\n",
+           encoder.frames, encoder.bitErrors, encoder.stalls, encoder.lates, encoder.violations);
+    printf("per capture:        %.0f ns host, %.1f McSPI calls, %.1f interrupts, %.2f us simulated\n",
+           elapsed / captures, (double) (simMcSPICalls - calls) / captures,
+           (double) (simInterruptsTaken - interrupts) / captures,
+           (double) (simTicks - ticks) / TIMER_1US / captures);
+
+    calls = (simMcSPICalls - calls) - (simMcSPIStatusReads - statusReads);
+    if (maxCalls != 0 && (double) calls / captures > maxCalls) {
+        printf("McSPI calls:        %.1f per capture less the status reads, more than %.1f\n",
+               (double) calls / captures, maxCalls);
+        return 1;
+    }
+
+    // Every capture writes its request to the Tx FIFO once, and only once
+    txWords = simMcSPITxWords - txWords;
+    if (txWords != captures * orbisFrames[ORBIS_REQ_POSITION].length) {
+        printf("Tx FIFO:            %u words written, %u expected\n", txWords,
+               captures * orbisFrames[ORBIS_REQ_POSITION].length);
+        return 1;
+    }
+
+    return (undetected == 0 && late == 0 && (spurious == 0 || degradedClockHz != 0)) ? 0 : 1;
+}
+
+// Bursts of burstFrames frames, every frame checked against the trajectory of the encoder model
+static int RunBursts(void)
+{
+    uint32_t ok = 0, crcFail = 0, timeouts = 0, undetected = 0, spurious = 0, failures = 0;
+    uint32_t calls = simMcSPICalls - simMcSPIStatusReads, frames = encoder.frames;
+    OrbisBurstFrame* burst = calloc(burstFrames, sizeof(*burst));
+    uint32_t start;
+    uint64_t startTicks, ticks;
+    double t0, elapsed, burstTicks, singleTicks, burstCalls, singleCalls;
+
+    if (burst == NULL) {
+        perror("calloc");
+        return 1;
+    }
+
+    // The CS assertion of a frame is as long after this as its timestamp is after start
+    start = TIME;
+    startTicks = simTicks;
+
+    ticks = simTicks;
+    t0 = HostNanoseconds();
+    encoder.csHighMin = UINT64_MAX;
+    encoder.csHighMax = 0;
+
+    for (uint32_t done = 0; done < captures; done += burstFrames) {
+        uint32_t n = (captures - done < burstFrames) ? captures - done : burstFrames;
+        uint32_t bitErrors = encoder.bitErrors, violations = encoder.violations, failed = 0;
+
+        // Only the CS high time in between the frames of a burst counts
+        encoder.deselected = 0;
+        OrbisBurstGet(burst, n);
+
+        for (uint32_t i = 0; i < n; i++) {
+            uint64_t selected = startTicks + (uint32_t) (burst[i].timestamp - start);
+            uint32_t expected = SimOrbisPosition(&encoder, selected) >> (14 - ORBIS_RESOLUTION);
+            OrbisResponse response;
+
+            if (ORBIS_TIMEOUT == burst[i].crc) {
+                timeouts++;
+                continue;
+            }
+            if (ORBIS_CRC_OK != burst[i].crc) {
+                crcFail++;
+                failed++;
+                continue;
+            }
+
+            ok++;
+            OrbisDecode(ORBIS_REQ_POSITION, burst[i].data, &response);
+            if (response.position != expected) {
+                undetected++;
+                if (!quiet)
+                    printf("capture %u: position %u passed the CRC, encoder sent %u\n",
+                           done + i, response.position, expected);
+            }
+        }
+
+        if (failed != 0 && bitErrors == encoder.bitErrors && violations == encoder.violations)
+            spurious += failed;
+    }
+
+    elapsed = HostNanoseconds() - t0;
+    burstTicks = (double) (simTicks - ticks);
+    burstCalls = (double) (simMcSPICalls - simMcSPIStatusReads - calls);
+
+    printf("captures:           %u, in bursts of %u\n", captures, burstFrames);
+    printf("  CRC OK:           %u\n", ok);
+    printf("  CRC fail:         %u (%u with no fault injected)\n", crcFail, spurious);
+    printf("  timeout:          %u\n", timeouts);
+    printf("  undetected:       %u\n", undetected);
+    printf("encoder:            %u frames, %u bits flipped, %u stalls, %u late, %u timing violations\n",
+           encoder.frames, encoder.bitErrors, encoder.stalls, encoder.lates, encoder.violations);
+    printf("per frame:          %.0f ns host, %.1f McSPI calls besides the status polls, %.2f us simulated\n",
+           elapsed / captures, burstCalls / captures, burstTicks / TIMER_1US / captures);
+
+    if (encoder.frames - frames != captures) {
+        printf("%u CS assertions for %u frames\n", encoder.frames - frames, captures);
+        failures++;
+    }
+
+    // Orbis takes a frame as one only if CS has been high for ORBIS_BURST_GAP before it, and
+    // any longer than that is time the burst loses
+    if (encoder.csHighMax != 0) {
+        printf("CS high in a burst: %.2f to %.2f us\n", (double) encoder.csHighMin / TIMER_1US,
+               (double) encoder.csHighMax / TIMER_1US);
+        if (encoder.csHighMin < ORBIS_BURST_GAP || encoder.csHighMax > ORBIS_BURST_GAP + BURST_GAP_SLACK) {
+            printf("CS high in a burst: not within %.2f and %.2f us\n", (double) ORBIS_BURST_GAP / TIMER_1US,
+                   (double) (ORBIS_BURST_GAP + BURST_GAP_SLACK) / TIMER_1US);
+            failures++;
+        }
+    }
+
+    // The same number of single captures, polled as the bursts are, for the comparison. The simulation
+    // gives the register accesses no time, so what the bursts save shows in the calls, not in the time.
+    calls = simMcSPICalls - simMcSPIStatusReads;
+    ticks = simTicks;
+    for (uint32_t i = 0; i < captures; i++)
+        OrbisEncoderRequestPolled(&orbisEncoder, ORBIS_REQ_POSITION, ORBIS_CAPTURE_TIMEOUT_DEFAULT);
+    singleTicks = (double) (simTicks - ticks);
+    singleCalls = (double) (simMcSPICalls - simMcSPIStatusReads - calls);
+
+    printf("single polled:      %.1f McSPI calls besides the status polls, %.2f us simulated\n",
+           singleCalls / captures, singleTicks / TIMER_1US / captures);
+
+    if (burstFrames > 1 && burstCalls >= singleCalls) {
+        printf("bursts take no fewer McSPI calls a frame than single captures\n");
+        failures++;
+    }
+
+    free(burst);
+
+    return (undetected == 0 && spurious == 0 && failures == 0) ? 0 : 1;
+}
+
+// Blocking captures through the failure recovery, every position handed out checked
+static int RunRecovery(void)
+{
+    uint32_t wrong = 0, overruns = 0;
+    uint32_t maxTicks = 0;
+    uint8_t hasFresh = 0;
+    OrbisPosition fresh = { 0 };
+    uint32_t freshTime = 0;
+
+    OrbisRecoveryInit(&recovery, &orbisEncoder, recoveryBudget, ORBIS_RECOVERY_ESCALATE_DEFAULT);
+
+    for (uint32_t i = 0; i < captures; i++) {
+        OrbisRecoverySample sample;
+        uint64_t t0;
+        uint32_t ticks;
+        uint8_t state;
+
+        if (outageFrames != 0 && i == captures / 2) {
+            encoder.outageStart = encoder.frames;
+            encoder.outageFrames = outageFrames;
+        }
+
+        t0 = simTicks;
+        state = OrbisRecoveryCapture(&recovery, &sample);
+        ticks = (uint32_t) (simTicks - t0);
+
+        if (ticks > maxTicks)
+            maxTicks = ticks;
+        if (ticks > recoveryBudget + RECOVERY_SLACK)
+            overruns++;
+
+        if (ORBIS_RECOVERY_FRESH == state) {
+            if (sample.position.position != encoder.lastPosition >> (14 - ORBIS_RESOLUTION) ||
+                (ORBIS_MULTITURN && sample.position.turns != encoder.lastTurns) || sample.position.error) {
+                wrong++;
+                if (!quiet)
+                    printf("capture %u: fresh position %u, encoder sent %u\n",
+                           i, sample.position.position, encoder.lastPosition);
+            }
+            fresh = sample.position;
+            freshTime = sample.timestamp;
+            hasFresh = 1;
+        } else if (ORBIS_RECOVERY_HELD == state) {
+            if (!hasFresh || sample.position.position != fresh.position ||
+                sample.position.turns != fresh.turns || sample.timestamp != freshTime) {
+                wrong++;
+                if (!quiet)
+                    printf("capture %u: held position %u, last fresh %u\n",
+                           i, sample.position.position, fresh.position);
+            }
+        } else if (hasFresh) {
+            wrong++;
+        }
+
+        if (!quiet && sample.escalated && recovery.consecutive == recovery.escalateAfter)
+            printf("capture %u: %u failed captures in a row, escalated\n", i, recovery.consecutive);
+    }
+
+    OrbisRecoveryReport(&recovery);
+    printf("encoder:            %u frames, %u bits flipped, %u stalls, %u late, %u errors\n",
+           encoder.frames, encoder.bitErrors, encoder.stalls, encoder.lates, encoder.errors);
+    printf("longest capture:    %.2f us simulated, budget %.2f us\n",
+           (double) maxTicks / TIMER_1US, (double) recoveryBudget / TIMER_1US);
+    printf("wrong positions:    %u\n", wrong);
+    printf("over budget:        %u\n", overruns);
+
+    return (wrong == 0 && overruns == 0) ? 0 : 1;
+}
+
+// Tasks of RunScheduled(), in scheduler ticks of ORBIS_SCHED_TICK_DEFAULT as in main.c
+static void SchedCaptureTask(void* context);
+static void SchedEstimatorTask(void* context);
+static void SchedLoadTask(void* context);
+static void SchedIdleTask(void* context);
+
+static OrbisTask schedTasks[] = {
+    { .name = "capture", .function = SchedCaptureTask, .period = 10, .phase = 0, .priority = 0 },
+    { .name = "estim", .function = SchedEstimatorTask, .period = 10, .phase = 5, .priority = 1 },
+    { .name = "load", .function = SchedLoadTask, .period = 100, .phase = 3, .priority = 2 },
+    { .name = "idle", .function = SchedIdleTask, .period = 50, .phase = 0, .priority = 3 },
+};
+
+#define SCHED_TASK_COUNT                (sizeof(schedTasks) / sizeof(schedTasks[0]))
+
+static void SchedCaptureTask(void* context)
+{
+    OrbisRecoverySample sample;
+
+    OrbisRecoveryCapture(&recovery, &sample);
+}
+
+static void SchedEstimatorTask(void* context)
+{
+    OrbisEstimate estimate;
+
+    OrbisEstimatorAt(&estimator, TIME, 5 * TIMER_1MS, &estimate);
+}
+
+static void SchedLoadTask(void* context)
+{
+    if (loadTicks != 0)
+        waitfor(loadTicks);
+}
+
+static void SchedIdleTask(void* context)
+{
+}
+
+// Blocking captures as the task of the scheduler, with the timing of every task checked
+static int RunScheduled(void)
+{
+    static OrbisScheduler sched;
+    OrbisTask* capture = &schedTasks[0];
+    OrbisTask* load = &schedTasks[2];
+    uint32_t failures = 0;
+    uint32_t blocking = 0;
+    uint32_t elapsed, minOverruns, maxOverruns;
+#if ORBIS_LOAD
+    OrbisLoadTimes times;
+#endif
+
+    OrbisRecoveryInit(&recovery, &orbisEncoder, recoveryBudget, ORBIS_RECOVERY_ESCALATE_DEFAULT);
+    OrbisEstimatorInit(&estimator, ORBIS_ESTIMATOR_THETA);
+    orbisEncoder.estimator = &estimator;
+
+    OrbisSchedInit(&sched, ORBIS_SCHED_TICK_DEFAULT);
+    for (uint32_t i = 0; i < SCHED_TASK_COUNT; i++)
+        OrbisSchedAdd(&sched, &schedTasks[i]);
+
+#if ORBIS_LOAD
+    OrbisLoadStart();
+#endif
+    OrbisSchedStart(&sched);
+
+    // The main loop of main.c
+    while (capture->runs < captures) {
+        if (!OrbisSchedRun(&sched))
+            OrbisSchedIdle(&sched);
+    }
+
+    OrbisSchedStop(&sched);
+#if ORBIS_LOAD
+    OrbisLoadGet(&times);
+#endif
+    orbisEncoder.estimator = NULL;
+    elapsed = TIME - sched.startTime;
+
+    if (!quiet)
+        OrbisSchedReport(&sched);
+    OrbisRecoveryReport(&recovery);
+#if ORBIS_LOAD
+    OrbisLoadReport(&times);
+#endif
+
+    // The ticks keep up with the timer
+    if (sched.ticks != elapsed / sched.tickPeriod) {
+        printf("scheduler: %u ticks in %u timer ticks, expected %u\n",
+               sched.ticks, elapsed, elapsed / sched.tickPeriod);
+        failures++;
+    }
+
+    for (uint32_t i = 0; i < SCHED_TASK_COUNT; i++) {
+        OrbisTask* task = &schedTasks[i];
+        uint32_t released = (sched.ticks < task->phase) ? 0 : (sched.ticks - task->phase) / task->period + 1;
+
+        // Every release has been run or counted as missed, but for the one that may be waiting now
+        if (task->runs + task->overruns != released && task->runs + task->overruns + 1 != released) {
+            printf("scheduler: %s released %u times, %u runs and %u overruns\n",
+                   task->name, released, task->runs, task->overruns);
+            failures++;
+        }
+
+        if (task != capture && task->execMax > blocking)
+            blocking = task->execMax;
+    }
+
+    // A task that has started runs to completion, so the capture waits for one of them at the most
+    if (capture->latenessMax > blocking + SCHED_SLACK) {
+        printf("scheduler: capture started up to %u ticks late, the longest other task takes %u\n",
+               capture->latenessMax, blocking);
+        failures++;
+    }
+
+    // A long load task makes the capture miss the releases that come while it runs, and only those
+    minOverruns = (loadTicks < TIMER_1MS) ? 0 : load->runs * (loadTicks / (capture->period * sched.tickPeriod) - 1);
+    maxOverruns = (loadTicks < TIMER_1MS) ? 0 : load->runs * (loadTicks / (capture->period * sched.tickPeriod) + 1);
+    if (capture->overruns < minOverruns || capture->overruns > maxOverruns) {
+        printf("scheduler: capture missed %u releases, expected %u to %u\n",
+               capture->overruns, minOverruns, maxOverruns);
+        failures++;
+    }
+
+#if ORBIS_LOAD
+    // Every share of the time is accounted for, and no more than there was
+    if (times.capture + times.isr + times.idle > times.elapsed || times.idle == 0) {
+        printf("load: capture %llu, ISR %llu, idle %llu ticks out of %llu\n",
+               (unsigned long long) times.capture, (unsigned long long) times.isr,
+               (unsigned long long) times.idle, (unsigned long long) times.elapsed);
+        failures++;
+    }
+
+    // The capture time is spent in the capture task, and is what is left of it after the sleep and the ISRs
+    if (times.capture > capture->execTotal) {
+        printf("load: capture %llu ticks, the capture task took %llu\n",
+               (unsigned long long) times.capture, (unsigned long long) capture->execTotal);
+        failures++;
+    }
+
+    // The load task spins, so its time is application time
+    if (times.application < load->execTotal) {
+        printf("load: application %llu ticks, the load task took %llu\n",
+               (unsigned long long) times.application, (unsigned long long) load->execTotal);
+        failures++;
+    }
+#endif
+
+    printf("scheduler:          %u ticks, capture jitter %.2f us, %u overruns, load %u runs\n",
+           sched.ticks, (double) OrbisSchedJitter(capture) / TIMER_1US, capture->overruns, load->runs);
+    printf("scheduler failures: %u\n", failures);
+
+    return (failures == 0) ? 0 : 1;
+}
+
+// Calibrate orbisEncoder and print the failures at every step of the sweep
+static int RunCalibration(void)
+{
+    static OrbisCalibration calibration;
+    uint8_t result = OrbisCalibrate(&orbisEncoder, 50, &calibration);
+
+    printf("calibration, failures in %u captures:\n%10s", calibration.captures, "Hz \\ us");
+    for (uint32_t d = 0; d < ORBIS_CALIB_DELAYS; d++)
+        printf("%7.1f", (double) orbisCalibDelays[d] / TIMER_1US);
+    printf("\n");
+
+    for (uint32_t c = 0; c < ORBIS_CALIB_CLOCKS; c++) {
+        printf("%10u", orbisCalibClocks[c]);
+        for (uint32_t d = 0; d < ORBIS_CALIB_DELAYS; d++)
+            printf("%7u", calibration.failures[c][d]);
+        printf("\n");
+    }
+
+    if (result != ORBIS_CRC_OK) {
+        printf("no reliable profile\n");
+        return 1;
+    }
+
+    OrbisProfileSave(&orbisEncoder);
+    printf("profile:            %u Hz, CS setup %u ticks\n", orbisEncoder.clockHz, orbisEncoder.csDelay);
+
+    // Saved and restored, as over a reset
+    orbisEncoder.clockHz = 0;
+    if (OrbisProfileRestore(&orbisEncoder) != ORBIS_CRC_OK || orbisEncoder.clockHz != calibration.profile.clockHz) {
+        printf("profile not restored\n");
+        return 1;
+    }
+
+    OrbisWatchdogInit(&watchdog, &orbisEncoder);
+
+    return 0;
+}
+
+// Sweeps over all the encoders, each checked against its model
+static int RunSweeps(void)
+{
+    uint32_t ok = 0, failed = 0, undetected = 0;
+    uint32_t frames = 0, bitErrors = 0, stalls = 0, lates = 0;
+    uint64_t ticks = simTicks;
+    double t0 = HostNanoseconds();
+    double elapsed;
+
+    for (uint32_t n = 0; n < captures; n++) {
+        ok += OrbisEncoderCaptureAll(handles, encoderCount, ORBIS_CAPTURE_TIMEOUT_DEFAULT);
+
+        for (uint32_t i = 0; i < encoderCount; i++) {
+            OrbisResponse response;
+
+            if (handles[i]->captureState != ORBIS_CAPTURE_DONE || handles[i]->captureCRC != ORBIS_CRC_OK) {
+                failed++;
+                continue;
+            }
+
+            OrbisDecode(ORBIS_REQ_POSITION, handles[i]->dataRx, &response);
+            if (!PositionMatches(&response, &models[i]))
+                undetected++;
+        }
+    }
+
+    elapsed = HostNanoseconds() - t0;
+
+    for (uint32_t i = 0; i < encoderCount; i++) {
+        frames += models[i].frames;
+        bitErrors += models[i].bitErrors;
+        stalls += models[i].stalls;
+        lates += models[i].lates;
+    }
+
+    printf("sweeps:             %u over %u encoders\n", captures, encoderCount);
+    printf("  CRC OK:           %u\n", ok);
+    printf("  failed:           %u\n", failed);
+    printf("  undetected:       %u\n", undetected);
+    printf("encoders:           %u frames, %u bits flipped, %u stalls, %u late\n",
+           frames, bitErrors, stalls, lates);
+    printf("per sweep:          %.0f ns host, %.2f us simulated\n",
+           elapsed / captures, (double) (simTicks - ticks) / TIMER_1US / captures);
+
+    return (undetected == 0) ? 0 : 1;
+}
+
+// Continuous acquisition into the sample ring buffer, drained as the application would
+//
+// Check the estimates of the sample against the encoder trajectory. Returns 1 if they are
+// out of tolerance, and keeps the worst errors, relative to the tolerance.
+//
+static double worstVelocity, worstAcceleration, worstPosition;
+
+static int CheckEstimate(const OrbisSample* sample)
+{
+    // The estimates are in counts of ORBIS_RESOLUTION bits, the model in counts of 14 bits
+    double scale = (double) (1u << (14 - ORBIS_RESOLUTION));
+    uint8_t resolution = encoder.resolution < ORBIS_RESOLUTION ? encoder.resolution : ORBIS_RESOLUTION;
+    double t = (double) sample->timestamp / SIM_CLOCK_HZ;
+    double velocity = (double) encoder.velocity + (double) encoder.acceleration * t;
+    double acceleration = (double) encoder.acceleration;
+    double quantum = (double) (1u << (14 - resolution));
+    double vError = fabs(sample->velocity * scale - velocity) /
+                    (ESTIMATOR_VELOCITY_FLOOR * quantum + ESTIMATOR_RELATIVE * fabs(velocity));
+    double aError = fabs(sample->acceleration * scale - acceleration) /
+                    (ESTIMATOR_ACCELERATION_FLOOR * quantum + ESTIMATOR_RELATIVE * fabs(acceleration));
+
+    if (vError > worstVelocity)
+        worstVelocity = vError;
+    if (aError > worstAcceleration)
+        worstAcceleration = aError;
+
+    return (vError > 1.0 || aError > 1.0);
+}
+
+//
+// Check the position estimated for the query time against the encoder trajectory. The query
+// is anywhere from a sample period before the last sample to a sample period after it.
+// Returns 1 if the estimate is out of tolerance, and counts the queries left unanswered.
+//
+static uint32_t unanswered;
+
+static int CheckQuery(uint32_t query)
+{
+    OrbisEstimate estimate;
+    double scale = (double) (1u << (14 - ORBIS_RESOLUTION));
+    uint8_t resolution = encoder.resolution < ORBIS_RESOLUTION ? encoder.resolution : ORBIS_RESOLUTION;
+    double t = (double) query / SIM_CLOCK_HZ;
+    double counts = (double) encoder.startCounts + (double) encoder.velocity * t
+                  + (double) encoder.acceleration * t * t / 2;
+    double error;
+
+    if (OrbisEstimatorAt(&estimator, query, 2 * acquisitionPeriod * TIMER_1US, &estimate) != ORBIS_ESTIMATOR_VALID) {
+        unanswered++;
+        return 0;
+    }
+
+    // Single-turn, so the difference is taken the shortest way round
+    error = fmod((double) estimate.position / 65536.0 * scale - counts, SIM_ORBIS_COUNTS);
+    if (error > SIM_ORBIS_COUNTS / 2)
+        error -= SIM_ORBIS_COUNTS;
+    if (error < -SIM_ORBIS_COUNTS / 2)
+        error += SIM_ORBIS_COUNTS;
+    error = fabs(error) / (ESTIMATOR_POSITION_FLOOR * (double) (1u << (14 - resolution)));
+
+    if (error > worstPosition)
+        worstPosition = error;
+
+    return error > 1.0;
+}
+
+// Whether the interval between two samples is not the acquisition period, give or take the
+// ACQUISITION_SLACK
+static int OffPeriod(uint32_t interval)
+{
+    uint32_t period = acquisitionPeriod * TIMER_1US;
+
+    return interval + ACQUISITION_SLACK < period || interval > period + ACQUISITION_SLACK;
+}
+
+// Whether the sample carries the position of its frame, decoded, or nothing if the CRC failed
+static int SampleDecoded(OrbisSample* sample)
+{
+    OrbisResponse response = { 0 };
+
+    if (ORBIS_CRC_OK == sample->crc)
+        OrbisDecode(ORBIS_REQ_POSITION, sample->data, &response);
+
+    return sample->position == response.position && sample->turns == response.turns &&
+           sample->error == response.error && sample->warning == response.warning;
+}
+
+static int RunAcquisition(void)
+{
+    OrbisSample samples[64];
+    uint32_t collected = 0, crcFail = 0, jitter = 0, offEstimates = 0, offQueries = 0, queries = 0;
+    uint32_t undecoded = 0, last = 0;
+    double t0 = HostNanoseconds();
+    double elapsed;
+
+    if (telemetry != NULL) {
+        SimUARTCapture(telemetry);
+        OrbisTelemetrySetup();
+    }
+
+    if (estimate) {
+        OrbisEstimatorInit(&estimator, ORBIS_ESTIMATOR_THETA);
+        orbisEncoder.estimator = &estimator;
+    }
+
+    OrbisAcquisitionStart(acquisitionPeriod * TIMER_1US);
+
+    while (collected < captures) {
+        uint32_t n;
+
+        SimAdvance(TIMER_100US);
+
+        n = OrbisRingRead(samples, 64);
+        for (uint32_t i = 0; i < n && collected < captures; i++) {
+            if (ORBIS_CRC_FAIL == samples[i].crc)
+                crcFail++;
+            if (!SampleDecoded(&samples[i]))
+                undecoded++;
+            if (collected > 0 && OffPeriod(samples[i].timestamp - last))
+                jitter++;
+            last = samples[i].timestamp;
+            collected++;
+
+            if (estimate && collected > ESTIMATOR_SETTLE && ORBIS_CRC_OK == samples[i].crc)
+                offEstimates += CheckEstimate(&samples[i]);
+
+            if (telemetry != NULL)
+                OrbisTelemetryPut(samples[i].timestamp, ORBIS_TELEMETRY_VALUE(samples[i].position, samples[i].turns),
+                                  ORBIS_TELEMETRY_STATUS(samples[i].crc, 0));
+        }
+
+        // As a control loop on its own timer would ask, at some time near the last sample
+        if (estimate && collected > ESTIMATOR_SETTLE) {
+            uint32_t period = acquisitionPeriod * TIMER_1US;
+            offQueries += CheckQuery(last - period + (queries * 7919u) % (2 * period));
+            queries++;
+        }
+
+        if (telemetry != NULL)
+            OrbisTelemetryPoll();
+    }
+
+    OrbisAcquisitionStop();
+
+    // Let the last frames out
+    if (telemetry != NULL) {
+        do {
+            OrbisTelemetryPoll();
+            SimAdvance(TIMER_100US);
+        } while (OrbisTelemetryPending() > 0);
+        SimAdvance(TIMER_100US);
+    }
+
+    elapsed = HostNanoseconds() - t0;
+
+    printf("samples:            %u every %u us\n", collected, acquisitionPeriod);
+    printf("  CRC fail:         %u\n", crcFail);
+    printf("  not decoded:      %u\n", undecoded);
+    printf("  off period:       %u\n", jitter);
+    printf("  trigger overruns: %u\n", orbisTriggerOverruns);
+    printf("  ring overruns:    %u\n", orbisRingOverruns);
+    printf("encoder:            %u frames, %u bits flipped, %u stalls, %u late, %u timing violations\n",
+           encoder.frames, encoder.bitErrors, encoder.stalls, encoder.lates, encoder.violations);
+    if (estimate) {
+        printf("estimator:          %u off, worst %.2f of the velocity and %.2f of the acceleration tolerance\n",
+               offEstimates, worstVelocity, worstAcceleration);
+        printf("  last estimate:    %d counts/s, %d counts/s2\n",
+               samples[0].velocity, samples[0].acceleration);
+        printf("  queries:          %u, %u off, %u unanswered, worst %.2f of the position tolerance\n",
+               queries, offQueries, unanswered, worstPosition);
+    }
+    if (telemetry != NULL) {
+        printf("telemetry:          %u frames, %u bytes, %u records dropped, %u bytes lost\n",
+               orbisTelemetryFrames, simUARTBytes, orbisTelemetryDropped, simUARTOverflows);
+    }
+    printf("per sample:         %.0f ns host\n", elapsed / collected);
+
+    // The loop above takes up to 64 samples every 100 us, so the ring only fills up if the
+    // period is shorter than that allows
+    if (orbisRingOverruns > 0 && acquisitionPeriod * 64 >= 100) {
+        printf("ring:               %u samples dropped, none expected\n", orbisRingOverruns);
+        return 1;
+    }
+
+    if (undecoded > 0) {
+        printf("acquisition:        %u samples without the position of their frame\n", undecoded);
+        return 1;
+    }
+
+    // Without a fault from the encoder, every sample must pass the CRC and come on time
+    if (encoder.bitErrors == 0 && encoder.stalls == 0 && encoder.lates == 0 && encoder.violations == 0 &&
+        (crcFail > 0 || jitter > 0 || orbisTriggerOverruns > 0)) {
+        printf("acquisition:        %u CRC fails, %u off period, %u trigger overruns, with no fault injected\n",
+               crcFail, jitter, orbisTriggerOverruns);
+        return 1;
+    }
+
+    return (offEstimates > 0 || offQueries > 0) ? 1 : 0;
+}
+
+// Check waitfor() and the deadlines against the simulated counter
+static int RunTimerSelfTest(void)
+{
+    TimerSelfTestResult results[TIMER_SELF_TEST_DELAYS];
+    uint8_t failures = TimerSelfTest(results);
+
+    if (!quiet || failures) {
+        printf("timer: counter read %u ticks\n", timerReadTicks);
+        for (uint32_t i = 0; i < TIMER_SELF_TEST_DELAYS; i++) {
+            printf("timer: %5u ticks requested, waitfor %5u, deadline %5u\n",
+                   results[i].requested, results[i].waited, results[i].deadline);
+        }
+    }
+
+    if (failures) {
+        printf("Delay timer self-test failed\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    int opt;
+    int result;
+
+    encoder.multiturn = ORBIS_MULTITURN;
+    encoder.velocity = 1000;
+    encoder.lateTicks = 50 * TIMER_1US;
+
+    while ((opt = getopt(argc, argv, "n:v:A:r:e:s:l:L:f:w:x:O:Rb:S:B:P:I:M:c:a:E:CD:T:W:Vq")) != -1) {
+        switch (opt) {
+        case 'n': captures = (uint32_t) strtoul(optarg, NULL, 0); break;
+        case 'v': encoder.velocity = strtoll(optarg, NULL, 0); break;
+        case 'A': encoder.acceleration = strtoll(optarg, NULL, 0); break;
+        case 'r': encoder.resolution = (uint8_t) strtoul(optarg, NULL, 0); break;
+        case 'e': encoder.bitErrorRate = (uint32_t) strtoul(optarg, NULL, 0); break;
+        case 's': encoder.stallEvery = (uint32_t) strtoul(optarg, NULL, 0); break;
+        case 'l': encoder.lateEvery = (uint32_t) strtoul(optarg, NULL, 0); break;
+        case 'L': encoder.lateTicks = strtoull(optarg, NULL, 0) * TIMER_1US; break;
+        case 'f': encoder.maxClockHz = (uint32_t) strtoul(optarg, NULL, 0); break;
+        case 'w': simMcSPIEOWLead = (uint32_t) strtoul(optarg, NULL, 0); break;
+        case 'x': encoder.errorEvery = (uint32_t) strtoul(optarg, NULL, 0); break;
+        case 'O': outageFrames = (uint32_t) strtoul(optarg, NULL, 0); break;
+        case 'R': recover = 1; break;
+        case 'b': recoveryBudget = (uint32_t) strtoul(optarg, NULL, 0) * TIMER_1US; break;
+        case 'S':
+            schedule = 1;
+            loadTicks = (uint32_t) strtoul(optarg, NULL, 0) * TIMER_1US;
+            break;
+        case 'B': burstFrames = (uint32_t) strtoul(optarg, NULL, 0); break;
+        case 'P': staleEvery = (uint32_t) strtoul(optarg, NULL, 0); break;
+        case 'I': otherTicks = (uint32_t) strtoul(optarg, NULL, 0) * TIMER_1US; break;
+        case 'M': maxRxWait = strtod(optarg, NULL); break;
+        case 'c': maxCalls = strtod(optarg, NULL); break;
+        case 'a': acquisitionPeriod = (uint32_t) strtoul(optarg, NULL, 0); break;
+        case 'E': encoderCount = (uint32_t) strtoul(optarg, NULL, 0); break;
+        case 'C': calibrate = 1; break;
+        case 'D': degradedClockHz = (uint32_t) strtoul(optarg, NULL, 0); break;
+        case 'T':
+            telemetry = fopen(optarg, "wb");
+            if (telemetry == NULL) {
+                perror(optarg);
+                return 2;
+            }
+            break;
+        case 'W':
+#if !ORBIS_RECORD
+            fprintf(stderr, "%s: built without the capture recorder, ORBIS_RECORD\n", argv[0]);
+            return 2;
+#endif
+            recording = fopen(optarg, "wb");
+            if (recording == NULL) {
+                perror(optarg);
+                return 2;
+            }
+            break;
+        case 'V': estimate = 1; break;
+        case 'q': quiet = 1; break;
+        default:
+            fprintf(stderr, "usage: %s [-n count] [-v counts/s] [-A counts/s2] [-r bits] [-e n] [-s n]"
+                            " [-l n] [-L us] [-f Hz] [-w ticks] [-x n] [-O frames] [-R] [-b us] [-S us] [-B frames] [-P n] [-I us] [-M us]"
+                            " [-c calls] [-a us] [-E count] [-C] [-D Hz] [-T file] [-W file] [-V] [-q]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if (captures == 0 || encoderCount == 0 || encoderCount > ENCODERS_MAX)
+        return 0;
+
+    SimReset();
+    SetupAsTarget();
+    OrbisSetup();
+#if ORBIS_USE_FIQ
+    OrbisFIQSetup();
+#endif
+
+    // The others are the same encoder, somewhere else on the trajectory
+    for (uint32_t i = 0; i < encoderCount; i++) {
+        uint32_t bus = i % ORBIS_BUS_COUNT;
+        uint32_t channel = i / ORBIS_BUS_COUNT;
+
+        if (i > 0) {
+            models[i] = models[0];
+            models[i].startCounts += 1000 * i;
+            models[i].random += i;
+        }
+
+        SimOrbisInit(&models[i]);
+        SimMcSPIAttach(orbisBus[bus].base, channel, &models[i].device);
+
+        if (i == 0) {
+            handles[i] = &orbisEncoder;
+            continue;
+        }
+
+        if (channel == 0)
+            OrbisBusSetup(&orbisBus[bus]);
+        OrbisEncoderSetup(&encoders[i], &orbisBus[bus], channel);
+        handles[i] = &encoders[i];
+    }
+
+    if (OrbisCRCSelfTest() != ORBIS_CRC_OK) {
+        printf("Orbis CRC self-test failed\n");
+        return 1;
+    }
+
+    if (RunTimerSelfTest() != 0)
+        return 1;
+
+    if (calibrate && RunCalibration() != 0)
+        return 1;
+
+#if ORBIS_LATENCY
+    OrbisLatencySetup();
+#endif
+
+    if (otherTicks != 0)
+        OtherSetup();
+    simMcSPIRxWaitMax = 0;
+
+#if ORBIS_RECORD
+    if (recording != NULL)
+        OrbisRecordStart(ORBIS_RECORD_CONTINUOUS, 0);
+#endif
+
+    if (encoderCount > 1)
+        result = RunSweeps();
+    else if (acquisitionPeriod != 0)
+        result = RunAcquisition();
+    else if (schedule)
+        result = RunScheduled();
+    else if (burstFrames != 0)
+        result = RunBursts();
+    else
+        result = recover ? RunRecovery() : RunCaptures();
+
+    if (otherTicks != 0 || maxRxWait != 0) {
+        printf("Rx FIFO wait:       %.2f us at most\n", (double) simMcSPIRxWaitMax / TIMER_1US);
+        if (maxRxWait != 0 && simMcSPIRxWaitMax > maxRxWait * TIMER_1US) {
+            printf("Rx FIFO wait:       longer than %.2f us\n", maxRxWait);
+            result = 1;
+        }
+    }
+
+#if ORBIS_LATENCY
+    if (!quiet)
+        OrbisLatencyReport();
+#endif
+
+    if (telemetry != NULL)
+        fclose(telemetry);
+
+    if (recording != NULL) {
+#if ORBIS_RECORD
+        OrbisRecordStop();
+        printf("recording:          %u frames written, %u bytes\n",
+               orbisRecording.header.written, OrbisRecordLength());
+        fwrite(&orbisRecording, 1, OrbisRecordLength(), recording);
+#endif
+        fclose(recording);
+    }
+
+    return result;
+}
@@ -0,0 +1,199 @@
+/*
+ * orbis_spidev_sim.c
+ * Runs the Orbis spidev backend on the host against a stand-in spidev device
+ *
+ * The backend, linux/orbis_spidev.c, is built unchanged, with SimSpidevIoctl() in place
+ * of ioctl() and the Orbis encoder model on the chip select, see sim_spidev.c. The position
+ * is captured count times with a frame per SPI_IOC_MESSAGE, then again with batch frames
+ * to one, and each run is checked:
+ *
+ *   - every frame is a CS assertion of its own, and there is a system call per batch
+ *   - every frame with a good CRC has the position the model sent at its CS assertion
+ *   - no frame breaks the timing limits of the encoder
+ *   - with no faults injected, every CRC is good
+ *
+ * The throughput of each run is the frames per second of simulated time, which includes
+ * the cost of every system call, and the host time per frame is printed along with it.
+ *
+ * Usage: orbis-spidev-sim [options]
+ *   -n <count>     frames in each run (10000)
+ *   -b <n>         frames per message in the batched run, at most ORBIS_SPIDEV_BATCH_MAX (32)
+ *   -o <us>        cost of a system call with its SPI message set-up (20)
+ *   -g <us>        gap with CS deasserted after each frame (ORBIS_SPIDEV_GAP_DEFAULT)
+ *   -D <Hz>        SPI clock (ORBIS_SPIDEV_SPEED_DEFAULT)
+ *   -v <counts/s>  encoder velocity, counts of the 14 bit position per second (1000)
+ *   -e <n>         flip one bit in n (never)
+ *   -s <n>         stall every n-th frame (never)
+ *   -q             quiet, print the summary only
+ *
+ * Exits with 1 if a check fails, 2 if the stand-in cannot be set up.
+ *
+ *  Created on: 16 Oct 2026
+ */
+#include <stdint.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "orbis_protocol.h"
+#include "orbis_spidev.h"
+#include "sim.h"
+
+static SimOrbis encoder;
+static SimSpidev spidev;
+static uint8_t quiet;
+
+// Capture count frames, batch to a message, and check them. Returns the failures.
+static uint32_t SpidevRun(OrbisSpidev* dev, OrbisSpidevFrame* frames, uint64_t* selects,
+                          uint32_t count, uint32_t batch, uint8_t faults, double* framesPerSecond)
+{
+    uint32_t messages = spidev.messages;
+    uint32_t stalls = encoder.stalls;
+    uint32_t failures = 0, crcFailures = 0;
+    uint64_t start = spidev.time;
+    uint64_t hostStart, hostTime;
+    int captured;
+
+    spidev.frames = 0;
+    spidev.selectLog = selects;
+    spidev.selectLogLength = count;
+
+    hostStart = OrbisSpidevNow();
+    captured = OrbisSpidevCapture(dev, ORBIS_REQ_POSITION, frames, count, batch);
+    hostTime = OrbisSpidevNow() - hostStart;
+
+    if (captured != (int) count) {
+        printf("batch %u: %s\n", batch, (captured < 0) ? strerror(errno) : "capture cut short");
+        return 1;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t expected = SimOrbisPosition(&encoder, selects[i]) >> (14 - ORBIS_RESOLUTION);
+
+        if (ORBIS_CRC_OK != frames[i].crc) {
+            crcFailures++;
+            continue;
+        }
+
+        if (frames[i].response.position != expected || frames[i].response.error) {
+            if (!quiet || failures < 10)
+                printf("batch %u, frame %u: position %u%s, expected %u\n", batch, i,
+                       frames[i].response.position, frames[i].response.error ? " (error)" : "", expected);
+            failures++;
+        }
+    }
+
+    if (spidev.frames != count) {
+        printf("batch %u: %u CS assertions for %u frames\n", batch, spidev.frames, count);
+        failures++;
+    }
+    if (spidev.messages - messages != (count + batch - 1) / batch) {
+        printf("batch %u: %u system calls for %u frames\n", batch, spidev.messages - messages, count);
+        failures++;
+    }
+    if (encoder.violations != 0) {
+        printf("batch %u: %u frames break the timing limits of the encoder\n", batch, encoder.violations);
+        failures++;
+    }
+    if (!faults && crcFailures != 0) {
+        printf("batch %u: %u CRC failures with no faults injected\n", batch, crcFailures);
+        failures++;
+    }
+
+    *framesPerSecond = count * (double) SIM_CLOCK_HZ / (double) (spidev.time - start);
+
+    printf("batch %u: %u frames, %.0f frames/s, %.2f us/frame simulated, %.3f us/frame host, "
+           "%u syscalls, %u CRC failures (%u stalls)\n",
+           batch, count, *framesPerSecond, 1e6 / *framesPerSecond, hostTime / 1e3 / count,
+           spidev.messages - messages, crcFailures, encoder.stalls - stalls);
+
+    return failures;
+}
+
+int main(int argc, char* argv[])
+{
+    uint32_t count = 10000, batch = 32;
+    uint32_t speedHz = ORBIS_SPIDEV_SPEED_DEFAULT;
+    uint16_t gapUs = ORBIS_SPIDEV_GAP_DEFAULT;
+    uint32_t overheadUs = 20;
+    uint32_t failures;
+    double single, batched;
+    OrbisSpidevFrame* frames;
+    uint64_t* selects;
+    OrbisSpidev dev;
+    int fd, opt;
+
+    encoder.velocity = 1000;
+    encoder.resolution = ORBIS_RESOLUTION;
+    encoder.multiturn = ORBIS_MULTITURN;
+
+    while ((opt = getopt(argc, argv, "n:b:o:g:D:v:e:s:q")) != -1) {
+        switch (opt) {
+        case 'n': count = (uint32_t) strtoul(optarg, NULL, 0); break;
+        case 'b': batch = (uint32_t) strtoul(optarg, NULL, 0); break;
+        case 'o': overheadUs = (uint32_t) strtoul(optarg, NULL, 0); break;
+        case 'g': gapUs = (uint16_t) strtoul(optarg, NULL, 0); break;
+        case 'D': speedHz = (uint32_t) strtoul(optarg, NULL, 0); break;
+        case 'v': encoder.velocity = strtoll(optarg, NULL, 0); break;
+        case 'e': encoder.bitErrorRate = (uint32_t) strtoul(optarg, NULL, 0); break;
+        case 's': encoder.stallEvery = (uint32_t) strtoul(optarg, NULL, 0); break;
+        case 'q': quiet = 1; break;
+        default:
+            fprintf(stderr, "usage: %s [-n count] [-b n] [-o us] [-g us] [-D Hz] [-v counts/s] [-e n] [-s n] [-q]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+
+    if (batch == 0 || batch > ORBIS_SPIDEV_BATCH_MAX || count == 0) {
+        fprintf(stderr, "the batch must be 1 to %u frames, and the count more than 0\n", ORBIS_SPIDEV_BATCH_MAX);
+        return 2;
+    }
+
+    frames = calloc(count, sizeof(*frames));
+    selects = calloc(count, sizeof(*selects));
+    if (frames == NULL || selects == NULL) {
+        perror("calloc");
+        return 2;
+    }
+
+    SimOrbisInit(&encoder);
+    spidev.syscallTicks = (uint64_t) overheadUs * (SIM_CLOCK_HZ / 1000000u);
+
+    fd = SimSpidevOpen(&spidev, &encoder.device);
+    if (fd < 0 || OrbisSpidevAttach(&dev, fd, SimSpidevIoctl, speedHz, gapUs) != 0) {
+        fprintf(stderr, "spidev stand-in: %s\n", strerror(errno));
+        return 2;
+    }
+
+    if (spidev.mode != ORBIS_SPIDEV_MODE || spidev.maxSpeedHz != speedHz) {
+        printf("spidev set up with mode %u at %u Hz\n", spidev.mode, spidev.maxSpeedHz);
+        return 1;
+    }
+
+    if (!quiet)
+        printf("%u Hz, %u us after each frame, %u us a system call\n", speedHz, gapUs, overheadUs);
+
+    failures = SpidevRun(&dev, frames, selects, count, 1, encoder.bitErrorRate || encoder.stallEvery, &single);
+    failures += SpidevRun(&dev, frames, selects, count, batch, encoder.bitErrorRate || encoder.stallEvery, &batched);
+
+    printf("batched/single: %.2f\n", batched / single);
+
+    // Each system call saved is worth overheadUs, so batching must pay off
+    if (batch > 1 && overheadUs > 0 && batched <= single) {
+        printf("batches of %u are no faster than single frames\n", batch);
+        failures++;
+    }
+
+    SimSpidevClose(fd);
+    free(frames);
+    free(selects);
+
+    if (failures != 0) {
+        printf("%u failures\n", failures);
+        return 1;
+    }
+
+    return 0;
+}
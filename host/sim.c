@@ -0,0 +1,328 @@
+/*
+ * sim.c
+ * Simulated time, register file and interrupt controller
+ *
+ * Time only moves when the driver looks at it: every read of a DMTimer counter costs
+ * simPollTicks, and the models catch up with the new time event by event. A busy wait
+ * on the counter thus runs the transfer on the bus in the meantime, just as on the target.
+ *
+ * Interrupts are taken as soon as they are raised, unless the master enable is off or a
+ * handler is already running, in which case they wait for the handler to return. There is
+ * no preemption between priorities, as in the driver's single-level IRQ setup. Interrupts
+ * routed to FIQ are the exception: they are masked by nothing but the FIQ enable and a
+ * running FIQ handler, so they preempt IRQ handlers and the IntDisable() sections.
+ *
+ * The software interrupt registers of the AINTC (INTC_ISR_SET and INTC_ISR_CLEAR) are
+ * looked at every time the interrupts are dispatched.
+ *
+ * WFI (ORBIS_WFI() in orbis_load.h) moves time on, event by event, until an interrupt is
+ * pending, whether IRQ is masked or not.
+ *
+ *  Created on: 16 Oct 2026
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "hw_types.h"
+#include "interrupt.h"
+#include "soc_AM335x.h"
+#include "hw_intc.h"
+#include "sim.h"
+
+#define SIM_REGISTERS           1024u
+#define SIM_INTERRUPTS          128u
+
+// Current simulated time, in 24 MHz ticks
+uint64_t simTicks;
+
+// Time taken by every read of a timer counter
+uint32_t simPollTicks = 2;
+
+// Number of interrupt handlers run
+uint32_t simInterruptsTaken;
+
+static struct {
+    unsigned int address;
+    unsigned int value;
+} simRegisters[SIM_REGISTERS];
+
+static void (*simHandlers[SIM_INTERRUPTS])(void);
+static uint8_t simPriority[SIM_INTERRUPTS];
+static uint8_t simEnabled[SIM_INTERRUPTS];
+static uint8_t simPending[SIM_INTERRUPTS];
+static uint8_t simSoftware[SIM_INTERRUPTS];
+static uint8_t simRoute[SIM_INTERRUPTS];
+static uint8_t simMasterEnabled;
+static uint8_t simInHandler;
+static uint8_t simFIQEnabled;
+static uint8_t simInFIQ;
+
+// Move time on by ticks, letting every model act on its events on the way
+void SimAdvance(uint64_t ticks)
+{
+    uint64_t target = simTicks + ticks;
+
+    while (simTicks < target) {
+        uint64_t next = target;
+        uint64_t event;
+
+        event = SimMcSPINextEvent();
+        if (event > simTicks && event < next)
+            next = event;
+        event = SimDMTimerNextEvent();
+        if (event > simTicks && event < next)
+            next = event;
+        event = SimUARTNextEvent();
+        if (event > simTicks && event < next)
+            next = event;
+
+        simTicks = next;
+
+        SimMcSPIUpdate();
+        SimDMTimerUpdate();
+        SimUARTUpdate();
+    }
+}
+
+// Start over at time zero with empty registers and no interrupt handlers
+void SimReset(void)
+{
+    simTicks = 0;
+    simInterruptsTaken = 0;
+    simMasterEnabled = 0;
+    simInHandler = 0;
+    simFIQEnabled = 0;
+    simInFIQ = 0;
+
+    for (uint32_t i = 0; i < SIM_REGISTERS; i++) {
+        simRegisters[i].address = 0;
+        simRegisters[i].value = 0;
+    }
+
+    for (uint32_t i = 0; i < SIM_INTERRUPTS; i++) {
+        simHandlers[i] = NULL;
+        simEnabled[i] = 0;
+        simPending[i] = 0;
+        simSoftware[i] = 0;
+        simRoute[i] = AINTC_HOSTINT_ROUTE_IRQ;
+        simPriority[i] = 0;
+    }
+}
+
+//
+// The register at address. Registers spring into existence, reset to zero, the first
+// time they are looked at. The models keep the status registers up to date here, so
+// that the driver can poll them with HWREG() as well as through the API.
+//
+// A timer counter register is brought up to date, at the cost of a counter read,
+// every time it is accessed.
+//
+volatile unsigned int* SimRegister(unsigned int address)
+{
+    SimDMTimerRegisterAccess(address);
+    return SimRegisterSlot(address);
+}
+
+// The register at address, without any side effects. For the models.
+volatile unsigned int* SimRegisterSlot(unsigned int address)
+{
+    uint32_t i = (address >> 2) % SIM_REGISTERS;
+
+    while (simRegisters[i].address != address) {
+        if (simRegisters[i].address == 0) {
+            simRegisters[i].address = address;
+            break;
+        }
+        i = (i + 1) % SIM_REGISTERS;
+    }
+
+    return &simRegisters[i].value;
+}
+
+// Raise the interrupt line, it is taken right away if nothing holds it back
+void SimInterruptRaise(unsigned int intrNum)
+{
+    simPending[intrNum % SIM_INTERRUPTS] = 1;
+    SimInterruptDispatch();
+}
+
+// Lower the interrupt line. The lines are level sensitive, so an interrupt that has
+// been dealt with before its handler got to run is not taken.
+void SimInterruptLower(unsigned int intrNum)
+{
+    simPending[intrNum % SIM_INTERRUPTS] = 0;
+}
+
+// Take in what has been written to the software interrupt registers of the AINTC
+static void SimInterruptSoftware(void)
+{
+    for (uint32_t bank = 0; bank < SIM_INTERRUPTS / 32; bank++) {
+        volatile unsigned int* set = SimRegisterSlot(SOC_AINTC_REGS + INTC_ISR_SET(bank));
+        volatile unsigned int* clear = SimRegisterSlot(SOC_AINTC_REGS + INTC_ISR_CLEAR(bank));
+
+        for (uint32_t bit = 0; bit < 32; bit++) {
+            if (*set & (1u << bit))
+                simSoftware[bank * 32 + bit] = 1;
+            if (*clear & (1u << bit))
+                simSoftware[bank * 32 + bit] = 0;
+        }
+
+        *set = 0;
+        *clear = 0;
+    }
+}
+
+// Run the handlers of the pending interrupts, FIQ first, then most urgent first
+void SimInterruptDispatch(void)
+{
+    for (;;) {
+        uint32_t best = SIM_INTERRUPTS;
+        uint8_t fiq = simFIQEnabled && !simInFIQ;
+        uint8_t irq = simMasterEnabled && !simInHandler && !simInFIQ;
+
+        SimInterruptSoftware();
+
+        for (uint32_t i = 0; i < SIM_INTERRUPTS; i++) {
+            uint8_t route = simRoute[i];
+
+            if (!(simPending[i] || simSoftware[i]) || !simEnabled[i] || simHandlers[i] == NULL)
+                continue;
+            if (route == AINTC_HOSTINT_ROUTE_FIQ ? !fiq : !irq)
+                continue;
+            if (best == SIM_INTERRUPTS || route > simRoute[best] ||
+                (route == simRoute[best] && simPriority[i] < simPriority[best]))
+                best = i;
+        }
+
+        if (best == SIM_INTERRUPTS)
+            return;
+
+        simPending[best] = 0;
+        simInterruptsTaken++;
+
+        // The handler runs with its own kind of interrupt masked, and whatever it does to the
+        // mask is undone on return, as the CPSR is restored
+        if (simRoute[best] == AINTC_HOSTINT_ROUTE_FIQ) {
+            uint8_t masterEnabled = simMasterEnabled;
+
+            simInFIQ = 1;
+            simHandlers[best]();
+            simInFIQ = 0;
+            simMasterEnabled = masterEnabled;
+        } else {
+            simInHandler = 1;
+            simHandlers[best]();
+            simInHandler = 0;
+            simMasterEnabled = 1;
+        }
+    }
+}
+
+// An enabled interrupt with a handler is pending, masked or not
+static uint8_t SimInterruptPending(void)
+{
+    SimInterruptSoftware();
+
+    for (uint32_t i = 0; i < SIM_INTERRUPTS; i++) {
+        if ((simPending[i] || simSoftware[i]) && simEnabled[i] && simHandlers[i] != NULL)
+            return 1;
+    }
+
+    return 0;
+}
+
+// WFI: sleep until an interrupt is pending, see orbis_load.h
+void SimWaitForInterrupt(void)
+{
+    while (!SimInterruptPending()) {
+        uint64_t next = SimMcSPINextEvent();
+        uint64_t event;
+
+        event = SimDMTimerNextEvent();
+        if (event < next)
+            next = event;
+        event = SimUARTNextEvent();
+        if (event < next)
+            next = event;
+
+        // Nothing will ever happen, the target would sleep for good
+        if (next == UINT64_MAX) {
+            fprintf(stderr, "WFI with no interrupt to come\n");
+            exit(3);
+        }
+
+        SimAdvance((next > simTicks) ? next - simTicks : 1);
+    }
+}
+
+void IntAINTCInit(void)
+{
+    for (uint32_t i = 0; i < SIM_INTERRUPTS; i++) {
+        simEnabled[i] = 0;
+        simPending[i] = 0;
+    }
+}
+
+void IntMasterIRQEnable(void)
+{
+    simMasterEnabled = 1;
+    SimInterruptDispatch();
+}
+
+void IntMasterIRQDisable(void)
+{
+    simMasterEnabled = 0;
+}
+
+void IntMasterFIQEnable(void)
+{
+    simFIQEnabled = 1;
+    SimInterruptDispatch();
+}
+
+unsigned int IntMasterStatusGet(void)
+{
+    return (simMasterEnabled && !simInHandler) ? 0 : 0x80;
+}
+
+// Disable IRQ and return the previous state for IntEnable(), as StarterWare does
+unsigned char IntDisable(void)
+{
+    unsigned char status = (unsigned char) IntMasterStatusGet();
+
+    IntMasterIRQDisable();
+    return status;
+}
+
+void IntEnable(unsigned char status)
+{
+    if ((status & 0x80) == 0)
+        IntMasterIRQEnable();
+}
+
+void IntRegister(unsigned int intrNum, void (*fnHandler)(void))
+{
+    simHandlers[intrNum % SIM_INTERRUPTS] = fnHandler;
+}
+
+void IntUnRegister(unsigned int intrNum)
+{
+    simHandlers[intrNum % SIM_INTERRUPTS] = NULL;
+}
+
+void IntPrioritySet(unsigned int intrNum, unsigned int priority, unsigned int hostIntRoute)
+{
+    simPriority[intrNum % SIM_INTERRUPTS] = (uint8_t) priority;
+    simRoute[intrNum % SIM_INTERRUPTS] = (uint8_t) hostIntRoute;
+}
+
+void IntSystemEnable(unsigned int intrNum)
+{
+    simEnabled[intrNum % SIM_INTERRUPTS] = 1;
+    SimInterruptDispatch();
+}
+
+void IntSystemDisable(unsigned int intrNum)
+{
+    simEnabled[intrNum % SIM_INTERRUPTS] = 0;
+}
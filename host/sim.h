@@ -0,0 +1,184 @@
+/*
+ * sim.h
+ * Host simulation of the AM335x peripherals used by the Orbis driver
+ *
+ * The driver sources are built unchanged against the stand-in StarterWare headers
+ * in starterware/, whose functions are implemented here by behavioural models of
+ * McSPI, EDMA3, DMTimer, UART0 and the interrupt controller, with an Orbis encoder model
+ * on the bus.
+ * The Linux spidev backend runs against a stand-in for a spidev device instead, with the same
+ * encoder model on it.
+ *
+ * The functions and global data structures are documented
+ * in the source code files to avoid saying the same thing twice.
+ * Use the source code files as a primary reference.
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#ifndef SIM_H_
+#define SIM_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Simulated time runs in the 24 MHz ticks of the DMTimer functional clock
+#define SIM_CLOCK_HZ            24000000u
+
+// The McSPI functional clock is twice the timer clock
+#define SIM_MCSPI_CLOCK_HZ      48000000u
+
+// Returned by SimDevice.holdoff for a device that never starts the transfer
+#define SIM_STALL               UINT64_MAX
+
+//
+// A device on a McSPI chip select. The McSPI model calls select and deselect on the CS
+// edges, and exchange once for every word shifted, with the word sent by the master and
+// the time the word started. The device returns the word it shifts back.
+//
+typedef struct SimDevice {
+    void (*select)(struct SimDevice* device, uint64_t time);
+    void (*deselect)(struct SimDevice* device, uint64_t time);
+    uint64_t (*holdoff)(struct SimDevice* device);
+    uint8_t (*exchange)(struct SimDevice* device, uint32_t index, uint8_t tx,
+                        uint64_t time, uint32_t clockHz);
+} SimDevice;
+
+// Counts per turn of the 14 bit position field, the unit of the model's trajectory
+#define SIM_ORBIS_COUNTS            16384
+
+//
+// Behavioural model of the Orbis encoder. Fill in the configuration, then call
+// SimOrbisInit() and attach &orbis->device to a chip select.
+//
+typedef struct {
+    SimDevice device;
+
+    // Configuration
+    uint8_t multiturn;              // 1 for multi-turn, the position is preceded by the turn count
+    uint8_t resolution;             // bits of position resolution, 12 or 14
+    int64_t startCounts;            // trajectory in counts of the 14 bit position field
+    int64_t velocity;               // counts per second
+    int64_t acceleration;           // counts per second squared
+    int16_t speed;                  // reported by the speed command, in rpm
+    int16_t temperature;            // reported by the temperature command, in 0.1 degC
+    uint8_t status;                 // reported by the status command
+    uint8_t serial[6];              // reported by the serial number command
+    uint8_t error;                  // error and warning bits to report, active high here
+    uint8_t warning;
+
+    // Timing limits of the device; a frame that breaks them is garbled
+    uint64_t setupTicks;            // minimum CS to first clock edge
+    uint32_t maxClockHz;            // fastest SPI clock the device follows
+
+    // Fault injection
+    uint32_t bitErrorRate;          // flip a random bit in one of that many bits, 0 for never
+    uint32_t stallEvery;            // never respond to every that many frames, 0 for never
+    uint32_t lateEvery;             // respond late to every that many frames, 0 for never
+    uint64_t lateTicks;             // how late
+    uint32_t errorEvery;            // set the error bit in every that many frames, 0 for never
+    uint32_t outageStart;           // never respond to the frames after this one...
+    uint32_t outageFrames;          // ... for that many frames, 0 for no outage
+
+    // State
+    uint32_t frames;                // frames started
+    uint32_t bitErrors;             // bits flipped
+    uint32_t stalls;
+    uint32_t lates;
+    uint32_t errors;                // frames with the error bit set by errorEvery
+    uint32_t violations;            // frames garbled because of the timing limits
+    uint8_t command;
+    uint8_t frame[16];
+    uint32_t frameLength;
+    uint32_t lastPosition;          // position word latched by the last frame
+    uint16_t lastTurns;             // turn count latched by the last frame, multi-turn only
+    uint64_t selectTime;
+    uint64_t deselectTime;
+    uint8_t deselected;             // 1 once deselected; clear it to leave the next CS high time out...
+    uint64_t csHighMin;             // ... of the shortest and the longest from one frame to the next
+    uint64_t csHighMax;
+    uint8_t garble;                 // 1 for a setup time violation, 2 for a clock violation
+    uint32_t random;
+} SimOrbis;
+
+//
+// Stand-in for a spidev device, with a device on its chip select. Fill in the configuration,
+// then open it with SimSpidevOpen() and use SimSpidevIoctl() in place of ioctl().
+//
+typedef struct {
+    // Configuration
+    uint64_t syscallTicks;          // cost of a message, from the ioctl() to its first CS assertion
+    uint64_t csSetupTicks;          // CS to the first clock edge
+    uint64_t* selectLog;            // time of every CS assertion, by frame, if not NULL...
+    uint32_t selectLogLength;       // ... for that many frames
+
+    // State
+    SimDevice* device;
+    uint64_t time;                  // ticks of the stand-in's own clock
+    uint32_t maxSpeedHz;
+    uint8_t mode;
+    uint8_t bits;
+    uint8_t selected;
+    uint32_t index;                 // word of the frame, since CS assertion
+    uint64_t holdoff;               // of the device, for the frame
+    uint32_t messages;              // SPI_IOC_MESSAGE calls
+    uint32_t transfers;
+    uint32_t frames;                // CS assertions
+} SimSpidev;
+
+// Simulated time
+extern uint64_t simTicks;
+extern uint32_t simPollTicks;
+void SimAdvance(uint64_t ticks);
+void SimReset(void);
+
+// Simulated register file
+volatile unsigned int* SimRegister(unsigned int address);
+volatile unsigned int* SimRegisterSlot(unsigned int address);
+
+// Interrupt controller
+void SimInterruptRaise(unsigned int intrNum);
+void SimInterruptLower(unsigned int intrNum);
+void SimInterruptDispatch(void);
+void SimWaitForInterrupt(void);
+extern uint32_t simInterruptsTaken;
+
+// McSPI
+void SimMcSPIAttach(unsigned int baseAdd, unsigned int chNum, SimDevice* device);
+uint64_t SimMcSPINextEvent(void);
+void SimMcSPIUpdate(void);
+extern uint32_t simMcSPICalls;
+extern uint32_t simMcSPIStatusReads;
+extern uint32_t simMcSPITxWords;
+extern uint32_t simMcSPIEOWLead;
+extern uint32_t simMcSPIRxWaitMax;
+int SimMcSPIDMARead(unsigned int address, uint32_t* word);
+
+// EDMA3
+void SimEDMAEvent(uint32_t channel);
+extern uint32_t simEDMATransfers;
+extern uint32_t simEDMAMissed;
+
+// DMTimer
+uint64_t SimDMTimerNextEvent(void);
+void SimDMTimerUpdate(void);
+void SimDMTimerRegisterAccess(unsigned int address);
+
+// UART0
+void SimUARTCapture(FILE* file);
+uint64_t SimUARTNextEvent(void);
+void SimUARTUpdate(void);
+extern uint32_t simUARTBytes;
+extern uint32_t simUARTOverflows;
+
+// Orbis model
+void SimOrbisInit(SimOrbis* orbis);
+uint32_t SimOrbisPosition(SimOrbis* orbis, uint64_t time);
+uint8_t SimOrbisCRC(const uint8_t* data, uint32_t length);
+
+// spidev
+int SimSpidevOpen(SimSpidev* spidev, SimDevice* device);
+void SimSpidevClose(int fd);
+int SimSpidevIoctl(int fd, unsigned long request, void* arg);
+
+#endif /* SIM_H_ */
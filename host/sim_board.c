@@ -0,0 +1,85 @@
+/*
+ * sim_board.c
+ * BeagleBone board support, GPIO and console for the host simulation
+ *
+ * The clock and pin mux set-up has nothing to do on the host. The console prints
+ * to the standard output.
+ *
+ *  Created on: 16 Oct 2026
+ */
+#include <stdarg.h>
+#include <stdio.h>
+#include "beaglebone.h"
+#include "pin_mux.h"
+#include "gpio_v2.h"
+#include "consoleUtils.h"
+#include "mcspi_beaglebone.h"
+
+void GpioPinMuxSetup(unsigned int offsetAddr, unsigned int padConfValue)
+{
+}
+
+void McSPI0ModuleClkConfig(void)
+{
+}
+
+void McSPI1ModuleClkConfig(void)
+{
+}
+
+void GPIO0ModuleClkConfig(void)
+{
+}
+
+void GPIO1ModuleClkConfig(void)
+{
+}
+
+void GPIO1Pin23PinMuxSetup(void)
+{
+}
+
+void DMTimer2ModuleClkConfig(void)
+{
+}
+
+void DMTimer4ModuleClkConfig(void)
+{
+}
+
+void EDMAModuleClkConfig(void)
+{
+}
+
+void GPIOModuleEnable(unsigned int baseAdd)
+{
+}
+
+void GPIOModuleReset(unsigned int baseAdd)
+{
+}
+
+void GPIODirModeSet(unsigned int baseAdd, unsigned int pinNumber, unsigned int pinDirection)
+{
+}
+
+void GPIOPinWrite(unsigned int baseAdd, unsigned int pinNumber, unsigned int pinValue)
+{
+}
+
+void ConsoleUtilsInit(void)
+{
+}
+
+void ConsoleUtilsSetType(int consoleType)
+{
+}
+
+void ConsoleUtilsPrintf(const char *string, ...)
+{
+    va_list args;
+
+    va_start(args, string);
+    vprintf(string, args);
+    va_end(args);
+}
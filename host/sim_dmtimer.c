@@ -0,0 +1,266 @@
+/*
+ * sim_dmtimer.c
+ * Behavioural model of the AM335x DMTimer2..7
+ *
+ * The timers count the 24 MHz functional clock with no prescaler, overflow from
+ * 0xFFFFFFFF to the reload value in auto-reload mode, stop on overflow in one-shot
+ * mode, and raise the overflow and match interrupts. Posted writes are not modelled:
+ * every write takes effect at once.
+ *
+ *  Created on: 16 Oct 2026
+ */
+#include <stdint.h>
+#include "hw_types.h"
+#include "soc_AM335x.h"
+#include "interrupt.h"
+#include "dmtimer.h"
+#include "sim.h"
+
+#define SIM_DMTIMERS            6u
+#define SIM_DMTIMER_SPAN        (1ull << 32)
+
+typedef struct {
+    unsigned int base;
+    unsigned int intrNum;
+    uint8_t running;
+    uint32_t mode;
+    uint32_t counter;       // counter value at refTime
+    uint64_t refTime;
+    uint32_t reload;
+    uint32_t compare;
+    uint32_t irqStatus;
+    uint32_t irqEnable;
+} SimDMTimer;
+
+static SimDMTimer simDMTimer[SIM_DMTIMERS] = {
+    { SOC_DMTIMER_2_REGS, SYS_INT_TINT2, 0, 0, 0, 0, 0, 0, 0, 0 },
+    { SOC_DMTIMER_3_REGS, SYS_INT_TINT3, 0, 0, 0, 0, 0, 0, 0, 0 },
+    { SOC_DMTIMER_4_REGS, SYS_INT_TINT4, 0, 0, 0, 0, 0, 0, 0, 0 },
+    { SOC_DMTIMER_5_REGS, SYS_INT_TINT5, 0, 0, 0, 0, 0, 0, 0, 0 },
+    { SOC_DMTIMER_6_REGS, SYS_INT_TINT6, 0, 0, 0, 0, 0, 0, 0, 0 },
+    { SOC_DMTIMER_7_REGS, SYS_INT_TINT7, 0, 0, 0, 0, 0, 0, 0, 0 }
+};
+
+static SimDMTimer* SimDMTimerGet(unsigned int baseAdd)
+{
+    for (uint32_t i = 0; i < SIM_DMTIMERS; i++) {
+        if (simDMTimer[i].base == baseAdd)
+            return &simDMTimer[i];
+    }
+
+    return &simDMTimer[0];
+}
+
+// Counter value now. Only valid until the next overflow, which SimDMTimerUpdate() takes care of.
+static uint32_t SimDMTimerValue(SimDMTimer* t)
+{
+    if (!t->running)
+        return t->counter;
+
+    return (uint32_t) (t->counter + (simTicks - t->refTime));
+}
+
+static void SimDMTimerRebase(SimDMTimer* t)
+{
+    t->counter = SimDMTimerValue(t);
+    t->refTime = simTicks;
+}
+
+static uint64_t SimDMTimerOverflowTime(SimDMTimer* t)
+{
+    return t->refTime + (SIM_DMTIMER_SPAN - t->counter);
+}
+
+// The match is on the counter reaching the compare value, so a counter already there matches
+// again only after going all the way round
+static uint64_t SimDMTimerMatchTime(SimDMTimer* t)
+{
+    uint32_t distance = t->compare - t->counter;
+
+    if (!(t->mode & DMTIMER_ONESHOT_CMP_ENABLE))
+        return UINT64_MAX;
+
+    return t->refTime + (distance ? distance : SIM_DMTIMER_SPAN);
+}
+
+static void SimDMTimerSync(SimDMTimer* t)
+{
+    *SimRegisterSlot(t->base + DMTIMER_IRQSTATUS) = t->irqStatus;
+
+    if (t->irqStatus & t->irqEnable)
+        SimInterruptRaise(t->intrNum);
+    else
+        SimInterruptLower(t->intrNum);
+}
+
+// Time of the next overflow or match of any running timer
+uint64_t SimDMTimerNextEvent(void)
+{
+    uint64_t next = UINT64_MAX;
+
+    for (uint32_t i = 0; i < SIM_DMTIMERS; i++) {
+        SimDMTimer* t = &simDMTimer[i];
+        uint64_t event;
+
+        if (!t->running)
+            continue;
+
+        event = SimDMTimerOverflowTime(t);
+        if (event < next)
+            next = event;
+
+        event = SimDMTimerMatchTime(t);
+        if (event < next && event > simTicks)
+            next = event;
+    }
+
+    return next;
+}
+
+// Act on the overflows and matches up to the current time
+void SimDMTimerUpdate(void)
+{
+    for (uint32_t i = 0; i < SIM_DMTIMERS; i++) {
+        SimDMTimer* t = &simDMTimer[i];
+        uint8_t changed = 0;
+
+        while (t->running) {
+            uint64_t overflow = SimDMTimerOverflowTime(t);
+            uint64_t match = SimDMTimerMatchTime(t);
+
+            if (match <= simTicks && match < overflow) {
+                t->irqStatus |= DMTIMER_INT_MAT_IT_FLAG;
+                t->counter = t->compare;
+                t->refTime = match;
+                changed = 1;
+            } else if (overflow <= simTicks) {
+                t->irqStatus |= DMTIMER_INT_OVF_IT_FLAG;
+                t->refTime = overflow;
+                changed = 1;
+
+                if (t->mode & DMTIMER_AUTORLD_NOCMP_ENABLE) {
+                    t->counter = t->reload;
+                } else {
+                    t->counter = 0;
+                    t->running = 0;
+                }
+            } else {
+                break;
+            }
+        }
+
+        if (changed)
+            SimDMTimerSync(t);
+    }
+}
+
+// Bring the counter register up to date when the driver reads it with HWREG()
+void SimDMTimerRegisterAccess(unsigned int address)
+{
+    for (uint32_t i = 0; i < SIM_DMTIMERS; i++) {
+        if (address == simDMTimer[i].base + DMTIMER_TCRR) {
+            SimAdvance(simPollTicks);
+            *SimRegisterSlot(address) = SimDMTimerValue(&simDMTimer[i]);
+        }
+    }
+}
+
+void DMTimerEnable(unsigned int baseAdd)
+{
+    SimDMTimer* t = SimDMTimerGet(baseAdd);
+
+    t->running = 1;
+    t->refTime = simTicks;
+}
+
+void DMTimerDisable(unsigned int baseAdd)
+{
+    SimDMTimer* t = SimDMTimerGet(baseAdd);
+
+    SimDMTimerRebase(t);
+    t->running = 0;
+}
+
+void DMTimerModeConfigure(unsigned int baseAdd, unsigned int timerMode)
+{
+    SimDMTimerGet(baseAdd)->mode = timerMode;
+}
+
+void DMTimerPreScalerClkEnable(unsigned int baseAdd, unsigned int ptv)
+{
+}
+
+void DMTimerPreScalerClkDisable(unsigned int baseAdd)
+{
+}
+
+void DMTimerCounterSet(unsigned int baseAdd, unsigned int counter)
+{
+    SimDMTimer* t = SimDMTimerGet(baseAdd);
+
+    t->counter = counter;
+    t->refTime = simTicks;
+}
+
+// Reading the counter takes simPollTicks, which is what moves simulated time along
+unsigned int DMTimerCounterGet(unsigned int baseAdd)
+{
+    SimAdvance(simPollTicks);
+    return SimDMTimerValue(SimDMTimerGet(baseAdd));
+}
+
+void DMTimerReloadSet(unsigned int baseAdd, unsigned int reload)
+{
+    SimDMTimerGet(baseAdd)->reload = reload;
+}
+
+unsigned int DMTimerReloadGet(unsigned int baseAdd)
+{
+    return SimDMTimerGet(baseAdd)->reload;
+}
+
+void DMTimerCompareSet(unsigned int baseAdd, unsigned int compareVal)
+{
+    SimDMTimer* t = SimDMTimerGet(baseAdd);
+
+    SimDMTimerRebase(t);
+    t->compare = compareVal;
+}
+
+unsigned int DMTimerCompareGet(unsigned int baseAdd)
+{
+    return SimDMTimerGet(baseAdd)->compare;
+}
+
+unsigned int DMTimerIntStatusGet(unsigned int baseAdd)
+{
+    return SimDMTimerGet(baseAdd)->irqStatus;
+}
+
+void DMTimerIntStatusClear(unsigned int baseAdd, unsigned int intFlags)
+{
+    SimDMTimer* t = SimDMTimerGet(baseAdd);
+
+    t->irqStatus &= ~intFlags;
+    SimDMTimerSync(t);
+}
+
+void DMTimerIntEnable(unsigned int baseAdd, unsigned int enableFlags)
+{
+    SimDMTimer* t = SimDMTimerGet(baseAdd);
+
+    t->irqEnable |= enableFlags;
+    SimDMTimerSync(t);
+}
+
+void DMTimerIntDisable(unsigned int baseAdd, unsigned int enableFlags)
+{
+    SimDMTimer* t = SimDMTimerGet(baseAdd);
+
+    t->irqEnable &= ~enableFlags;
+    SimDMTimerSync(t);
+}
+
+void DMTimerPostedModeConfig(unsigned int baseAdd, unsigned int postMode)
+{
+}
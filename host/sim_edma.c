@@ -0,0 +1,223 @@
+/*
+ * sim_edma.c
+ * Behavioural model of the AM335x EDMA3 channel controller
+ *
+ * Models what the EDMA3 receive path of the Orbis driver relies on: DMA channels started
+ * by their events, each with the PaRAM set of the same number, A-B synchronised transfers,
+ * the STATIC bit and linking, and the transfer completion interrupt of region 0.
+ * A transfer request is carried out at once, when its event is taken.
+ *
+ * The McSPI model raises the events of its receive DMA requests, and a source address
+ * that is a McSPI Rx register reads its Rx FIFO, see SimMcSPIDMARead(). Any other address
+ * is host memory. The driver hands EDMA3 32 bit addresses, so the host programs are linked
+ * at a fixed address below 4 GB (-no-pie in the Makefile) for those to be the addresses
+ * of its buffers.
+ *
+ * After the final transfer request of a set that is not static, the set is reloaded from
+ * the one it links to, or emptied if there is none, as EDMA3 does. An event that comes
+ * while the one before is still latched, or that finds an empty set, is missed.
+ *
+ *  Created on: 16 Oct 2026
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "hw_types.h"
+#include "soc_AM335x.h"
+#include "interrupt.h"
+#include "edma.h"
+#include "sim.h"
+
+#define SIM_EDMA_CHANNELS       64u
+#define SIM_EDMA_PARAM_SETS     256u
+
+// The link address of no set to link to
+#define SIM_EDMA_LINK_NULL      0xFFFFu
+
+// Transfer requests carried out
+uint32_t simEDMATransfers;
+
+// Events missed, because the one before was still latched or the set was empty
+uint32_t simEDMAMissed;
+
+static EDMA3CCPaRAMEntry simEDMAParam[SIM_EDMA_PARAM_SETS];
+static uint64_t simEDMAEnabled;             // EER, the channels taking their events
+static uint64_t simEDMALatched;             // ER, the events waiting to be taken
+static uint64_t simEDMAPending;             // IPR, the transfer completion codes signalled
+static uint64_t simEDMAIntEnabled;          // IER
+
+// Raise the completion interrupt while an enabled completion code is pending
+static void SimEDMASync(void)
+{
+    if (simEDMAPending & simEDMAIntEnabled)
+        SimInterruptRaise(SYS_INT_EDMACOMPINT);
+    else
+        SimInterruptLower(SYS_INT_EDMACOMPINT);
+}
+
+// An element of aCnt bytes from the source to the destination
+static void SimEDMAElement(uint32_t src, uint32_t dst, uint32_t aCnt)
+{
+    uint8_t* to = (uint8_t*) (uintptr_t) dst;
+    uint32_t word;
+
+    // A peripheral register gives a word a read, the rest of the element is the same word
+    if (SimMcSPIDMARead(src, &word)) {
+        for (uint32_t i = 0; i < aCnt; i++)
+            to[i] = (uint8_t) (word >> (8 * (i % 4)));
+        return;
+    }
+
+    for (uint32_t i = 0; i < aCnt; i++)
+        to[i] = ((const uint8_t*) (uintptr_t) src)[i];
+}
+
+// Carry out the next transfer request of the set of the channel
+static void SimEDMATransfer(uint32_t channel)
+{
+    EDMA3CCPaRAMEntry* set = &simEDMAParam[channel];
+    uint32_t opt = set->opt;
+    uint32_t tcc = (opt & EDMA3CC_OPT_TCC) >> EDMA3CC_OPT_TCC_SHIFT;
+    uint8_t final;
+
+    if (set->aCnt == 0 || set->bCnt == 0 || set->cCnt == 0) {
+        simEDMAMissed++;
+        return;
+    }
+
+    if (!(opt & EDMA3CC_OPT_SYNCDIM)) {
+        fprintf(stderr, "EDMA3 channel %u: A synchronised transfers are not modelled\n", channel);
+        exit(3);
+    }
+
+    // A-B synchronised: bCnt elements of aCnt bytes, then the next such array on the next event
+    for (uint32_t b = 0; b < set->bCnt; b++)
+        SimEDMAElement(set->srcAddr + b * (int32_t) set->srcBIdx,
+                       set->destAddr + b * (int32_t) set->destBIdx, set->aCnt);
+
+    simEDMATransfers++;
+    final = (set->cCnt == 1);
+
+    // A static set is left as it is, so every event moves the same array
+    if (!(opt & EDMA3CC_OPT_STATIC)) {
+        if (!final) {
+            set->srcAddr += (int32_t) set->srcCIdx;
+            set->destAddr += (int32_t) set->destCIdx;
+            set->cCnt--;
+        } else if (set->linkAddr == SIM_EDMA_LINK_NULL) {
+            EDMA3CCPaRAMEntry empty = { 0 };
+
+            empty.linkAddr = SIM_EDMA_LINK_NULL;
+            *set = empty;
+        } else {
+            *set = simEDMAParam[((set->linkAddr - EDMA3CC_OPT(0)) / 0x20) % SIM_EDMA_PARAM_SETS];
+        }
+    }
+
+    if ((final && (opt & EDMA3CC_OPT_TCINTEN)) || (!final && (opt & EDMA3CC_OPT_ITCINTEN))) {
+        simEDMAPending |= (uint64_t) 1 << tcc;
+        SimEDMASync();
+    }
+}
+
+//
+// The event of the channel, raised by a peripheral. It is taken at once if the channel
+// is enabled, or else latched until it is.
+//
+void SimEDMAEvent(uint32_t channel)
+{
+    uint64_t bit = (uint64_t) 1 << (channel % SIM_EDMA_CHANNELS);
+
+    if (simEDMALatched & bit) {
+        simEDMAMissed++;
+        return;
+    }
+
+    if (!(simEDMAEnabled & bit)) {
+        simEDMALatched |= bit;
+        return;
+    }
+
+    SimEDMATransfer(channel % SIM_EDMA_CHANNELS);
+}
+
+void EDMA3Init(unsigned int baseAdd, unsigned int queNum)
+{
+    EDMA3CCPaRAMEntry empty = { 0 };
+
+    empty.linkAddr = SIM_EDMA_LINK_NULL;
+
+    for (uint32_t i = 0; i < SIM_EDMA_PARAM_SETS; i++)
+        simEDMAParam[i] = empty;
+
+    simEDMAEnabled = 0;
+    simEDMALatched = 0;
+    simEDMAPending = 0;
+    simEDMAIntEnabled = 0;
+    SimEDMASync();
+}
+
+// Clears the event of the channel and enables its completion interrupt, as StarterWare does
+unsigned int EDMA3RequestChannel(unsigned int baseAdd, unsigned int chType, unsigned int chNum,
+                                 unsigned int tccNum, unsigned int evtQNum)
+{
+    if (chType != EDMA3_CHANNEL_TYPE_DMA || chNum >= SIM_EDMA_CHANNELS)
+        return FALSE;
+
+    simEDMALatched &= ~((uint64_t) 1 << chNum);
+    simEDMAIntEnabled |= (uint64_t) 1 << (tccNum % SIM_EDMA_CHANNELS);
+    SimEDMASync();
+
+    return TRUE;
+}
+
+void EDMA3SetPaRAM(unsigned int baseAdd, unsigned int chNum, EDMA3CCPaRAMEntry* newPaRAM)
+{
+    simEDMAParam[chNum % SIM_EDMA_PARAM_SETS] = *newPaRAM;
+}
+
+void EDMA3GetPaRAM(unsigned int baseAdd, unsigned int PaRAMId, EDMA3CCPaRAMEntry* currPaRAM)
+{
+    *currPaRAM = simEDMAParam[PaRAMId % SIM_EDMA_PARAM_SETS];
+}
+
+// Enabling the event of a channel takes the event latched, if there is one
+unsigned int EDMA3EnableTransfer(unsigned int baseAdd, unsigned int chNum, unsigned int trigMode)
+{
+    uint64_t bit = (uint64_t) 1 << (chNum % SIM_EDMA_CHANNELS);
+
+    switch (trigMode) {
+    case EDMA3_TRIG_MODE_MANUAL:
+        SimEDMATransfer(chNum % SIM_EDMA_CHANNELS);
+        return TRUE;
+    case EDMA3_TRIG_MODE_EVENT:
+        simEDMAEnabled |= bit;
+        if (simEDMALatched & bit) {
+            simEDMALatched &= ~bit;
+            SimEDMATransfer(chNum % SIM_EDMA_CHANNELS);
+        }
+        return TRUE;
+    default:
+        return FALSE;
+    }
+}
+
+unsigned int EDMA3DisableTransfer(unsigned int baseAdd, unsigned int chNum, unsigned int trigMode)
+{
+    if (trigMode != EDMA3_TRIG_MODE_EVENT)
+        return trigMode == EDMA3_TRIG_MODE_MANUAL;
+
+    simEDMAEnabled &= ~((uint64_t) 1 << (chNum % SIM_EDMA_CHANNELS));
+    return TRUE;
+}
+
+unsigned int EDMA3GetIntrStatus(unsigned int baseAdd)
+{
+    return (unsigned int) simEDMAPending;
+}
+
+void EDMA3ClrIntr(unsigned int baseAdd, unsigned int value)
+{
+    simEDMAPending &= ~((uint64_t) 1 << (value % SIM_EDMA_CHANNELS));
+    SimEDMASync();
+}
@@ -0,0 +1,641 @@
+/*
+ * sim_mcspi.c
+ * Behavioural model of the AM335x McSPI modules
+ *
+ * Models what the Orbis driver relies on: master mode channels with optional FIFOs,
+ * the transfer levels and word count of MCSPI_XFERLEVEL, manual CS control, and the
+ * TX_EMPTY, RX_FULL and EOW interrupt events. A word takes WL * (48 MHz / SPI clock)
+ * cycles of the functional clock on the bus. The device on the chip select is called
+ * for every word, see SimDevice in sim.h.
+ *
+ * The CS assertion sets TXS and raises TX_EMPTY when the Tx side is empty, as observed
+ * on the target and noted in orbis.c, and enabling the channel does not.
+ *
+ * EOW is raised as the last word of the word count comes off the bus, or simMcSPIEOWLead
+ * ticks before that, to check that a driver which takes it does not assume the last word
+ * is already in the Rx FIFO.
+ *
+ * A channel with its Rx DMA request enabled raises the EDMA3 event of the request, see
+ * sim_edma.c, as the Rx FIFO fills up to the RX_FULL level, and EDMA3 reads the Rx register
+ * through SimMcSPIDMARead(). Only the Rx requests of channels 0 and 1 are wired to EDMA3
+ * on the AM335x. The Tx requests are not modelled.
+ *
+ * The longest time a response waits in an Rx FIFO, from reaching the RX_FULL level to its
+ * first word being read out, is kept in simMcSPIRxWaitMax. On the interrupt paths of the driver
+ * that is the time it takes to get into the handler that drains the FIFO.
+ *
+ *  Created on: 16 Oct 2026
+ */
+#include <stdint.h>
+#include <stddef.h>
+#include "hw_types.h"
+#include "soc_AM335x.h"
+#include "interrupt.h"
+#include "hw_mcspi.h"
+#include "mcspi.h"
+#include "sim.h"
+
+#define SIM_MCSPI_MODULES       2u
+#define SIM_MCSPI_CHANNELS      4u
+#define SIM_MCSPI_FIFO_WORDS    32u
+
+typedef struct {
+    SimDevice* device;
+
+    // Configuration
+    uint32_t trMode;
+    uint32_t txFifo;
+    uint32_t rxFifo;
+    uint32_t fRatio;
+    uint32_t wordLength;
+
+    // State
+    uint8_t enabled;
+    uint8_t selected;
+    uint8_t busy;
+    uint8_t tx[SIM_MCSPI_FIFO_WORDS];
+    uint32_t txHead;
+    uint32_t txCount;
+    uint8_t rx[SIM_MCSPI_FIFO_WORDS];
+    uint32_t rxHead;
+    uint32_t rxCount;
+    uint32_t rxLast;
+    uint64_t startNotBefore;
+    uint64_t wordEnd;
+    uint64_t eowTime;
+    uint8_t wordRx;
+    uint32_t frameIndex;
+    uint32_t wordsDone;
+    uint32_t wordCount;
+    uint32_t almostFull;
+    uint32_t almostEmpty;
+    uint8_t dmaRx;
+    uint8_t dmaRequest;
+    uint64_t rxFullTime;            // when the Rx FIFO reached the RX_FULL level, until it is read
+} SimMcSPIChannel;
+
+typedef struct {
+    unsigned int base;
+    unsigned int intrNum;
+    uint32_t rxEvent;                       // EDMA3 event of the Rx request of channel 0, channel 1 is 2 up
+    uint32_t irqStatus;
+    uint32_t irqEnable;
+    SimMcSPIChannel ch[SIM_MCSPI_CHANNELS];
+} SimMcSPIModule;
+
+// Number of McSPI API calls made by the driver, a measure of its CPU cost on the target
+uint32_t simMcSPICalls;
+
+// Of those, the reads of the channel status, which a polled capture spins on for as long as it waits
+uint32_t simMcSPIStatusReads;
+
+// Words written to the Tx FIFOs, whether they fitted or not
+uint32_t simMcSPITxWords;
+
+// How early EOW is raised, in ticks before the last word is in the Rx FIFO
+uint32_t simMcSPIEOWLead;
+
+// Longest a response has waited in an Rx FIFO, from the RX_FULL level to its first read, in ticks
+uint32_t simMcSPIRxWaitMax;
+
+static SimMcSPIModule simMcSPI[SIM_MCSPI_MODULES] = {
+    { SOC_SPI_0_REGS, SYS_INT_SPI0INT, 17, 0, 0, { { NULL } } },
+    { SOC_SPI_1_REGS, SYS_INT_SPI1INT, 43, 0, 0, { { NULL } } }
+};
+
+static SimMcSPIModule* SimMcSPIModuleGet(unsigned int baseAdd)
+{
+    return (baseAdd == SOC_SPI_1_REGS) ? &simMcSPI[1] : &simMcSPI[0];
+}
+
+// Words each FIFO holds. A shared FIFO is split in two when both directions use it.
+static uint32_t SimMcSPIDepth(SimMcSPIChannel* ch, uint32_t fifo)
+{
+    if (!fifo)
+        return 1;
+
+    return (ch->txFifo && ch->rxFifo) ? SIM_MCSPI_FIFO_WORDS / 2 : SIM_MCSPI_FIFO_WORDS;
+}
+
+//
+// Raise the Rx DMA request of the channel as the Rx FIFO fills up to the RX_FULL level.
+// The request is raised once, and again only after EDMA3 has read the FIFO below the level.
+//
+static void SimMcSPIDMARequest(SimMcSPIModule* m, uint32_t n)
+{
+    SimMcSPIChannel* ch = &m->ch[n];
+    uint32_t level = ch->rxFifo ? ch->almostFull : 1;
+
+    if (!ch->dmaRx || n > 1 || ch->rxCount < level) {
+        ch->dmaRequest = 0;
+        return;
+    }
+
+    if (ch->dmaRequest)
+        return;
+
+    ch->dmaRequest = 1;
+    SimEDMAEvent(m->rxEvent + 2 * n);
+
+    if (ch->rxCount < level)
+        ch->dmaRequest = 0;
+}
+
+// Publish the state to the register file and raise the interrupt line, if it is active
+static void SimMcSPISync(SimMcSPIModule* m)
+{
+    for (uint32_t n = 0; n < SIM_MCSPI_CHANNELS; n++) {
+        SimMcSPIChannel* ch = &m->ch[n];
+        uint32_t stat = 0;
+
+        SimMcSPIDMARequest(m, n);
+
+        if (ch->rxCount > 0)
+            stat |= MCSPI_CH0STAT_RXS;
+        if (ch->txCount == 0)
+            stat |= MCSPI_CH0STAT_TXS | MCSPI_CH0STAT_TXFFE;
+        if (ch->txCount == 0 && !ch->busy)
+            stat |= MCSPI_CH0STAT_EOT;
+        if (ch->txCount == SimMcSPIDepth(ch, ch->txFifo))
+            stat |= MCSPI_CH0STAT_TXFFF;
+        if (ch->rxCount == 0)
+            stat |= MCSPI_CH0STAT_RXFFE;
+        if (ch->rxCount == SimMcSPIDepth(ch, ch->rxFifo))
+            stat |= MCSPI_CH0STAT_RXFFF;
+
+        HWREG(m->base + MCSPI_CHSTAT(n)) = stat;
+        HWREG(m->base + MCSPI_CHCTRL(n)) = ch->enabled ? MCSPI_CH0CTRL_EN : 0;
+    }
+
+    HWREG(m->base + MCSPI_IRQSTATUS) = m->irqStatus;
+    HWREG(m->base + MCSPI_IRQENABLE) = m->irqEnable;
+
+    if (m->irqStatus & m->irqEnable)
+        SimInterruptRaise(m->intrNum);
+    else
+        SimInterruptLower(m->intrNum);
+}
+
+// The Rx FIFO is being read, which ends the wait of a response that has reached the RX_FULL level
+static void SimMcSPIRxWaitEnd(SimMcSPIChannel* ch)
+{
+    if (ch->rxFullTime != 0 && simTicks - ch->rxFullTime > simMcSPIRxWaitMax)
+        simMcSPIRxWaitMax = (uint32_t) (simTicks - ch->rxFullTime);
+    ch->rxFullTime = 0;
+}
+
+// Put the next word on the bus, if the channel is ready for it
+static void SimMcSPIWordStart(SimMcSPIChannel* ch, uint64_t now)
+{
+    uint8_t tx = 0;
+
+    if (!ch->enabled || !ch->selected || ch->busy || ch->device == NULL)
+        return;
+    if (ch->wordCount != 0 && ch->wordsDone >= ch->wordCount)
+        return;
+    if (ch->trMode != MCSPI_RX_ONLY_MODE && ch->txCount == 0)
+        return;
+    if (ch->trMode != MCSPI_TX_ONLY_MODE && ch->rxCount == SimMcSPIDepth(ch, ch->rxFifo))
+        return;
+    if (now < ch->startNotBefore)
+        return;
+
+    if (ch->trMode != MCSPI_RX_ONLY_MODE) {
+        tx = ch->tx[ch->txHead];
+        ch->txHead = (ch->txHead + 1) % SIM_MCSPI_FIFO_WORDS;
+        ch->txCount--;
+    }
+
+    ch->busy = 1;
+    ch->wordEnd = now + (ch->wordLength * ch->fRatio + 1) / 2;
+
+    if (simMcSPIEOWLead > 0 && ch->wordCount != 0 && ch->wordsDone + 1 == ch->wordCount)
+        ch->eowTime = (ch->wordEnd > now + simMcSPIEOWLead) ? ch->wordEnd - simMcSPIEOWLead : now + 1;
+    ch->wordRx = ch->device->exchange(ch->device, ch->frameIndex++, tx, now,
+                                      SIM_MCSPI_CLOCK_HZ / ch->fRatio);
+}
+
+// Take the word off the bus and raise the events it brings
+static void SimMcSPIWordEnd(SimMcSPIModule* m, uint32_t n)
+{
+    SimMcSPIChannel* ch = &m->ch[n];
+    uint32_t depth = SimMcSPIDepth(ch, ch->txFifo);
+
+    ch->busy = 0;
+    ch->wordsDone++;
+
+    if (ch->trMode != MCSPI_TX_ONLY_MODE) {
+        ch->rx[(ch->rxHead + ch->rxCount) % SIM_MCSPI_FIFO_WORDS] = ch->wordRx;
+        ch->rxCount++;
+
+        if (ch->rxCount == (ch->rxFifo ? ch->almostFull : 1)) {
+            m->irqStatus |= MCSPI_INT_RX_FULL(n);
+            ch->rxFullTime = ch->wordEnd;
+        }
+    }
+
+    if (ch->trMode != MCSPI_RX_ONLY_MODE &&
+        depth - ch->txCount == (ch->txFifo ? ch->almostEmpty : 1))
+        m->irqStatus |= MCSPI_INT_TX_EMPTY(n);
+
+    if (ch->wordCount != 0 && ch->wordsDone == ch->wordCount && simMcSPIEOWLead == 0)
+        m->irqStatus |= MCSPI_INT_EOWKE;
+}
+
+//
+// Connect the device to the chip select of the channel. The Orbis driver talks to
+// McSPI0 channel 0; the other channels and McSPI1 are there for more devices.
+//
+void SimMcSPIAttach(unsigned int baseAdd, unsigned int chNum, SimDevice* device)
+{
+    SimMcSPIModuleGet(baseAdd)->ch[chNum % SIM_MCSPI_CHANNELS].device = device;
+}
+
+// Time of the next word boundary on any channel
+uint64_t SimMcSPINextEvent(void)
+{
+    uint64_t next = UINT64_MAX;
+
+    for (uint32_t i = 0; i < SIM_MCSPI_MODULES; i++) {
+        for (uint32_t n = 0; n < SIM_MCSPI_CHANNELS; n++) {
+            SimMcSPIChannel* ch = &simMcSPI[i].ch[n];
+
+            if (ch->eowTime != 0 && ch->eowTime < next)
+                next = ch->eowTime;
+            if (ch->busy && ch->wordEnd < next)
+                next = ch->wordEnd;
+            else if (!ch->busy && ch->selected && ch->startNotBefore < next)
+                next = ch->startNotBefore;
+        }
+    }
+
+    return next;
+}
+
+// Act on the word boundaries up to the current time
+void SimMcSPIUpdate(void)
+{
+    for (uint32_t i = 0; i < SIM_MCSPI_MODULES; i++) {
+        SimMcSPIModule* m = &simMcSPI[i];
+        uint8_t changed = 0;
+
+        for (uint32_t n = 0; n < SIM_MCSPI_CHANNELS; n++) {
+            SimMcSPIChannel* ch = &m->ch[n];
+
+            if (ch->eowTime != 0 && ch->eowTime <= simTicks) {
+                ch->eowTime = 0;
+                m->irqStatus |= MCSPI_INT_EOWKE;
+                changed = 1;
+            }
+
+            for (;;) {
+                if (ch->busy && ch->wordEnd <= simTicks) {
+                    uint64_t end = ch->wordEnd;
+
+                    SimMcSPIWordEnd(m, n);
+                    SimMcSPIWordStart(ch, end);
+                    changed = 1;
+                } else if (!ch->busy && ch->selected && ch->startNotBefore <= simTicks &&
+                           ch->startNotBefore != 0) {
+                    uint64_t start = ch->startNotBefore;
+
+                    ch->startNotBefore = 0;
+                    SimMcSPIWordStart(ch, start);
+                    changed = 1;
+                } else {
+                    break;
+                }
+            }
+        }
+
+        if (changed)
+            SimMcSPISync(m);
+    }
+}
+
+void McSPIReset(unsigned int baseAdd)
+{
+    SimMcSPIModule* m = SimMcSPIModuleGet(baseAdd);
+
+    simMcSPICalls++;
+
+    m->irqStatus = 0;
+    m->irqEnable = 0;
+
+    for (uint32_t n = 0; n < SIM_MCSPI_CHANNELS; n++) {
+        SimDevice* device = m->ch[n].device;
+        SimMcSPIChannel zero = { NULL };
+
+        m->ch[n] = zero;
+        m->ch[n].device = device;
+        m->ch[n].fRatio = 1;
+        m->ch[n].wordLength = 8;
+        m->ch[n].almostFull = 1;
+        m->ch[n].almostEmpty = 1;
+    }
+
+    HWREG(baseAdd + MCSPI_XFERLEVEL) = 0;
+    HWREG(baseAdd + MCSPI_SYSSTATUS) = 1;
+    SimMcSPISync(m);
+}
+
+void McSPICSEnable(unsigned int baseAdd)
+{
+    simMcSPICalls++;
+}
+
+void McSPICSDisable(unsigned int baseAdd)
+{
+    simMcSPICalls++;
+}
+
+void McSPIMasterModeEnable(unsigned int baseAdd)
+{
+    simMcSPICalls++;
+}
+
+unsigned int McSPIMasterModeConfig(unsigned int baseAdd, unsigned int channelMode,
+                                   unsigned int trMode, unsigned int pinMode, unsigned int chNum)
+{
+    simMcSPICalls++;
+    SimMcSPIModuleGet(baseAdd)->ch[chNum].trMode = trMode;
+    return TRUE;
+}
+
+void McSPIClkConfig(unsigned int baseAdd, unsigned int spiInClk, unsigned int spiOutClk,
+                    unsigned int chNum, unsigned int clkMode)
+{
+    uint32_t fRatio = spiInClk / spiOutClk;
+
+    simMcSPICalls++;
+    SimMcSPIModuleGet(baseAdd)->ch[chNum].fRatio = (fRatio == 0) ? 1 : fRatio;
+}
+
+void McSPIWordLengthSet(unsigned int baseAdd, unsigned int wordLength, unsigned int chNum)
+{
+    simMcSPICalls++;
+    SimMcSPIModuleGet(baseAdd)->ch[chNum].wordLength = (wordLength >> 7) + 1;
+}
+
+void McSPICSPolarityConfig(unsigned int baseAdd, unsigned int spiEnPol, unsigned int chNum)
+{
+    simMcSPICalls++;
+}
+
+void McSPICSTimeControlSet(unsigned int baseAdd, unsigned int csTimeControl, unsigned int chNum)
+{
+    simMcSPICalls++;
+}
+
+void McSPITxFIFOConfig(unsigned int baseAdd, unsigned int txFifo, unsigned int chNum)
+{
+    simMcSPICalls++;
+    SimMcSPIModuleGet(baseAdd)->ch[chNum].txFifo = (txFifo == MCSPI_TX_FIFO_ENABLE);
+}
+
+void McSPIRxFIFOConfig(unsigned int baseAdd, unsigned int rxFifo, unsigned int chNum)
+{
+    simMcSPICalls++;
+    SimMcSPIModuleGet(baseAdd)->ch[chNum].rxFifo = (rxFifo == MCSPI_RX_FIFO_ENABLE);
+}
+
+void McSPIFIFOTrigLvlSet(unsigned int baseAdd, unsigned char afl, unsigned char ael,
+                         unsigned int trMode)
+{
+    uint32_t level = HWREG(baseAdd + MCSPI_XFERLEVEL) & MCSPI_XFERLEVEL_WCNT;
+
+    simMcSPICalls++;
+
+    if (trMode != MCSPI_TX_ONLY_MODE)
+        level |= ((uint32_t) (afl - 1) << MCSPI_XFERLEVEL_AFL_SHIFT) & MCSPI_XFERLEVEL_AFL;
+    if (trMode != MCSPI_RX_ONLY_MODE)
+        level |= ((uint32_t) (ael - 1) << MCSPI_XFERLEVEL_AEL_SHIFT) & MCSPI_XFERLEVEL_AEL;
+
+    HWREG(baseAdd + MCSPI_XFERLEVEL) = level;
+}
+
+void McSPIWordCountSet(unsigned int baseAdd, unsigned short wCnt)
+{
+    simMcSPICalls++;
+    HWREG(baseAdd + MCSPI_XFERLEVEL) = (HWREG(baseAdd + MCSPI_XFERLEVEL) & ~MCSPI_XFERLEVEL_WCNT)
+                                     | ((uint32_t) wCnt << MCSPI_XFERLEVEL_WCNT_SHIFT);
+}
+
+// The transfer levels and the word count are taken from MCSPI_XFERLEVEL at this point
+void McSPIChannelEnable(unsigned int baseAdd, unsigned int chNum)
+{
+    SimMcSPIModule* m = SimMcSPIModuleGet(baseAdd);
+    SimMcSPIChannel* ch = &m->ch[chNum];
+    uint32_t level = HWREG(baseAdd + MCSPI_XFERLEVEL);
+
+    simMcSPICalls++;
+
+    ch->wordCount = (level & MCSPI_XFERLEVEL_WCNT) >> MCSPI_XFERLEVEL_WCNT_SHIFT;
+    ch->almostFull = ((level & MCSPI_XFERLEVEL_AFL) >> MCSPI_XFERLEVEL_AFL_SHIFT) + 1;
+    ch->almostEmpty = ((level & MCSPI_XFERLEVEL_AEL) >> MCSPI_XFERLEVEL_AEL_SHIFT) + 1;
+    ch->wordsDone = 0;
+    ch->enabled = 1;
+
+    SimMcSPIWordStart(ch, simTicks);
+    SimMcSPISync(m);
+}
+
+// Disabling the channel stops the transfer and empties the FIFOs
+void McSPIChannelDisable(unsigned int baseAdd, unsigned int chNum)
+{
+    SimMcSPIModule* m = SimMcSPIModuleGet(baseAdd);
+    SimMcSPIChannel* ch = &m->ch[chNum];
+
+    simMcSPICalls++;
+
+    ch->enabled = 0;
+    ch->busy = 0;
+    ch->eowTime = 0;
+    ch->txCount = 0;
+    ch->rxCount = 0;
+    ch->rxFullTime = 0;
+    SimMcSPISync(m);
+}
+
+void McSPICSAssert(unsigned int baseAdd, unsigned int chNum)
+{
+    SimMcSPIModule* m = SimMcSPIModuleGet(baseAdd);
+    SimMcSPIChannel* ch = &m->ch[chNum];
+    uint64_t holdoff = 0;
+
+    simMcSPICalls++;
+
+    if (ch->selected)
+        return;
+
+    ch->selected = 1;
+    ch->frameIndex = 0;
+
+    if (ch->device != NULL) {
+        ch->device->select(ch->device, simTicks);
+        holdoff = ch->device->holdoff(ch->device);
+    }
+
+    // Zero means no hold-off pending, so a transfer that may start now is let through at once
+    ch->startNotBefore = (holdoff == SIM_STALL) ? SIM_STALL : ((holdoff == 0) ? 0 : simTicks + holdoff);
+
+    if (ch->trMode != MCSPI_RX_ONLY_MODE && ch->txCount == 0)
+        m->irqStatus |= MCSPI_INT_TX_EMPTY(chNum);
+
+    SimMcSPIWordStart(ch, simTicks);
+    SimMcSPISync(m);
+}
+
+void McSPICSDeAssert(unsigned int baseAdd, unsigned int chNum)
+{
+    SimMcSPIModule* m = SimMcSPIModuleGet(baseAdd);
+    SimMcSPIChannel* ch = &m->ch[chNum];
+
+    simMcSPICalls++;
+
+    if (!ch->selected)
+        return;
+
+    ch->selected = 0;
+    ch->busy = 0;
+    ch->eowTime = 0;
+    ch->startNotBefore = 0;
+
+    if (ch->device != NULL)
+        ch->device->deselect(ch->device, simTicks);
+
+    SimMcSPISync(m);
+}
+
+void McSPIDMAEnable(unsigned int baseAdd, unsigned int dmaFlags, unsigned int chNum)
+{
+    SimMcSPIModule* m = SimMcSPIModuleGet(baseAdd);
+
+    simMcSPICalls++;
+
+    if (dmaFlags & MCSPI_DMA_RX_EVENT)
+        m->ch[chNum].dmaRx = 1;
+    SimMcSPISync(m);
+}
+
+void McSPIDMADisable(unsigned int baseAdd, unsigned int dmaFlags, unsigned int chNum)
+{
+    SimMcSPIModule* m = SimMcSPIModuleGet(baseAdd);
+
+    simMcSPICalls++;
+
+    if (dmaFlags & MCSPI_DMA_RX_EVENT) {
+        m->ch[chNum].dmaRx = 0;
+        m->ch[chNum].dmaRequest = 0;
+    }
+}
+
+void McSPIIntEnable(unsigned int baseAdd, unsigned int intFlags)
+{
+    SimMcSPIModule* m = SimMcSPIModuleGet(baseAdd);
+
+    simMcSPICalls++;
+    m->irqEnable |= intFlags;
+    SimMcSPISync(m);
+}
+
+void McSPIIntDisable(unsigned int baseAdd, unsigned int intFlags)
+{
+    SimMcSPIModule* m = SimMcSPIModuleGet(baseAdd);
+
+    simMcSPICalls++;
+    m->irqEnable &= ~intFlags;
+    SimMcSPISync(m);
+}
+
+void McSPIIntStatusClear(unsigned int baseAdd, unsigned int intFlags)
+{
+    SimMcSPIModule* m = SimMcSPIModuleGet(baseAdd);
+
+    simMcSPICalls++;
+    m->irqStatus &= ~intFlags;
+    SimMcSPISync(m);
+}
+
+unsigned int McSPIIntStatusGet(unsigned int baseAdd)
+{
+    simMcSPICalls++;
+    return SimMcSPIModuleGet(baseAdd)->irqStatus;
+}
+
+unsigned int McSPIChannelStatusGet(unsigned int baseAdd, unsigned int chNum)
+{
+    simMcSPICalls++;
+    simMcSPIStatusReads++;
+    return HWREG(baseAdd + MCSPI_CHSTAT(chNum));
+}
+
+void McSPITransmitData(unsigned int baseAdd, unsigned int txData, unsigned int chNum)
+{
+    SimMcSPIModule* m = SimMcSPIModuleGet(baseAdd);
+    SimMcSPIChannel* ch = &m->ch[chNum];
+
+    simMcSPICalls++;
+    simMcSPITxWords++;
+
+    // A write to a full Tx FIFO is lost
+    if (ch->txCount < SimMcSPIDepth(ch, ch->txFifo)) {
+        ch->tx[(ch->txHead + ch->txCount) % SIM_MCSPI_FIFO_WORDS] = (uint8_t) txData;
+        ch->txCount++;
+    }
+
+    SimMcSPIWordStart(ch, simTicks);
+    SimMcSPISync(m);
+}
+
+// Reading an empty Rx FIFO returns the last word again
+unsigned int McSPIReceiveData(unsigned int baseAdd, unsigned int chNum)
+{
+    SimMcSPIModule* m = SimMcSPIModuleGet(baseAdd);
+    SimMcSPIChannel* ch = &m->ch[chNum];
+
+    simMcSPICalls++;
+
+    if (ch->rxCount > 0) {
+        SimMcSPIRxWaitEnd(ch);
+        ch->rxLast = ch->rx[ch->rxHead];
+        ch->rxHead = (ch->rxHead + 1) % SIM_MCSPI_FIFO_WORDS;
+        ch->rxCount--;
+
+        // Room in the Rx FIFO lets a transfer held up by it carry on
+        SimMcSPIWordStart(ch, simTicks);
+        SimMcSPISync(m);
+    }
+
+    return ch->rxLast;
+}
+
+//
+// A read of the register at address by EDMA3. If it is the Rx register of a channel, takes
+// the word off its Rx FIFO, or the last word again if it is empty, and returns 1; returns 0
+// for any other address. Not a McSPI call of the driver, so not counted as one.
+//
+int SimMcSPIDMARead(unsigned int address, uint32_t* word)
+{
+    for (uint32_t i = 0; i < SIM_MCSPI_MODULES; i++) {
+        for (uint32_t n = 0; n < SIM_MCSPI_CHANNELS; n++) {
+            SimMcSPIChannel* ch = &simMcSPI[i].ch[n];
+
+            if (address != simMcSPI[i].base + MCSPI_CHRX(n))
+                continue;
+
+            if (ch->rxCount > 0) {
+                SimMcSPIRxWaitEnd(ch);
+                ch->rxLast = ch->rx[ch->rxHead];
+                ch->rxHead = (ch->rxHead + 1) % SIM_MCSPI_FIFO_WORDS;
+                ch->rxCount--;
+                SimMcSPIWordStart(ch, simTicks);
+            }
+
+            *word = ch->rxLast;
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,248 @@
+/*
+ * sim_orbis.c
+ * Behavioural model of the Orbis rotary encoder on a McSPI chip select
+ *
+ * The position is latched when the encoder is selected and follows the configured
+ * trajectory, start + velocity * t + acceleration * t^2 / 2, in counts of the 14 bit
+ * position field. The response is the turn count (multi-turn only), the position word,
+ * the data asked for by the command byte, if any, and the inverted CRC, as on page 14
+ * of the Orbis datasheet. The CRC is computed bit by bit, independently of the driver.
+ *
+ * Faults to inject:
+ *   - bit errors, a random bit of the response is flipped once in bitErrorRate bits;
+ *   - stalls, the transfer never starts, so that the capture runs into its deadline;
+ *   - late responses, the transfer starts lateTicks after it could have;
+ *   - encoder errors, the error bit is set in the response, which is otherwise good;
+ *   - an outage, a run of frames that all stall.
+ * A frame is also garbled if the master breaks the timing limits of the encoder: too short
+ * a time from CS to the first clock edge shifts the response by a bit, too fast a clock
+ * corrupts one bit in eight.
+ *
+ * The time CS is high from one frame to the next is kept, the shortest and the longest,
+ * for the bursts of frames to be checked against.
+ *
+ *  Created on: 16 Oct 2026
+ */
+#include <stdint.h>
+#include "sim.h"
+
+#define SIM_ORBIS_CMD_SERIAL        0x76u
+#define SIM_ORBIS_CMD_SPEED         0x73u
+#define SIM_ORBIS_CMD_TEMPERATURE   0x74u
+#define SIM_ORBIS_CMD_STATUS        0x64u
+
+static uint32_t SimOrbisRandom(SimOrbis* orbis)
+{
+    uint32_t x = orbis->random;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    orbis->random = x;
+
+    return x;
+}
+
+// One in n, never for n of zero
+static uint8_t SimOrbisChance(SimOrbis* orbis, uint32_t n)
+{
+    return (n != 0) && (SimOrbisRandom(orbis) % n == 0);
+}
+
+// Orbis CRC: polynomial 0x97, initial value 0, no final xor, most significant bit first
+uint8_t SimOrbisCRC(const uint8_t* data, uint32_t length)
+{
+    uint8_t crc = 0;
+
+    for (uint32_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (uint32_t bit = 0; bit < 8; bit++)
+            crc = (crc & 0x80u) ? (uint8_t) ((crc << 1) ^ 0x97u) : (uint8_t) (crc << 1);
+    }
+
+    return crc;
+}
+
+// Position in counts of the 14 bit field at the time, turns included, before wrapping
+static int64_t SimOrbisCounts(SimOrbis* orbis, uint64_t time)
+{
+    double t = (double) time / SIM_CLOCK_HZ;
+    double counts = (double) orbis->startCounts + (double) orbis->velocity * t
+                  + (double) orbis->acceleration * t * t / 2;
+
+    return (int64_t) (counts < 0 ? counts - 1 : counts);
+}
+
+// The 14 bit position the encoder reports at the time, with the resolution applied
+uint32_t SimOrbisPosition(SimOrbis* orbis, uint64_t time)
+{
+    int64_t counts = SimOrbisCounts(orbis, time);
+    uint32_t position = (uint32_t) (((counts % SIM_ORBIS_COUNTS) + SIM_ORBIS_COUNTS) % SIM_ORBIS_COUNTS);
+
+    return position & ~((1u << (14 - orbis->resolution)) - 1);
+}
+
+// Put the response to the command together, for the position latched at selection
+static void SimOrbisFrameBuild(SimOrbis* orbis)
+{
+    uint32_t n = 0;
+    uint32_t position = SimOrbisPosition(orbis, orbis->selectTime);
+    uint8_t error = orbis->error;
+    uint16_t word;
+
+    if (orbis->errorEvery != 0 && orbis->frames % orbis->errorEvery == 0) {
+        orbis->errors++;
+        error = 1;
+    }
+
+    word = (uint16_t) ((position << 2) | (error ? 0 : 2) | (orbis->warning ? 0 : 1));
+
+    if (orbis->multiturn) {
+        int64_t counts = SimOrbisCounts(orbis, orbis->selectTime);
+        int64_t turns = (counts - (int64_t) position) / SIM_ORBIS_COUNTS;
+        orbis->frame[n++] = (uint8_t) (turns >> 8);
+        orbis->frame[n++] = (uint8_t) turns;
+        orbis->lastTurns = (uint16_t) turns;
+    }
+
+    orbis->frame[n++] = (uint8_t) (word >> 8);
+    orbis->frame[n++] = (uint8_t) word;
+
+    switch (orbis->command) {
+    case SIM_ORBIS_CMD_SERIAL:
+        for (uint32_t i = 0; i < sizeof(orbis->serial); i++)
+            orbis->frame[n++] = orbis->serial[i];
+        break;
+    case SIM_ORBIS_CMD_SPEED:
+        orbis->frame[n++] = (uint8_t) ((uint16_t) orbis->speed >> 8);
+        orbis->frame[n++] = (uint8_t) orbis->speed;
+        break;
+    case SIM_ORBIS_CMD_TEMPERATURE:
+        orbis->frame[n++] = (uint8_t) ((uint16_t) orbis->temperature >> 8);
+        orbis->frame[n++] = (uint8_t) orbis->temperature;
+        break;
+    case SIM_ORBIS_CMD_STATUS:
+        orbis->frame[n++] = orbis->status;
+        break;
+    default:
+        break;
+    }
+
+    orbis->frame[n] = (uint8_t) ~SimOrbisCRC(orbis->frame, n);
+    orbis->frameLength = n + 1;
+    orbis->lastPosition = position;
+}
+
+static void SimOrbisSelect(SimDevice* device, uint64_t time)
+{
+    SimOrbis* orbis = (SimOrbis*) device;
+
+    if (orbis->deselected) {
+        uint64_t csHigh = time - orbis->deselectTime;
+
+        if (csHigh < orbis->csHighMin)
+            orbis->csHighMin = csHigh;
+        if (csHigh > orbis->csHighMax)
+            orbis->csHighMax = csHigh;
+    }
+
+    orbis->frames++;
+    orbis->selectTime = time;
+    orbis->frameLength = 0;
+    orbis->garble = 0;
+}
+
+static void SimOrbisDeselect(SimDevice* device, uint64_t time)
+{
+    SimOrbis* orbis = (SimOrbis*) device;
+
+    orbis->deselectTime = time;
+    orbis->deselected = 1;
+}
+
+static uint64_t SimOrbisHoldoff(SimDevice* device)
+{
+    SimOrbis* orbis = (SimOrbis*) device;
+
+    if ((orbis->stallEvery != 0 && orbis->frames % orbis->stallEvery == 0) ||
+        (orbis->frames > orbis->outageStart && orbis->frames - orbis->outageStart <= orbis->outageFrames)) {
+        orbis->stalls++;
+        return SIM_STALL;
+    }
+
+    if (orbis->lateEvery != 0 && orbis->frames % orbis->lateEvery == 0) {
+        orbis->lates++;
+        return orbis->lateTicks;
+    }
+
+    return 0;
+}
+
+static uint8_t SimOrbisExchange(SimDevice* device, uint32_t index, uint8_t tx,
+                                uint64_t time, uint32_t clockHz)
+{
+    SimOrbis* orbis = (SimOrbis*) device;
+    uint8_t rx;
+
+    // The command byte comes in while the position goes out, and the data it asks for
+    // is only due after the position, so the whole response is known from the first word
+    if (index == 0) {
+        orbis->command = tx;
+        SimOrbisFrameBuild(orbis);
+
+        if (time - orbis->selectTime < orbis->setupTicks || clockHz > orbis->maxClockHz) {
+            orbis->violations++;
+            orbis->garble = (time - orbis->selectTime < orbis->setupTicks) ? 1 : 2;
+        }
+    }
+
+    rx = (index < orbis->frameLength) ? orbis->frame[index] : 0xFFu;
+
+    // Too early: the first bit is missed and the response comes one bit late
+    if (orbis->garble == 1)
+        rx = (uint8_t) ((rx >> 1) | ((index == 0 ? 0 : orbis->frame[index - 1]) << 7));
+
+    for (uint32_t bit = 0; bit < 8; bit++) {
+        if (SimOrbisChance(orbis, orbis->bitErrorRate) ||
+            (orbis->garble == 2 && SimOrbisChance(orbis, 8))) {
+            rx ^= (uint8_t) (1u << bit);
+            orbis->bitErrors++;
+        }
+    }
+
+    return rx;
+}
+
+//
+// Reset the state of the model, keeping its configuration. The limits left at zero
+// default to a 4 MHz clock and 1 us from CS to the first clock edge, which the driver's
+// 3 MHz clock and 2 us wait after CS assertion are within.
+//
+void SimOrbisInit(SimOrbis* orbis)
+{
+    orbis->device.select = SimOrbisSelect;
+    orbis->device.deselect = SimOrbisDeselect;
+    orbis->device.holdoff = SimOrbisHoldoff;
+    orbis->device.exchange = SimOrbisExchange;
+
+    if (orbis->resolution == 0 || orbis->resolution > 14)
+        orbis->resolution = 14;
+    if (orbis->maxClockHz == 0)
+        orbis->maxClockHz = 4000000u;
+    if (orbis->setupTicks == 0)
+        orbis->setupTicks = SIM_CLOCK_HZ / 1000000u;
+
+    orbis->frames = 0;
+    orbis->bitErrors = 0;
+    orbis->stalls = 0;
+    orbis->lates = 0;
+    orbis->violations = 0;
+    orbis->frameLength = 0;
+    orbis->garble = 0;
+    orbis->deselected = 0;
+    orbis->csHighMin = UINT64_MAX;
+    orbis->csHighMax = 0;
+
+    if (orbis->random == 0)
+        orbis->random = 2463534242u;
+}
@@ -0,0 +1,226 @@
+/*
+ * sim_spidev.c
+ * Stand-in for a Linux spidev device, with a simulated device on its chip select
+ *
+ * SimSpidevIoctl() takes the place of ioctl() on the descriptor SimSpidevOpen() gives out,
+ * so that the spidev backend (linux/orbis_spidev.c) runs on the host unchanged. It takes
+ * the SPI mode, word length and clock requests, and SPI_IOC_MESSAGE(N) with the number of
+ * transfers worked out from the size in the request, as spidev does, and the same limits:
+ * 8 bit words only here, at most SIM_SPIDEV_BUFSIZ bytes in a message.
+ *
+ * A message costs syscallTicks, for the system call and the set-up of the message in
+ * the SPI core, before its first transfer. CS is asserted before a transfer unless it has
+ * been left asserted, and the device sees the select, csSetupTicks later the first word, and
+ * every word at the clock of the transfer. After the transfer come its delay_usecs, then CS
+ * is deasserted if cs_change says so: after every transfer with it set but the last, and after
+ * the last unless it has it set, as in the SPI core.
+ *
+ * A device that stalls, see SimDevice.holdoff, leaves MISO to the pull-up, so the frame is
+ * all ones; one that is late is taken to be the same for the frame. Time is kept in the 24 MHz
+ * ticks of the rest of the simulation, but by the stand-in only, in spidev->time.
+ *
+ *  Created on: 16 Oct 2026
+ */
+#include <stdint.h>
+#include <stddef.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <linux/spi/spidev.h>
+#include "sim.h"
+
+// Message size limit of spidev, its bufsiz module parameter
+#define SIM_SPIDEV_BUFSIZ       4096u
+
+#define SIM_SPIDEV_OPEN         4u
+
+static struct {
+    int fd;
+    SimSpidev* spidev;
+} simSpidevOpen[SIM_SPIDEV_OPEN];
+
+//
+// Open the stand-in for the device, with the configuration filled in. The CS setup left at zero
+// defaults to 2 us, and a message costs nothing unless syscallTicks says otherwise.
+//
+// Returns the descriptor to use with SimSpidevIoctl(), or -1.
+//
+int SimSpidevOpen(SimSpidev* spidev, SimDevice* device)
+{
+    for (uint32_t i = 0; i < SIM_SPIDEV_OPEN; i++) {
+        if (simSpidevOpen[i].spidev != NULL)
+            continue;
+
+        // A real descriptor, so that it is not mistaken for another one
+        simSpidevOpen[i].fd = open("/dev/null", O_RDWR);
+        if (simSpidevOpen[i].fd < 0)
+            return -1;
+        simSpidevOpen[i].spidev = spidev;
+
+        spidev->device = device;
+        spidev->mode = 0;
+        spidev->bits = 8;
+        spidev->maxSpeedHz = 500000u;
+        if (spidev->csSetupTicks == 0)
+            spidev->csSetupTicks = 2 * (SIM_CLOCK_HZ / 1000000u);
+        spidev->time = 0;
+        spidev->selected = 0;
+        spidev->messages = 0;
+        spidev->transfers = 0;
+        spidev->frames = 0;
+
+        return simSpidevOpen[i].fd;
+    }
+
+    errno = EMFILE;
+    return -1;
+}
+
+void SimSpidevClose(int fd)
+{
+    for (uint32_t i = 0; i < SIM_SPIDEV_OPEN; i++) {
+        if (simSpidevOpen[i].spidev != NULL && simSpidevOpen[i].fd == fd) {
+            close(fd);
+            simSpidevOpen[i].spidev = NULL;
+        }
+    }
+}
+
+// One transfer of a message, CS asserted first if it is not
+static void SimSpidevTransfer(SimSpidev* spidev, const struct spi_ioc_transfer* transfer, uint8_t last)
+{
+    const uint8_t* tx = (const uint8_t*) (uintptr_t) transfer->tx_buf;
+    uint8_t* rx = (uint8_t*) (uintptr_t) transfer->rx_buf;
+    uint32_t clockHz = (transfer->speed_hz != 0) ? transfer->speed_hz : spidev->maxSpeedHz;
+    uint8_t deselect;
+
+    if (!spidev->selected) {
+        spidev->device->select(spidev->device, spidev->time);
+        spidev->holdoff = spidev->device->holdoff(spidev->device);
+        spidev->selected = 1;
+        spidev->index = 0;
+        if (spidev->selectLog != NULL && spidev->frames < spidev->selectLogLength)
+            spidev->selectLog[spidev->frames] = spidev->time;
+        spidev->frames++;
+        spidev->time += spidev->csSetupTicks;
+    }
+
+    for (uint32_t i = 0; i < transfer->len; i++) {
+        uint8_t word = (tx != NULL) ? tx[i] : 0;
+
+        if (spidev->holdoff != 0)
+            word = 0xFFu;
+        else
+            word = spidev->device->exchange(spidev->device, spidev->index, word, spidev->time, clockHz);
+
+        if (rx != NULL)
+            rx[i] = word;
+
+        spidev->index++;
+        spidev->time += (uint64_t) 8 * SIM_CLOCK_HZ / clockHz;
+    }
+
+    spidev->time += (uint64_t) transfer->delay_usecs * (SIM_CLOCK_HZ / 1000000u);
+
+    deselect = transfer->cs_change ? !last : last;
+    if (deselect) {
+        spidev->device->deselect(spidev->device, spidev->time);
+        spidev->selected = 0;
+    }
+
+    spidev->transfers++;
+}
+
+// SPI_IOC_MESSAGE(n): check the transfers as spidev does, then run them
+static int SimSpidevMessage(SimSpidev* spidev, const struct spi_ioc_transfer* transfers, uint32_t n)
+{
+    uint32_t total = 0;
+
+    for (uint32_t i = 0; i < n; i++) {
+        if (transfers[i].bits_per_word != 0 && transfers[i].bits_per_word != 8) {
+            errno = EINVAL;
+            return -1;
+        }
+        if (transfers[i].speed_hz > spidev->maxSpeedHz) {
+            errno = EINVAL;
+            return -1;
+        }
+        total += transfers[i].len;
+    }
+
+    if (total > SIM_SPIDEV_BUFSIZ) {
+        errno = EMSGSIZE;
+        return -1;
+    }
+
+    spidev->messages++;
+    spidev->time += spidev->syscallTicks;
+
+    for (uint32_t i = 0; i < n; i++)
+        SimSpidevTransfer(spidev, &transfers[i], i == n - 1);
+
+    return (int) total;
+}
+
+//
+// ioctl() on a descriptor from SimSpidevOpen(): the spidev requests the backend makes.
+//
+// Returns what spidev would, -1 with errno set for a request it would refuse.
+//
+int SimSpidevIoctl(int fd, unsigned long request, void* arg)
+{
+    SimSpidev* spidev = NULL;
+
+    for (uint32_t i = 0; i < SIM_SPIDEV_OPEN; i++) {
+        if (simSpidevOpen[i].spidev != NULL && simSpidevOpen[i].fd == fd)
+            spidev = simSpidevOpen[i].spidev;
+    }
+
+    if (spidev == NULL) {
+        errno = EBADF;
+        return -1;
+    }
+
+    switch (request) {
+    case SPI_IOC_WR_MODE:
+        spidev->mode = *(uint8_t*) arg;
+        return 0;
+    case SPI_IOC_RD_MODE:
+        *(uint8_t*) arg = spidev->mode;
+        return 0;
+    case SPI_IOC_WR_BITS_PER_WORD:
+        if (*(uint8_t*) arg != 0 && *(uint8_t*) arg != 8) {
+            errno = EINVAL;
+            return -1;
+        }
+        spidev->bits = 8;
+        return 0;
+    case SPI_IOC_RD_BITS_PER_WORD:
+        *(uint8_t*) arg = spidev->bits;
+        return 0;
+    case SPI_IOC_WR_MAX_SPEED_HZ:
+        spidev->maxSpeedHz = *(uint32_t*) arg;
+        return 0;
+    case SPI_IOC_RD_MAX_SPEED_HZ:
+        *(uint32_t*) arg = spidev->maxSpeedHz;
+        return 0;
+    default:
+        break;
+    }
+
+    // SPI_IOC_MESSAGE(n), whose size is that of n transfers
+    if (_IOC_TYPE(request) == SPI_IOC_MAGIC && _IOC_NR(request) == 0 && _IOC_DIR(request) == _IOC_WRITE) {
+        uint32_t size = _IOC_SIZE(request);
+
+        if (size == 0 || size % sizeof(struct spi_ioc_transfer) != 0) {
+            errno = EINVAL;
+            return -1;
+        }
+
+        return SimSpidevMessage(spidev, (const struct spi_ioc_transfer*) arg,
+                                size / sizeof(struct spi_ioc_transfer));
+    }
+
+    errno = ENOTTY;
+    return -1;
+}
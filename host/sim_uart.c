@@ -0,0 +1,169 @@
+/*
+ * sim_uart.c
+ * Behavioural model of the AM335x UART0 transmitter
+ *
+ * The Tx FIFO holds 64 bytes and shifts them out at the programmed bit rate, 10 bits
+ * a byte (8N1). The THR interrupt, when enabled, is raised while the FIFO has room for
+ * the trigger level number of bytes (granularity 1). Bytes written into a full FIFO are
+ * lost and counted. Every byte is appended to the capture file, if there is one, as it
+ * enters the FIFO. The receiver is not modelled.
+ *
+ *  Created on: 16 Oct 2026
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include "hw_types.h"
+#include "soc_AM335x.h"
+#include "interrupt.h"
+#include "uart_irda_cir.h"
+#include "sim.h"
+
+#define SIM_UART_FIFO           64u
+
+static struct {
+    uint32_t divisor;
+    uint32_t trigger;
+    uint32_t level;             // bytes in the Tx FIFO
+    uint64_t shiftEnd;          // when the byte being shifted out is gone
+    uint8_t thrEnabled;
+    uint8_t enabled;
+} simUART = { .divisor = 26, .trigger = 1 };
+
+static FILE* simUARTCapture;
+
+// Bytes written to the Tx FIFO, and lost because it was full
+uint32_t simUARTBytes;
+uint32_t simUARTOverflows;
+
+// Write everything sent from now on to the file
+void SimUARTCapture(FILE* file)
+{
+    simUARTCapture = file;
+}
+
+static uint64_t SimUARTByteTicks(void)
+{
+    return 10ull * 16u * simUART.divisor * SIM_CLOCK_HZ / 48000000u;
+}
+
+static void SimUARTSync(void)
+{
+    if (simUART.thrEnabled && SIM_UART_FIFO - simUART.level >= simUART.trigger)
+        SimInterruptRaise(SYS_INT_UART0INT);
+    else
+        SimInterruptLower(SYS_INT_UART0INT);
+}
+
+// Time the byte being shifted out is gone
+uint64_t SimUARTNextEvent(void)
+{
+    return (simUART.level > 0) ? simUART.shiftEnd : UINT64_MAX;
+}
+
+void SimUARTUpdate(void)
+{
+    uint8_t changed = 0;
+
+    while (simUART.level > 0 && simUART.shiftEnd <= simTicks) {
+        simUART.level--;
+        simUART.shiftEnd += SimUARTByteTicks();
+        changed = 1;
+    }
+
+    if (changed)
+        SimUARTSync();
+}
+
+unsigned int UARTOperatingModeSelect(unsigned int baseAdd, unsigned int modeFlag)
+{
+    simUART.enabled = (modeFlag != UART_DISABLED_MODE);
+    return 0;
+}
+
+unsigned int UARTDivisorValCompute(unsigned int moduleClk, unsigned int baudRate,
+                                   unsigned int modeFlag, unsigned int mirOverSampRate)
+{
+    unsigned int oversampling = (modeFlag == UART13x_OPER_MODE) ? 13u : 16u;
+
+    return moduleClk / (oversampling * baudRate);
+}
+
+unsigned int UARTDivisorLatchWrite(unsigned int baseAdd, unsigned int divisorValue)
+{
+    simUART.divisor = divisorValue ? divisorValue : 1u;
+    return 0;
+}
+
+void UARTDivisorLatchDisable(unsigned int baseAdd)
+{
+}
+
+unsigned int UARTRegConfigModeEnable(unsigned int baseAdd, unsigned int modeFlag)
+{
+    return 0;
+}
+
+void UARTLineCharacConfig(unsigned int baseAdd, unsigned int wLenStbFlag, unsigned int parityFlag)
+{
+}
+
+unsigned int UARTFIFOConfig(unsigned int baseAdd, unsigned int fifoConfig)
+{
+    simUART.trigger = (fifoConfig >> 14) & 0xFFu;
+    if (simUART.trigger == 0)
+        simUART.trigger = 1;
+
+    // Tx FIFO clear
+    if (fifoConfig & (1u << 5))
+        simUART.level = 0;
+
+    return 0;
+}
+
+unsigned int UARTFIFOWrite(unsigned int baseAdd, unsigned char* pBuffer, unsigned int numTxBytes)
+{
+    for (unsigned int i = 0; i < numTxBytes; i++) {
+        if (simUART.level == SIM_UART_FIFO) {
+            simUARTOverflows++;
+            continue;
+        }
+
+        if (simUART.level == 0)
+            simUART.shiftEnd = simTicks + SimUARTByteTicks();
+        simUART.level++;
+        simUARTBytes++;
+
+        if (simUARTCapture != NULL)
+            fputc(pBuffer[i], simUARTCapture);
+    }
+
+    SimUARTSync();
+    return numTxBytes;
+}
+
+void UARTIntEnable(unsigned int baseAdd, unsigned int intFlag)
+{
+    if (intFlag & UART_INT_THR)
+        simUART.thrEnabled = 1;
+    SimUARTSync();
+}
+
+void UARTIntDisable(unsigned int baseAdd, unsigned int intFlag)
+{
+    if (intFlag & UART_INT_THR)
+        simUART.thrEnabled = 0;
+    SimUARTSync();
+}
+
+unsigned int UARTIntIdentityGet(unsigned int baseAdd)
+{
+    if (simUART.thrEnabled && SIM_UART_FIFO - simUART.level >= simUART.trigger)
+        return UART_INTID_TX_THRES_REACH;
+
+    return 0;
+}
+
+signed char UARTCharGetNonBlocking(unsigned int baseAdd)
+{
+    return -1;
+}
@@ -0,0 +1,22 @@
+/*
+ * beaglebone.h
+ * Host stand-in for the StarterWare header of the same name.
+ * The clock and pin mux functions are no-ops, see sim_board.c.
+ */
+#ifndef _BEAGLEBONE_H_
+#define _BEAGLEBONE_H_
+
+#define CONTROL_CONF_SPI0_SCLK          (0x950)
+#define CONTROL_CONF_SPI0_D0            (0x954)
+#define CONTROL_CONF_SPI0_D1            (0x958)
+#define CONTROL_CONF_SPI0_CS0           (0x95C)
+#define CONTROL_CONF_SPI0_CS1           (0x960)
+
+void GPIO0ModuleClkConfig(void);
+void GPIO1ModuleClkConfig(void);
+void GPIO1Pin23PinMuxSetup(void);
+void DMTimer2ModuleClkConfig(void);
+void DMTimer4ModuleClkConfig(void);
+void EDMAModuleClkConfig(void);
+
+#endif
@@ -0,0 +1,14 @@
+/*
+ * consoleUtils.h
+ * Host stand-in for the StarterWare header of the same name. Prints to stdout.
+ */
+#ifndef _CONSOLEUTILS_H_
+#define _CONSOLEUTILS_H_
+
+#define CONSOLE_UART                    (0)
+
+void ConsoleUtilsInit(void);
+void ConsoleUtilsSetType(int consoleType);
+void ConsoleUtilsPrintf(const char *string, ...);
+
+#endif
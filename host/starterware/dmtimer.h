@@ -0,0 +1,44 @@
+/*
+ * dmtimer.h
+ * Host stand-in for the StarterWare header of the same name.
+ * The functions are implemented by the DMTimer model in sim_dmtimer.c.
+ */
+#ifndef _DMTIMER_H_
+#define _DMTIMER_H_
+
+#include "hw_dmtimer.h"
+
+#define DMTIMER_ONESHOT_CMP_ENABLE      (0x00000040u)
+#define DMTIMER_ONESHOT_NOCMP_ENABLE    (0x00000000u)
+#define DMTIMER_AUTORLD_CMP_ENABLE      (0x00000042u)
+#define DMTIMER_AUTORLD_NOCMP_ENABLE    (0x00000002u)
+
+#define DMTIMER_INT_TCAR_IT_FLAG        (0x00000004u)
+#define DMTIMER_INT_OVF_IT_FLAG         (0x00000002u)
+#define DMTIMER_INT_MAT_IT_FLAG         (0x00000001u)
+
+#define DMTIMER_INT_TCAR_EN_FLAG        (0x00000004u)
+#define DMTIMER_INT_OVF_EN_FLAG         (0x00000002u)
+#define DMTIMER_INT_MAT_EN_FLAG         (0x00000001u)
+
+#define DMTIMER_POSTED                  (0x00000004u)
+#define DMTIMER_NONPOSTED               (0x00000000u)
+
+void DMTimerEnable(unsigned int baseAdd);
+void DMTimerDisable(unsigned int baseAdd);
+void DMTimerModeConfigure(unsigned int baseAdd, unsigned int timerMode);
+void DMTimerPreScalerClkEnable(unsigned int baseAdd, unsigned int ptv);
+void DMTimerPreScalerClkDisable(unsigned int baseAdd);
+void DMTimerCounterSet(unsigned int baseAdd, unsigned int counter);
+unsigned int DMTimerCounterGet(unsigned int baseAdd);
+void DMTimerReloadSet(unsigned int baseAdd, unsigned int reload);
+unsigned int DMTimerReloadGet(unsigned int baseAdd);
+void DMTimerCompareSet(unsigned int baseAdd, unsigned int compareVal);
+unsigned int DMTimerCompareGet(unsigned int baseAdd);
+unsigned int DMTimerIntStatusGet(unsigned int baseAdd);
+void DMTimerIntStatusClear(unsigned int baseAdd, unsigned int intFlags);
+void DMTimerIntEnable(unsigned int baseAdd, unsigned int enableFlags);
+void DMTimerIntDisable(unsigned int baseAdd, unsigned int enableFlags);
+void DMTimerPostedModeConfig(unsigned int baseAdd, unsigned int postMode);
+
+#endif
@@ -0,0 +1,44 @@
+/*
+ * edma.h
+ * Host stand-in for the StarterWare header of the same name.
+ * The functions are implemented by the EDMA3 model in sim_edma.c.
+ */
+#ifndef _EDMA_H_
+#define _EDMA_H_
+
+#include "hw_edma3cc.h"
+
+#define EDMA3_CHANNEL_TYPE_DMA          (0u)
+#define EDMA3_CHANNEL_TYPE_QDMA         (1u)
+
+#define EDMA3_TRIG_MODE_MANUAL          (0u)
+#define EDMA3_TRIG_MODE_QDMA            (1u)
+#define EDMA3_TRIG_MODE_EVENT           (2u)
+
+typedef struct EDMA3CCPaRAMEntry {
+    unsigned int opt;
+    unsigned int srcAddr;
+    unsigned short aCnt;
+    unsigned short bCnt;
+    unsigned int destAddr;
+    short srcBIdx;
+    short destBIdx;
+    unsigned short linkAddr;
+    unsigned short bCntReload;
+    short srcCIdx;
+    short destCIdx;
+    unsigned short cCnt;
+    unsigned short rsvd;
+} EDMA3CCPaRAMEntry;
+
+void EDMA3Init(unsigned int baseAdd, unsigned int queNum);
+unsigned int EDMA3RequestChannel(unsigned int baseAdd, unsigned int chType, unsigned int chNum,
+                                 unsigned int tccNum, unsigned int evtQNum);
+void EDMA3SetPaRAM(unsigned int baseAdd, unsigned int chNum, EDMA3CCPaRAMEntry* newPaRAM);
+void EDMA3GetPaRAM(unsigned int baseAdd, unsigned int PaRAMId, EDMA3CCPaRAMEntry* currPaRAM);
+unsigned int EDMA3EnableTransfer(unsigned int baseAdd, unsigned int chNum, unsigned int trigMode);
+unsigned int EDMA3DisableTransfer(unsigned int baseAdd, unsigned int chNum, unsigned int trigMode);
+unsigned int EDMA3GetIntrStatus(unsigned int baseAdd);
+void EDMA3ClrIntr(unsigned int baseAdd, unsigned int value);
+
+#endif
@@ -0,0 +1,18 @@
+/*
+ * gpio_v2.h
+ * Host stand-in for the StarterWare header of the same name.
+ */
+#ifndef _GPIO_V2_H_
+#define _GPIO_V2_H_
+
+#define GPIO_PIN_LOW                    (0x0)
+#define GPIO_PIN_HIGH                   (0x1)
+#define GPIO_DIR_OUTPUT                 (0x0)
+#define GPIO_DIR_INPUT                  (0x1)
+
+void GPIOModuleEnable(unsigned int baseAdd);
+void GPIOModuleReset(unsigned int baseAdd);
+void GPIODirModeSet(unsigned int baseAdd, unsigned int pinNumber, unsigned int pinDirection);
+void GPIOPinWrite(unsigned int baseAdd, unsigned int pinNumber, unsigned int pinValue);
+
+#endif
@@ -0,0 +1,21 @@
+/*
+ * hw_dmtimer.h
+ * Host stand-in for the StarterWare header of the same name.
+ */
+#ifndef _HW_DMTIMER_H_
+#define _HW_DMTIMER_H_
+
+#define DMTIMER_IRQSTATUS_RAW           (0x24)
+#define DMTIMER_IRQSTATUS               (0x28)
+#define DMTIMER_IRQENABLE_SET           (0x2C)
+#define DMTIMER_IRQENABLE_CLR           (0x30)
+#define DMTIMER_TCLR                    (0x38)
+#define DMTIMER_TCRR                    (0x3C)
+#define DMTIMER_TLDR                    (0x40)
+#define DMTIMER_TWPS                    (0x48)
+#define DMTIMER_TMAR                    (0x4C)
+#define DMTIMER_TSICR                   (0x54)
+
+#define DMTIMER_TSICR_POSTED            (0x00000004u)
+
+#endif
@@ -0,0 +1,22 @@
+/*
+ * hw_edma3cc.h
+ * Host stand-in for the StarterWare header of the same name.
+ * Only the PaRAM OPT fields used by the driver are listed.
+ */
+#ifndef _HW_EDMA3CC_H_
+#define _HW_EDMA3CC_H_
+
+#define EDMA3CC_OPT(n)                  (0x4000 + ((n) * 0x20))
+
+#define EDMA3CC_OPT_SYNCDIM             (0x00000004u)
+#define EDMA3CC_OPT_SYNCDIM_SHIFT       (0x00000002u)
+#define EDMA3CC_OPT_STATIC              (0x00000008u)
+#define EDMA3CC_OPT_STATIC_SHIFT        (0x00000003u)
+#define EDMA3CC_OPT_TCC                 (0x0003F000u)
+#define EDMA3CC_OPT_TCC_SHIFT           (0x0000000Cu)
+#define EDMA3CC_OPT_TCINTEN             (0x00100000u)
+#define EDMA3CC_OPT_TCINTEN_SHIFT       (0x00000014u)
+#define EDMA3CC_OPT_ITCINTEN            (0x00200000u)
+#define EDMA3CC_OPT_ITCINTEN_SHIFT      (0x00000015u)
+
+#endif
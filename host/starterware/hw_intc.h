@@ -0,0 +1,16 @@
+/*
+ * hw_intc.h
+ * Host stand-in for the StarterWare header of the same name.
+ * Only the AINTC registers used by the driver are listed.
+ */
+#ifndef _HW_INTC_H_
+#define _HW_INTC_H_
+
+#define INTC_CONTROL                    (0x48)
+#define INTC_CONTROL_NEWFIQAGR          (0x00000002u)
+#define INTC_CONTROL_NEWIRQAGR          (0x00000001u)
+
+#define INTC_ISR_SET(n)                 (0x90 + ((n) * 0x20))
+#define INTC_ISR_CLEAR(n)               (0x94 + ((n) * 0x20))
+
+#endif
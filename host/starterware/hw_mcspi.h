@@ -0,0 +1,44 @@
+/*
+ * hw_mcspi.h
+ * Host stand-in for the StarterWare header of the same name.
+ * Register offsets and bit fields follow the AM335x TRM.
+ */
+#ifndef _HW_MCSPI_H_
+#define _HW_MCSPI_H_
+
+#define MCSPI_SYSCONFIG                 (0x110)
+#define MCSPI_SYSSTATUS                 (0x114)
+#define MCSPI_IRQSTATUS                 (0x118)
+#define MCSPI_IRQENABLE                 (0x11C)
+#define MCSPI_SYST                      (0x124)
+#define MCSPI_MODULCTRL                 (0x128)
+#define MCSPI_CHCONF(n)                 (0x12C + ((n) * 0x14))
+#define MCSPI_CHSTAT(n)                 (0x130 + ((n) * 0x14))
+#define MCSPI_CHCTRL(n)                 (0x134 + ((n) * 0x14))
+#define MCSPI_CHTX(n)                   (0x138 + ((n) * 0x14))
+#define MCSPI_CHRX(n)                   (0x13C + ((n) * 0x14))
+#define MCSPI_XFERLEVEL                 (0x17C)
+
+#define MCSPI_CH0STAT_RXS               (0x00000001u)
+#define MCSPI_CH0STAT_TXS               (0x00000002u)
+#define MCSPI_CH0STAT_EOT               (0x00000004u)
+#define MCSPI_CH0STAT_TXFFE             (0x00000008u)
+#define MCSPI_CH0STAT_TXFFF             (0x00000010u)
+#define MCSPI_CH0STAT_RXFFE             (0x00000020u)
+#define MCSPI_CH0STAT_RXFFF             (0x00000040u)
+
+#define MCSPI_CH0CONF_TCS0              (0x06000000u)
+#define MCSPI_CH0CONF_TCS0_SHIFT        (0x00000019u)
+
+#define MCSPI_CH0CTRL_EN                (0x00000001u)
+
+#define MCSPI_IRQSTATUS_EOW             (0x00020000u)
+
+#define MCSPI_XFERLEVEL_AEL             (0x0000003Fu)
+#define MCSPI_XFERLEVEL_AEL_SHIFT       (0x00000000u)
+#define MCSPI_XFERLEVEL_AFL             (0x00003F00u)
+#define MCSPI_XFERLEVEL_AFL_SHIFT       (0x00000008u)
+#define MCSPI_XFERLEVEL_WCNT            (0xFFFF0000u)
+#define MCSPI_XFERLEVEL_WCNT_SHIFT      (0x00000010u)
+
+#endif
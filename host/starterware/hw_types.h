@@ -0,0 +1,18 @@
+/*
+ * hw_types.h
+ * Host stand-in for the StarterWare header of the same name.
+ *
+ * Register accesses go to the simulated register file instead of the memory map,
+ * see SimRegister() in sim.c.
+ */
+#ifndef _HW_TYPES_H_
+#define _HW_TYPES_H_
+
+volatile unsigned int* SimRegister(unsigned int address);
+
+#define HWREG(x)        (*SimRegister(x))
+
+#define TRUE            1
+#define FALSE           0
+
+#endif
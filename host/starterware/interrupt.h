@@ -0,0 +1,37 @@
+/*
+ * interrupt.h
+ * Host stand-in for the StarterWare header of the same name.
+ * The functions are implemented by the interrupt controller model in sim.c.
+ */
+#ifndef _INTERRUPT_H_
+#define _INTERRUPT_H_
+
+#define SYS_INT_BENCH                   (3)
+#define SYS_INT_EDMACOMPINT             (12)
+#define SYS_INT_SPI0INT                 (65)
+#define SYS_INT_TINT2                   (68)
+#define SYS_INT_TINT3                   (69)
+#define SYS_INT_UART0INT                (72)
+#define SYS_INT_TINT4                   (92)
+#define SYS_INT_TINT5                   (93)
+#define SYS_INT_TINT6                   (94)
+#define SYS_INT_TINT7                   (95)
+#define SYS_INT_SPI1INT                 (125)
+
+#define AINTC_HOSTINT_ROUTE_IRQ         (0)
+#define AINTC_HOSTINT_ROUTE_FIQ         (1)
+
+void IntAINTCInit(void);
+void IntMasterIRQEnable(void);
+void IntMasterIRQDisable(void);
+void IntMasterFIQEnable(void);
+unsigned int IntMasterStatusGet(void);
+unsigned char IntDisable(void);
+void IntEnable(unsigned char status);
+void IntRegister(unsigned int intrNum, void (*fnHandler)(void));
+void IntUnRegister(unsigned int intrNum);
+void IntPrioritySet(unsigned int intrNum, unsigned int priority, unsigned int hostIntRoute);
+void IntSystemEnable(unsigned int intrNum);
+void IntSystemDisable(unsigned int intrNum);
+
+#endif
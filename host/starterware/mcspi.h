@@ -0,0 +1,94 @@
+/*
+ * mcspi.h
+ * Host stand-in for the StarterWare header of the same name.
+ * The functions are implemented by the McSPI model in sim_mcspi.c.
+ */
+#ifndef _MCSPI_H_
+#define _MCSPI_H_
+
+#include "hw_mcspi.h"
+
+#define MCSPI_INT_TX_EMPTY(chan)        (0x1u << ((chan) * 4))
+#define MCSPI_INT_TX_UNDERFLOW(chan)    (0x2u << ((chan) * 4))
+#define MCSPI_INT_RX_FULL(chan)         (0x4u << ((chan) * 4))
+#define MCSPI_INT_RX0_OVERFLOW          (0x8u)
+#define MCSPI_INT_EOWKE                 (MCSPI_IRQSTATUS_EOW)
+
+#define MCSPI_TX_RX_MODE                (0x00000000u)
+#define MCSPI_RX_ONLY_MODE              (0x00001000u)
+#define MCSPI_TX_ONLY_MODE              (0x00002000u)
+
+#define MCSPI_DATA_LINE_COMM_MODE_0     (0x0u)
+#define MCSPI_DATA_LINE_COMM_MODE_1     (0x1u)
+#define MCSPI_DATA_LINE_COMM_MODE_2     (0x2u)
+#define MCSPI_DATA_LINE_COMM_MODE_3     (0x3u)
+#define MCSPI_DATA_LINE_COMM_MODE_4     (0x4u)
+#define MCSPI_DATA_LINE_COMM_MODE_5     (0x5u)
+#define MCSPI_DATA_LINE_COMM_MODE_6     (0x6u)
+#define MCSPI_DATA_LINE_COMM_MODE_7     (0x7u)
+
+#define MCSPI_SINGLE_CH                 (0x1u)
+#define MCSPI_MULTI_CH                  (0x0u)
+
+#define MCSPI_CLK_MODE_0                (0x0u)
+#define MCSPI_CLK_MODE_1                (0x1u)
+#define MCSPI_CLK_MODE_2                (0x2u)
+#define MCSPI_CLK_MODE_3                (0x3u)
+
+#define MCSPI_CS_POL_HIGH               (0x00u)
+#define MCSPI_CS_POL_LOW                (0x40u)
+
+#define MCSPI_CS_TCS_0PNT5_CLK          (0x0u << MCSPI_CH0CONF_TCS0_SHIFT)
+#define MCSPI_CS_TCS_1PNT5_CLK          (0x1u << MCSPI_CH0CONF_TCS0_SHIFT)
+#define MCSPI_CS_TCS_2PNT5_CLK          (0x2u << MCSPI_CH0CONF_TCS0_SHIFT)
+#define MCSPI_CS_TCS_3PNT5_CLK          (0x3u << MCSPI_CH0CONF_TCS0_SHIFT)
+
+#define MCSPI_WORD_LENGTH(n)            ((unsigned int) ((n) - 1) << 7)
+
+#define MCSPI_RX_FIFO_ENABLE            (0x10000000u)
+#define MCSPI_RX_FIFO_DISABLE           (0x00000000u)
+#define MCSPI_TX_FIFO_ENABLE            (0x08000000u)
+#define MCSPI_TX_FIFO_DISABLE           (0x00000000u)
+
+#define MCSPI_DMA_RX_EVENT              (0x00008000u)
+#define MCSPI_DMA_TX_EVENT              (0x00004000u)
+
+#define MCSPI_CH_STAT_RXS_FULL          (MCSPI_CH0STAT_RXS)
+#define MCSPI_CH_STAT_TXS_EMPTY         (MCSPI_CH0STAT_TXS)
+#define MCSPI_CH_STAT_EOT               (MCSPI_CH0STAT_EOT)
+#define MCSPI_CH_TXFFE                  (MCSPI_CH0STAT_TXFFE)
+#define MCSPI_CH_TXFFF                  (MCSPI_CH0STAT_TXFFF)
+#define MCSPI_CH_RXFFE                  (MCSPI_CH0STAT_RXFFE)
+#define MCSPI_CH_RXFFF                  (MCSPI_CH0STAT_RXFFF)
+
+void McSPIClkConfig(unsigned int baseAdd, unsigned int spiInClk, unsigned int spiOutClk,
+                    unsigned int chNum, unsigned int clkMode);
+void McSPIWordLengthSet(unsigned int baseAdd, unsigned int wordLength, unsigned int chNum);
+void McSPICSEnable(unsigned int baseAdd);
+void McSPICSDisable(unsigned int baseAdd);
+void McSPICSPolarityConfig(unsigned int baseAdd, unsigned int spiEnPol, unsigned int chNum);
+void McSPICSTimeControlSet(unsigned int baseAdd, unsigned int csTimeControl, unsigned int chNum);
+void McSPIChannelEnable(unsigned int baseAdd, unsigned int chNum);
+void McSPIChannelDisable(unsigned int baseAdd, unsigned int chNum);
+void McSPIReset(unsigned int baseAdd);
+void McSPICSAssert(unsigned int baseAdd, unsigned int chNum);
+void McSPICSDeAssert(unsigned int baseAdd, unsigned int chNum);
+void McSPIMasterModeEnable(unsigned int baseAdd);
+unsigned int McSPIMasterModeConfig(unsigned int baseAdd, unsigned int channelMode,
+                                   unsigned int trMode, unsigned int pinMode, unsigned int chNum);
+void McSPIDMAEnable(unsigned int baseAdd, unsigned int dmaFlags, unsigned int chNum);
+void McSPIDMADisable(unsigned int baseAdd, unsigned int dmaFlags, unsigned int chNum);
+void McSPIIntEnable(unsigned int baseAdd, unsigned int intFlags);
+void McSPIIntDisable(unsigned int baseAdd, unsigned int intFlags);
+void McSPITransmitData(unsigned int baseAdd, unsigned int txData, unsigned int chNum);
+unsigned int McSPIReceiveData(unsigned int baseAdd, unsigned int chNum);
+void McSPIIntStatusClear(unsigned int baseAdd, unsigned int intFlags);
+unsigned int McSPIIntStatusGet(unsigned int baseAdd);
+unsigned int McSPIChannelStatusGet(unsigned int baseAdd, unsigned int chNum);
+void McSPITxFIFOConfig(unsigned int baseAdd, unsigned int txFifo, unsigned int chNum);
+void McSPIRxFIFOConfig(unsigned int baseAdd, unsigned int rxFifo, unsigned int chNum);
+void McSPIFIFOTrigLvlSet(unsigned int baseAdd, unsigned char afl, unsigned char ael,
+                         unsigned int trMode);
+void McSPIWordCountSet(unsigned int baseAdd, unsigned short wCnt);
+
+#endif
@@ -0,0 +1,20 @@
+/*
+ * pin_mux.h
+ * Host stand-in for the pin mux header used by the driver.
+ */
+#ifndef _PIN_MUX_H_
+#define _PIN_MUX_H_
+
+#define PAD_FS_RXE_NA_PUPDD(n)          (0x28u | (n))
+#define PAD_FS_RXD_NA_PUPDD(n)          (0x08u | (n))
+#define PAD_FS_RXE_PU_PUPDE(n)          (0x30u | (n))
+
+#define CONTROL_CONF_ECAP0_IN_PWM0_OUT  (0x964)
+#define CONTROL_CONF_MCASP0_ACLKX       (0x990)
+#define CONTROL_CONF_MCASP0_FSX         (0x994)
+#define CONTROL_CONF_MCASP0_AXR0        (0x998)
+#define CONTROL_CONF_MCASP0_AHCLKR      (0x99C)
+
+void GpioPinMuxSetup(unsigned int offsetAddr, unsigned int padConfValue);
+
+#endif
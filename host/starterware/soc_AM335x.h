@@ -0,0 +1,29 @@
+/*
+ * soc_AM335x.h
+ * Host stand-in for the StarterWare header of the same name.
+ * Only the module base addresses used by the driver are listed.
+ */
+#ifndef _SOC_AM335x_H_
+#define _SOC_AM335x_H_
+
+#define SOC_SPI_0_REGS                  (0x48030000u)
+#define SOC_SPI_1_REGS                  (0x481A0000u)
+
+#define SOC_DMTIMER_2_REGS              (0x48040000u)
+#define SOC_DMTIMER_3_REGS              (0x48042000u)
+#define SOC_DMTIMER_4_REGS              (0x48044000u)
+#define SOC_DMTIMER_5_REGS              (0x48046000u)
+#define SOC_DMTIMER_6_REGS              (0x48048000u)
+#define SOC_DMTIMER_7_REGS              (0x4804A000u)
+
+#define SOC_GPIO_0_REGS                 (0x44E07000u)
+#define SOC_GPIO_1_REGS                 (0x4804C000u)
+
+#define SOC_UART_0_REGS                 (0x44E09000u)
+#define SOC_AINTC_REGS                  (0x48200000u)
+#define SOC_EDMA30CC_0_REGS             (0x49000000u)
+#define SOC_CM_PER_REGS                 (0x44E00000u)
+#define SOC_CM_DPLL_REGS                (0x44E00500u)
+#define SOC_CONTROL_REGS                (0x44E10000u)
+
+#endif
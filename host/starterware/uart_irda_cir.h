@@ -0,0 +1,52 @@
+/*
+ * uart_irda_cir.h
+ * Host stand-in for the StarterWare header of the same name.
+ * The functions are implemented by the UART model in sim_uart.c.
+ */
+#ifndef _UART_IRDA_CIR_H_
+#define _UART_IRDA_CIR_H_
+
+#define UART_INT_THR                    (0x00000002u)
+#define UART_INTID_TX_THRES_REACH       (0x00000002u)
+
+#define UART16x_OPER_MODE               (0x00000000u)
+#define UART13x_OPER_MODE               (0x00000003u)
+#define UART_DISABLED_MODE              (0x00000007u)
+#define UART_MIR_OVERSAMPLING_RATE_41   (0x00000000u)
+#define UART_MIR_OVERSAMPLING_RATE_42   (0x00000080u)
+
+#define UART_REG_CONFIG_MODE_A          (0x0080u)
+#define UART_REG_CONFIG_MODE_B          (0x00BFu)
+#define UART_REG_OPERATIONAL_MODE       (0x007Fu)
+
+#define UART_FRAME_WORD_LENGTH_8        (0x00000003u)
+#define UART_FRAME_NUM_STB_1            (0x00000000u)
+#define UART_PARITY_NONE                (0x00000000u)
+
+#define UART_TRIG_LVL_GRANULARITY_4     (0x00000000u)
+#define UART_TRIG_LVL_GRANULARITY_1     (0x00000001u)
+#define UART_DMA_EN_PATH_FCR            (0x00000000u)
+#define UART_DMA_EN_PATH_SCR            (0x00000001u)
+#define UART_DMA_MODE_0_ENABLE          (0x00000000u)
+
+#define UART_FIFO_CONFIG(txGra, rxGra, txTrig, rxTrig, txClr, rxClr, dmaEnPath, dmaMode) \
+        ((unsigned int) ((((txGra) & 0xF) << 26) | (((rxGra) & 0xF) << 22) | \
+                         (((txTrig) & 0xFF) << 14) | (((rxTrig) & 0xFF) << 6) | \
+                         (((txClr) & 0x1) << 5) | (((rxClr) & 0x1) << 4) | \
+                         (((dmaEnPath) & 0x1) << 3) | ((dmaMode) & 0x7)))
+
+unsigned int UARTOperatingModeSelect(unsigned int baseAdd, unsigned int modeFlag);
+unsigned int UARTDivisorValCompute(unsigned int moduleClk, unsigned int baudRate,
+                                   unsigned int modeFlag, unsigned int mirOverSampRate);
+unsigned int UARTDivisorLatchWrite(unsigned int baseAdd, unsigned int divisorValue);
+void UARTDivisorLatchDisable(unsigned int baseAdd);
+unsigned int UARTRegConfigModeEnable(unsigned int baseAdd, unsigned int modeFlag);
+void UARTLineCharacConfig(unsigned int baseAdd, unsigned int wLenStbFlag, unsigned int parityFlag);
+unsigned int UARTFIFOConfig(unsigned int baseAdd, unsigned int fifoConfig);
+unsigned int UARTFIFOWrite(unsigned int baseAdd, unsigned char* pBuffer, unsigned int numTxBytes);
+void UARTIntEnable(unsigned int baseAdd, unsigned int intFlag);
+void UARTIntDisable(unsigned int baseAdd, unsigned int intFlag);
+unsigned int UARTIntIdentityGet(unsigned int baseAdd);
+signed char UARTCharGetNonBlocking(unsigned int baseAdd);
+
+#endif
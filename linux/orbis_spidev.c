@@ -0,0 +1,205 @@
+/*
+ * orbis_spidev.c
+ * Orbis encoder through the Linux spidev interface
+ *
+ * The bare-metal driver owns the McSPI and takes an interrupt or two per frame. Under Linux
+ * the frames go through the kernel's SPI core instead, one ioctl() on /dev/spidevB.C each,
+ * and the cost of the system call and of the SPI message set-up easily exceeds the 15 us
+ * a position frame takes on the wire. So the frames are batched: OrbisSpidevCapture() puts
+ * up to ORBIS_SPIDEV_BATCH_MAX of them in a single SPI_IOC_MESSAGE, a transfer each.
+ *
+ * Every transfer but the last has cs_change set, so CS is deasserted after it and asserted
+ * again before the next one, which makes each transfer a frame of its own for Orbis. The
+ * last transfer of a message has it clear, CS goes up at the end of the message anyway.
+ * Each transfer carries delay_usecs, the gap after the frame, CS deasserted after it, which
+ * also keeps the next message off the encoder for that long.
+ *
+ * spidev has nothing for the delay from CS assertion to the first clock edge, which Orbis
+ * needs (see ORBIS_DELAY_SINGLE in orbis.h). Where the controller driver supports it, set
+ * it in the device tree with spi-cs-setup-delay-ns on the spidev node.
+ *
+ * The frames are checked and decoded by the protocol layer, orbis_protocol.c, the same code
+ * as in the bare-metal driver. Only the time of each frame is different: the kernel does not
+ * say when a transfer took place, so it is interpolated between the times before and after
+ * the ioctl(), which is all that can be had from user space.
+ *
+ * The ioctl() goes through dev->ioctl, so that the host build can put a stand-in for
+ * the device behind it, see host/sim_spidev.c.
+ *
+ *  Created on: 16 Oct 2026
+ */
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/spi/spidev.h>
+#include "orbis_protocol.h"
+#include "orbis_crc.h"
+#include "orbis_spidev.h"
+
+static int OrbisSpidevSystemIoctl(int fd, unsigned long request, void* arg)
+{
+    return ioctl(fd, request, arg);
+}
+
+// CLOCK_MONOTONIC, in ns
+uint64_t OrbisSpidevNow(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t) now.tv_sec * 1000000000u + (uint64_t) now.tv_nsec;
+}
+
+//
+// Open the spidev device at path, e.g. /dev/spidev1.0, for the Orbis encoder on it,
+// see OrbisSpidevAttach().
+//
+// Returns 0, or -1 with errno set.
+//
+int OrbisSpidevOpen(OrbisSpidev* dev, const char* path, uint32_t speedHz, uint16_t gapUs)
+{
+    int fd = open(path, O_RDWR);
+
+    if (fd < 0)
+        return -1;
+
+    if (OrbisSpidevAttach(dev, fd, OrbisSpidevSystemIoctl, speedHz, gapUs) != 0) {
+        int error = errno;
+
+        close(fd);
+        errno = error;
+        return -1;
+    }
+
+    return 0;
+}
+
+//
+// Take the open spidev descriptor fd for the Orbis encoder on it, with its ioctl(), and set
+// the SPI mode, 8 bit words and the clock. The frames have a gap of gapUs after them.
+//
+// Returns 0, or -1 with errno set.
+//
+int OrbisSpidevAttach(OrbisSpidev* dev, int fd, OrbisSpidevIoctl ioctlFunction,
+                      uint32_t speedHz, uint16_t gapUs)
+{
+    uint8_t mode = ORBIS_SPIDEV_MODE;
+    uint8_t bits = 8;
+
+    dev->fd = fd;
+    dev->ioctl = ioctlFunction;
+    dev->speedHz = speedHz;
+    dev->gapUs = gapUs;
+    dev->prepared = 0;
+    dev->syscalls = 0;
+    dev->frames = 0;
+    dev->crcFailures = 0;
+
+    // Tables of the CRC strategy selected at compile time
+    OrbisCRCInit();
+
+    if (dev->ioctl(fd, SPI_IOC_WR_MODE, &mode) < 0 ||
+        dev->ioctl(fd, SPI_IOC_WR_BITS_PER_WORD, &bits) < 0 ||
+        dev->ioctl(fd, SPI_IOC_WR_MAX_SPEED_HZ, &speedHz) < 0)
+        return -1;
+
+    return 0;
+}
+
+void OrbisSpidevClose(OrbisSpidev* dev)
+{
+    if (dev->ioctl == OrbisSpidevSystemIoctl)
+        close(dev->fd);
+    dev->fd = -1;
+}
+
+// Set up every transfer for the request, each a frame with CS deasserted after it
+static void OrbisSpidevPrepare(OrbisSpidev* dev, uint8_t request)
+{
+    uint32_t length = OrbisFrameRequest(request, dev->tx);
+
+    for (uint32_t i = 0; i < ORBIS_SPIDEV_BATCH_MAX; i++) {
+        struct spi_ioc_transfer* transfer = &dev->transfers[i];
+
+        memset(transfer, 0, sizeof(*transfer));
+        transfer->tx_buf = (uintptr_t) dev->tx;
+        transfer->rx_buf = (uintptr_t) dev->rx[i];
+        transfer->len = length;
+        transfer->speed_hz = dev->speedHz;
+        transfer->delay_usecs = dev->gapUs;
+        transfer->bits_per_word = 8;
+        transfer->cs_change = 1;
+    }
+
+    dev->request = request;
+    dev->prepared = ORBIS_SPIDEV_BATCH_MAX;
+}
+
+//
+// Capture count frames of the request, batch of them to a SPI_IOC_MESSAGE, at most
+// ORBIS_SPIDEV_BATCH_MAX. A batch of 1 is a system call per frame.
+//
+// Every frame is checked and, if its CRC is good, decoded into frames[]. Its time is
+// interpolated across the ioctl() of its batch.
+//
+// Returns the number of frames captured, count unless the ioctl() fails, and -1 with errno
+// set if it fails on the first batch.
+//
+int OrbisSpidevCapture(OrbisSpidev* dev, uint8_t request, OrbisSpidevFrame* frames,
+                       uint32_t count, uint32_t batch)
+{
+    uint32_t done = 0;
+
+    if (batch == 0 || batch > ORBIS_SPIDEV_BATCH_MAX || request >= ORBIS_REQ_COUNT) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (dev->prepared == 0 || dev->request != request)
+        OrbisSpidevPrepare(dev, request);
+
+    while (done < count) {
+        uint32_t n = (count - done < batch) ? count - done : batch;
+        uint64_t before, after;
+        int result;
+
+        // The last transfer of the message leaves CS to the end of the message
+        dev->transfers[n - 1].cs_change = 0;
+
+        before = OrbisSpidevNow();
+        result = dev->ioctl(dev->fd, SPI_IOC_MESSAGE(n), dev->transfers);
+        after = OrbisSpidevNow();
+
+        dev->transfers[n - 1].cs_change = 1;
+        dev->syscalls++;
+
+        if (result < 0)
+            return (done == 0) ? -1 : (int) done;
+
+        for (uint32_t i = 0; i < n; i++) {
+            OrbisSpidevFrame* frame = &frames[done + i];
+            uint32_t length = dev->transfers[i].len;
+
+            frame->time = before + (after - before) * i / n;
+            frame->length = (uint8_t) length;
+            for (uint32_t j = 0; j < length; j++)
+                frame->data[j] = dev->rx[i][j];
+
+            frame->crc = OrbisFrameValidate(frame->data, length);
+            if (ORBIS_CRC_OK == frame->crc)
+                OrbisDecode(request, frame->data, &frame->response);
+            else
+                dev->crcFailures++;
+        }
+
+        dev->frames += n;
+        done += n;
+    }
+
+    return (int) done;
+}
@@ -0,0 +1,68 @@
+/*
+ * orbis_spidev.h
+ * Orbis encoder through the Linux spidev interface
+ *
+ * The functions and global data structures are documented
+ * in the source code file to avoid saying the same thing twice.
+ * Use the source code file as a primary reference.
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#ifndef ORBIS_SPIDEV_H_
+#define ORBIS_SPIDEV_H_
+
+#include <stdint.h>
+#include <linux/spi/spidev.h>
+#include "orbis_protocol.h"
+
+// Most frames in one SPI_IOC_MESSAGE. The kernel takes at most 511 transfers in a message,
+// and spidev at most bufsiz bytes of them, 4096 by default.
+#define ORBIS_SPIDEV_BATCH_MAX             64u
+
+// SPI clock, as the bare-metal driver, and the gap with CS deasserted after each frame
+#define ORBIS_SPIDEV_SPEED_DEFAULT    3000000u
+#define ORBIS_SPIDEV_GAP_DEFAULT           10u     // us
+
+// Clock phase as on the McSPI, MCSPI_CLK_MODE_1: data latched on the falling edge
+#define ORBIS_SPIDEV_MODE              SPI_MODE_1
+
+// The ioctl() of the device, or a stand-in for it
+typedef int (*OrbisSpidevIoctl)(int fd, unsigned long request, void* arg);
+
+// A frame as captured, decoded if the CRC is good
+typedef struct {
+    uint64_t time;                         // CLOCK_MONOTONIC ns, estimated, see OrbisSpidevCapture()
+    uint8_t data[ORBIS_SIZE_BUFFER];       // The response, CRC included
+    uint8_t length;
+    uint8_t crc;                           // ORBIS_CRC_OK or ORBIS_CRC_FAIL
+    OrbisResponse response;                // Decoded if the CRC is good
+} OrbisSpidevFrame;
+
+// An Orbis encoder on a spidev device
+typedef struct {
+    int fd;
+    OrbisSpidevIoctl ioctl;
+    uint32_t speedHz;
+    uint16_t gapUs;                        // CS deasserted after each frame, in us
+
+    uint8_t tx[ORBIS_SIZE_BUFFER];         // The frame sent, the same for every transfer of a request
+    uint8_t request;                       // Request the transfers are set up for
+    uint32_t prepared;                     // Transfers set up for it, 0 for none
+    struct spi_ioc_transfer transfers[ORBIS_SPIDEV_BATCH_MAX];
+    uint8_t rx[ORBIS_SPIDEV_BATCH_MAX][ORBIS_SIZE_BUFFER];
+
+    uint64_t syscalls;                     // SPI_IOC_MESSAGE calls made
+    uint64_t frames;                       // Frames captured
+    uint64_t crcFailures;
+} OrbisSpidev;
+
+int OrbisSpidevOpen(OrbisSpidev* dev, const char* path, uint32_t speedHz, uint16_t gapUs);
+int OrbisSpidevAttach(OrbisSpidev* dev, int fd, OrbisSpidevIoctl ioctlFunction,
+                      uint32_t speedHz, uint16_t gapUs);
+void OrbisSpidevClose(OrbisSpidev* dev);
+int OrbisSpidevCapture(OrbisSpidev* dev, uint8_t request, OrbisSpidevFrame* frames,
+                       uint32_t count, uint32_t batch);
+uint64_t OrbisSpidevNow(void);
+
+#endif /* ORBIS_SPIDEV_H_ */
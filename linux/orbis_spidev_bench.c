@@ -0,0 +1,118 @@
+/*
+ * orbis_spidev_bench.c
+ * Throughput of the Orbis spidev backend, a frame per system call against batched frames
+ *
+ * Captures the position from the Orbis encoder on a spidev device, first with a frame per
+ * SPI_IOC_MESSAGE, then with batch frames to one, and prints for each the frames per second,
+ * the time per frame, the system calls made and the CRC failures. The last position seen
+ * is printed as well, as a sanity check of the wiring.
+ *
+ * Usage: orbis-spidev [options]
+ *   -d <device>    spidev device (/dev/spidev1.0)
+ *   -s <Hz>        SPI clock (ORBIS_SPIDEV_SPEED_DEFAULT)
+ *   -g <us>        gap with CS deasserted after each frame (ORBIS_SPIDEV_GAP_DEFAULT)
+ *   -b <n>         frames per message in the batched run, at most ORBIS_SPIDEV_BATCH_MAX (32)
+ *   -n <count>     frames in each run (10000)
+ *
+ * Exits with 1 if a capture fails, 2 if the device cannot be set up.
+ *
+ *  Created on: 16 Oct 2026
+ */
+#include <stdint.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "orbis_protocol.h"
+#include "orbis_spidev.h"
+
+// Run the capture of count frames, batch to a message, and print the figures
+static int BenchRun(OrbisSpidev* dev, OrbisSpidevFrame* frames, uint32_t count, uint32_t batch,
+                    double* framesPerSecond)
+{
+    uint64_t syscalls = dev->syscalls;
+    uint64_t failures = dev->crcFailures;
+    uint64_t start, elapsed;
+    int captured;
+
+    start = OrbisSpidevNow();
+    captured = OrbisSpidevCapture(dev, ORBIS_REQ_POSITION, frames, count, batch);
+    elapsed = OrbisSpidevNow() - start;
+
+    if (captured != (int) count) {
+        fprintf(stderr, "batch %u: %s\n", batch, (captured < 0) ? strerror(errno) : "capture cut short");
+        return 1;
+    }
+
+    *framesPerSecond = count * 1e9 / (double) elapsed;
+
+    printf("batch %u: %u frames in %.3f ms, %.0f frames/s, %.2f us/frame, %llu syscalls, %llu CRC failures",
+           batch, count, elapsed / 1e6, *framesPerSecond, elapsed / 1e3 / count,
+           (unsigned long long) (dev->syscalls - syscalls), (unsigned long long) (dev->crcFailures - failures));
+    if (ORBIS_CRC_OK == frames[count - 1].crc)
+        printf(", position %u%s", frames[count - 1].response.position,
+               frames[count - 1].response.error ? " (error)" : "");
+    printf("\n");
+
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    const char* path = "/dev/spidev1.0";
+    uint32_t speedHz = ORBIS_SPIDEV_SPEED_DEFAULT;
+    uint16_t gapUs = ORBIS_SPIDEV_GAP_DEFAULT;
+    uint32_t batch = 32;
+    uint32_t count = 10000;
+    double single, batched;
+    OrbisSpidevFrame* frames;
+    OrbisSpidev dev;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "d:s:g:b:n:")) != -1) {
+        switch (opt) {
+        case 'd': path = optarg; break;
+        case 's': speedHz = (uint32_t) strtoul(optarg, NULL, 0); break;
+        case 'g': gapUs = (uint16_t) strtoul(optarg, NULL, 0); break;
+        case 'b': batch = (uint32_t) strtoul(optarg, NULL, 0); break;
+        case 'n': count = (uint32_t) strtoul(optarg, NULL, 0); break;
+        default:
+            fprintf(stderr, "usage: %s [-d device] [-s Hz] [-g us] [-b n] [-n count]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if (batch == 0 || batch > ORBIS_SPIDEV_BATCH_MAX || count == 0) {
+        fprintf(stderr, "the batch must be 1 to %u frames, and the count more than 0\n", ORBIS_SPIDEV_BATCH_MAX);
+        return 2;
+    }
+
+    frames = calloc(count, sizeof(*frames));
+    if (frames == NULL) {
+        perror("calloc");
+        return 2;
+    }
+
+    if (OrbisSpidevOpen(&dev, path, speedHz, gapUs) != 0) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        free(frames);
+        return 2;
+    }
+
+    printf("%s at %u Hz, %u us after each frame\n", path, speedHz, gapUs);
+
+    if (BenchRun(&dev, frames, count, 1, &single) != 0 ||
+        BenchRun(&dev, frames, count, batch, &batched) != 0) {
+        OrbisSpidevClose(&dev);
+        free(frames);
+        return 1;
+    }
+
+    printf("batched/single: %.2f\n", batched / single);
+
+    OrbisSpidevClose(&dev);
+    free(frames);
+
+    return 0;
+}
@@ -6,8 +6,6 @@
  *
  * Based on the StarterWare GPIO Example (Blinky)
  *
- * TODO The timer over-waits by a factor of x2 to x4, investigate
- *
  * Oliver Frolovs, 2019
  */
 /*
@@ -50,11 +48,27 @@
 #include "beaglebone.h"
 #include "gpio_v2.h"
 #include "pin_mux.h"
-#include "delay.h"
 #include "interrupt.h"
 #include "consoleUtils.h"
 #include "orbis.h"
+#include "orbis_crc.h"
+#include "orbis_calib.h"
+#include "orbis_estimator.h"
+#include "orbis_recovery.h"
+#include "orbis_ring.h"
+#include "orbis_sched.h"
+#include "orbis_telemetry.h"
+#include "orbis_memory.h"
+#include "orbis_load.h"
+#include "orbis_record.h"
 #include "util.h"
+#include "uart_irda_cir.h"
+#if ORBIS_USE_EDMA
+#include "orbis_edma.h"
+#endif
+#if ORBIS_USE_FIQ
+#include "orbis_fiq.h"
+#endif
 
 /*****************************************************************************
 **                INTERNAL MACRO DEFINITIONS
@@ -62,20 +76,100 @@
 #define GPIO_INSTANCE_ADDRESS           (SOC_GPIO_1_REGS)
 #define GPIO_INSTANCE_PIN_NUMBER        (23)
 
-#define LED_DELAY (0x122222)
+/* Task periods, in scheduler ticks of ORBIS_SCHED_TICK_DEFAULT (100 us) */
+#define CAPTURE_TASK_PERIOD             (10)        /* 1 kHz */
+#define ESTIMATOR_TASK_PERIOD           (10)        /* 1 kHz, half way between the captures */
+#define ESTIMATOR_TASK_PHASE            (5)
+#define CONSOLE_TASK_PERIOD             (1000)      /* 10 Hz */
+#define HEARTBEAT_TASK_PERIOD           (2500)      /* The LED toggles at 4 Hz, blinks at 2 Hz */
+#define TELEMETRY_TASK_PERIOD           (10)        /* 1 kHz, 10 samples at a time */
+
+/* The estimate goes stale when the position has not been captured for this long */
+#define ESTIMATE_MAX_AGE                (5 * TIMER_1MS)
+
+/* Sampling period in telemetry mode, 10 kHz, and samples moved from the ring at a time */
+#define TELEMETRY_PERIOD                (10 * TIMER_10US)
+#define TELEMETRY_READ_BATCH            (32)
+
+/* Frames the capture recorder keeps after the first failure, the rest are from before it */
+#define RECORD_AFTER_FAILURE            (ORBIS_RECORD_FRAMES / 4)
+
+/* Captures timed for each capture backend, and before and after the caches are enabled
+   in the performance build profile */
+#define CAPTURE_CYCLES_COUNT            (64)
 
 /*****************************************************************************
 **                INTERNAL FUNCTION PROTOTYPES
 *****************************************************************************/
-static void Delay(unsigned int count);
 static void InterruptSetup(void);
 static void TimerSetup(void);
+static void TimerSelfTestReport(void);
 static void LEDGPIOSetup(void);
 static void ConsoleUARTSetup(void);
+static void OrbisProfileSetup(void);
+static void SchedulerSetup(void);
+static void EstimatorTask(void* context);
+static void HeartbeatTask(void* context);
+#if ORBIS_TELEMETRY
+static void TelemetrySetup(void);
+static void TelemetryTask(void* context);
+#else
+static void CaptureTask(void* context);
+static void ConsoleTask(void* context);
+#endif
+#if ORBIS_LOAD && !ORBIS_TELEMETRY
+static void LoadReport(void);
+#endif
+static void BackendBenchmark(void);
+static uint32_t CaptureCycles(uint8_t polled);
+static uint32_t BurstCycles(void);
+#if ORBIS_PERFORMANCE
+static void CacheSetup(void);
+#endif
 
 /*****************************************************************************
 **                GLOBAL VARIABLES
 *****************************************************************************/
+static OrbisCalibration orbisCalibration;
+static OrbisWatchdog orbisWatchdog;
+static OrbisRecovery orbisRecovery;
+static OrbisEstimator orbisEstimator;
+static OrbisScheduler orbisScheduler;
+
+/* Frames of the burst timed at start-up, see BurstCycles() */
+static OrbisBurstFrame orbisBurstFrames[CAPTURE_CYCLES_COUNT];
+#if ORBIS_LOAD && !ORBIS_TELEMETRY
+static OrbisLoadTimes orbisLoadReported;
+#endif
+
+/* Latest estimate of the position, for the control code, and the result of the query */
+static OrbisEstimate orbisEstimate;
+static uint8_t orbisEstimateState = ORBIS_ESTIMATOR_SETTLING;
+
+/* The tasks of the main loop, see SchedulerSetup() */
+#if ORBIS_TELEMETRY
+static OrbisTask telemetryTask = {
+    .name = "telem", .function = TelemetryTask,
+    .period = TELEMETRY_TASK_PERIOD, .phase = 0, .priority = 0
+};
+#else
+static OrbisTask captureTask = {
+    .name = "capture", .function = CaptureTask,
+    .period = CAPTURE_TASK_PERIOD, .phase = 0, .priority = 0
+};
+static OrbisTask consoleTask = {
+    .name = "console", .function = ConsoleTask,
+    .period = CONSOLE_TASK_PERIOD, .phase = 0, .priority = 2
+};
+#endif
+static OrbisTask estimatorTask = {
+    .name = "estim", .function = EstimatorTask,
+    .period = ESTIMATOR_TASK_PERIOD, .phase = ESTIMATOR_TASK_PHASE, .priority = 1
+};
+static OrbisTask heartbeatTask = {
+    .name = "led", .function = HeartbeatTask,
+    .period = HEARTBEAT_TASK_PERIOD, .phase = 0, .priority = 3
+};
 
 /*****************************************************************************
 **                INTERNAL FUNCTION DEFINITIONS
@@ -85,7 +179,8 @@ static void ConsoleUARTSetup(void);
 */
 int main()
 {
-    uint32_t orbisCRCFailures = 0;
+    /* The hot path has to be in OCMC RAM before anything refers to it */
+    OrbisMemorySetup();
 
     GPIO0ModuleClkConfig();
     GPIOModuleEnable(SOC_GPIO_0_REGS);
@@ -100,6 +195,7 @@ int main()
 
     TimerSetup();
     ConsoleUtilsPrintf("\t+ Delay timer...\n");
+    TimerSelfTestReport();
 
     LEDGPIOSetup();
     ConsoleUtilsPrintf("\t+ LEDs...\n");
@@ -107,43 +203,196 @@ int main()
     OrbisSetup();
     ConsoleUtilsPrintf("\t+ Orbis rotary encoder...\n");
 
-    ConsoleUtilsPrintf("Entering the main loop...\n");
+#if ORBIS_USE_FIQ
+    OrbisFIQSetup();
+    ConsoleUtilsPrintf("\t+ McSPI0 interrupt on FIQ...\n");
+#endif
+
+#if ORBIS_LATENCY
+    OrbisLatencySetup();
+    ConsoleUtilsPrintf("\t+ Latency histograms, type 'l' for the report...\n");
+#endif
+
+    if (OrbisCRCSelfTest() != ORBIS_CRC_OK)
+        ConsoleUtilsPrintf("\t! Orbis CRC self-test failed\n");
+
+    OrbisProfileSetup();
+    OrbisWatchdogInit(&orbisWatchdog, &orbisEncoder);
+    OrbisRecoveryInit(&orbisRecovery, &orbisEncoder, ORBIS_RECOVERY_BUDGET_DEFAULT,
+                      ORBIS_RECOVERY_ESCALATE_DEFAULT);
+
+    /* Every position with a good CRC goes into the estimator, whichever way it was captured */
+    OrbisEstimatorInit(&orbisEstimator, ORBIS_ESTIMATOR_THETA);
+    orbisEncoder.estimator = &orbisEstimator;
+
+#if ORBIS_PERFORMANCE
+    CacheSetup();
+#endif
+
+    BackendBenchmark();
+
+#if ORBIS_RECORD
+    /* Keep the frames around the first failure for offline analysis, see host/orbis_replay.c */
+    OrbisRecordStart(ORBIS_RECORD_TRIGGERED, RECORD_AFTER_FAILURE);
+    ConsoleUtilsPrintf("\t+ Capture recorder, %u frames%s...\n", ORBIS_RECORD_FRAMES,
+                       ORBIS_TELEMETRY ? "" : ", type 'd' to dump them");
+#endif
+
+    SchedulerSetup();
+
+#if ORBIS_TELEMETRY
+    ConsoleUtilsPrintf("Switching the console to binary telemetry at %u bit/s...\n", ORBIS_TELEMETRY_BAUD);
+    TelemetrySetup();
+#else
+    ConsoleUtilsPrintf("Entering the main loop, type 's' for the task statistics, 'r' for the recovery counters%s...\n",
+                       ORBIS_LOAD ? ", 'c' for the CPU load" : "");
+#endif
+
+#if ORBIS_LOAD
+    OrbisLoadStart();
+#endif
+
+    /* The tasks run to completion, in the order of priority, as they come due, and the CPU
+       sleeps in between */
+    OrbisSchedStart(&orbisScheduler);
+
     while(1)
     {
-        /* Driving a logic HIGH on the GPIO pin. */
-        GPIOPinWrite(GPIO_INSTANCE_ADDRESS,
-                     GPIO_INSTANCE_PIN_NUMBER,
-                     GPIO_PIN_HIGH);
-
-        Delay(LED_DELAY);
-
-        /* Get data from Orbis */
-        if (OrbisCaptureGet() != ORBIS_CRC_OK) {
-            orbisCRCFailures++;
-            /*
-            ConsoleUtilsPrintf("VAL: %x\t\tCRC_RX: %x\t\tCRC_CP: %x\n",
-                               (orbisDataRx[0] << 16) | (orbisDataRx[1] << 8) | orbisDataRx[2],
-                               (uint8_t) ~orbisDataRx[orbisDataRxLength - 1],
-                               OrbisCRC_Buffer(orbisDataRx, orbisDataRxLength - 1));
-             */
-        }
-
-        /* Driving a logic LOW on the GPIO pin. */
-        GPIOPinWrite(GPIO_INSTANCE_ADDRESS,
-                     GPIO_INSTANCE_PIN_NUMBER,
-                     GPIO_PIN_LOW);
-
-        Delay(LED_DELAY);
+        if (!OrbisSchedRun(&orbisScheduler))
+            OrbisSchedIdle(&orbisScheduler);
+    }
+
+}
+
+/*
+** Put the tasks on the scheduler. In telemetry mode the position is sampled continuously
+** and the console is taken over by telemetry, so the capture and the console tasks give way
+** to the telemetry task.
+*/
+static void SchedulerSetup(void)
+{
+    OrbisSchedInit(&orbisScheduler, ORBIS_SCHED_TICK_DEFAULT);
+
+#if ORBIS_TELEMETRY
+    OrbisSchedAdd(&orbisScheduler, &telemetryTask);
+#else
+    OrbisSchedAdd(&orbisScheduler, &captureTask);
+    OrbisSchedAdd(&orbisScheduler, &consoleTask);
+#endif
+    OrbisSchedAdd(&orbisScheduler, &estimatorTask);
+    OrbisSchedAdd(&orbisScheduler, &heartbeatTask);
+
+    ConsoleUtilsPrintf("\t+ Scheduler, %u tasks on a %u tick period...\n",
+                       orbisScheduler.count, orbisScheduler.tickPeriod);
+}
+
+#if !ORBIS_TELEMETRY
+/*
+** Capture the position: a good position, fresh or held, never a corrupted one
+*/
+static void CaptureTask(void* context)
+{
+    OrbisRecoverySample sample;
+#if ORBIS_RECORD
+    static uint8_t recordState = ORBIS_RECORD_RUNNING;
+#endif
+
+    OrbisRecoveryCapture(&orbisRecovery, &sample);
+
+    /* Slow down if the link has got worse since the calibration */
+    if (OrbisWatchdogUpdate(&orbisWatchdog, sample.firstResult)) {
+        OrbisProfileSave(&orbisEncoder);
+        ConsoleUtilsPrintf("Orbis CRC errors, falling back to %u Hz, CS setup %u ticks\n",
+                           orbisEncoder.clockHz, orbisEncoder.csDelay);
+    }
+
+    /* Say so once, when the failures have gone on for too long */
+    if (sample.escalated && orbisRecovery.consecutive == orbisRecovery.escalateAfter) {
+        ConsoleUtilsPrintf("Orbis failed %u captures in a row, holding the position from %u ticks ago\n",
+                           orbisRecovery.consecutive, sample.age);
+        OrbisRecoveryReport(&orbisRecovery);
+    }
+
+#if ORBIS_RECORD
+    /* Say so once, when the recorder has the frames around the failure */
+    if (recordState != orbisRecording.header.state && ORBIS_RECORD_DONE == orbisRecording.header.state)
+        ConsoleUtilsPrintf("Orbis capture recorder stopped after a failure, type 'd' to dump it\n");
+    recordState = orbisRecording.header.state;
+#endif
+}
+
+#endif
+
+/*
+** Bring the position estimate up to now, for the control code
+*/
+static void EstimatorTask(void* context)
+{
+    orbisEstimateState = OrbisEstimatorAt(&orbisEstimator, TIME, ESTIMATE_MAX_AGE, &orbisEstimate);
+}
+
+#if !ORBIS_TELEMETRY
+/*
+** Reports on demand
+*/
+static void ConsoleTask(void* context)
+{
+    switch (UARTCharGetNonBlocking(SOC_UART_0_REGS)) {
+#if ORBIS_LATENCY
+    case 'l':
+        /* The capture latency histograms */
+        OrbisLatencyReport();
+        break;
+#endif
+    case 's':
+        OrbisSchedReport(&orbisScheduler);
+        break;
+    case 'r':
+        OrbisRecoveryReport(&orbisRecovery);
+        break;
+#if ORBIS_LOAD
+    case 'c':
+        LoadReport();
+        break;
+#endif
+#if ORBIS_RECORD
+    case 'd':
+        /* The capture recording, in hex */
+        OrbisRecordDump();
+        break;
+#endif
+    default:
+        break;
     }
+}
+
+#endif
+
+#if ORBIS_LOAD && !ORBIS_TELEMETRY
+/*
+** Where the CPU time has gone since the last report
+*/
+static void LoadReport(void)
+{
+    OrbisLoadTimes now, window;
+
+    OrbisLoadGet(&now);
+    OrbisLoadDifference(&now, &orbisLoadReported, &window);
+    OrbisLoadReport(&window);
 
+    orbisLoadReported = now;
 }
+#endif
 
 /*
-** A function which is used to generate a delay.
+** Blink the LED
 */
-static void Delay(volatile unsigned int count)
+static void HeartbeatTask(void* context)
 {
-    while(count--);
+    static uint32_t level = GPIO_PIN_LOW;
+
+    level = (level == GPIO_PIN_LOW) ? GPIO_PIN_HIGH : GPIO_PIN_LOW;
+    GPIOPinWrite(GPIO_INSTANCE_ADDRESS, GPIO_INSTANCE_PIN_NUMBER, level);
 }
 
 static void InterruptSetup(void)
@@ -156,7 +405,8 @@ static void InterruptSetup(void)
     /* Initialze ARM interrupt controller */
     IntAINTCInit();
 
-    /* Register McSPIIsr interrupt handler */
+#if !ORBIS_USE_FIQ
+    /* Register McSPIIsr interrupt handler, OrbisFIQSetup() routes it to FIQ instead */
     IntRegister(SYS_INT_SPI0INT, orbisMcSPIIsr);
 
     /* Set Interrupt Priority */
@@ -164,6 +414,109 @@ static void InterruptSetup(void)
 
     /* Enable system interrupt in AINTC */
     IntSystemEnable(SYS_INT_SPI0INT);
+#endif
+
+    /* Register the McSPI1 interrupt handler, McSPI1 stays on IRQ with ORBIS_USE_FIQ too */
+    IntRegister(SYS_INT_SPI1INT, orbisMcSPI1Isr);
+    IntPrioritySet(SYS_INT_SPI1INT, 0, AINTC_HOSTINT_ROUTE_IRQ);
+    IntSystemEnable(SYS_INT_SPI1INT);
+
+    /* Register the deadline timer interrupt handler */
+    IntRegister(TIMER_DEADLINE_INT, timerDeadlineIsr);
+    IntPrioritySet(TIMER_DEADLINE_INT, 0, AINTC_HOSTINT_ROUTE_IRQ);
+    IntSystemEnable(TIMER_DEADLINE_INT);
+
+    /* Register the continuous acquisition timer interrupt handler */
+    IntRegister(ORBIS_TRIGGER_TIMER_INT, orbisTriggerIsr);
+    IntPrioritySet(ORBIS_TRIGGER_TIMER_INT, 1, AINTC_HOSTINT_ROUTE_IRQ);
+    IntSystemEnable(ORBIS_TRIGGER_TIMER_INT);
+
+#if ORBIS_TELEMETRY
+    /* Register the telemetry UART interrupt handler */
+    IntRegister(ORBIS_TELEMETRY_UART_INT, orbisTelemetryIsr);
+    IntPrioritySet(ORBIS_TELEMETRY_UART_INT, 2, AINTC_HOSTINT_ROUTE_IRQ);
+    IntSystemEnable(ORBIS_TELEMETRY_UART_INT);
+#endif
+
+#if ORBIS_USE_EDMA
+    /* Register EDMA3 transfer completion interrupt handler */
+    IntRegister(SYS_INT_EDMACOMPINT, orbisEDMACompletionIsr);
+    IntPrioritySet(SYS_INT_EDMACOMPINT, 0, AINTC_HOSTINT_ROUTE_IRQ);
+    IntSystemEnable(SYS_INT_EDMACOMPINT);
+#endif
+}
+
+#if ORBIS_PERFORMANCE
+/*
+** Enable the MMU, the caches and the branch prediction, and report what it does to a capture
+*/
+static void CacheSetup(void)
+{
+    uint32_t uncached, cached;
+
+    ORBIS_LATENCY_CLOCK_START();
+    uncached = CaptureCycles(ORBIS_USE_POLLED);
+
+    OrbisCacheEnable();
+
+    /* The counter reads take a different time through the MMU */
+    TimerCalibrate();
+
+    cached = CaptureCycles(ORBIS_USE_POLLED);
+
+    ConsoleUtilsPrintf("\t+ MMU and caches, capture %u cycles uncached, %u cached...\n",
+                       uncached, cached);
+}
+
+#endif
+
+/*
+** Time the blocking position capture with both backends, the one ORBIS_USE_POLLED selects
+** for OrbisCaptureGet() and the other
+*/
+static void BackendBenchmark(void)
+{
+    uint32_t interrupt, polled, burst;
+
+    ORBIS_LATENCY_CLOCK_START();
+    interrupt = CaptureCycles(0);
+    polled = CaptureCycles(1);
+    burst = BurstCycles();
+
+    ConsoleUtilsPrintf("\t+ Capture %u %s interrupt-driven, %u polled%s...\n",
+                       interrupt, ORBIS_LATENCY_PMU ? "cycles" : "timer ticks", polled,
+                       ORBIS_USE_POLLED ? ", polled in use" : "");
+    ConsoleUtilsPrintf("\t+ Capture %u %s a frame in bursts of %u...\n",
+                       burst, ORBIS_LATENCY_PMU ? "cycles" : "timer ticks", CAPTURE_CYCLES_COUNT);
+}
+
+/*
+** Mean cycles of a blocking position capture on orbisEncoder, interrupt-driven or polled
+*/
+static uint32_t CaptureCycles(uint8_t polled)
+{
+    uint32_t start = ORBIS_LATENCY_CLOCK();
+
+    for (uint32_t i = 0; i < CAPTURE_CYCLES_COUNT; i++) {
+        if (polled)
+            OrbisEncoderRequestPolled(&orbisEncoder, ORBIS_REQ_POSITION, ORBIS_CAPTURE_TIMEOUT_DEFAULT);
+        else
+            OrbisEncoderRequestInterrupt(&orbisEncoder, ORBIS_REQ_POSITION, ORBIS_CAPTURE_TIMEOUT_DEFAULT);
+    }
+
+    return (ORBIS_LATENCY_CLOCK() - start) / CAPTURE_CYCLES_COUNT;
+}
+
+/*
+** Mean cycles of a frame of a burst of position frames on orbisEncoder, see OrbisEncoderBurst()
+*/
+static uint32_t BurstCycles(void)
+{
+    uint32_t start = ORBIS_LATENCY_CLOCK();
+
+    OrbisBurstGet(orbisBurstFrames, CAPTURE_CYCLES_COUNT);
+
+    return (ORBIS_LATENCY_CLOCK() - start) / CAPTURE_CYCLES_COUNT;
 }
 
 static void TimerSetup(void)
@@ -172,8 +525,26 @@ static void TimerSetup(void)
     DMTimerPreScalerClkDisable(SOC_DMTIMER_4_REGS);
     DMTimerCounterSet(SOC_DMTIMER_4_REGS, 0);
     DMTimerReloadSet(SOC_DMTIMER_4_REGS, 0);
-    DMTimerModeConfigure(SOC_DMTIMER_4_REGS, DMTIMER_AUTORLD_NOCMP_ENABLE);
+    DMTimerModeConfigure(SOC_DMTIMER_4_REGS, DMTIMER_AUTORLD_CMP_ENABLE);
     DMTimerEnable(SOC_DMTIMER_4_REGS);
+
+    TimerCalibrate();
+    TimerDeadlineSetup();
+}
+
+// Check the delays against the counter and print what was measured
+static void TimerSelfTestReport(void)
+{
+    TimerSelfTestResult results[TIMER_SELF_TEST_DELAYS];
+    uint8_t failures = TimerSelfTest(results);
+
+    for (uint32_t i = 0; i < TIMER_SELF_TEST_DELAYS; i++) {
+        ConsoleUtilsPrintf("\t  %u ticks: waitfor %u, deadline %u\n",
+                           results[i].requested, results[i].waited, results[i].deadline);
+    }
+
+    if (failures)
+        ConsoleUtilsPrintf("\t! Delay timer self-test failed\n");
 }
 
 static void LEDGPIOSetup(void)
@@ -196,6 +567,56 @@ static void LEDGPIOSetup(void)
                    GPIO_DIR_OUTPUT);
 }
 
+/*
+** Use the Orbis SPI clock and CS setup delay kept from the last run,
+** or calibrate them if there are none.
+*/
+static void OrbisProfileSetup(void)
+{
+    if (OrbisProfileRestore(&orbisEncoder) == ORBIS_CRC_OK) {
+        ConsoleUtilsPrintf("\t+ Orbis profile restored...\n");
+    } else if (OrbisCalibrate(&orbisEncoder, ORBIS_CALIB_CAPTURES, &orbisCalibration) == ORBIS_CRC_OK) {
+        OrbisProfileSave(&orbisEncoder);
+        ConsoleUtilsPrintf("\t+ Orbis profile calibrated...\n");
+    } else {
+        ConsoleUtilsPrintf("\t! Orbis calibration failed, using the defaults\n");
+    }
+
+    ConsoleUtilsPrintf("\t  SPI clock %u Hz, CS setup %u ticks\n",
+                       orbisEncoder.clockHz, orbisEncoder.csDelay);
+}
+
+#if ORBIS_TELEMETRY
+/*
+** Binary telemetry in place of the console: the position is sampled continuously
+** and every sample goes out over UART0, see orbis_telemetry.c
+*/
+static void TelemetrySetup(void)
+{
+    /* Let the last console message out before the bit rate changes */
+    waitfor(TIMER_1MS);
+
+    OrbisTelemetrySetup();
+    OrbisAcquisitionStart(TELEMETRY_PERIOD);
+}
+
+/*
+** Move the samples from the ring to the telemetry UART
+*/
+static void TelemetryTask(void* context)
+{
+    static OrbisSample samples[TELEMETRY_READ_BATCH];
+    uint32_t n = OrbisRingRead(samples, TELEMETRY_READ_BATCH);
+
+    for (uint32_t i = 0; i < n; i++) {
+        OrbisTelemetryPut(samples[i].timestamp, ORBIS_TELEMETRY_VALUE(samples[i].position, samples[i].turns),
+                          ORBIS_TELEMETRY_STATUS(samples[i].crc, 0));
+    }
+
+    OrbisTelemetryPoll();
+}
+#endif
+
 static void ConsoleUARTSetup(void)
 {
     ConsoleUtilsInit();
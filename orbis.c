@@ -2,13 +2,41 @@
  * orbis.c
  * Orbis Rotary Encoder driver for TI StarterWare
  *
- * This driver uses McSPI0 module channel 0 in single-channel,
- * four-pin, FIFO Rx-only (half duplex), interrupt-driven mode.
+ * This driver uses McSPI modules in single-channel, four-pin, FIFO Tx/Rx (full duplex),
+ * interrupt-driven mode. The command goes out on D0 while the response comes in on D1.
  *
- * The TX_EMPTY and RX_FULL interrupts are processed.
+ * Each encoder is an OrbisEncoder bound to a McSPI module (OrbisBus) and a chip select,
+ * and carries all the state of its captures. The two McSPI modules have an interrupt
+ * each and capture at the same time. The encoders sharing a module take turns: only one
+ * chip select is active at a time, the others wait, and they are served round-robin
+ * as the bus frees up. The FIFO goes with the channel on the bus.
  *
- * Since no command is being sent, the size of response is 5 bytes for multi-turn,
- * or 3 bytes for single-turn Orbis: (ORBIS_SIZE_MULTITURN + ORBIS_SIZE_POSITION + ORBIS_SIZE_CRC).
+ * The single-encoder API (OrbisSetup(), OrbisCaptureGet() and the rest) works on
+ * orbisEncoder, on McSPI0 channel 0.
+ *
+ * The TX_EMPTY and RX_FULL interrupts are processed. Alternatively, with ORBIS_USE_EDMA
+ * set, the response is moved by EDMA3 and only its completion interrupt is taken, or, with
+ * ORBIS_USE_EOW set, only the McSPI end of word count interrupt is taken and the response
+ * is drained from the Rx FIFO then.
+ *
+ * The blocking interrupt-driven captures sleep with WFI while they wait for the interrupts,
+ * see OrbisEncoderSleep(), and the time they take is counted by orbis_load.c.
+ *
+ * Every capture, completed or timed out, is offered to the capture recorder, see orbis_record.c.
+ *
+ * OrbisEncoderBurst() reads many frames back to back in one session of the channel, for
+ * oversampling, without setting up and tearing down the channel for each of them.
+ *
+ * With no command (ORBIS_CMD_NONE), the size of response is 5 bytes for multi-turn,
+ * or 3 bytes for single-turn Orbis: (ORBIS_SIZE_HEADER + ORBIS_SIZE_CRC). Which of the two
+ * is set at compile time with ORBIS_MULTITURN, see the encoder variant in orbis_protocol.h.
+ * Any other command appends its data to the position, just before the CRC. The command
+ * byte is the first word sent, the rest of the transfer is padded with ORBIS_CMD_NONE.
+ * The command byte and the response length of each request are in orbisFrames[], see
+ * orbis_protocol.c, and its transfer levels in orbisXferLevels[].
+ *
+ * The protocol itself, the frame layout, the CRC check and the decoding, is in orbis_protocol.c,
+ * which has nothing to do with the McSPI and is shared with the Linux spidev backend.
  *
  * Caveat: Each SPI word (WL 1 byte) takes up 2 bytes in the FIFO (TRM, Table 24-9)
  * but this is irrelevant for setting RX_FULL level. The level is set in relation to
@@ -20,248 +48,1177 @@
  *      Author: Oliver Frolovs
  */
 #include <stdint.h>
+#include <stddef.h>
 #include "hw_types.h"
 #include "soc_AM335x.h"
 #include "beaglebone.h"
 #include "pin_mux.h"
 #include "gpio_v2.h"
 #include "dmtimer.h"
+#include "interrupt.h"
 #include "hw_mcspi.h"
 #include "mcspi.h"
 #include "mcspi_beaglebone.h"
 #include "orbis.h"
+#include "orbis_crc.h"
+#include "orbis_ring.h"
+#include "orbis_estimator.h"
+#include "orbis_load.h"
+#include "orbis_memory.h"
+#include "orbis_record.h"
 #include "util.h"
+#if ORBIS_USE_EDMA
+#include "orbis_edma.h"
+#endif
+#if ORBIS_USE_FIQ
+#include "orbis_fiq.h"
+#endif
 
-// The buffer for data read from Orbis, including the CRC. The size of response depends on the command
-// transmitted. Allocate enough memory to store the longest possible response.
-volatile uint8_t orbisDataRx[ORBIS_SIZE_BUFFER];
-
-// The length of the response to the last transmitted command, including the CRC.
-volatile uint32_t orbisDataRxLength;
-
-// Flag to signal that ISR has successfully read the value from the FIFO
-volatile uint32_t orbisReady;
-
-// The CRC as it has been read from SPI. The CRC is the last byte transmitted. So the value
-// comes from orbisDataRx[orbisDataRxLength-1].
-uint8_t orbisReceivedCRC;
-
-// The CRC as it has been calculated from the contents of orbisDataRx buffer.
-uint8_t orbisCalculatedCRC;
-
-// Sticky flag to indicate that there was a CRC error. Takes values from {ORBIS_CRC_OK, ORBIS_CRC_FAIL}.
-uint8_t orbisCRCErrorFlag;
-
-//
-// Orbis CRC calculation table representing 0x97 polynome. Adapted from the Appendix 1 of the Orbis datasheet.
-//
-static uint8_t orbisTableCRC[256] = {
-    0x00, 0x97, 0xB9, 0x2E, 0xE5, 0x72, 0x5C, 0xCB, 0x5D, 0xCA, 0xE4, 0x73, 0xB8, 0x2F, 0x01, 0x96,
-    0xBA, 0x2D, 0x03, 0x94, 0x5F, 0xC8, 0xE6, 0x71, 0xE7, 0x70, 0x5E, 0xC9, 0x02, 0x95, 0xBB, 0x2C,
-    0xE3, 0x74, 0x5A, 0xCD, 0x06, 0x91, 0xBF, 0x28, 0xBE, 0x29, 0x07, 0x90, 0x5B, 0xCC, 0xE2, 0x75,
-    0x59, 0xCE, 0xE0, 0x77, 0xBC, 0x2B, 0x05, 0x92, 0x04, 0x93, 0xBD, 0x2A, 0xE1, 0x76, 0x58, 0xCF,
-    0x51, 0xC6, 0xE8, 0x7F, 0xB4, 0x23, 0x0D, 0x9A, 0x0C, 0x9B, 0xB5, 0x22, 0xE9, 0x7E, 0x50, 0xC7,
-    0xEB, 0x7C, 0x52, 0xC5, 0x0E, 0x99, 0xB7, 0x20, 0xB6, 0x21, 0x0F, 0x98, 0x53, 0xC4, 0xEA, 0x7D,
-    0xB2, 0x25, 0x0B, 0x9C, 0x57, 0xC0, 0xEE, 0x79, 0xEF, 0x78, 0x56, 0xC1, 0x0A, 0x9D, 0xB3, 0x24,
-    0x08, 0x9F, 0xB1, 0x26, 0xED, 0x7A, 0x54, 0xC3, 0x55, 0xC2, 0xEC, 0x7B, 0xB0, 0x27, 0x09, 0x9E,
-    0xA2, 0x35, 0x1B, 0x8C, 0x47, 0xD0, 0xFE, 0x69, 0xFF, 0x68, 0x46, 0xD1, 0x1A, 0x8D, 0xA3, 0x34,
-    0x18, 0x8F, 0xA1, 0x36, 0xFD, 0x6A, 0x44, 0xD3, 0x45, 0xD2, 0xFC, 0x6B, 0xA0, 0x37, 0x19, 0x8E,
-    0x41, 0xD6, 0xF8, 0x6F, 0xA4, 0x33, 0x1D, 0x8A, 0x1C, 0x8B, 0xA5, 0x32, 0xF9, 0x6E, 0x40, 0xD7,
-    0xFB, 0x6C, 0x42, 0xD5, 0x1E, 0x89, 0xA7, 0x30, 0xA6, 0x31, 0x1F, 0x88, 0x43, 0xD4, 0xFA, 0x6D,
-    0xF3, 0x64, 0x4A, 0xDD, 0x16, 0x81, 0xAF, 0x38, 0xAE, 0x39, 0x17, 0x80, 0x4B, 0xDC, 0xF2, 0x65,
-    0x49, 0xDE, 0xF0, 0x67, 0xAC, 0x3B, 0x15, 0x82, 0x14, 0x83, 0xAD, 0x3A, 0xF1, 0x66, 0x48, 0xDF,
-    0x10, 0x87, 0xA9, 0x3E, 0xF5, 0x62, 0x4C, 0xDB, 0x4D, 0xDA, 0xF4, 0x63, 0xA8, 0x3F, 0x11, 0x86,
-    0xAA, 0x3D, 0x13, 0x84, 0x4F, 0xD8, 0xF6, 0x61, 0xF7, 0x60, 0x4E, 0xD9, 0x12, 0x85, 0xAB, 0x3C
+// The McSPI modules. The base addresses are all that is needed until OrbisBusSetup().
+OrbisBus orbisBus[ORBIS_BUS_COUNT] = {
+    { .base = SOC_SPI_0_REGS },
+    { .base = SOC_SPI_1_REGS }
 };
 
-// Configure McSPI0 controller and channel for communication with Orbis rotary encoder.
-void OrbisSetup(void)
+// The encoder of the single-encoder API, and of the continuous acquisition mode. EDMA3 writes
+// its frames around the data cache, so it is kept uncached when both can be on, see orbis_memory.c
+#if ORBIS_PERFORMANCE && ORBIS_USE_EDMA && defined(__TI_COMPILER_VERSION__)
+#pragma DATA_SECTION(orbisEncoder, ORBIS_SECTION_DMA)
+#endif
+OrbisEncoder orbisEncoder;
+
+// Number of acquisition timer ticks which could not start a capture because the previous one
+// had not finished yet
+volatile uint32_t orbisTriggerOverruns;
+
+// Pad configuration registers of the McSPI pins as routed on BeagleBone Black, and their mux modes.
+// McSPI1 is on the McASP0 pins (P9.28-31), with CS1 on eCAP0 (P9.42).
+static const uint32_t orbisBusPins[ORBIS_BUS_COUNT][3] = {
+    { CONTROL_CONF_SPI0_SCLK, CONTROL_CONF_SPI0_D0, CONTROL_CONF_SPI0_D1 },
+    { CONTROL_CONF_MCASP0_ACLKX, CONTROL_CONF_MCASP0_FSX, CONTROL_CONF_MCASP0_AXR0 }
+};
+static const uint32_t orbisBusPinMode[ORBIS_BUS_COUNT] = { 0, 3 };
+static const uint32_t orbisChipSelectPins[ORBIS_BUS_COUNT][ORBIS_BUS_CHANNELS] = {
+    { CONTROL_CONF_SPI0_CS0, CONTROL_CONF_SPI0_CS1 },
+    { CONTROL_CONF_MCASP0_AHCLKR, CONTROL_CONF_ECAP0_IN_PWM0_OUT }
+};
+static const uint32_t orbisChipSelectPinMode[ORBIS_BUS_COUNT][ORBIS_BUS_CHANNELS] = {
+    { 0, 0 },
+    { 3, 2 }
+};
+
+#if ORBIS_USE_EDMA
+// Only McSPI0 channel 0 has its receive request wired to the EDMA3 channel the driver uses
+#define ORBIS_EDMA_CAPABLE(encoder)     ((encoder)->bus == &orbisBus[0] && (encoder)->channel == 0)
+#endif
+
+static void OrbisRequestPrepare(OrbisEncoder* encoder, uint8_t request, uint32_t timeout,
+                                OrbisCaptureCallback callback);
+static void OrbisChannelOpen(OrbisEncoder* encoder, uint32_t xferLevel);
+static void OrbisTransferSelect(OrbisEncoder* encoder);
+static void OrbisTransferStart(OrbisEncoder* encoder);
+static void OrbisCSSetupDone(void* context);
+static void OrbisEncoderSleep(OrbisEncoder* encoder);
+
+// The capture interrupt path and the polled capture run from OCMC RAM in the performance build
+// profile, see orbis_memory.c
+#if ORBIS_PERFORMANCE && defined(__TI_COMPILER_VERSION__)
+#pragma CODE_SECTION(OrbisBusService, ORBIS_SECTION_FAST_TEXT)
+#pragma CODE_SECTION(OrbisBusIsr, ORBIS_SECTION_FAST_TEXT)
+#pragma CODE_SECTION(orbisMcSPIIsr, ORBIS_SECTION_FAST_TEXT)
+#pragma CODE_SECTION(orbisMcSPI1Isr, ORBIS_SECTION_FAST_TEXT)
+#pragma CODE_SECTION(OrbisCSSetupDone, ORBIS_SECTION_FAST_TEXT)
+#pragma CODE_SECTION(OrbisCaptureComplete, ORBIS_SECTION_FAST_TEXT)
+#pragma CODE_SECTION(OrbisEncoderValidateCRC, ORBIS_SECTION_FAST_TEXT)
+#pragma CODE_SECTION(OrbisChannelOpen, ORBIS_SECTION_FAST_TEXT)
+#pragma CODE_SECTION(OrbisTransferSelect, ORBIS_SECTION_FAST_TEXT)
+#pragma CODE_SECTION(OrbisEncoderRequestPolled, ORBIS_SECTION_FAST_TEXT)
+#pragma CODE_SECTION(OrbisEncoderBurst, ORBIS_SECTION_FAST_TEXT)
+#endif
+
+//
+// MCSPI_XFERLEVEL values of the requests, worked out in advance from the same response lengths
+// as orbisFrames[], so that a transfer is set up with a single register write. Indexed by
+// ORBIS_REQ_...; the command bytes and the lengths themselves are only in orbisFrames[].
+//
+const uint32_t orbisXferLevels[ORBIS_REQ_COUNT] = {
+    ORBIS_XFERLEVEL(ORBIS_LENGTH_POSITION),
+    ORBIS_XFERLEVEL(ORBIS_LENGTH_SERIAL),
+    ORBIS_XFERLEVEL(ORBIS_LENGTH_SPEED),
+    ORBIS_XFERLEVEL(ORBIS_LENGTH_TEMPERATURE),
+    ORBIS_XFERLEVEL(ORBIS_LENGTH_STATUS)
+};
+
+// Configure a McSPI module for communication with Orbis rotary encoders on its chip selects.
+void OrbisBusSetup(OrbisBus* bus)
 {
+    uint32_t n = (bus == &orbisBus[1]) ? 1 : 0;
+
     // Surrounding modules and other global initialisation...
 
-    // Pin muxing
-    GpioPinMuxSetup(CONTROL_CONF_SPI0_SCLK, PAD_FS_RXE_NA_PUPDD(0));
-    GpioPinMuxSetup(CONTROL_CONF_SPI0_D0,   PAD_FS_RXD_NA_PUPDD(0));
-    GpioPinMuxSetup(CONTROL_CONF_SPI0_D1,   PAD_FS_RXE_PU_PUPDE(0));
-    GpioPinMuxSetup(CONTROL_CONF_SPI0_CS0,  PAD_FS_RXD_NA_PUPDD(0));
+    // Pin muxing: SCLK, D0 and D1. The chip selects are muxed as the encoders are set up.
+    GpioPinMuxSetup(orbisBusPins[n][0], PAD_FS_RXE_NA_PUPDD(orbisBusPinMode[n]));
+    GpioPinMuxSetup(orbisBusPins[n][1], PAD_FS_RXD_NA_PUPDD(orbisBusPinMode[n]));
+    GpioPinMuxSetup(orbisBusPins[n][2], PAD_FS_RXE_PU_PUPDE(orbisBusPinMode[n]));
 
     // Enable clock to the module
-    McSPI0ModuleClkConfig();
+    if (bus->base == SOC_SPI_1_REGS)
+        McSPI1ModuleClkConfig();
+    else
+        McSPI0ModuleClkConfig();
 
     // Soft reset (waiting included)
-    McSPIReset(SOC_SPI_0_REGS);
+    McSPIReset(bus->base);
 
     // Module-wide options...
 
     // We are going to use CS pins, enable four-pin mode
-    McSPICSEnable(SOC_SPI_0_REGS);
+    McSPICSEnable(bus->base);
 
     // Put the module into master mode as it is in slave mode after soft reset
-    McSPIMasterModeEnable(SOC_SPI_0_REGS);
+    McSPIMasterModeEnable(bus->base);
 
-    // Channel options...
+    // Set D1 to be an input at module level. Why doesn't StarterWare do that? I checked the source!
+    HWREG(bus->base + MCSPI_SYST) |= (1 << 9);
 
-    // MCSPI_DATA_LINE_COMM_MODE_7 = D1 & D0 no output; receive on D1
-    McSPIMasterModeConfig(SOC_SPI_0_REGS, MCSPI_SINGLE_CH,
-                          MCSPI_RX_ONLY_MODE, MCSPI_DATA_LINE_COMM_MODE_7,
-                          ORBIS_SPI_CHANNEL);
+    for (uint32_t i = 0; i < ORBIS_BUS_CHANNELS; i++)
+        bus->encoders[i] = NULL;
+    bus->active = NULL;
+    bus->next = 0;
 
-    // Set D1 to be an input at module level. Why doesn't StarterWare do that? I checked the source!
-    HWREG(SOC_SPI_0_REGS + MCSPI_SYST) |= (1 << 9);
+    // Nobody has the FIFO yet
+    bus->fifoChannel = ORBIS_BUS_CHANNELS;
+    bus->wakeDeadline.armed = 0;
+
+    // Tables of the CRC strategy selected at compile time
+    OrbisCRCInit();
+
+#if ORBIS_USE_EDMA
+    if (bus == &orbisBus[0])
+        OrbisEDMASetup();
+#endif
+}
+
+// Configure the McSPI channel for communication with the Orbis encoder on its chip select.
+void OrbisEncoderSetup(OrbisEncoder* encoder, OrbisBus* bus, uint32_t channel)
+{
+    uint32_t n = (bus == &orbisBus[1]) ? 1 : 0;
+
+    encoder->bus = bus;
+    encoder->channel = channel;
+    encoder->rxBuffer = encoder->dataRx;
+    encoder->acquisitionSlot = NULL;
+    encoder->estimator = NULL;
+    encoder->captureState = ORBIS_CAPTURE_IDLE;
+    encoder->waiting = 0;
+    encoder->ready = 0;
+    encoder->crcErrorFlag = ORBIS_CRC_OK;
+    encoder->clockHz = MCSPI_ORBIS_OUT_FREQ;
+    encoder->csDelay = ORBIS_DELAY_MULTI;
+
+    GpioPinMuxSetup(orbisChipSelectPins[n][channel], PAD_FS_RXD_NA_PUPDD(orbisChipSelectPinMode[n][channel]));
+
+    // Channel options...
+
+    // MCSPI_DATA_LINE_COMM_MODE_6 = D0 output; receive on D1
+    McSPIMasterModeConfig(bus->base, MCSPI_SINGLE_CH,
+                          MCSPI_TX_RX_MODE, MCSPI_DATA_LINE_COMM_MODE_6,
+                          channel);
 
     // Orbis loads data on rising clk edge, read it on the falling edge. Idle clock is low.
-    McSPIClkConfig(SOC_SPI_0_REGS, MCSPI_IN_CLK, MCSPI_ORBIS_OUT_FREQ, ORBIS_SPI_CHANNEL,
-                   MCSPI_CLK_MODE_1);
-    McSPICSPolarityConfig(SOC_SPI_0_REGS, MCSPI_CS_POL_LOW, ORBIS_SPI_CHANNEL);
+    McSPIClkConfig(bus->base, MCSPI_IN_CLK, encoder->clockHz, channel, MCSPI_CLK_MODE_1);
+    McSPICSPolarityConfig(bus->base, MCSPI_CS_POL_LOW, channel);
 
     // Set SPI word length
-    McSPIWordLengthSet(SOC_SPI_0_REGS, MCSPI_WORD_LENGTH(ORBIS_BITS_PER_WORD), ORBIS_SPI_CHANNEL);
+    McSPIWordLengthSet(bus->base, MCSPI_WORD_LENGTH(ORBIS_BITS_PER_WORD), channel);
+
+    // Enable both FIFOs for the first channel on the bus. The longest request fits into either half
+    // of the shared FIFO buffer. The FIFO can only be used by one channel, so it is handed over
+    // to another channel when that one starts a transfer, see OrbisTransferStart().
+    if (bus->fifoChannel == ORBIS_BUS_CHANNELS) {
+        McSPIRxFIFOConfig(bus->base, MCSPI_RX_FIFO_ENABLE, channel);
+        McSPITxFIFOConfig(bus->base, MCSPI_TX_FIFO_ENABLE, channel);
+        bus->fifoChannel = channel;
+    }
 
-    // Enable Rx FIFO
-    McSPIRxFIFOConfig(SOC_SPI_0_REGS, MCSPI_RX_FIFO_ENABLE, ORBIS_SPI_CHANNEL);
-    McSPITxFIFOConfig(SOC_SPI_0_REGS, MCSPI_TX_FIFO_DISABLE, ORBIS_SPI_CHANNEL);
+    bus->encoders[channel] = encoder;
 }
 
-// Interrupt handler
-void orbisMcSPIIsr(void)
+//
+// Change the SPI clock and the CS setup delay of the encoder, see orbis_calib.c.
+// Must not be called while a capture of the encoder is in progress or waiting.
+//
+void OrbisEncoderProfileSet(OrbisEncoder* encoder, uint32_t clockHz, uint32_t csDelay)
+{
+    encoder->clockHz = clockHz;
+    encoder->csDelay = csDelay;
+
+    McSPIClkConfig(encoder->bus->base, MCSPI_IN_CLK, clockHz, encoder->channel, MCSPI_CLK_MODE_1);
+}
+
+// Configure McSPI0 controller and channel 0 for communication with orbisEncoder.
+void OrbisSetup(void)
 {
+    OrbisBusSetup(&orbisBus[0]);
+    OrbisEncoderSetup(&orbisEncoder, &orbisBus[0], ORBIS_SPI_CHANNEL);
+}
+
+//
+// Serve the McSPI interrupt of the encoder whose capture is on the bus: fill the Tx FIFO,
+// or drain the response from the Rx FIFO. Returns the encoder if its response has been
+// drained and the capture is to be completed, NULL otherwise.
+//
+// Touches nothing but the McSPI module and the capture on the bus, so it can run from FIQ,
+// see orbis_fiq.c.
+//
+OrbisEncoder* OrbisBusService(OrbisBus* bus)
+{
+    OrbisEncoder* encoder = bus->active;
+    uint32_t channel;
+
+    // Nothing on the bus, the capture has been abandoned
+    if (encoder == NULL) {
+        McSPIIntStatusClear(bus->base, McSPIIntStatusGet(bus->base));
+        return NULL;
+    }
+
+    channel = encoder->channel;
+
+    // With ORBIS_USE_EOW the Tx FIFO is filled when the CS setup delay is over, see OrbisCSSetupDone().
+    // TX_EMPTY is not enabled then, but its status is set all the same and must not be taken
+    // for a request to fill the FIFO again.
+#if !ORBIS_USE_EOW
     // if tx empty fill register, assert cs, wait
-    if (MCSPI_INT_TX_EMPTY(ORBIS_SPI_CHANNEL) & McSPIIntStatusGet(SOC_SPI_0_REGS)) {
+    if (MCSPI_INT_TX_EMPTY(channel) & McSPIIntStatusGet(bus->base)) {
+        ORBIS_LATENCY_STAMP(encoder, ORBIS_STAGE_TX);
 
-        // The channel is in the Rx mode, so no need to keep refilling the Tx register.
-        McSPITransmitData(SOC_SPI_0_REGS, ORBIS_CMD_NONE, ORBIS_SPI_CHANNEL);
+        // The Tx FIFO takes the whole request at once, so no need to keep refilling it.
+        McSPITransmitData(bus->base, encoder->txCommand, channel);
+        for (uint32_t i = 1; i < encoder->dataRxLength; i++) {
+            McSPITransmitData(bus->base, ORBIS_CMD_NONE, channel);
+        }
 
-        McSPIIntDisable(SOC_SPI_0_REGS, MCSPI_INT_TX_EMPTY(ORBIS_SPI_CHANNEL));
-        McSPIIntStatusClear(SOC_SPI_0_REGS, MCSPI_INT_TX_EMPTY(ORBIS_SPI_CHANNEL));
+        McSPIIntDisable(bus->base, MCSPI_INT_TX_EMPTY(channel));
+        McSPIIntStatusClear(bus->base, MCSPI_INT_TX_EMPTY(channel));
     }
+#endif
 
-    // if eow then what? rx_full may not be there yet...
-    /*
-    if (MCSPI_INT_EOWKE & McSPIIntStatusGet(SOC_SPI_0_REGS)) {
+#if ORBIS_USE_EOW
+    // The word count is done, so all of the response has been clocked in. The last word may still
+    // be on its way into the Rx FIFO, so wait for each word, but not for ever: a word that does not
+    // turn up leaves the capture to time out in OrbisEncoderPoll().
+    if (MCSPI_INT_EOWKE & McSPIIntStatusGet(bus->base)) {
+        uint32_t start;
 
-        McSPIIntDisable(SOC_SPI_0_REGS, MCSPI_INT_EOWKE);
-        McSPIIntStatusClear(SOC_SPI_0_REGS, MCSPI_INT_EOWKE);
+        ORBIS_LATENCY_STAMP(encoder, ORBIS_STAGE_RX);
+
+        McSPIIntDisable(bus->base, MCSPI_INT_EOWKE);
+        McSPIIntStatusClear(bus->base, MCSPI_INT_EOWKE | MCSPI_INT_TX_EMPTY(channel) | MCSPI_INT_RX_FULL(channel));
+
+        start = TIME;
+        for (uint32_t i = 0; i < encoder->dataRxLength; i++) {
+            while (!(McSPIChannelStatusGet(bus->base, channel) & MCSPI_CH_STAT_RXS_FULL)) {
+                if ((TIME - start) >= ORBIS_EOW_DRAIN_TIMEOUT)
+                    return NULL;
+            }
+            encoder->rxBuffer[i] = McSPIReceiveData(bus->base, channel) & ORBIS_BIT_MASK;
+        }
+        ORBIS_LATENCY_STAMP(encoder, ORBIS_STAGE_DRAIN);
+
+        return encoder;
     }
-    */
+
+    return NULL;
+#else
 
     //if rx full read full response
-    if (MCSPI_INT_RX_FULL(ORBIS_SPI_CHANNEL) & McSPIIntStatusGet(SOC_SPI_0_REGS)) {
+    if (MCSPI_INT_RX_FULL(channel) & McSPIIntStatusGet(bus->base)) {
+        ORBIS_LATENCY_STAMP(encoder, ORBIS_STAGE_RX);
 
         // Read Orbis response from the FIFO (via Rx register)
-        for (uint32_t i = 0; i < orbisDataRxLength; i++) {
-            orbisDataRx[i] = McSPIReceiveData(SOC_SPI_0_REGS, ORBIS_SPI_CHANNEL) & ORBIS_BIT_MASK;
+        for (uint32_t i = 0; i < encoder->dataRxLength; i++) {
+            encoder->rxBuffer[i] = McSPIReceiveData(bus->base, channel) & ORBIS_BIT_MASK;
         }
+        ORBIS_LATENCY_STAMP(encoder, ORBIS_STAGE_DRAIN);
 
-        McSPIIntDisable(SOC_SPI_0_REGS, MCSPI_INT_RX_FULL(ORBIS_SPI_CHANNEL));
-        McSPIIntStatusClear(SOC_SPI_0_REGS, MCSPI_INT_RX_FULL(ORBIS_SPI_CHANNEL));
+        McSPIIntDisable(bus->base, MCSPI_INT_RX_FULL(channel));
+        McSPIIntStatusClear(bus->base, MCSPI_INT_RX_FULL(channel));
 
-        orbisReady = 1;
+        return encoder;
     }
+
+    return NULL;
+#endif
 }
 
-// Returns ORBIS_CRC_OK or ORBIS_CRC_FAIL
-uint8_t OrbisCaptureGet(void)
+// Interrupt handler of the encoder whose capture is on the bus
+void OrbisBusIsr(OrbisBus* bus)
+{
+    OrbisEncoder* encoder = OrbisBusService(bus);
+
+    if (encoder != NULL)
+        OrbisCaptureComplete(encoder);
+}
+
+// McSPI0 interrupt handler
+void orbisMcSPIIsr(void)
+{
+    ORBIS_LOAD_ISR_ENTER();
+    OrbisBusIsr(&orbisBus[0]);
+    ORBIS_LOAD_ISR_EXIT();
+}
+
+// McSPI1 interrupt handler
+void orbisMcSPI1Isr(void)
+{
+    ORBIS_LOAD_ISR_ENTER();
+    OrbisBusIsr(&orbisBus[1]);
+    ORBIS_LOAD_ISR_EXIT();
+}
+
+// Start a position capture on orbisEncoder, see OrbisEncoderRequestStart()
+void OrbisCaptureStart(uint32_t timeout, OrbisCaptureCallback callback)
+{
+    OrbisEncoderRequestStart(&orbisEncoder, ORBIS_REQ_POSITION, timeout, callback);
+}
+
+// Send a request to orbisEncoder, see OrbisEncoderRequestStart()
+void OrbisRequestStart(uint8_t request, uint32_t timeout, OrbisCaptureCallback callback)
+{
+    OrbisEncoderRequestStart(&orbisEncoder, request, timeout, callback);
+}
+
+//
+// Send a request to the encoder and return without waiting for the response.
+// The request is one of ORBIS_REQ_...
+//
+// If another encoder on the same McSPI module is on the bus, the request waits
+// for its turn, see OrbisBusNext(). It is sent from the interrupt handler then.
+//
+// The capture has to complete within timeout DMTimer4 ticks of the CS assertion, otherwise
+// OrbisEncoderPoll() abandons it and reports ORBIS_CAPTURE_TIMEOUT. If callback is not
+// NULL, it is called once the capture has finished, either way, with the capture state
+// and the CRC validation result. The callback is called from the interrupt handler when
+// the capture completes, and from OrbisEncoderPoll() when it times out, so keep it short.
+//
+// The caller must not start a new capture while the encoder's captureState is ORBIS_CAPTURE_BUSY.
+//
+void OrbisEncoderRequestStart(OrbisEncoder* encoder, uint8_t request, uint32_t timeout,
+                              OrbisCaptureCallback callback)
+{
+    OrbisBus* bus = encoder->bus;
+    unsigned char irq;
+    uint8_t start;
+
+    OrbisRequestPrepare(encoder, request, timeout, callback);
+
+    // Take the bus, or join the queue. The interrupt handler of the capture on the bus
+    // may be handing it over at this very moment.
+    irq = IntDisable();
+    start = (bus->active == NULL);
+    if (start)
+        bus->active = encoder;
+    else
+        encoder->waiting = 1;
+    IntEnable(irq);
+
+    if (start)
+        OrbisTransferStart(encoder);
+}
+
+//
+// Set up the capture state of the encoder for the request, before it goes on the bus
+//
+static void OrbisRequestPrepare(OrbisEncoder* encoder, uint8_t request, uint32_t timeout,
+                                OrbisCaptureCallback callback)
+{
+    ORBIS_LATENCY_BEGIN(encoder);
+
+    encoder->captureCallback = callback;
+    encoder->captureTimeout = timeout;
+    encoder->captureState = ORBIS_CAPTURE_BUSY;
+    encoder->ready = 0;
+    encoder->request = request;
+
+    // Orbis will respond with position information (16 bit single-turn, 32 bit multi-turn),
+    // the data asked for by the command, if any, and CRC (8 bit).
+    encoder->txCommand = orbisFrames[request].command;
+    encoder->dataRxLength = orbisFrames[request].length;
+}
+
+//
+// Put the request of the encoder on the bus. The encoder must already own the bus.
+//
+static void OrbisTransferStart(OrbisEncoder* encoder)
 {
-    // Just an ordinary null request for now as we don't yet have TX capability. Orbis will
-    // respond with position information (16 bit single-turn, 32 bit multi-turn) and CRC (8 bit) only.
-    orbisDataRxLength = ORBIS_SIZE_POSITION + ORBIS_SIZE_CRC;
+#if ORBIS_USE_EDMA
+    // The RX_FULL condition now raises a DMA request, so EDMA must be armed before the channel is enabled
+    if (ORBIS_EDMA_CAPABLE(encoder))
+        OrbisEDMARxArm(encoder, encoder->rxBuffer, encoder->dataRxLength);
+#endif
 
-    // Set transfer levels for Rx in terms of bytes that we wish to READ. In fact, 8 bit SPI word occupies
+    OrbisTransferSelect(encoder);
+
+    // Give Orbis time to prepare the transmission after CS signal is enabled. The clock starts
+    // when the Tx FIFO is filled, which is left to the timer interrupt rather than waited for here.
+    TimerDeadlineArm(&encoder->csDeadline, encoder->captureStartTime + encoder->csDelay,
+                     OrbisCSSetupDone, encoder);
+}
+
+//
+// Give the FIFO to the channel of the encoder, set the transfer levels and the word count
+// to xferLevel and enable the channel. Shared by the captures and the bursts.
+//
+static void OrbisChannelOpen(OrbisEncoder* encoder, uint32_t xferLevel)
+{
+    OrbisBus* bus = encoder->bus;
+    uint32_t channel = encoder->channel;
+
+    // Hand the FIFO over, if the last transfer on this bus was with another encoder
+    if (bus->fifoChannel != channel) {
+        McSPIRxFIFOConfig(bus->base, MCSPI_RX_FIFO_DISABLE, bus->fifoChannel);
+        McSPITxFIFOConfig(bus->base, MCSPI_TX_FIFO_DISABLE, bus->fifoChannel);
+        McSPIRxFIFOConfig(bus->base, MCSPI_RX_FIFO_ENABLE, channel);
+        McSPITxFIFOConfig(bus->base, MCSPI_TX_FIFO_ENABLE, channel);
+        bus->fifoChannel = channel;
+    }
+
+    // Set transfer levels in terms of bytes that we wish to WRITE and READ. In fact, 8 bit SPI word occupies
     // 2 bytes in FIFO, as per TRM Table 24-9, but this fact is irrelevant for setting AFL and AEL levels.
-    // If the program uses only one WCNT value (the same command is send to the peripheral every time),
-    // then the FIFO trigger levels can be set once and forever in the Setup() for the peripheral. Since
-    // eventually all Orbis commands will be supported, WCNT value would be different for each command, so
-    // the transfer levels should be set before every transfer just as the WCNT is.
+    // The WCNT value is different for each command, so the transfer levels are set before every transfer
+    // just as the WCNT is. Both come from the table, in one register write.
     //
-    // Transfer levels should be set before enabling the channel (AM335x TRM 24.3.2.10.4)
-    McSPIFIFOTrigLvlSet(SOC_SPI_0_REGS, orbisDataRxLength, 1, MCSPI_RX_ONLY_MODE);
+    // Transfer levels and word count should be set before enabling the channel (AM335x TRM 24.3.2.10.4)
+    HWREG(bus->base + MCSPI_XFERLEVEL) = xferLevel;
 
-    // Word count should be set before enabling the channel (AM335x TRM 24.3.2.10.4)
-    McSPIWordCountSet(SOC_SPI_0_REGS, orbisDataRxLength);
-
-    // We are the only device on this SPI bus, so can enable the channel without checking
-    // if there is any activity on the bus. The AM335x TRM (24.4.1.9) claims that this action
-    // sets MCSPI_CHxSTAT[TXS] bit to indicate that the channel's Tx register is empty, but
-    // this does not happen.
-    McSPIChannelEnable(SOC_SPI_0_REGS, ORBIS_SPI_CHANNEL);
+    // Only this channel is enabled on the module, so there is no activity on the bus to check for.
+    // The AM335x TRM (24.4.1.9) claims that this action sets MCSPI_CHxSTAT[TXS] bit to indicate
+    // that the channel's Tx register is empty, but this does not happen.
+    McSPIChannelEnable(bus->base, channel);
 
     // The interrupt status bits should always be reset after the channel is enabled and before
     // the even is enabled as an interrupt source (TRM 24.3.4.1)
-    //McSPIIntStatusClear(SOC_SPI_0_REGS, MCSPI_INT_TX_EMPTY(ORBIS_SPI_CHANNEL) | MCSPI_INT_RX_FULL(ORBIS_SPI_CHANNEL) | MCSPI_INT_EOWKE);
-    McSPIIntStatusClear(SOC_SPI_0_REGS, MCSPI_INT_TX_EMPTY(ORBIS_SPI_CHANNEL) | MCSPI_INT_RX_FULL(ORBIS_SPI_CHANNEL));
+    McSPIIntStatusClear(bus->base, MCSPI_INT_TX_EMPTY(channel) | MCSPI_INT_RX_FULL(channel) | MCSPI_INT_EOWKE);
+}
+
+//
+// Configure the channel for the request of the encoder, enable it and select the encoder.
+// Shared by the interrupt-driven and the polled captures.
+//
+static void OrbisTransferSelect(OrbisEncoder* encoder)
+{
+    OrbisBus* bus = encoder->bus;
+    uint32_t channel = encoder->channel;
+
+    OrbisChannelOpen(encoder, orbisXferLevels[encoder->request]);
+
+    // The deadline is measured from the moment the encoder is selected. Orbis latches the position
+    // as it is selected too, so this is also the timestamp of the sample, see OrbisEstimatorAt().
+    encoder->captureStartTime = TIME;
 
     // Assert CS manually as we are in four-pin mode. This will set MCSPI_CHxSTAT[TXS] bit,
     // to indicate that the channel's Tx register is empty. This behaviour is a deviation
     // from the AM335x TRM.
-    McSPICSAssert(SOC_SPI_0_REGS, ORBIS_SPI_CHANNEL);
+    McSPICSAssert(bus->base, channel);
+    ORBIS_LATENCY_STAMP(encoder, ORBIS_STAGE_CS);
+}
+
+//
+// The CS setup delay of the encoder is over: let the transfer go. Called from the timer interrupt.
+//
+static void OrbisCSSetupDone(void* context)
+{
+    OrbisEncoder* encoder = (OrbisEncoder*) context;
+    OrbisBus* bus = encoder->bus;
+    uint32_t channel = encoder->channel;
 
-    // Wait for Orbis to prepare the transmission after CS signal is enabled
-    waitfor(ORBIS_DELAY_MULTI);
+    ORBIS_LATENCY_STAMP(encoder, ORBIS_STAGE_SETUP);
 
-    // ?
-    orbisReady = 0;
+#if ORBIS_USE_EDMA
+    // TXS is already set by the CS assertion, so there is no need to take an interrupt just to fill
+    // the Tx FIFO. The only interrupt of the capture is the EDMA3 transfer completion.
+    if (ORBIS_EDMA_CAPABLE(encoder)) {
+        McSPITransmitData(bus->base, encoder->txCommand, channel);
+        for (uint32_t i = 1; i < encoder->dataRxLength; i++) {
+            McSPITransmitData(bus->base, ORBIS_CMD_NONE, channel);
+        }
+        return;
+    }
+#endif
+
+#if ORBIS_USE_EOW
+    // Same here, the Tx FIFO is filled straight away and the clock starts. The word count was set
+    // to the length of the response along with the transfer levels, so EOW marks its last word.
+    McSPIIntEnable(bus->base, MCSPI_INT_EOWKE);
 
+    McSPITransmitData(bus->base, encoder->txCommand, channel);
+    for (uint32_t i = 1; i < encoder->dataRxLength; i++) {
+        McSPITransmitData(bus->base, ORBIS_CMD_NONE, channel);
+    }
+    McSPIIntStatusClear(bus->base, MCSPI_INT_TX_EMPTY(channel));
+    ORBIS_LATENCY_STAMP(encoder, ORBIS_STAGE_TX);
+#else
     // Enable interrupts
-    //McSPIIntEnable(SOC_SPI_0_REGS, MCSPI_INT_TX_EMPTY(ORBIS_SPI_CHANNEL) | MCSPI_INT_RX_FULL(ORBIS_SPI_CHANNEL) | MCSPI_INT_EOWKE);
-    McSPIIntEnable(SOC_SPI_0_REGS, MCSPI_INT_TX_EMPTY(ORBIS_SPI_CHANNEL) | MCSPI_INT_RX_FULL(ORBIS_SPI_CHANNEL));
+    McSPIIntEnable(bus->base, MCSPI_INT_TX_EMPTY(channel) | MCSPI_INT_RX_FULL(channel));
+#endif
+}
+
+//
+// The bus is free: start the capture of the next waiting encoder, looking at the chip selects
+// round-robin from the one after the encoder that had the bus last. Must be called with IRQ
+// disabled, which it is in the interrupt handlers.
+//
+static void OrbisBusNext(OrbisBus* bus)
+{
+    for (uint32_t i = 0; i < ORBIS_BUS_CHANNELS; i++) {
+        uint32_t channel = (bus->next + i) % ORBIS_BUS_CHANNELS;
+        OrbisEncoder* encoder = bus->encoders[channel];
+
+        if (encoder != NULL && encoder->waiting) {
+            encoder->waiting = 0;
+            bus->active = encoder;
+            bus->next = (channel + 1) % ORBIS_BUS_CHANNELS;
+            OrbisTransferStart(encoder);
+            return;
+        }
+    }
+}
 
-    // Interrupt triggered... wait until the driver has read the value from the FIFO...
-    while (orbisReady != 1);
+//
+// Finish the capture once the response is in the encoder's dataRx: release the bus,
+// validate the CRC, publish the result, start the next waiting capture on the bus
+// and notify the caller.
+//
+// In the continuous acquisition mode the response is in the ring buffer slot instead.
+// The sample is completed there and published to the consumer.
+//
+// Called from the interrupt handler that has received the last byte of the response.
+//
+void OrbisCaptureComplete(OrbisEncoder* encoder)
+{
+    OrbisBus* bus = encoder->bus;
 
     // We are done transmitting the data, deassert CS
-    McSPICSDeAssert(SOC_SPI_0_REGS, ORBIS_SPI_CHANNEL);
+    McSPICSDeAssert(bus->base, encoder->channel);
 
     // Disable the channel
-    McSPIChannelDisable(SOC_SPI_0_REGS, ORBIS_SPI_CHANNEL);
+    McSPIChannelDisable(bus->base, encoder->channel);
 
-    // Validate CRC and report back
-    uint8_t isValidCRC = OrbisValidateCRC();
+    // Validate CRC before anyone is told that the data is there
+    if (encoder->acquisitionSlot != NULL) {
+        volatile OrbisSample* sample = encoder->acquisitionSlot;
+        OrbisPosition position = { 0 };
 
-    return isValidCRC;
+        sample->timestamp = encoder->captureStartTime;
+        sample->length = (uint8_t) encoder->dataRxLength;
+        sample->crc = OrbisFrameValidate(sample->data, encoder->dataRxLength);
+
+        // The position goes into the sample decoded, but only if it can be trusted
+        if (ORBIS_CRC_OK == sample->crc)
+            OrbisPositionDecode(sample->data, &position);
+        sample->position = (uint16_t) position.position;
+        sample->turns = (uint16_t) position.turns;
+        sample->error = (uint8_t) position.error;
+        sample->warning = (uint8_t) position.warning;
+
+        // The CRC error flag is sticky
+        if (ORBIS_CRC_FAIL == sample->crc)
+            encoder->crcErrorFlag = ORBIS_CRC_FAIL;
+
+        encoder->captureCRC = sample->crc;
+        ORBIS_RECORD_CAPTURE(encoder, sample->data, sample->crc);
+
+        // Velocity and acceleration go with the sample, if the encoder has an estimator
+        sample->velocity = 0;
+        sample->acceleration = 0;
+        if (ORBIS_CRC_OK == sample->crc && encoder->estimator != NULL &&
+            OrbisEstimatorUpdate(encoder->estimator, sample->timestamp, sample->data) == ORBIS_ESTIMATOR_VALID) {
+            sample->velocity = encoder->estimator->velocity;
+            sample->acceleration = encoder->estimator->acceleration;
+        }
+
+        OrbisRingSlotCommit();
+        encoder->acquisitionSlot = NULL;
+        encoder->rxBuffer = encoder->dataRx;
+    } else {
+        encoder->captureCRC = OrbisEncoderValidateCRC(encoder);
+        ORBIS_RECORD_CAPTURE(encoder, encoder->dataRx, encoder->captureCRC);
+
+        if (ORBIS_CRC_OK == encoder->captureCRC && encoder->estimator != NULL)
+            OrbisEstimatorUpdate(encoder->estimator, encoder->captureStartTime, encoder->dataRx);
+    }
+    ORBIS_LATENCY_STAMP(encoder, ORBIS_STAGE_CRC);
+    ORBIS_LATENCY_END(encoder);
+
+    encoder->ready = 1;
+    encoder->captureState = ORBIS_CAPTURE_DONE;
+
+    bus->active = NULL;
+    OrbisBusNext(bus);
+
+    if (encoder->captureCallback != NULL)
+        encoder->captureCallback(encoder, ORBIS_CAPTURE_DONE, encoder->captureCRC);
 }
 
 //
-// Calculate and store CRC for Orbis response. Set a global flag, if there is a CRC error.
+// Abandon the capture on the bus if it has not completed before its deadline,
+// and give the bus to the next waiting encoder.
 //
-// Sets global variables orbisReceivedCRC, orbisCalculatedCRC, and orbisCRCErrorFlag.
-// Returns ORBIS_CRC_OK if validation is successful, ORBIS_CRC_FAIL otherwise.
+static void OrbisBusPoll(OrbisBus* bus)
+{
+    OrbisEncoder* encoder = bus->active;
+    uint32_t channel;
+    unsigned char irq;
+
+    if (encoder == NULL || encoder->captureState != ORBIS_CAPTURE_BUSY)
+        return;
+
+    if ((TIME - encoder->captureStartTime) < encoder->captureTimeout)
+        return;
+
+    channel = encoder->channel;
+
+    // Out of time. Silence the completion interrupts first, as the response might
+    // have arrived just now, and only then decide whether the capture has failed.
+    // The transfer may not even have started, if the timeout is shorter than the CS setup delay.
+    TimerDeadlineCancel(&encoder->csDeadline);
+#if ORBIS_USE_EDMA
+    if (ORBIS_EDMA_CAPABLE(encoder)) {
+        McSPIDMADisable(bus->base, MCSPI_DMA_RX_EVENT, channel);
+        EDMA3DisableTransfer(SOC_EDMA30CC_0_REGS, ORBIS_EDMA_RX_EVENT, EDMA3_TRIG_MODE_EVENT);
+    }
+#endif
+    McSPIIntDisable(bus->base, MCSPI_INT_TX_EMPTY(channel) | MCSPI_INT_RX_FULL(channel) | MCSPI_INT_EOWKE);
+
+    // The completion interrupt may have been raised already and still be pending, with IRQ
+    // disabled by the caller, or it may be taken right now. Decide with IRQ disabled, and take
+    // back a completion that is pending, or it completes whatever capture comes next on the bus.
+    irq = IntDisable();
+    if (encoder->captureState != ORBIS_CAPTURE_BUSY) {
+        IntEnable(irq);
+        return;
+    }
+#if ORBIS_USE_EDMA
+    if (ORBIS_EDMA_CAPABLE(encoder))
+        EDMA3ClrIntr(SOC_EDMA30CC_0_REGS, ORBIS_EDMA_RX_TCC);
+#endif
+#if ORBIS_USE_FIQ
+    if (bus == &orbisBus[0])
+        OrbisFIQCompletionCancel();
+#endif
+
+    McSPIIntStatusClear(bus->base, MCSPI_INT_TX_EMPTY(channel) | MCSPI_INT_RX_FULL(channel) | MCSPI_INT_EOWKE);
+    McSPICSDeAssert(bus->base, channel);
+    McSPIChannelDisable(bus->base, channel);
+
+    // A sample that has timed out is never published
+    encoder->acquisitionSlot = NULL;
+    encoder->rxBuffer = encoder->dataRx;
+
+    encoder->captureCRC = ORBIS_CRC_FAIL;
+    encoder->captureState = ORBIS_CAPTURE_TIMEOUT;
+    ORBIS_RECORD_CAPTURE(encoder, NULL, ORBIS_TIMEOUT);
+
+    bus->active = NULL;
+    OrbisBusNext(bus);
+    IntEnable(irq);
+
+    if (encoder->captureCallback != NULL)
+        encoder->captureCallback(encoder, ORBIS_CAPTURE_TIMEOUT, encoder->captureCRC);
+}
+
+// Nothing to do, the interrupt has woken the CPU up, see OrbisBusWakeArm()
+static void OrbisBusWake(void* context)
+{
+}
+
 //
-uint8_t OrbisValidateCRC(void)
+// Make sure that a sleeping wait on the bus wakes up when the capture on the bus is past its
+// deadline, which is only ever noticed by OrbisBusPoll(). Called with IRQ disabled.
+//
+// Returns 1 if it is all right to sleep, 0 if the deadline has already passed.
+//
+static uint8_t OrbisBusWakeArm(OrbisBus* bus)
 {
-    uint8_t isValidCRC = ORBIS_CRC_FAIL;
+    OrbisEncoder* active = bus->active;
+    uint32_t due;
 
-    orbisReceivedCRC = (uint8_t) ~orbisDataRx[orbisDataRxLength - 1];
-    orbisCalculatedCRC = OrbisCRC_Buffer(orbisDataRx, orbisDataRxLength - 1);
+    if (active == NULL)
+        return 1;
 
-    isValidCRC = (orbisReceivedCRC == orbisCalculatedCRC) ? ORBIS_CRC_OK : ORBIS_CRC_FAIL;
+    due = active->captureStartTime + active->captureTimeout;
 
-    // The CRC error flag is sticky
-    if (ORBIS_CRC_FAIL == isValidCRC)
-        orbisCRCErrorFlag = ORBIS_CRC_FAIL;
+    if (!bus->wakeDeadline.armed || bus->wakeDeadline.due != due) {
+        TimerDeadlineCancel(&bus->wakeDeadline);
+        TimerDeadlineArm(&bus->wakeDeadline, due, OrbisBusWake, bus);
+    }
 
-    return isValidCRC;
+    // A deadline that has passed is made on the spot and does not stay armed
+    return bus->wakeDeadline.armed;
+}
+
+//
+// Sleep until the next interrupt if the capture of the encoder is still in progress. The McSPI,
+// EDMA3 and timer interrupts of the capture wake it up, and so does its deadline.
+//
+static void OrbisEncoderSleep(OrbisEncoder* encoder)
+{
+    unsigned char irq = IntDisable();
+
+    if (encoder->captureState == ORBIS_CAPTURE_BUSY && OrbisBusWakeArm(encoder->bus))
+        OrbisLoadSleep();
+
+    IntEnable(irq);
+}
+
+//
+// Check on the capture started with OrbisEncoderRequestStart(). Abandons the capture on
+// the encoder's bus, this one or another encoder's, if it is past its deadline.
+//
+// Returns the capture state: ORBIS_CAPTURE_BUSY, ORBIS_CAPTURE_DONE, ORBIS_CAPTURE_TIMEOUT
+// or ORBIS_CAPTURE_IDLE, if no capture has been started.
+//
+uint8_t OrbisEncoderPoll(OrbisEncoder* encoder)
+{
+    if (encoder->captureState != ORBIS_CAPTURE_BUSY)
+        return encoder->captureState;
+
+    OrbisBusPoll(encoder->bus);
+
+    return encoder->captureState;
+}
+
+// Check on the capture of orbisEncoder, see OrbisEncoderPoll()
+uint8_t OrbisCapturePoll(void)
+{
+    return OrbisEncoderPoll(&orbisEncoder);
+}
+
+//
+// Blocking request, interrupt-driven: start it and wait for the interrupt handlers to finish it.
+//
+// Returns the capture state, ORBIS_CAPTURE_DONE or ORBIS_CAPTURE_TIMEOUT.
+//
+uint8_t OrbisEncoderRequestInterrupt(OrbisEncoder* encoder, uint8_t request, uint32_t timeout)
+{
+    uint8_t state;
+
+    ORBIS_LOAD_CAPTURE_BEGIN();
+    OrbisEncoderRequestStart(encoder, request, timeout, NULL);
+
+    // Interrupt triggered... sleep until the driver has read the value from the FIFO...
+    while ((state = OrbisEncoderPoll(encoder)) == ORBIS_CAPTURE_BUSY)
+        OrbisEncoderSleep(encoder);
+
+    TimerDeadlineCancel(&encoder->bus->wakeDeadline);
+    ORBIS_LOAD_CAPTURE_END();
+
+    return state;
+}
+
+//
+// Blocking request, polled: the McSPI interrupts are not used at all. The CS setup delay is
+// waited for, the Tx FIFO filled, and every word of the response is read as soon as
+// MCSPI_CHxSTAT[RXS] shows it has arrived, all on the spot. The channel state is the same
+// as for the interrupt-driven capture, and the capture is completed the same way, CRC and all.
+//
+// The whole capture has to fit in timeout DMTimer4 ticks from the CS assertion, which is
+// checked on every turn of the loops; then it is abandoned as OrbisEncoderPoll() would.
+// Interrupts stay enabled, so a capture of another encoder on the bus is waited for first.
+//
+// Returns the capture state, ORBIS_CAPTURE_DONE or ORBIS_CAPTURE_TIMEOUT.
+//
+uint8_t OrbisEncoderRequestPolled(OrbisEncoder* encoder, uint8_t request, uint32_t timeout)
+{
+    OrbisBus* bus = encoder->bus;
+    uint32_t channel = encoder->channel;
+    unsigned char irq;
+    uint8_t start = 0;
+
+    ORBIS_LOAD_CAPTURE_BEGIN();
+    OrbisRequestPrepare(encoder, request, timeout, NULL);
+
+    while (!start) {
+        irq = IntDisable();
+        start = (bus->active == NULL);
+        if (start)
+            bus->active = encoder;
+        IntEnable(irq);
+
+        if (!start)
+            OrbisBusPoll(bus);
+    }
+
+    OrbisTransferSelect(encoder);
+
+    while ((TIME - encoder->captureStartTime) < encoder->csDelay);
+    ORBIS_LATENCY_STAMP(encoder, ORBIS_STAGE_SETUP);
+
+    // TXS is set by the CS assertion, the whole request goes into the Tx FIFO at once
+    McSPITransmitData(bus->base, encoder->txCommand, channel);
+    for (uint32_t i = 1; i < encoder->dataRxLength; i++) {
+        McSPITransmitData(bus->base, ORBIS_CMD_NONE, channel);
+    }
+    ORBIS_LATENCY_STAMP(encoder, ORBIS_STAGE_TX);
+
+    for (uint32_t i = 0; i < encoder->dataRxLength; i++) {
+        while (!(McSPIChannelStatusGet(bus->base, channel) & MCSPI_CH_STAT_RXS_FULL)) {
+            if ((TIME - encoder->captureStartTime) >= timeout) {
+                OrbisBusPoll(bus);
+                ORBIS_LOAD_CAPTURE_END();
+                return encoder->captureState;
+            }
+        }
+        encoder->rxBuffer[i] = McSPIReceiveData(bus->base, channel) & ORBIS_BIT_MASK;
+
+        if (i == 0) {
+            ORBIS_LATENCY_STAMP(encoder, ORBIS_STAGE_RX);
+        }
+    }
+    ORBIS_LATENCY_STAMP(encoder, ORBIS_STAGE_DRAIN);
+
+    // The status bits raised on the way are of no interest, and the bus handover wants IRQ disabled
+    McSPIIntStatusClear(bus->base, MCSPI_INT_TX_EMPTY(channel) | MCSPI_INT_RX_FULL(channel) | MCSPI_INT_EOWKE);
+
+    irq = IntDisable();
+    OrbisCaptureComplete(encoder);
+    IntEnable(irq);
+    ORBIS_LOAD_CAPTURE_END();
+
+    return encoder->captureState;
 }
 
 //
-// Calculate CRC from fixed length buffer with 0x97 polynome.
-// Adapted from the Appendix 1 of the Orbis data sheet.
-// Input: pointer to the buffer, and how many bytes from
-// the buffer to use to calculate CRC. The CRC is 8 bit and the length
-// of the preceding data depends on the request/response type.
+// Burst of count frames of the request, back to back, in one session of the encoder's
+// McSPI channel. A single capture sets the transfer levels and the word count, enables the
+// channel and disables it again for each frame. Here the channel is opened once, with
+// no word count, and left enabled: each frame is a CS assertion, the CS setup delay, the
+// request written into the Tx FIFO and the response read from the Rx FIFO as it comes in,
+// polled, as in OrbisEncoderRequestPolled(). CS is then deasserted for ORBIS_BURST_GAP
+// before the next frame, which makes it a frame of its own for Orbis.
+//
+// Every frame is checked on its own, with its timestamp, the time of its CS assertion,
+// and goes to the capture recorder and to the estimator of the encoder, if it has one.
+// A frame that is not in timeout DMTimer4 ticks after its CS assertion is marked
+// ORBIS_TIMEOUT, the channel is disabled and enabled again to empty the FIFOs, and the
+// burst goes on with the next frame.
+//
+// The bus is taken for the whole burst, so the other encoders on it wait for its end.
 //
-uint8_t OrbisCRC_Buffer(volatile uint8_t* buffer, uint32_t numOfBytes)
+// Returns the number of frames with a good CRC.
+//
+uint32_t OrbisEncoderBurst(OrbisEncoder* encoder, uint8_t request, OrbisBurstFrame frames[],
+                           uint32_t count, uint32_t timeout)
 {
-    uint32_t t;
-    uint8_t icrc;
+    OrbisBus* bus = encoder->bus;
+    uint32_t channel = encoder->channel;
+    uint32_t good = 0;
+    uint32_t gapStart = 0;
+    unsigned char irq;
+    uint8_t start = 0;
+
+    if (count == 0)
+        return 0;
+
+    ORBIS_LOAD_CAPTURE_BEGIN();
+    OrbisRequestPrepare(encoder, request, timeout, NULL);
+
+    while (!start) {
+        irq = IntDisable();
+        start = (bus->active == NULL);
+        if (start)
+            bus->active = encoder;
+        IntEnable(irq);
+
+        if (!start)
+            OrbisBusPoll(bus);
+    }
+
+    // No word count, the session lasts for as many frames as there are
+    OrbisChannelOpen(encoder, orbisXferLevels[request] & ~MCSPI_XFERLEVEL_WCNT);
+
+    for (uint32_t k = 0; k < count; k++) {
+        OrbisBurstFrame* frame = &frames[k];
+        uint8_t timedOut = 0;
+
+        if (k > 0)
+            while ((TIME - gapStart) < ORBIS_BURST_GAP);
+
+        encoder->captureStartTime = TIME;
+        McSPICSAssert(bus->base, channel);
+
+        while ((TIME - encoder->captureStartTime) < encoder->csDelay);
 
-    numOfBytes -= 1;
-    icrc = 1;
-    t = buffer[0];
-    while (numOfBytes--)
-    {
-        // TODO is the way ^ is done and assigned compatible with SEI CERT C Coding Standard section INT02-C?
-        t = buffer[icrc++] ^ orbisTableCRC[t];
+        McSPITransmitData(bus->base, encoder->txCommand, channel);
+        for (uint32_t i = 1; i < encoder->dataRxLength; i++) {
+            McSPITransmitData(bus->base, ORBIS_CMD_NONE, channel);
+        }
+
+        for (uint32_t i = 0; i < encoder->dataRxLength && !timedOut; i++) {
+            while (!(McSPIChannelStatusGet(bus->base, channel) & MCSPI_CH_STAT_RXS_FULL)) {
+                if ((TIME - encoder->captureStartTime) >= timeout) {
+                    timedOut = 1;
+                    break;
+                }
+            }
+            if (!timedOut)
+                frame->data[i] = (uint8_t) (McSPIReceiveData(bus->base, channel) & ORBIS_BIT_MASK);
+        }
+
+        McSPICSDeAssert(bus->base, channel);
+        gapStart = TIME;
+
+        frame->timestamp = encoder->captureStartTime;
+
+        if (timedOut) {
+            // Whatever is left of the frame goes with the FIFOs
+            McSPIChannelDisable(bus->base, channel);
+            McSPIChannelEnable(bus->base, channel);
+
+            frame->crc = ORBIS_TIMEOUT;
+            ORBIS_RECORD_CAPTURE(encoder, NULL, ORBIS_TIMEOUT);
+            continue;
+        }
+
+        frame->crc = OrbisFrameValidate(frame->data, encoder->dataRxLength);
+        ORBIS_RECORD_CAPTURE(encoder, frame->data, frame->crc);
+
+        if (ORBIS_CRC_OK == frame->crc) {
+            good++;
+            if (encoder->estimator != NULL)
+                OrbisEstimatorUpdate(encoder->estimator, frame->timestamp, frame->data);
+        } else {
+            // The CRC error flag is sticky
+            encoder->crcErrorFlag = ORBIS_CRC_FAIL;
+        }
     }
 
-    return orbisTableCRC[t];
+    McSPIIntStatusClear(bus->base, MCSPI_INT_TX_EMPTY(channel) | MCSPI_INT_RX_FULL(channel) | MCSPI_INT_EOWKE);
+    McSPIChannelDisable(bus->base, channel);
+
+    encoder->captureCRC = (ORBIS_CRC_OK == frames[count - 1].crc) ? ORBIS_CRC_OK : ORBIS_CRC_FAIL;
+    encoder->ready = 1;
+    encoder->captureState = ORBIS_CAPTURE_DONE;
+
+    irq = IntDisable();
+    bus->active = NULL;
+    OrbisBusNext(bus);
+    IntEnable(irq);
+    ORBIS_LOAD_CAPTURE_END();
+
+    return good;
+}
+
+// Burst of position frames from orbisEncoder, with the default deadline for each, see OrbisEncoderBurst()
+uint32_t OrbisBurstGet(OrbisBurstFrame frames[], uint32_t count)
+{
+    return OrbisEncoderBurst(&orbisEncoder, ORBIS_REQ_POSITION, frames, count, ORBIS_CAPTURE_TIMEOUT_DEFAULT);
+}
+
+//
+// Blocking request with the backend chosen by ORBIS_USE_POLLED and a deadline of timeout
+// DMTimer4 ticks from the CS assertion.
+//
+// Returns the capture state, ORBIS_CAPTURE_DONE or ORBIS_CAPTURE_TIMEOUT.
+//
+uint8_t OrbisEncoderRequestWait(OrbisEncoder* encoder, uint8_t request, uint32_t timeout)
+{
+#if ORBIS_USE_POLLED
+    return OrbisEncoderRequestPolled(encoder, request, timeout);
+#else
+    return OrbisEncoderRequestInterrupt(encoder, request, timeout);
+#endif
+}
+
+//
+// Blocking capture with the default deadline of ORBIS_CAPTURE_TIMEOUT_DEFAULT, interrupt-driven
+// or polled as set by ORBIS_USE_POLLED.
+//
+// Returns ORBIS_CRC_OK, ORBIS_CRC_FAIL, or ORBIS_TIMEOUT if Orbis did not respond in time.
+//
+uint8_t OrbisEncoderCaptureGet(OrbisEncoder* encoder)
+{
+    uint8_t state = OrbisEncoderRequestWait(encoder, ORBIS_REQ_POSITION, ORBIS_CAPTURE_TIMEOUT_DEFAULT);
+
+    return (ORBIS_CAPTURE_DONE == state) ? encoder->captureCRC : ORBIS_TIMEOUT;
+}
+
+// Blocking capture from orbisEncoder, see OrbisEncoderCaptureGet()
+uint8_t OrbisCaptureGet(void)
+{
+    return OrbisEncoderCaptureGet(&orbisEncoder);
+}
+
+//
+// Blocking request with the default deadline of ORBIS_CAPTURE_TIMEOUT_DEFAULT, interrupt-driven
+// or polled as set by ORBIS_USE_POLLED. The response, if it arrives in time, is decoded into
+// response whether its CRC is correct or not.
+//
+// Returns ORBIS_CRC_OK, ORBIS_CRC_FAIL, or ORBIS_TIMEOUT if Orbis did not respond in time.
+//
+uint8_t OrbisEncoderRequestGet(OrbisEncoder* encoder, uint8_t request, OrbisResponse* response)
+{
+    uint8_t state = OrbisEncoderRequestWait(encoder, request, ORBIS_CAPTURE_TIMEOUT_DEFAULT);
+
+    if (ORBIS_CAPTURE_DONE != state)
+        return ORBIS_TIMEOUT;
+
+    OrbisDecode(request, encoder->dataRx, response);
+
+    return encoder->captureCRC;
+}
+
+// Blocking request to orbisEncoder, see OrbisEncoderRequestGet()
+uint8_t OrbisRequestGet(uint8_t request, OrbisResponse* response)
+{
+    return OrbisEncoderRequestGet(&orbisEncoder, request, response);
+}
+
+//
+// Capture the position from all the encoders and wait for them all to finish. The captures
+// on different McSPI modules run at the same time, those on the same module one after another.
+// The deadline of each capture is timeout DMTimer4 ticks from its own CS assertion.
+//
+// Returns the number of encoders whose capture has completed with a correct CRC.
+//
+uint32_t OrbisEncoderCaptureAll(OrbisEncoder* encoders[], uint32_t count, uint32_t timeout)
+{
+    uint32_t busy;
+    uint32_t ok = 0;
+
+    ORBIS_LOAD_CAPTURE_BEGIN();
+
+    for (uint32_t i = 0; i < count; i++)
+        OrbisEncoderRequestStart(encoders[i], ORBIS_REQ_POSITION, timeout, NULL);
+
+    // Sleep until all are done, waking up at the deadline of every capture on the bus
+    for (;;) {
+        unsigned char irq;
+        uint8_t sleep = 1;
+
+        busy = 0;
+        for (uint32_t i = 0; i < count; i++) {
+            if (OrbisEncoderPoll(encoders[i]) == ORBIS_CAPTURE_BUSY)
+                busy++;
+        }
+        if (busy == 0)
+            break;
+
+        irq = IntDisable();
+        busy = 0;
+        for (uint32_t i = 0; i < count; i++) {
+            if (encoders[i]->captureState == ORBIS_CAPTURE_BUSY)
+                busy++;
+        }
+        for (uint32_t i = 0; i < ORBIS_BUS_COUNT; i++)
+            sleep &= OrbisBusWakeArm(&orbisBus[i]);
+        if (busy != 0 && sleep)
+            OrbisLoadSleep();
+        IntEnable(irq);
+    }
+
+    for (uint32_t i = 0; i < ORBIS_BUS_COUNT; i++)
+        TimerDeadlineCancel(&orbisBus[i].wakeDeadline);
+
+    ORBIS_LOAD_CAPTURE_END();
+
+    for (uint32_t i = 0; i < count; i++) {
+        if (encoders[i]->captureState == ORBIS_CAPTURE_DONE && encoders[i]->captureCRC == ORBIS_CRC_OK)
+            ok++;
+    }
+
+    return ok;
+}
+
+//
+// Start the continuous acquisition mode on orbisEncoder: a capture is started every period
+// DMTimer4 ticks (the acquisition timer runs from the same 24 MHz clock) and every completed
+// sample is put into the sample ring buffer together with its timestamp. Use OrbisRingRead()
+// to collect the samples.
+//
+// The acquisition timer runs in auto-reload mode and interrupts on overflow, so the
+// rate is set by the hardware and does not depend on the interrupt latency.
+//
+// Do not call OrbisCaptureGet() or OrbisCaptureStart() while the acquisition is running.
+//
+void OrbisAcquisitionStart(uint32_t period)
+{
+    OrbisRingReset();
+    orbisTriggerOverruns = 0;
+
+    DMTimer2ModuleClkConfig();
+    DMTimerDisable(ORBIS_TRIGGER_TIMER_REGS);
+
+    DMTimerCounterSet(ORBIS_TRIGGER_TIMER_REGS, TIMER_OVERFLOW - period + 1);
+    DMTimerReloadSet(ORBIS_TRIGGER_TIMER_REGS, TIMER_OVERFLOW - period + 1);
+    DMTimerModeConfigure(ORBIS_TRIGGER_TIMER_REGS, DMTIMER_AUTORLD_NOCMP_ENABLE);
+
+    DMTimerIntStatusClear(ORBIS_TRIGGER_TIMER_REGS, DMTIMER_INT_OVF_IT_FLAG);
+    DMTimerIntEnable(ORBIS_TRIGGER_TIMER_REGS, DMTIMER_INT_OVF_EN_FLAG);
+
+    DMTimerEnable(ORBIS_TRIGGER_TIMER_REGS);
+}
+
+// Stop the continuous acquisition mode and wait for the capture in progress to finish.
+void OrbisAcquisitionStop(void)
+{
+    DMTimerDisable(ORBIS_TRIGGER_TIMER_REGS);
+    DMTimerIntDisable(ORBIS_TRIGGER_TIMER_REGS, DMTIMER_INT_OVF_EN_FLAG);
+    DMTimerIntStatusClear(ORBIS_TRIGGER_TIMER_REGS, DMTIMER_INT_OVF_IT_FLAG);
+
+    while (OrbisCapturePoll() == ORBIS_CAPTURE_BUSY)
+        OrbisEncoderSleep(&orbisEncoder);
+
+    TimerDeadlineCancel(&orbisEncoder.bus->wakeDeadline);
+}
+
+// Acquisition timer interrupt handler. Starts the next capture of the continuous acquisition mode.
+void orbisTriggerIsr(void)
+{
+    volatile OrbisSample* slot;
+
+    ORBIS_LOAD_ISR_ENTER();
+
+    DMTimerIntStatusClear(ORBIS_TRIGGER_TIMER_REGS, DMTIMER_INT_OVF_IT_FLAG);
+
+    // Also gives up on the previous capture, if it is past its deadline. Otherwise, if there is
+    // no room for the sample, the overrun is counted by the ring buffer.
+    if (OrbisCapturePoll() == ORBIS_CAPTURE_BUSY) {
+        orbisTriggerOverruns++;
+    } else if ((slot = OrbisRingSlotAcquire()) != NULL) {
+        orbisEncoder.acquisitionSlot = slot;
+        orbisEncoder.rxBuffer = slot->data;
+
+        OrbisCaptureStart(ORBIS_CAPTURE_TIMEOUT_DEFAULT, NULL);
+    }
+
+    ORBIS_LOAD_ISR_EXIT();
+}
+
+//
+// Calculate and store CRC for Orbis response. Set the encoder's flag, if there is a CRC error.
+//
+// Sets receivedCRC, calculatedCRC, and crcErrorFlag of the encoder.
+// Returns ORBIS_CRC_OK if validation is successful, ORBIS_CRC_FAIL otherwise.
+//
+uint8_t OrbisEncoderValidateCRC(OrbisEncoder* encoder)
+{
+    uint8_t isValidCRC = ORBIS_CRC_FAIL;
+
+    encoder->receivedCRC = (uint8_t) ~encoder->dataRx[encoder->dataRxLength - 1];
+    encoder->calculatedCRC = OrbisCRCFrame(encoder->dataRx, encoder->dataRxLength - 1);
+
+    isValidCRC = (encoder->receivedCRC == encoder->calculatedCRC) ? ORBIS_CRC_OK : ORBIS_CRC_FAIL;
+
+    // The CRC error flag is sticky
+    if (ORBIS_CRC_FAIL == isValidCRC)
+        encoder->crcErrorFlag = ORBIS_CRC_FAIL;
+
+    return isValidCRC;
+}
+
+// Validate the CRC of the last response of orbisEncoder, see OrbisEncoderValidateCRC()
+uint8_t OrbisValidateCRC(void)
+{
+    return OrbisEncoderValidateCRC(&orbisEncoder);
 }
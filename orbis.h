@@ -13,57 +13,191 @@
 #ifndef ORBIS_H_
 #define ORBIS_H_
 
+#include <stdint.h>
+#include "util.h"
+#include "orbis_protocol.h"
+#include "orbis_latency.h"
+
 #define MCSPI_IN_CLK                  48000000u
 #define MCSPI_ORBIS_OUT_FREQ           3000000u
 #define ORBIS_SPI_CHANNEL                    0u
 
+// McSPI0 and McSPI1, each with up to two encoders, on CS0 and CS1 as routed on BeagleBone Black
+#define ORBIS_BUS_COUNT                      2u
+#define ORBIS_BUS_CHANNELS                   2u
+
 #define ORBIS_BITS_PER_WORD                  8u
 #define ORBIS_WORD_COUNT                     5u
 #define ORBIS_BIT_MASK                    0xFFu
 
-#define ORBIS_CRC_OK    0u
-#define ORBIS_CRC_FAIL  1u
+// State of a non-blocking capture, see OrbisCaptureStart() and OrbisCapturePoll()
+#define ORBIS_CAPTURE_IDLE     0u
+#define ORBIS_CAPTURE_BUSY     1u
+#define ORBIS_CAPTURE_DONE     2u
+#define ORBIS_CAPTURE_TIMEOUT  3u
+
+// Timer which paces the continuous acquisition mode, see OrbisAcquisitionStart()
+#define ORBIS_TRIGGER_TIMER_REGS        SOC_DMTIMER_2_REGS
+#define ORBIS_TRIGGER_TIMER_INT         SYS_INT_TINT2
+
+// Deadline used by OrbisCaptureGet(), counted from CS assertion. A 5 byte response
+// at 3 MHz takes about 15 us, so this leaves plenty of margin.
+#define ORBIS_CAPTURE_TIMEOUT_DEFAULT   (100 * TIMER_1US)
+
+// Receive mode. When set to 1, the response is moved from the Rx FIFO into orbisDataRx
+// by EDMA3 and the CPU takes one EDMA3 completion interrupt per frame instead of the
+// McSPI TX_EMPTY and RX_FULL interrupts. See orbis_edma.c.
+#ifndef ORBIS_USE_EDMA
+#define ORBIS_USE_EDMA                       0
+#endif
+
+// McSPI0 interrupt routing. When set to 1, SYS_INT_SPI0INT goes to FIQ and a dedicated handler
+// serves the FIFOs without StarterWare's IRQ dispatch; the rest of the capture is completed
+// at IRQ level. See orbis_fiq.c. IRQ is the default.
+#ifndef ORBIS_USE_FIQ
+#define ORBIS_USE_FIQ                        0
+#endif
+
+#if ORBIS_USE_FIQ && ORBIS_USE_EDMA
+#error "ORBIS_USE_FIQ serves the McSPI FIFOs, which ORBIS_USE_EDMA leaves to EDMA3"
+#endif
 
-// TODO something is wrong with the timer as I can see on the scope; this results in about 8 microsec
+// Completion event. When set to 1, the Tx FIFO is filled as soon as the CS setup delay is over
+// and the only McSPI interrupt of the capture is EOW, end of word count, after which the response
+// is drained from the Rx FIFO. One interrupt per frame instead of TX_EMPTY and RX_FULL.
+#ifndef ORBIS_USE_EOW
+#define ORBIS_USE_EOW                        0
+#endif
+
+#if ORBIS_USE_EOW && ORBIS_USE_EDMA
+#error "ORBIS_USE_EOW drains the Rx FIFO in the McSPI interrupt, which ORBIS_USE_EDMA leaves to EDMA3"
+#endif
+
+// EOW may come before the last word is in the Rx FIFO. How long to wait for each word then.
+#define ORBIS_EOW_DRAIN_TIMEOUT         TIMER_10US
+
+// Backend of the blocking captures, OrbisCaptureGet() and the rest. When set to 1, they spin
+// on the McSPI channel status instead of taking interrupts, see OrbisEncoderRequestPolled().
+// The asynchronous captures and the continuous acquisition are interrupt-driven either way.
+#ifndef ORBIS_USE_POLLED
+#define ORBIS_USE_POLLED                     0
+#endif
+
+// CS setup delays, from CS assertion to the first clock edge
 #define ORBIS_DELAY_SINGLE            TIMER_1US
 #define ORBIS_DELAY_MULTI       (2 * TIMER_1US)
 
-//
-// Orbis command set
-//
-#define ORBIS_CMD_NONE          0x00u
-#define ORBIS_CMD_SERIAL        0x76u
-#define ORBIS_CMD_SPEED         0x73u
-#define ORBIS_CMD_TEMPERATURE   0x74u
-#define ORBIS_CMD_STATUS        0x64u
-
-//
-// The sizes of parts of responses supported by Orbis,
-// both single- and multi- turn. In bytes. Each byte is 8 bits.
-// This information closely follows page 14 of Orbis datasheet.
-//
-#define ORBIS_SIZE_MULTITURN     2
-#define ORBIS_SIZE_POSITION      2
-#define ORBIS_SIZE_SERIAL        6
-#define ORBIS_SIZE_SPEED         2
-#define ORBIS_SIZE_TEMPERATURE   2
-#define ORBIS_SIZE_STATUS        1
-#define ORBIS_SIZE_CRC           1
-#define ORBIS_SIZE_BUFFER        (ORBIS_SIZE_MULTITURN + ORBIS_SIZE_POSITION + ORBIS_SIZE_SERIAL + ORBIS_SIZE_CRC)
-
-extern volatile uint8_t orbisDataRx[ORBIS_SIZE_BUFFER];
-extern volatile uint32_t orbisDataRxLength;
-extern volatile uint32_t orbisReady;
-
-extern uint8_t orbisReceivedCRC;
-extern uint8_t orbisCalculatedCRC;
-extern uint8_t orbisCRCErrorFlag;
+// CS deasserted between the frames of a burst, see OrbisEncoderBurst()
+#ifndef ORBIS_BURST_GAP
+#define ORBIS_BURST_GAP               TIMER_1US
+#endif
+
+// MCSPI_XFERLEVEL value for a transfer of n words: WCNT = n, and both FIFO trigger levels at n words
+#define ORBIS_XFERLEVEL(n)      (((uint32_t) (n) << MCSPI_XFERLEVEL_WCNT_SHIFT) | \
+                                 (((uint32_t) (n) - 1u) << MCSPI_XFERLEVEL_AFL_SHIFT) | \
+                                 (((uint32_t) (n) - 1u) << MCSPI_XFERLEVEL_AEL_SHIFT))
+
+// MCSPI_XFERLEVEL value of each request, for the response length in orbisFrames[]
+extern const uint32_t orbisXferLevels[ORBIS_REQ_COUNT];
+
+// A frame of a burst, see OrbisEncoderBurst()
+typedef struct {
+    uint32_t timestamp;                    // DMTimer4 time of the CS assertion
+    uint8_t crc;                           // ORBIS_CRC_OK, ORBIS_CRC_FAIL or ORBIS_TIMEOUT
+    uint8_t data[ORBIS_SIZE_BUFFER];       // The response, CRC included, unless it has timed out
+} OrbisBurstFrame;
+
+struct OrbisEncoder;
+struct OrbisSample;
+struct OrbisEstimator;
+
+// Capture completion callback: the encoder, capture state (ORBIS_CAPTURE_DONE or ORBIS_CAPTURE_TIMEOUT)
+// and CRC result
+typedef void (*OrbisCaptureCallback)(struct OrbisEncoder* encoder, uint8_t state, uint8_t crc);
+
+// A McSPI module with Orbis encoders on its chip selects. Only one of them is on the bus at a time.
+typedef struct {
+    uint32_t base;                         // SOC_SPI_0_REGS or SOC_SPI_1_REGS
+    struct OrbisEncoder* encoders[ORBIS_BUS_CHANNELS]; // Encoder on each chip select, or NULL
+    struct OrbisEncoder* volatile active;  // Encoder whose capture is on the bus, or NULL
+    uint32_t next;                         // Chip select to look at first for a waiting capture
+    uint32_t fifoChannel;                  // Channel the FIFO is given to
+    TimerDeadline wakeDeadline;            // Wakes a blocking wait at the deadline of the capture on the bus
+} OrbisBus;
+
+// An Orbis encoder on a chip select of a McSPI module, and the state of its captures
+typedef struct OrbisEncoder {
+    OrbisBus* bus;
+    uint32_t channel;                      // McSPI channel, the same as the chip select
+
+    volatile uint8_t dataRx[ORBIS_SIZE_BUFFER];
+    volatile uint32_t dataRxLength;
+    volatile uint32_t ready;
+
+    uint8_t receivedCRC;
+    uint8_t calculatedCRC;
+    uint8_t crcErrorFlag;
+
+    volatile uint8_t captureState;
+    volatile uint8_t captureCRC;
+    volatile uint8_t waiting;              // Capture requested but the bus is busy with another encoder
+    uint8_t request;
+    uint8_t txCommand;
+
+    uint32_t clockHz;                      // SPI clock, MCSPI_ORBIS_OUT_FREQ unless calibrated
+    uint32_t csDelay;                      // DMTimer4 ticks from CS assertion to the first clock edge
+    TimerDeadline csDeadline;              // Ends the CS setup delay, see OrbisTransferStart()
+
+    uint32_t captureStartTime;
+    uint32_t captureTimeout;
+    OrbisCaptureCallback captureCallback;
+
+    volatile uint8_t* rxBuffer;
+    volatile struct OrbisSample* acquisitionSlot;
+    struct OrbisEstimator* estimator;      // Fed every position with a good CRC, if not NULL
+
+#if ORBIS_LATENCY
+    uint32_t latencyStamps[ORBIS_STAGE_COUNT];
+    uint32_t latencyMask;                  // Stages stamped in the current capture
+#endif
+} OrbisEncoder;
+
+extern OrbisBus orbisBus[ORBIS_BUS_COUNT];
+extern OrbisEncoder orbisEncoder;
+extern volatile uint32_t orbisTriggerOverruns;
+
+void OrbisBusSetup(OrbisBus* bus);
+void OrbisEncoderSetup(OrbisEncoder* encoder, OrbisBus* bus, uint32_t channel);
+void OrbisEncoderProfileSet(OrbisEncoder* encoder, uint32_t clockHz, uint32_t csDelay);
+void OrbisEncoderRequestStart(OrbisEncoder* encoder, uint8_t request, uint32_t timeout,
+                              OrbisCaptureCallback callback);
+uint8_t OrbisEncoderPoll(OrbisEncoder* encoder);
+uint8_t OrbisEncoderRequestInterrupt(OrbisEncoder* encoder, uint8_t request, uint32_t timeout);
+uint8_t OrbisEncoderRequestPolled(OrbisEncoder* encoder, uint8_t request, uint32_t timeout);
+uint32_t OrbisEncoderBurst(OrbisEncoder* encoder, uint8_t request, OrbisBurstFrame frames[],
+                           uint32_t count, uint32_t timeout);
+uint8_t OrbisEncoderRequestWait(OrbisEncoder* encoder, uint8_t request, uint32_t timeout);
+uint8_t OrbisEncoderRequestGet(OrbisEncoder* encoder, uint8_t request, OrbisResponse* response);
+uint8_t OrbisEncoderCaptureGet(OrbisEncoder* encoder);
+uint32_t OrbisEncoderCaptureAll(OrbisEncoder* encoders[], uint32_t count, uint32_t timeout);
+uint8_t OrbisEncoderValidateCRC(OrbisEncoder* encoder);
+OrbisEncoder* OrbisBusService(OrbisBus* bus);
+void OrbisBusIsr(OrbisBus* bus);
+void orbisMcSPI1Isr(void);
+void OrbisCaptureComplete(OrbisEncoder* encoder);
 
 void OrbisSetup(void);
 void orbisMcSPIIsr(void);
 uint8_t OrbisCaptureGet(void);
+uint32_t OrbisBurstGet(OrbisBurstFrame frames[], uint32_t count);
+void OrbisCaptureStart(uint32_t timeout, OrbisCaptureCallback callback);
+void OrbisRequestStart(uint8_t request, uint32_t timeout, OrbisCaptureCallback callback);
+uint8_t OrbisRequestGet(uint8_t request, OrbisResponse* response);
+uint8_t OrbisCapturePoll(void);
+void OrbisAcquisitionStart(uint32_t period);
+void OrbisAcquisitionStop(void);
+void orbisTriggerIsr(void);
 uint8_t OrbisValidateCRC(void);
-uint8_t OrbisCRC_Buffer(volatile uint8_t* buffer, uint32_t numOfBytes);
 
 // TODO maybe OrbisPrintDataFrame() for debug?
 
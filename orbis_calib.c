@@ -0,0 +1,216 @@
+/*
+ * orbis_calib.c
+ * SPI clock and CS setup delay calibration for the Orbis rotary encoder driver
+ *
+ * MCSPI_ORBIS_OUT_FREQ and ORBIS_DELAY_MULTI are safe for any cable, but a short
+ * cable allows a faster clock and a shorter wait after CS assertion, which means
+ * shorter frames and less time spent in the CS setup wait. OrbisCalibrate() sweeps
+ * the clocks in orbisCalibClocks[] and the delays in orbisCalibDelays[], runs a number
+ * of captures at each step, and counts those that fail the CRC check (or time out).
+ * The profile chosen keeps a step of margin from the edge of what worked: the clock
+ * is one step slower than the fastest clock without a failure, and the delay is one
+ * step longer than the shortest delay without a failure at that clock.
+ *
+ * The chosen profile is kept in orbisProfileStore, which is not cleared at start-up,
+ * so a warm reset or a reload from the debugger can skip the calibration. The record
+ * carries a magic number and a CRC to tell it from whatever was in memory at power-up.
+ *
+ * Conditions change, so OrbisWatchdogUpdate() keeps an eye on the live CRC error rate
+ * and drops to the next slower profile when it rises above ORBIS_WATCHDOG_FAILURES
+ * in ORBIS_WATCHDOG_WINDOW captures.
+ *
+ *  Created on: 16 Oct 2026
+ */
+#include <stdint.h>
+#include <stddef.h>
+#include "hw_types.h"
+#include "soc_AM335x.h"
+#include "dmtimer.h"
+#include "hw_mcspi.h"
+#include "orbis.h"
+#include "orbis_crc.h"
+#include "orbis_calib.h"
+#include "util.h"
+
+// SPI clocks to try, fastest first: 48 MHz divided by 4, 6, 8, 10, 12, 16, 24 and 48
+const uint32_t orbisCalibClocks[ORBIS_CALIB_CLOCKS] = {
+    12000000u, 8000000u, 6000000u, 4800000u, 4000000u, 3000000u, 2000000u, 1000000u
+};
+
+// CS setup delays to try, shortest first: 0.5, 1, 1.5, 2, 3 and 5 us
+const uint32_t orbisCalibDelays[ORBIS_CALIB_DELAYS] = {
+    TIMER_1US / 2, TIMER_1US, 3 * TIMER_1US / 2, 2 * TIMER_1US, 3 * TIMER_1US, 5 * TIMER_1US
+};
+
+// The calibrated profile of every encoder, by McSPI module and chip select. Kept out of .bss,
+// so that it survives a warm reset.
+#ifdef __TI_COMPILER_VERSION__
+#pragma DATA_SECTION(orbisProfileStore, ".orbis_noinit")
+#endif
+OrbisProfileRecord orbisProfileStore[ORBIS_BUS_COUNT][ORBIS_BUS_CHANNELS];
+
+static OrbisProfileRecord* OrbisProfileRecordGet(OrbisEncoder* encoder)
+{
+    uint32_t bus = (encoder->bus == &orbisBus[1]) ? 1 : 0;
+
+    return &orbisProfileStore[bus][encoder->channel];
+}
+
+static uint32_t OrbisProfileRecordCRC(OrbisProfileRecord* record)
+{
+    return OrbisCRC((const uint8_t*) record, offsetof(OrbisProfileRecord, crc));
+}
+
+//
+// Find the fastest reliable profile of the encoder, apply it and record it in result.
+// Each step of the sweep takes captures blocking captures, so the encoder must be
+// otherwise idle. Leaves the profile as it was if no step is free of failures.
+//
+// Returns ORBIS_CRC_OK if a profile has been chosen, ORBIS_CRC_FAIL otherwise.
+//
+uint8_t OrbisCalibrate(OrbisEncoder* encoder, uint32_t captures, OrbisCalibration* result)
+{
+    OrbisProfile previous = { encoder->clockHz, encoder->csDelay };
+    uint32_t shortest[ORBIS_CALIB_CLOCKS];
+    uint32_t fastest = ORBIS_CALIB_CLOCKS;
+    uint32_t clock;
+
+    result->captures = captures;
+
+    for (uint32_t c = 0; c < ORBIS_CALIB_CLOCKS; c++) {
+        shortest[c] = ORBIS_CALIB_DELAYS;
+
+        for (uint32_t d = 0; d < ORBIS_CALIB_DELAYS; d++) {
+            uint32_t failures = 0;
+
+            OrbisEncoderProfileSet(encoder, orbisCalibClocks[c], orbisCalibDelays[d]);
+
+            // OrbisEncoderValidateCRC() checks every response on the way
+            for (uint32_t i = 0; i < captures; i++) {
+                if (OrbisEncoderCaptureGet(encoder) != ORBIS_CRC_OK)
+                    failures++;
+            }
+
+            result->failures[c][d] = (uint16_t) ((failures > 0xFFFFu) ? 0xFFFFu : failures);
+
+            if (failures == 0 && shortest[c] == ORBIS_CALIB_DELAYS)
+                shortest[c] = d;
+        }
+
+        if (shortest[c] < ORBIS_CALIB_DELAYS && fastest == ORBIS_CALIB_CLOCKS)
+            fastest = c;
+    }
+
+    // The sweep has left the sticky flag set, whatever the outcome
+    encoder->crcErrorFlag = ORBIS_CRC_OK;
+
+    if (fastest == ORBIS_CALIB_CLOCKS) {
+        OrbisEncoderProfileSet(encoder, previous.clockHz, previous.csDelay);
+        result->profile = previous;
+        return ORBIS_CRC_FAIL;
+    }
+
+    // A step of margin on both, as long as the slower clock has worked too
+    clock = fastest + 1;
+    if (clock == ORBIS_CALIB_CLOCKS || shortest[clock] == ORBIS_CALIB_DELAYS)
+        clock = fastest;
+
+    result->clock = (uint8_t) clock;
+    result->delay = (uint8_t) ((shortest[clock] + 1 < ORBIS_CALIB_DELAYS) ? shortest[clock] + 1 : shortest[clock]);
+    result->profile.clockHz = orbisCalibClocks[result->clock];
+    result->profile.csDelay = orbisCalibDelays[result->delay];
+
+    OrbisEncoderProfileSet(encoder, result->profile.clockHz, result->profile.csDelay);
+
+    return ORBIS_CRC_OK;
+}
+
+// Keep the current profile of the encoder over a reset
+void OrbisProfileSave(OrbisEncoder* encoder)
+{
+    OrbisProfileRecord* record = OrbisProfileRecordGet(encoder);
+
+    record->magic = ORBIS_PROFILE_MAGIC;
+    record->clockHz = encoder->clockHz;
+    record->csDelay = encoder->csDelay;
+    record->crc = OrbisProfileRecordCRC(record);
+}
+
+//
+// Apply the profile kept for the encoder by OrbisProfileSave().
+//
+// Returns ORBIS_CRC_OK if there was a valid profile, ORBIS_CRC_FAIL otherwise.
+//
+uint8_t OrbisProfileRestore(OrbisEncoder* encoder)
+{
+    OrbisProfileRecord* record = OrbisProfileRecordGet(encoder);
+
+    if (record->magic != ORBIS_PROFILE_MAGIC || record->crc != OrbisProfileRecordCRC(record) ||
+        record->clockHz == 0 || record->clockHz > MCSPI_IN_CLK)
+        return ORBIS_CRC_FAIL;
+
+    OrbisEncoderProfileSet(encoder, record->clockHz, record->csDelay);
+
+    return ORBIS_CRC_OK;
+}
+
+void OrbisWatchdogInit(OrbisWatchdog* watchdog, OrbisEncoder* encoder)
+{
+    watchdog->encoder = encoder;
+    watchdog->captures = 0;
+    watchdog->failures = 0;
+    watchdog->fallbacks = 0;
+}
+
+//
+// Account for the result of a capture, as returned by OrbisEncoderCaptureGet(). Once too
+// many captures have failed in the window, the encoder drops to the next slower clock of
+// orbisCalibClocks[] and the next longer delay of orbisCalibDelays[]. Call it between
+// captures: the profile must not change under a capture in progress.
+//
+// Returns 1 if the profile has been slowed down, 0 otherwise.
+//
+uint8_t OrbisWatchdogUpdate(OrbisWatchdog* watchdog, uint8_t result)
+{
+    OrbisEncoder* encoder = watchdog->encoder;
+    uint32_t clockHz = encoder->clockHz;
+    uint32_t csDelay = encoder->csDelay;
+
+    watchdog->captures++;
+    if (result != ORBIS_CRC_OK)
+        watchdog->failures++;
+
+    if (watchdog->failures <= ORBIS_WATCHDOG_FAILURES) {
+        if (watchdog->captures >= ORBIS_WATCHDOG_WINDOW) {
+            watchdog->captures = 0;
+            watchdog->failures = 0;
+        }
+        return 0;
+    }
+
+    watchdog->captures = 0;
+    watchdog->failures = 0;
+
+    // The first slower clock and longer delay than the current ones. There is nowhere
+    // to go from the slowest clock with the longest delay.
+    for (uint32_t c = 0; c < ORBIS_CALIB_CLOCKS; c++) {
+        if (orbisCalibClocks[c] < encoder->clockHz) {
+            clockHz = orbisCalibClocks[c];
+            break;
+        }
+    }
+    for (uint32_t d = 0; d < ORBIS_CALIB_DELAYS; d++) {
+        if (orbisCalibDelays[d] > encoder->csDelay) {
+            csDelay = orbisCalibDelays[d];
+            break;
+        }
+    }
+
+    if (clockHz == encoder->clockHz && csDelay == encoder->csDelay)
+        return 0;
+
+    OrbisEncoderProfileSet(encoder, clockHz, csDelay);
+    watchdog->fallbacks++;
+
+    return 1;
+}
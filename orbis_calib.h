@@ -0,0 +1,79 @@
+/*
+ * orbis_calib.h
+ * SPI clock and CS setup delay calibration for the Orbis rotary encoder driver
+ *
+ * The functions and global data structures are documented
+ * in the source code file to avoid saying the same thing twice.
+ * Use the source code file as a primary reference.
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#ifndef ORBIS_CALIB_H_
+#define ORBIS_CALIB_H_
+
+#include <stdint.h>
+#include "orbis.h"
+
+// The steps of the sweep, fastest first. The clocks are 48 MHz divided by a whole number.
+#define ORBIS_CALIB_CLOCKS                   8u
+#define ORBIS_CALIB_DELAYS                   6u
+
+// Captures at each step of the sweep
+#ifndef ORBIS_CALIB_CAPTURES
+#define ORBIS_CALIB_CAPTURES               200u
+#endif
+
+// The watchdog falls back to the next slower profile when more than ORBIS_WATCHDOG_FAILURES
+// out of ORBIS_WATCHDOG_WINDOW captures fail
+#ifndef ORBIS_WATCHDOG_WINDOW
+#define ORBIS_WATCHDOG_WINDOW             1000u
+#endif
+#ifndef ORBIS_WATCHDOG_FAILURES
+#define ORBIS_WATCHDOG_FAILURES             10u
+#endif
+
+// Marks a valid record in orbisProfileStore
+#define ORBIS_PROFILE_MAGIC         0x4F524250u
+
+typedef struct {
+    uint32_t clockHz;                      // SPI clock
+    uint32_t csDelay;                      // DMTimer4 ticks from CS assertion to the first clock edge
+} OrbisProfile;
+
+// Outcome of OrbisCalibrate(): the failures at every step and the profile chosen
+typedef struct {
+    uint16_t failures[ORBIS_CALIB_CLOCKS][ORBIS_CALIB_DELAYS];
+    uint32_t captures;                     // Captures at each step
+    uint8_t clock;                         // Index of the chosen clock into orbisCalibClocks[]
+    uint8_t delay;                         // Index of the chosen delay into orbisCalibDelays[]
+    OrbisProfile profile;
+} OrbisCalibration;
+
+// A profile as kept over a reset
+typedef struct {
+    uint32_t magic;
+    uint32_t clockHz;
+    uint32_t csDelay;
+    uint32_t crc;                          // OrbisCRC() of the fields above
+} OrbisProfileRecord;
+
+// Live CRC error rate watch of an encoder, see OrbisWatchdogUpdate()
+typedef struct {
+    OrbisEncoder* encoder;
+    uint32_t captures;                     // Captures in the current window
+    uint32_t failures;                     // Failures in the current window
+    uint32_t fallbacks;                    // Times the profile has been slowed down
+} OrbisWatchdog;
+
+extern const uint32_t orbisCalibClocks[ORBIS_CALIB_CLOCKS];
+extern const uint32_t orbisCalibDelays[ORBIS_CALIB_DELAYS];
+extern OrbisProfileRecord orbisProfileStore[ORBIS_BUS_COUNT][ORBIS_BUS_CHANNELS];
+
+uint8_t OrbisCalibrate(OrbisEncoder* encoder, uint32_t captures, OrbisCalibration* result);
+void OrbisProfileSave(OrbisEncoder* encoder);
+uint8_t OrbisProfileRestore(OrbisEncoder* encoder);
+void OrbisWatchdogInit(OrbisWatchdog* watchdog, OrbisEncoder* encoder);
+uint8_t OrbisWatchdogUpdate(OrbisWatchdog* watchdog, uint8_t result);
+
+#endif /* ORBIS_CALIB_H_ */
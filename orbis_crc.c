@@ -0,0 +1,315 @@
+/*
+ * orbis_crc.c
+ * CRC engine for Orbis responses (0x97 polynome)
+ *
+ * The Orbis CRC is an 8-bit, most significant bit first CRC with 0x97 polynome, zero
+ * initial value and no final XOR. The response carries it inverted in its last byte.
+ *
+ * The strategy is chosen at compile time with ORBIS_CRC_STRATEGY:
+ *
+ *   ORBIS_CRC_TABLE   - byte at a time through the datasheet table (256 bytes of tables);
+ *   ORBIS_CRC_SLICE4  - four bytes per step through four tables (1 KB of tables);
+ *   ORBIS_CRC_SLICE8  - eight bytes per step through eight tables (2 KB of tables);
+ *   ORBIS_CRC_NIBBLE  - four bits per step through a 16-entry table (16 bytes of tables).
+ *
+ * The slicing works because the CRC is linear: the CRC of a byte followed by k zero bytes
+ * is a fixed function of that byte, so each byte in a slice is looked up independently in
+ * its own table and the results are XORed together. Table k is table k-1 looked up in the
+ * datasheet table once more; the tables are derived from the datasheet table by OrbisCRCInit().
+ *
+ * The nibble table happens to be the first 16 entries of the datasheet table.
+ *
+ * Live frames are a few bytes long, so the strategy matters most for the offline
+ * validation of recorded frames with OrbisCRCValidateBatch(). The frames of the driver are
+ * checked with OrbisCRCFrame(), which goes through the same strategy.
+ *
+ *  Created on: 16 Oct 2026
+ */
+#include <stdint.h>
+#include "orbis_protocol.h"
+#include "orbis_crc.h"
+#include "orbis_memory.h"
+
+// The CRC of the capture interrupt path runs from OCMC RAM in the performance build profile,
+// with its table, see orbis_memory.c
+#if ORBIS_PERFORMANCE && defined(__TI_COMPILER_VERSION__)
+#pragma CODE_SECTION(OrbisCRC, ORBIS_SECTION_FAST_TEXT)
+#pragma CODE_SECTION(OrbisCRCFrame, ORBIS_SECTION_FAST_TEXT)
+#pragma DATA_SECTION(orbisTableCRC, ORBIS_SECTION_FAST_CONST)
+#pragma DATA_SECTION(orbisTableCRCNibble, ORBIS_SECTION_FAST_CONST)
+#endif
+
+#if ORBIS_CRC_USE_NEON
+#include <arm_neon.h>
+#endif
+
+#if ORBIS_CRC_STRATEGY != ORBIS_CRC_NIBBLE
+//
+// Orbis CRC calculation table representing 0x97 polynome. Adapted from the Appendix 1 of the Orbis datasheet.
+//
+static const uint8_t orbisTableCRC[256] = {
+    0x00, 0x97, 0xB9, 0x2E, 0xE5, 0x72, 0x5C, 0xCB, 0x5D, 0xCA, 0xE4, 0x73, 0xB8, 0x2F, 0x01, 0x96,
+    0xBA, 0x2D, 0x03, 0x94, 0x5F, 0xC8, 0xE6, 0x71, 0xE7, 0x70, 0x5E, 0xC9, 0x02, 0x95, 0xBB, 0x2C,
+    0xE3, 0x74, 0x5A, 0xCD, 0x06, 0x91, 0xBF, 0x28, 0xBE, 0x29, 0x07, 0x90, 0x5B, 0xCC, 0xE2, 0x75,
+    0x59, 0xCE, 0xE0, 0x77, 0xBC, 0x2B, 0x05, 0x92, 0x04, 0x93, 0xBD, 0x2A, 0xE1, 0x76, 0x58, 0xCF,
+    0x51, 0xC6, 0xE8, 0x7F, 0xB4, 0x23, 0x0D, 0x9A, 0x0C, 0x9B, 0xB5, 0x22, 0xE9, 0x7E, 0x50, 0xC7,
+    0xEB, 0x7C, 0x52, 0xC5, 0x0E, 0x99, 0xB7, 0x20, 0xB6, 0x21, 0x0F, 0x98, 0x53, 0xC4, 0xEA, 0x7D,
+    0xB2, 0x25, 0x0B, 0x9C, 0x57, 0xC0, 0xEE, 0x79, 0xEF, 0x78, 0x56, 0xC1, 0x0A, 0x9D, 0xB3, 0x24,
+    0x08, 0x9F, 0xB1, 0x26, 0xED, 0x7A, 0x54, 0xC3, 0x55, 0xC2, 0xEC, 0x7B, 0xB0, 0x27, 0x09, 0x9E,
+    0xA2, 0x35, 0x1B, 0x8C, 0x47, 0xD0, 0xFE, 0x69, 0xFF, 0x68, 0x46, 0xD1, 0x1A, 0x8D, 0xA3, 0x34,
+    0x18, 0x8F, 0xA1, 0x36, 0xFD, 0x6A, 0x44, 0xD3, 0x45, 0xD2, 0xFC, 0x6B, 0xA0, 0x37, 0x19, 0x8E,
+    0x41, 0xD6, 0xF8, 0x6F, 0xA4, 0x33, 0x1D, 0x8A, 0x1C, 0x8B, 0xA5, 0x32, 0xF9, 0x6E, 0x40, 0xD7,
+    0xFB, 0x6C, 0x42, 0xD5, 0x1E, 0x89, 0xA7, 0x30, 0xA6, 0x31, 0x1F, 0x88, 0x43, 0xD4, 0xFA, 0x6D,
+    0xF3, 0x64, 0x4A, 0xDD, 0x16, 0x81, 0xAF, 0x38, 0xAE, 0x39, 0x17, 0x80, 0x4B, 0xDC, 0xF2, 0x65,
+    0x49, 0xDE, 0xF0, 0x67, 0xAC, 0x3B, 0x15, 0x82, 0x14, 0x83, 0xAD, 0x3A, 0xF1, 0x66, 0x48, 0xDF,
+    0x10, 0x87, 0xA9, 0x3E, 0xF5, 0x62, 0x4C, 0xDB, 0x4D, 0xDA, 0xF4, 0x63, 0xA8, 0x3F, 0x11, 0x86,
+    0xAA, 0x3D, 0x13, 0x84, 0x4F, 0xD8, 0xF6, 0x61, 0xF7, 0x60, 0x4E, 0xD9, 0x12, 0x85, 0xAB, 0x3C
+};
+#endif
+
+#if ORBIS_CRC_STRATEGY == ORBIS_CRC_NIBBLE || ORBIS_CRC_USE_NEON
+// CRC of a single nibble, which is the first 16 entries of the datasheet table
+static const uint8_t orbisTableCRCNibble[16] = {
+    0x00, 0x97, 0xB9, 0x2E, 0xE5, 0x72, 0x5C, 0xCB, 0x5D, 0xCA, 0xE4, 0x73, 0xB8, 0x2F, 0x01, 0x96
+};
+#endif
+
+#if ORBIS_CRC_STRATEGY == ORBIS_CRC_SLICE4
+#define ORBIS_CRC_SLICES    4
+#elif ORBIS_CRC_STRATEGY == ORBIS_CRC_SLICE8
+#define ORBIS_CRC_SLICES    8
+#endif
+
+#ifdef ORBIS_CRC_SLICES
+// orbisTableCRCSlice[k][x] is the CRC of byte x followed by k zero bytes. Filled in by OrbisCRCInit().
+static uint8_t orbisTableCRCSlice[ORBIS_CRC_SLICES][256];
+#endif
+
+// Prepare the tables of the selected strategy. Call once before any CRC is calculated.
+void OrbisCRCInit(void)
+{
+#ifdef ORBIS_CRC_SLICES
+    for (uint32_t x = 0; x < 256; x++) {
+        orbisTableCRCSlice[0][x] = orbisTableCRC[x];
+        for (uint32_t k = 1; k < ORBIS_CRC_SLICES; k++)
+            orbisTableCRCSlice[k][x] = orbisTableCRC[orbisTableCRCSlice[k - 1][x]];
+    }
+#endif
+}
+
+//
+// Calculate CRC of numOfBytes bytes from the buffer with the strategy selected at compile time.
+// The buffer is not volatile, so the compiler is free to optimise the loop.
+//
+uint8_t OrbisCRC(const uint8_t* buffer, uint32_t numOfBytes)
+{
+    uint8_t crc = 0;
+
+#if ORBIS_CRC_STRATEGY == ORBIS_CRC_SLICE8
+    while (numOfBytes >= 8) {
+        crc = orbisTableCRCSlice[7][crc ^ buffer[0]] ^ orbisTableCRCSlice[6][buffer[1]] ^
+              orbisTableCRCSlice[5][buffer[2]]       ^ orbisTableCRCSlice[4][buffer[3]] ^
+              orbisTableCRCSlice[3][buffer[4]]       ^ orbisTableCRCSlice[2][buffer[5]] ^
+              orbisTableCRCSlice[1][buffer[6]]       ^ orbisTableCRCSlice[0][buffer[7]];
+        buffer += 8;
+        numOfBytes -= 8;
+    }
+#endif
+
+#if ORBIS_CRC_STRATEGY == ORBIS_CRC_SLICE4 || ORBIS_CRC_STRATEGY == ORBIS_CRC_SLICE8
+    while (numOfBytes >= 4) {
+        crc = orbisTableCRCSlice[3][crc ^ buffer[0]] ^ orbisTableCRCSlice[2][buffer[1]] ^
+              orbisTableCRCSlice[1][buffer[2]]       ^ orbisTableCRCSlice[0][buffer[3]];
+        buffer += 4;
+        numOfBytes -= 4;
+    }
+#endif
+
+#if ORBIS_CRC_STRATEGY == ORBIS_CRC_NIBBLE
+    while (numOfBytes--) {
+        crc ^= *buffer++;
+        crc = (uint8_t) (crc << 4) ^ orbisTableCRCNibble[crc >> 4];
+        crc = (uint8_t) (crc << 4) ^ orbisTableCRCNibble[crc >> 4];
+    }
+#else
+    while (numOfBytes--)
+        crc = orbisTableCRC[crc ^ *buffer++];
+#endif
+
+    return crc;
+}
+
+//
+// Calculate CRC of numOfBytes bytes of a frame buffer which may still be written to, by an
+// interrupt handler or EDMA3, with the strategy selected at compile time. The bytes are read
+// once, in order, into a copy that OrbisCRC() is free to read as it likes. Frames longer
+// than ORBIS_SIZE_BUFFER bytes go through OrbisCRC_Buffer() instead.
+//
+uint8_t OrbisCRCFrame(const volatile uint8_t* buffer, uint32_t numOfBytes)
+{
+    uint8_t copy[ORBIS_SIZE_BUFFER];
+
+    if (numOfBytes > ORBIS_SIZE_BUFFER)
+        return OrbisCRC_Buffer((volatile uint8_t*) buffer, numOfBytes);
+
+    for (uint32_t i = 0; i < numOfBytes; i++)
+        copy[i] = buffer[i];
+
+    return OrbisCRC(copy, numOfBytes);
+}
+
+//
+// Calculate CRC from fixed length buffer with 0x97 polynome.
+// Adapted from the Appendix 1 of the Orbis data sheet.
+// Input: pointer to the buffer, and how many bytes from
+// the buffer to use to calculate CRC. The CRC is 8 bit and the length
+// of the preceding data depends on the request/response type.
+//
+// This is the reference version, which reads the buffer a byte at a time as it may
+// still be written by the interrupt handler. Use OrbisCRC() on buffers which are not.
+//
+uint8_t OrbisCRC_Buffer(volatile uint8_t* buffer, uint32_t numOfBytes)
+{
+#if ORBIS_CRC_STRATEGY == ORBIS_CRC_NIBBLE
+    uint8_t crc = 0;
+
+    while (numOfBytes--) {
+        crc ^= *buffer++;
+        crc = (uint8_t) (crc << 4) ^ orbisTableCRCNibble[crc >> 4];
+        crc = (uint8_t) (crc << 4) ^ orbisTableCRCNibble[crc >> 4];
+    }
+
+    return crc;
+#else
+    uint32_t t;
+    uint8_t icrc;
+
+    numOfBytes -= 1;
+    icrc = 1;
+    t = buffer[0];
+    while (numOfBytes--)
+    {
+        // TODO is the way ^ is done and assigned compatible with SEI CERT C Coding Standard section INT02-C?
+        t = buffer[icrc++] ^ orbisTableCRC[t];
+    }
+
+    return orbisTableCRC[t];
+#endif
+}
+
+#if ORBIS_CRC_USE_NEON
+//
+// Validate eight frames of the batch at once, one frame per NEON lane. Each step looks up
+// a nibble of every lane in the 16-entry table with a single VTBL.
+//
+static uint8_t orbisCRCValidate8(const uint8_t* frames, uint32_t stride, uint32_t frameLength,
+                                 uint8_t* results)
+{
+    const uint8x8x2_t table = { { vld1_u8(&orbisTableCRCNibble[0]), vld1_u8(&orbisTableCRCNibble[8]) } };
+    uint8_t lanes[8];
+    uint8x8_t crc = vdup_n_u8(0);
+    uint8_t failures = 0;
+
+    for (uint32_t i = 0; i < frameLength - 1; i++) {
+        for (uint32_t j = 0; j < 8; j++)
+            lanes[j] = frames[j * stride + i];
+
+        crc = veor_u8(crc, vld1_u8(lanes));
+        crc = veor_u8(vshl_n_u8(crc, 4), vtbl2_u8(table, vshr_n_u8(crc, 4)));
+        crc = veor_u8(vshl_n_u8(crc, 4), vtbl2_u8(table, vshr_n_u8(crc, 4)));
+    }
+
+    vst1_u8(lanes, crc);
+
+    for (uint32_t j = 0; j < 8; j++) {
+        uint8_t receivedCRC = (uint8_t) ~frames[j * stride + frameLength - 1];
+
+        results[j] = (lanes[j] == receivedCRC) ? ORBIS_CRC_OK : ORBIS_CRC_FAIL;
+        failures += results[j];
+    }
+
+    return failures;
+}
+#endif
+
+//
+// Validate frameCount frames of frameLength bytes each, including the CRC byte. Frames start
+// stride bytes apart, so they can be packed back to back or sit inside larger records.
+//
+// The verdict for each frame, ORBIS_CRC_OK or ORBIS_CRC_FAIL, goes into results, which may be
+// NULL if only the count is of interest. Returns the number of frames which have failed.
+//
+uint32_t OrbisCRCValidateBatch(const uint8_t* frames, uint32_t stride, uint32_t frameLength,
+                               uint32_t frameCount, uint8_t* results)
+{
+    uint32_t failures = 0;
+    uint32_t i = 0;
+
+#if ORBIS_CRC_USE_NEON
+    uint8_t verdicts[8];
+
+    for (; i + 8 <= frameCount; i += 8) {
+        failures += orbisCRCValidate8(&frames[i * stride], stride, frameLength, verdicts);
+        if (results != 0) {
+            for (uint32_t j = 0; j < 8; j++)
+                results[i + j] = verdicts[j];
+        }
+    }
+#endif
+
+    for (; i < frameCount; i++) {
+        const uint8_t* frame = &frames[i * stride];
+        uint8_t receivedCRC = (uint8_t) ~frame[frameLength - 1];
+        uint8_t verdict = (OrbisCRC(frame, frameLength - 1) == receivedCRC) ? ORBIS_CRC_OK : ORBIS_CRC_FAIL;
+
+        if (results != 0)
+            results[i] = verdict;
+        failures += verdict;
+    }
+
+    return failures;
+}
+
+//
+// Check the selected strategy against the definition of the CRC, a bit at a time,
+// for every single byte and for messages of every length up to 16 bytes. Also check
+// the datasheet table itself, when it is there.
+//
+// Returns ORBIS_CRC_OK if the strategy is equivalent to the datasheet, ORBIS_CRC_FAIL otherwise.
+//
+uint8_t OrbisCRCSelfTest(void)
+{
+    uint8_t message[16];
+    uint8_t expected = 0;
+
+    for (uint32_t x = 0; x < 256; x++) {
+        uint8_t crc = (uint8_t) x;
+
+        for (uint32_t b = 0; b < 8; b++)
+            crc = (crc & 0x80u) ? (uint8_t) ((crc << 1) ^ 0x97u) : (uint8_t) (crc << 1);
+
+#if ORBIS_CRC_STRATEGY != ORBIS_CRC_NIBBLE
+        if (orbisTableCRC[x] != crc)
+            return ORBIS_CRC_FAIL;
+#endif
+        message[0] = (uint8_t) x;
+        if (OrbisCRC(message, 1) != crc)
+            return ORBIS_CRC_FAIL;
+    }
+
+    for (uint32_t n = 0; n < sizeof(message); n++) {
+        // Arbitrary but reproducible contents
+        message[n] = (uint8_t) (0x5Au + 37u * n);
+
+        // Extend the bit-at-a-time CRC by one byte
+        expected ^= message[n];
+        for (uint32_t b = 0; b < 8; b++)
+            expected = (expected & 0x80u) ? (uint8_t) ((expected << 1) ^ 0x97u) : (uint8_t) (expected << 1);
+
+        if (OrbisCRC(message, n + 1) != expected || OrbisCRC_Buffer(message, n + 1) != expected ||
+            OrbisCRCFrame(message, n + 1) != expected)
+            return ORBIS_CRC_FAIL;
+    }
+
+    return ORBIS_CRC_OK;
+}
@@ -0,0 +1,42 @@
+/*
+ * orbis_crc.h
+ * CRC engine for Orbis responses (0x97 polynome)
+ *
+ * The functions and global data structures are documented
+ * in the source code file to avoid saying the same thing twice.
+ * Use the source code file as a primary reference.
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#ifndef ORBIS_CRC_H_
+#define ORBIS_CRC_H_
+
+#include <stdint.h>
+
+//
+// CRC calculation strategies, see orbis_crc.c
+//
+#define ORBIS_CRC_TABLE     0   // Byte at a time, 256-entry datasheet table
+#define ORBIS_CRC_SLICE4    1   // Four bytes at a time, 4 x 256-entry tables
+#define ORBIS_CRC_SLICE8    2   // Eight bytes at a time, 8 x 256-entry tables
+#define ORBIS_CRC_NIBBLE    3   // Four bits at a time, 16-entry table, for size-constrained images
+
+#ifndef ORBIS_CRC_STRATEGY
+#define ORBIS_CRC_STRATEGY  ORBIS_CRC_TABLE
+#endif
+
+// Validate eight frames at once with NEON in OrbisCRCValidateBatch(). Needs a NEON-enabled build.
+#ifndef ORBIS_CRC_USE_NEON
+#define ORBIS_CRC_USE_NEON  0
+#endif
+
+void OrbisCRCInit(void);
+uint8_t OrbisCRC(const uint8_t* buffer, uint32_t numOfBytes);
+uint8_t OrbisCRCFrame(const volatile uint8_t* buffer, uint32_t numOfBytes);
+uint8_t OrbisCRC_Buffer(volatile uint8_t* buffer, uint32_t numOfBytes);
+uint32_t OrbisCRCValidateBatch(const uint8_t* frames, uint32_t stride, uint32_t frameLength,
+                               uint32_t frameCount, uint8_t* results);
+uint8_t OrbisCRCSelfTest(void);
+
+#endif /* ORBIS_CRC_H_ */
@@ -0,0 +1,125 @@
+/*
+ * orbis_edma.c
+ * EDMA3-driven receive path for the Orbis rotary encoder driver
+ *
+ * In this mode McSPI0 channel 0 raises a DMA request instead of the RX_FULL
+ * interrupt when the Rx FIFO reaches the trigger level, and EDMA3 moves the
+ * whole response from the Rx register straight into the frame buffer. The CPU
+ * takes exactly one interrupt, the EDMA3 transfer completion, per frame.
+ *
+ * The DMA request moves the frame in one go (A-B synchronised transfer, ACNT = 1 byte,
+ * BCNT = frame length), and the PaRAM set is written again for every capture, which
+ * is what lets the frame buffer and the frame length change from one to the next.
+ *
+ * Caveat: the McSPI Rx register is 32 bit wide but it is read one byte at a time
+ * here, which returns the 8-bit SPI word without the need to mask it.
+ *
+ *  Created on: 16 Oct 2026
+ */
+#include <stdint.h>
+#include "hw_types.h"
+#include "soc_AM335x.h"
+#include "beaglebone.h"
+#include "hw_mcspi.h"
+#include "mcspi.h"
+#include "edma.h"
+#include "hw_edma3cc.h"
+#include "orbis.h"
+#include "orbis_edma.h"
+#include "orbis_load.h"
+
+// The encoder the frame is for, on McSPI0 channel 0
+static OrbisEncoder* orbisEDMAEncoder;
+
+// Enable EDMA3 and claim the McSPI0 channel 0 receive event for the driver.
+void OrbisEDMASetup(void)
+{
+    EDMAModuleClkConfig();
+
+    EDMA3Init(SOC_EDMA30CC_0_REGS, ORBIS_EDMA_EVENT_QUEUE);
+
+    EDMA3RequestChannel(SOC_EDMA30CC_0_REGS, EDMA3_CHANNEL_TYPE_DMA,
+                        ORBIS_EDMA_RX_EVENT, ORBIS_EDMA_RX_TCC, ORBIS_EDMA_EVENT_QUEUE);
+}
+
+//
+// Fill in the PaRAM set for receiving a frame of frameLength bytes from the McSPI Rx
+// register at srcAddr into the buffer at dstAddr.
+//
+// Does not touch the hardware, so the descriptor can be checked away from the target.
+//
+void OrbisEDMARxParamBuild(EDMA3CCPaRAMEntry* param, uint32_t srcAddr, uint32_t dstAddr,
+                           uint32_t frameLength)
+{
+    param->srcAddr    = srcAddr;
+    param->destAddr   = dstAddr;
+
+    // One byte per SPI word, the whole frame for the one DMA request of the capture
+    param->aCnt       = 1;
+    param->bCnt       = (uint16_t) frameLength;
+    param->cCnt       = 1;
+    param->bCntReload = 0;
+
+    // The source is a FIFO register and never moves, the destination advances by a byte
+    param->srcBIdx    = 0;
+    param->srcCIdx    = 0;
+    param->destBIdx   = 1;
+    param->destCIdx   = 0;
+
+    // No linking, the set is reprogrammed for every capture
+    param->linkAddr   = 0xFFFFu;
+
+    // A-B synchronised, static, completion interrupt on the transfer request
+    param->opt        = EDMA3CC_OPT_SYNCDIM | EDMA3CC_OPT_STATIC
+                      | ((ORBIS_EDMA_RX_TCC << EDMA3CC_OPT_TCC_SHIFT) & EDMA3CC_OPT_TCC)
+                      | (1u << EDMA3CC_OPT_TCINTEN_SHIFT);
+}
+
+//
+// Prepare EDMA3 and McSPI0 for the DMA receive of a frame into buffer, for the encoder
+// on McSPI0 channel 0. Must be called before the channel is enabled for the capture.
+//
+void OrbisEDMARxArm(OrbisEncoder* encoder, volatile uint8_t* buffer, uint32_t frameLength)
+{
+    EDMA3CCPaRAMEntry param;
+
+    orbisEDMAEncoder = encoder;
+
+    OrbisEDMARxParamBuild(&param, SOC_SPI_0_REGS + MCSPI_CHRX(ORBIS_SPI_CHANNEL),
+                          (uint32_t) (uintptr_t) buffer, frameLength);
+    EDMA3SetPaRAM(SOC_EDMA30CC_0_REGS, ORBIS_EDMA_RX_EVENT, &param);
+
+    // A completion left over from an abandoned capture must not complete this one
+    EDMA3ClrIntr(SOC_EDMA30CC_0_REGS, ORBIS_EDMA_RX_TCC);
+    EDMA3EnableTransfer(SOC_EDMA30CC_0_REGS, ORBIS_EDMA_RX_EVENT, EDMA3_TRIG_MODE_EVENT);
+
+    // DMA request enable should be set before enabling the channel
+    McSPIDMAEnable(SOC_SPI_0_REGS, MCSPI_DMA_RX_EVENT, ORBIS_SPI_CHANNEL);
+}
+
+// EDMA3 transfer completion interrupt handler
+void orbisEDMACompletionIsr(void)
+{
+    OrbisEncoder* encoder = orbisEDMAEncoder;
+
+    ORBIS_LOAD_ISR_ENTER();
+
+    if (EDMA3GetIntrStatus(SOC_EDMA30CC_0_REGS) & (1u << ORBIS_EDMA_RX_TCC)) {
+
+        EDMA3ClrIntr(SOC_EDMA30CC_0_REGS, ORBIS_EDMA_RX_TCC);
+
+        // The capture may have timed out in the meantime, see OrbisBusPoll(), and the bus
+        // may have gone on to the next one, which this frame is not the response of
+        if (encoder == orbisBus[0].active && encoder->captureState == ORBIS_CAPTURE_BUSY) {
+            ORBIS_LATENCY_STAMP(encoder, ORBIS_STAGE_RX);
+
+            // The frame is in, stop McSPI from requesting any more transfers
+            McSPIDMADisable(SOC_SPI_0_REGS, MCSPI_DMA_RX_EVENT, ORBIS_SPI_CHANNEL);
+            EDMA3DisableTransfer(SOC_EDMA30CC_0_REGS, ORBIS_EDMA_RX_EVENT, EDMA3_TRIG_MODE_EVENT);
+
+            OrbisCaptureComplete(encoder);
+        }
+    }
+
+    ORBIS_LOAD_ISR_EXIT();
+}
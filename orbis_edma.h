@@ -0,0 +1,31 @@
+/*
+ * orbis_edma.h
+ * EDMA3-driven receive path for the Orbis rotary encoder driver
+ *
+ * The functions and global data structures are documented
+ * in the source code file to avoid saying the same thing twice.
+ * Use the source code file as a primary reference.
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#ifndef ORBIS_EDMA_H_
+#define ORBIS_EDMA_H_
+
+#include <stdint.h>
+#include "edma.h"
+#include "orbis.h"
+
+// EDMA3 event number of McSPI0 channel 0 receive request (AM335x TRM, EDMA3 event map).
+// The channel number and the transfer completion code are the same as the event number.
+#define ORBIS_EDMA_RX_EVENT                17u
+#define ORBIS_EDMA_RX_TCC                  ORBIS_EDMA_RX_EVENT
+#define ORBIS_EDMA_EVENT_QUEUE              0u
+
+void OrbisEDMASetup(void);
+void OrbisEDMARxArm(OrbisEncoder* encoder, volatile uint8_t* buffer, uint32_t frameLength);
+void OrbisEDMARxParamBuild(EDMA3CCPaRAMEntry* param, uint32_t srcAddr, uint32_t dstAddr,
+                           uint32_t frameLength);
+void orbisEDMACompletionIsr(void);
+
+#endif /* ORBIS_EDMA_H_ */
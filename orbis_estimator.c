@@ -0,0 +1,209 @@
+/*
+ * orbis_estimator.c
+ * Fixed-point velocity and acceleration estimator for the Orbis position samples
+ *
+ * The estimator takes in the position frames as they are captured, unwraps the position
+ * over the turns, and runs a fading-memory alpha-beta-gamma (g-h-k) filter on it, which
+ * follows a constant acceleration with no lag and gives the velocity and acceleration on
+ * every sample without asking Orbis for its speed.
+ *
+ * The samples need not be evenly spaced: every step is scaled by the time between the
+ * samples, from their DMTimer4 timestamps. All of it is integer arithmetic, as the build
+ * allows no floating point:
+ *
+ *   position      Q16 counts
+ *   velocity      Q32 counts per tick
+ *   acceleration  Q48 counts per tick squared
+ *   gains         Q32
+ *
+ * where a count is one step of the ORBIS_RESOLUTION bit position and a tick is 1/24 us. The results
+ * are also given in counts per second and per second squared.
+ *
+ * The gains follow from the fading-memory factor theta: g = 1 - theta^3,
+ * h = 1.5 (1 - theta)^2 (1 + theta), k = 0.5 (1 - theta)^3.
+ *
+ * Samples with the error bit set, long gaps, and samples too far off the prediction
+ * start the estimate over.
+ *
+ * OrbisEstimatorAt() evaluates the estimate at any DMTimer4 time near the last sample,
+ * before it or after it, so that a control loop on its own timer sees the position at
+ * its own instant rather than one up to a sample period old.
+ *
+ *  Created on: 16 Oct 2026
+ */
+#include <stdint.h>
+#include "interrupt.h"
+#include "orbis.h"
+#include "orbis_estimator.h"
+
+//
+// Set the estimator up with the fading-memory factor theta in Q16
+// (ORBIS_ESTIMATOR_THETA unless there is a reason otherwise).
+//
+void OrbisEstimatorInit(OrbisEstimator* estimator, uint32_t theta)
+{
+    int64_t d = 65536 - (int64_t) theta;
+    int64_t d2 = d * d;
+    int64_t d3 = d2 * d;
+    int64_t theta3 = (int64_t) theta * theta * theta;
+
+    estimator->g = ((1ll << 48) - theta3) >> 16;
+    estimator->h = (3 * d2 * (65536 + (int64_t) theta)) >> 17;
+    estimator->k = d3 >> 17;
+
+    OrbisEstimatorRestart(estimator);
+}
+
+// Forget the samples so far, the next one starts the estimate over
+void OrbisEstimatorRestart(OrbisEstimator* estimator)
+{
+    estimator->samples = 0;
+    estimator->counts = 0;
+    estimator->x = 0;
+    estimator->v = 0;
+    estimator->a = 0;
+    estimator->velocity = 0;
+    estimator->acceleration = 0;
+}
+
+static void OrbisEstimatorOutput(OrbisEstimator* estimator)
+{
+    // Q32 counts per tick to counts per second, and Q48 per tick squared to per second squared,
+    // a step at a time so as not to overflow
+    estimator->velocity = (int32_t) ((estimator->v * TIMER_MASTER_FREQ) >> 32);
+    estimator->acceleration = (int32_t) ((((estimator->a * TIMER_MASTER_FREQ) >> 24) * TIMER_MASTER_FREQ) >> 24);
+}
+
+//
+// Take in the position frame captured at timestamp (DMTimer4 time of the CS assertion).
+// The frame is as received, in the layout of the encoder variant, see OrbisPositionDecode().
+// The CRC must have been checked already.
+//
+// Returns ORBIS_ESTIMATOR_VALID if velocity and acceleration hold estimates,
+// ORBIS_ESTIMATOR_SETTLING while there are too few samples since the start.
+//
+uint8_t OrbisEstimatorUpdate(OrbisEstimator* estimator, uint32_t timestamp, const volatile uint8_t* frame)
+{
+    OrbisPosition position;
+    uint32_t raw;
+    const uint32_t bits = ORBIS_RESOLUTION + ORBIS_TURN_BITS;
+    int64_t dt, delta, predicted, velocity, residual;
+
+    OrbisPositionDecode(frame, &position);
+
+    // The position is not valid when Orbis reports an error
+    if (position.error) {
+        OrbisEstimatorRestart(estimator);
+        return ORBIS_ESTIMATOR_SETTLING;
+    }
+
+    // The turn count is 0 for single-turn Orbis, which leaves just the position
+    raw = ((uint32_t) position.turns << ORBIS_RESOLUTION) | position.position;
+
+    dt = (int64_t) (uint32_t) (timestamp - estimator->lastTime);
+    if (estimator->samples > 0 && (dt == 0 || dt > ORBIS_ESTIMATOR_MAX_GAP))
+        OrbisEstimatorRestart(estimator);
+
+    // Unwrap: the shortest way round from the last sample, sign-extended from the field width
+    if (estimator->samples > 0) {
+        delta = (int64_t) ((raw - estimator->lastRaw) << (32 - bits));
+        delta = (int32_t) delta >> (32 - bits);
+        estimator->counts += delta;
+    } else {
+        estimator->counts = raw;
+    }
+
+    estimator->lastRaw = raw;
+    estimator->lastTime = timestamp;
+
+    switch (estimator->samples) {
+    case 0:
+        estimator->x = estimator->counts * 65536;
+        estimator->samples = 1;
+        return ORBIS_ESTIMATOR_SETTLING;
+
+    case 1:
+        // Velocity from the first two samples, the filter takes it from there
+        estimator->v = (estimator->counts * 65536 - estimator->x) * 65536 / dt;
+        estimator->x = estimator->counts * 65536;
+        estimator->samples = 2;
+        OrbisEstimatorOutput(estimator);
+        return ORBIS_ESTIMATOR_VALID;
+
+    default:
+        break;
+    }
+
+    // Predict to the time of the sample
+    velocity = estimator->v + ((estimator->a * dt) >> 16);
+    predicted = estimator->x + ((estimator->v * dt) >> 16) + ((((estimator->a * dt) >> 16) * dt) >> 17);
+    residual = estimator->counts * 65536 - predicted;
+
+    if (residual > ((int64_t) ORBIS_ESTIMATOR_MAX_RESIDUAL << 16) ||
+        residual < -((int64_t) ORBIS_ESTIMATOR_MAX_RESIDUAL << 16)) {
+        OrbisEstimatorRestart(estimator);
+        estimator->counts = raw;
+        estimator->x = estimator->counts * 65536;
+        estimator->samples = 1;
+        return ORBIS_ESTIMATOR_SETTLING;
+    }
+
+    // Correct by the residual
+    estimator->x = predicted + ((estimator->g * residual) >> 32);
+    estimator->v = velocity + ((estimator->h * residual) >> 16) / dt;
+    estimator->a = estimator->a + ((2 * estimator->k * residual) / dt) / dt;
+
+    if (estimator->samples < 3)
+        estimator->samples++;
+
+    OrbisEstimatorOutput(estimator);
+    return ORBIS_ESTIMATOR_VALID;
+}
+
+//
+// Position and velocity at timestamp (DMTimer4 time), from the estimate at the last sample
+// carried along the constant acceleration: interpolated back if the query is older than the
+// last sample, extrapolated forward if it is newer. The query may be no further than maxAge
+// ticks either way from the last sample, and no further than ORBIS_ESTIMATOR_MAX_GAP.
+//
+// Returns ORBIS_ESTIMATOR_VALID with the estimate filled in, ORBIS_ESTIMATOR_SETTLING while
+// there are too few samples, or ORBIS_ESTIMATOR_STALE if the last sample is too far off the
+// query, with only the age filled in.
+//
+// Takes a consistent copy of the estimate with the interrupts off for a few loads, so it can
+// be called from the main loop or from another interrupt handler.
+//
+uint8_t OrbisEstimatorAt(const volatile OrbisEstimator* estimator, uint32_t timestamp, uint32_t maxAge,
+                         OrbisEstimate* estimate)
+{
+    unsigned char irq;
+    uint8_t samples;
+    uint32_t lastTime;
+    int64_t x, v, a, dt, velocity;
+
+    irq = IntDisable();
+    samples = estimator->samples;
+    lastTime = estimator->lastTime;
+    x = estimator->x;
+    v = estimator->v;
+    a = estimator->a;
+    IntEnable(irq);
+
+    if (samples < 2)
+        return ORBIS_ESTIMATOR_SETTLING;
+
+    // Signed, the query may be either side of the last sample
+    dt = (int32_t) (timestamp - lastTime);
+    estimate->age = (uint32_t) (dt < 0 ? -dt : dt);
+
+    if (estimate->age > maxAge || estimate->age > ORBIS_ESTIMATOR_MAX_GAP)
+        return ORBIS_ESTIMATOR_STALE;
+
+    // Same steps as the prediction in OrbisEstimatorUpdate()
+    velocity = v + ((a * dt) >> 16);
+    estimate->counts = x + ((v * dt) >> 16) + ((((a * dt) >> 16) * dt) >> 17);
+    estimate->position = (uint32_t) estimate->counts & (((uint32_t) ORBIS_ESTIMATOR_COUNTS << 16) - 1u);
+    estimate->velocity = (int32_t) ((velocity * TIMER_MASTER_FREQ) >> 32);
+
+    return ORBIS_ESTIMATOR_VALID;
+}
@@ -0,0 +1,69 @@
+/*
+ * orbis_estimator.h
+ * Fixed-point velocity and acceleration estimator for the Orbis position samples
+ *
+ * The functions and global data structures are documented
+ * in the source code file to avoid saying the same thing twice.
+ * Use the source code file as a primary reference.
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#ifndef ORBIS_ESTIMATOR_H_
+#define ORBIS_ESTIMATOR_H_
+
+#include <stdint.h>
+#include "util.h"
+#include "orbis.h"
+
+// Fading-memory factor of the filter, Q16. Closer to 1 is smoother and slower to follow.
+#ifndef ORBIS_ESTIMATOR_THETA
+#define ORBIS_ESTIMATOR_THETA           62259u      // 0.95
+#endif
+
+// Position counts per turn of the encoder variant
+#define ORBIS_ESTIMATOR_COUNTS          (1 << ORBIS_RESOLUTION)
+
+// Longer gaps between samples than this, in DMTimer4 ticks, start the estimate over
+#define ORBIS_ESTIMATOR_MAX_GAP         (10 * TIMER_1MS)
+
+// A sample further than this many counts from the prediction starts the estimate over
+#define ORBIS_ESTIMATOR_MAX_RESIDUAL    1024
+
+// Result of OrbisEstimatorUpdate() and OrbisEstimatorAt()
+#define ORBIS_ESTIMATOR_VALID           0u
+#define ORBIS_ESTIMATOR_SETTLING        1u
+#define ORBIS_ESTIMATOR_STALE           2u
+
+typedef struct OrbisEstimator {
+    uint8_t samples;                       // Samples taken in since the start, up to 3
+
+    int64_t g, h, k;                       // Filter gains, Q32
+
+    uint32_t lastRaw;                      // Turns and position of the last sample, as reported
+    uint32_t lastTime;                     // DMTimer4 time of the last sample
+    int64_t counts;                        // Unwrapped position of the last sample
+
+    int64_t x;                             // Position estimate, Q16 counts
+    int64_t v;                             // Velocity estimate, Q32 counts per tick
+    int64_t a;                             // Acceleration estimate, Q48 counts per tick squared
+
+    int32_t velocity;                      // Counts per second
+    int32_t acceleration;                  // Counts per second squared
+} OrbisEstimator;
+
+// Position and velocity at the query time, from OrbisEstimatorAt()
+typedef struct {
+    int64_t counts;                        // Position, Q16 counts, unwrapped over the turns
+    uint32_t position;                     // Single-turn position, Q16 counts
+    int32_t velocity;                      // Counts per second
+    uint32_t age;                          // DMTimer4 ticks between the last sample and the query
+} OrbisEstimate;
+
+void OrbisEstimatorInit(OrbisEstimator* estimator, uint32_t theta);
+void OrbisEstimatorRestart(OrbisEstimator* estimator);
+uint8_t OrbisEstimatorUpdate(OrbisEstimator* estimator, uint32_t timestamp, const volatile uint8_t* frame);
+uint8_t OrbisEstimatorAt(const volatile OrbisEstimator* estimator, uint32_t timestamp, uint32_t maxAge,
+                         OrbisEstimate* estimate);
+
+#endif /* ORBIS_ESTIMATOR_H_ */
@@ -0,0 +1,283 @@
+/*
+ * orbis_filter.c
+ * Oversampling filter for the Orbis position: decimating mean, median or trimmed mean,
+ * with outlier rejection
+ *
+ * The filter sits on top of captures made faster than the control loop needs them, e.g. the
+ * frames of OrbisEncoderBurst(), and makes one output of every decimation frames it accepts.
+ * Averaging n frames with noise on them, or frames of a moving shaft, resolves the position
+ * below a count: by about sqrt(n) for the mean, less for the median of whole counts. The price is
+ * latency: the output stands for the mean time of its frames, half the time the window
+ * takes behind its last frame, and the window has to fill before there is an output.
+ *
+ * The position is unwrapped over the turns, the same way as in orbis_estimator.c, before it is
+ * combined, so the window may straddle the wrap-around of the single-turn position, or of the
+ * turn count. The frames of a window are kept as Q16 counts from its first frame, and combined
+ * as the filter is set up:
+ *
+ *   ORBIS_FILTER_MEAN      the mean of the frames
+ *   ORBIS_FILTER_MEDIAN    the median, or the mean of the middle two
+ *   ORBIS_FILTER_TRIMMED   the mean of the frames left after trim from either end of the sorted window
+ *
+ * all of it in integer arithmetic, to Q16 counts as in the estimator. On a moving shaft the frames
+ * are taken less the trend, the velocity between the last two outputs, before they are combined,
+ * and the trend is added back at the output's timestamp. That changes nothing for the mean, but
+ * the median and the trimmed mean would otherwise sort the frames by their time and keep only the
+ * middle ones. The median and the trimmed mean sort the window, which takes longer, so their
+ * windows are best kept short.
+ *
+ * A frame that passes the CRC check can still be wrong. Every frame is checked against where the
+ * trajectory says the position should be: the last frame accepted, carried along the velocity
+ * between the last two outputs once there are two. A frame further
+ * off than maxJump counts is rejected and left out of the window. When more than
+ * ORBIS_FILTER_MAX_REJECTS frames are rejected in a row, it is the trajectory that is wrong,
+ * e.g. after a real step, and the filter starts over from the frame. Frames with the error
+ * bit set are not used, and a long gap between frames starts the filter over.
+ *
+ * The output rate is the capture rate over the decimation, and has nothing to do with the rate
+ * the output is read at: OrbisFilterGet() gives the latest output, whenever it is called, and its
+ * sequence number says whether it is a new one.
+ *
+ *  Created on: 16 Oct 2026
+ */
+#include <stdint.h>
+#include "interrupt.h"
+#include "orbis.h"
+#include "orbis_filter.h"
+
+//
+// Set the filter up to combine decimation frames to an output (at most ORBIS_FILTER_WINDOW)
+// by the method, ORBIS_FILTER_MEAN, ORBIS_FILTER_MEDIAN or ORBIS_FILTER_TRIMMED with trim frames
+// dropped from either end, and to reject frames further than maxJump counts off the trajectory
+// (ORBIS_FILTER_MAX_JUMP unless there is a reason otherwise).
+//
+void OrbisFilterInit(OrbisFilter* filter, uint8_t method, uint32_t decimation, uint32_t trim, uint32_t maxJump)
+{
+    if (decimation == 0)
+        decimation = 1;
+    if (decimation > ORBIS_FILTER_WINDOW)
+        decimation = ORBIS_FILTER_WINDOW;
+
+    filter->method = method;
+    filter->decimation = (uint16_t) decimation;
+    filter->trim = (uint8_t) ((2 * trim < decimation) ? trim : (decimation - 1) / 2);
+    filter->maxJump = maxJump;
+
+    filter->accepted = 0;
+    filter->rejected = 0;
+    filter->restarts = 0;
+    filter->errors = 0;
+
+    filter->output.sequence = 0;
+
+    OrbisFilterRestart(filter);
+}
+
+// Forget the frames and the trajectory so far, the next frame starts the filter over
+void OrbisFilterRestart(OrbisFilter* filter)
+{
+    filter->anchored = 0;
+    filter->outputs = 0;
+    filter->consecutive = 0;
+    filter->count = 0;
+    filter->windowRejected = 0;
+    filter->v = 0;
+}
+
+// Sort the frames of the window into sorted, smallest first
+static void OrbisFilterSort(const OrbisFilter* filter, int64_t sorted[])
+{
+    for (uint32_t i = 0; i < filter->count; i++) {
+        int64_t value = filter->window[i];
+        uint32_t j;
+
+        for (j = i; j > 0 && sorted[j - 1] > value; j--)
+            sorted[j] = sorted[j - 1];
+        sorted[j] = value;
+    }
+}
+
+// Combine the frames of the full window into the output, and carry the trajectory on to it
+static void OrbisFilterOutputUpdate(OrbisFilter* filter)
+{
+    int64_t sorted[ORBIS_FILTER_WINDOW];
+    uint32_t n = filter->count, first = 0, last = filter->count;
+    int64_t sum = 0, x;
+    uint32_t timestamp;
+    unsigned char irq;
+
+    if (ORBIS_FILTER_MEAN == filter->method) {
+        for (uint32_t i = 0; i < n; i++)
+            sum += filter->window[i];
+        x = sum / n;
+    } else {
+        OrbisFilterSort(filter, sorted);
+
+        if (ORBIS_FILTER_TRIMMED == filter->method) {
+            first = filter->trim;
+            last = n - filter->trim;
+        } else {
+            first = (n - 1) / 2;
+            last = n / 2 + 1;
+        }
+
+        for (uint32_t i = first; i < last; i++)
+            sum += sorted[i];
+        x = sum / (last - first);
+    }
+
+    // The trend back in, at the mean time of the frames
+    x += filter->base * 65536 + ((filter->trend * (filter->timeSum / n)) >> 16);
+    timestamp = filter->baseTime + filter->timeSum / n;
+
+    if (filter->outputs > 0 && timestamp != filter->xTime)
+        filter->v = (x - filter->x) * 65536 / (int64_t) (uint32_t) (timestamp - filter->xTime);
+    if (filter->outputs < 2)
+        filter->outputs++;
+
+    filter->x = x;
+    filter->xTime = timestamp;
+
+    // The output may be read from another context, see OrbisFilterGet()
+    irq = IntDisable();
+    filter->output.counts = x;
+    filter->output.position = (uint32_t) x & (((uint32_t) 1 << (ORBIS_RESOLUTION + 16)) - 1u);
+    filter->output.timestamp = timestamp;
+    filter->output.span = filter->lastTime - filter->baseTime;
+    filter->output.frames = (uint16_t) n;
+    filter->output.rejected = filter->windowRejected;
+    filter->output.sequence++;
+    IntEnable(irq);
+
+    filter->count = 0;
+    filter->windowRejected = 0;
+}
+
+//
+// Take in the position frame captured at timestamp (DMTimer4 time of the CS assertion).
+// The frame is as received, in the layout of the encoder variant, see OrbisPositionDecode().
+// The CRC must have been checked already.
+//
+// Returns ORBIS_FILTER_ACCEPTED if the frame has gone into the window, ORBIS_FILTER_OUTPUT
+// if it has completed an output as well, ORBIS_FILTER_REJECTED if it is too far off the
+// trajectory, ORBIS_FILTER_RESTARTED if the filter has started over from it, or
+// ORBIS_FILTER_ERROR if Orbis reports an error.
+//
+uint8_t OrbisFilterUpdate(OrbisFilter* filter, uint32_t timestamp, const volatile uint8_t* frame)
+{
+    OrbisPosition position;
+    uint32_t raw;
+    const uint32_t bits = ORBIS_RESOLUTION + ORBIS_TURN_BITS;
+    int64_t counts, predicted, residual;
+    uint8_t result = ORBIS_FILTER_ACCEPTED;
+
+    OrbisPositionDecode(frame, &position);
+
+    // The position is not valid when Orbis reports an error
+    if (position.error) {
+        filter->errors++;
+        return ORBIS_FILTER_ERROR;
+    }
+
+    // The turn count is 0 for single-turn Orbis, which leaves just the position
+    raw = ((uint32_t) position.turns << ORBIS_RESOLUTION) | position.position;
+
+    if (filter->anchored && (uint32_t) (timestamp - filter->lastTime) > ORBIS_FILTER_MAX_GAP)
+        OrbisFilterRestart(filter);
+
+    if (filter->anchored) {
+        // Unwrap: the shortest way round from the last frame accepted, sign-extended from the field width
+        int64_t delta = (int64_t) ((raw - filter->lastRaw) << (32 - bits));
+
+        counts = filter->counts + ((int32_t) delta >> (32 - bits));
+
+        // The velocity is 0 until there are two outputs
+        predicted = filter->counts * 65536 + ((filter->v * (timestamp - filter->lastTime)) >> 16);
+        residual = counts * 65536 - predicted;
+
+        if (residual > ((int64_t) filter->maxJump << 16) || residual < -((int64_t) filter->maxJump << 16)) {
+            filter->rejected++;
+            filter->windowRejected++;
+            if (++filter->consecutive <= ORBIS_FILTER_MAX_REJECTS)
+                return ORBIS_FILTER_REJECTED;
+
+            // It is the trajectory that is off, start over from this frame
+            filter->restarts++;
+            OrbisFilterRestart(filter);
+            result = ORBIS_FILTER_RESTARTED;
+        }
+    }
+
+    if (!filter->anchored) {
+        counts = raw;
+        filter->anchored = 1;
+    }
+
+    filter->consecutive = 0;
+    filter->lastRaw = raw;
+    filter->lastTime = timestamp;
+    filter->counts = counts;
+    filter->accepted++;
+
+    if (filter->count == 0) {
+        filter->base = counts;
+        filter->baseTime = timestamp;
+        filter->timeSum = 0;
+        filter->trend = filter->v;
+    }
+    filter->window[filter->count++] = (counts - filter->base) * 65536 -
+                                      ((filter->trend * (timestamp - filter->baseTime)) >> 16);
+    filter->timeSum += timestamp - filter->baseTime;
+
+    if (filter->count < filter->decimation)
+        return result;
+
+    OrbisFilterOutputUpdate(filter);
+
+    return (ORBIS_FILTER_ACCEPTED == result) ? ORBIS_FILTER_OUTPUT : result;
+}
+
+//
+// Take in the frames of a burst, see OrbisEncoderBurst(), those with a good CRC.
+//
+// Returns the number of outputs the burst has completed.
+//
+uint32_t OrbisFilterBurst(OrbisFilter* filter, const OrbisBurstFrame frames[], uint32_t count)
+{
+    uint32_t outputs = 0;
+
+    for (uint32_t k = 0; k < count; k++) {
+        if (frames[k].crc == ORBIS_CRC_OK &&
+            OrbisFilterUpdate(filter, frames[k].timestamp, frames[k].data) == ORBIS_FILTER_OUTPUT)
+            outputs++;
+    }
+
+    return outputs;
+}
+
+//
+// The latest output of the filter. The age of the output is the time since its timestamp;
+// whether it is a new one, its sequence number says.
+//
+// Returns ORBIS_FILTER_VALID with the output filled in, ORBIS_FILTER_SETTLING if there has
+// been no output since the filter was set up.
+//
+// Takes a consistent copy with the interrupts off, so it can be called from the main loop
+// or from an interrupt handler.
+//
+uint8_t OrbisFilterGet(const volatile OrbisFilter* filter, OrbisFilterOutput* output)
+{
+    unsigned char irq = IntDisable();
+
+    output->counts = filter->output.counts;
+    output->position = filter->output.position;
+    output->timestamp = filter->output.timestamp;
+    output->span = filter->output.span;
+    output->sequence = filter->output.sequence;
+    output->frames = filter->output.frames;
+    output->rejected = filter->output.rejected;
+
+    IntEnable(irq);
+
+    return (output->sequence == 0) ? ORBIS_FILTER_SETTLING : ORBIS_FILTER_VALID;
+}
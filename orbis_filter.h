@@ -0,0 +1,104 @@
+/*
+ * orbis_filter.h
+ * Oversampling filter for the Orbis position: decimating mean, median or trimmed mean,
+ * with outlier rejection
+ *
+ * The functions and global data structures are documented
+ * in the source code file to avoid saying the same thing twice.
+ * Use the source code file as a primary reference.
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#ifndef ORBIS_FILTER_H_
+#define ORBIS_FILTER_H_
+
+#include <stdint.h>
+#include "util.h"
+#include "orbis.h"
+
+// Most frames that go into an output
+#ifndef ORBIS_FILTER_WINDOW
+#define ORBIS_FILTER_WINDOW                 64u
+#endif
+
+// A frame further than this many counts off the trajectory is rejected, 1/256 of a turn
+#ifndef ORBIS_FILTER_MAX_JUMP
+#define ORBIS_FILTER_MAX_JUMP       (1u << (ORBIS_RESOLUTION - 8))
+#endif
+
+// Frames rejected in a row before the filter takes the trajectory as lost and starts over
+#ifndef ORBIS_FILTER_MAX_REJECTS
+#define ORBIS_FILTER_MAX_REJECTS             4u
+#endif
+
+// Longer gaps between frames than this, in DMTimer4 ticks, start the filter over
+#define ORBIS_FILTER_MAX_GAP          (10 * TIMER_1MS)
+
+// How the frames of an output are combined
+#define ORBIS_FILTER_MEAN                    0u
+#define ORBIS_FILTER_MEDIAN                  1u
+#define ORBIS_FILTER_TRIMMED                 2u     // Mean of the frames left after trim from either end
+
+// Result of OrbisFilterUpdate()
+#define ORBIS_FILTER_ACCEPTED                0u
+#define ORBIS_FILTER_OUTPUT                  1u     // Accepted, and it completed an output
+#define ORBIS_FILTER_REJECTED                2u
+#define ORBIS_FILTER_RESTARTED               3u     // Too many rejected in a row, started over from it
+#define ORBIS_FILTER_ERROR                   4u     // Orbis reports an error, not used
+
+// Result of OrbisFilterGet()
+#define ORBIS_FILTER_VALID                   0u
+#define ORBIS_FILTER_SETTLING                1u
+
+// An output of the filter
+typedef struct {
+    int64_t counts;                        // Position, Q16 counts, unwrapped over the turns
+    uint32_t position;                     // Single-turn position, Q16 counts
+    uint32_t timestamp;                    // DMTimer4 time the position stands for, the mean time of its frames
+    uint32_t span;                         // DMTimer4 ticks from its first frame to its last
+    uint32_t sequence;                     // Outputs since the start, goes up with every new one
+    uint16_t frames;                       // Frames that went into it
+    uint16_t rejected;                     // Frames rejected while they were collected
+} OrbisFilterOutput;
+
+typedef struct {
+    uint8_t method;                        // ORBIS_FILTER_MEAN, ORBIS_FILTER_MEDIAN or ORBIS_FILTER_TRIMMED
+    uint8_t trim;                          // Frames dropped from either end, ORBIS_FILTER_TRIMMED
+    uint16_t decimation;                   // Frames to an output, up to ORBIS_FILTER_WINDOW
+    uint32_t maxJump;                      // Counts off the trajectory a frame may be
+
+    uint8_t anchored;                      // A frame has been accepted since the start
+    uint8_t outputs;                       // Outputs since the start, up to 2, for the trajectory
+    uint16_t consecutive;                  // Frames rejected in a row
+    uint32_t lastRaw;                      // Turns and position of the last frame accepted, as reported
+    uint32_t lastTime;                     // DMTimer4 time of the last frame accepted
+    int64_t counts;                        // Unwrapped position of the last frame accepted
+
+    int64_t base;                          // Unwrapped position of the first frame of the window
+    uint32_t baseTime;                     // DMTimer4 time of the first frame of the window
+    uint32_t timeSum;                      // DMTimer4 ticks of the frames of the window after the first
+    uint16_t count;                        // Frames in the window
+    uint16_t windowRejected;               // Frames rejected since the window was started
+    int64_t window[ORBIS_FILTER_WINDOW];   // Frames of the window, Q16 counts from the first, less the trend
+    int64_t trend;                         // Velocity the window is taken less, Q32 counts per tick
+
+    int64_t x;                             // Last output, Q16 counts
+    uint32_t xTime;                        // DMTimer4 time of the last output
+    int64_t v;                             // Velocity between the last two outputs, Q32 counts per tick
+
+    uint32_t accepted;
+    uint32_t rejected;
+    uint32_t restarts;
+    uint32_t errors;
+
+    OrbisFilterOutput output;              // The latest output, see OrbisFilterGet()
+} OrbisFilter;
+
+void OrbisFilterInit(OrbisFilter* filter, uint8_t method, uint32_t decimation, uint32_t trim, uint32_t maxJump);
+void OrbisFilterRestart(OrbisFilter* filter);
+uint8_t OrbisFilterUpdate(OrbisFilter* filter, uint32_t timestamp, const volatile uint8_t* frame);
+uint32_t OrbisFilterBurst(OrbisFilter* filter, const OrbisBurstFrame frames[], uint32_t count);
+uint8_t OrbisFilterGet(const volatile OrbisFilter* filter, OrbisFilterOutput* output);
+
+#endif /* ORBIS_FILTER_H_ */
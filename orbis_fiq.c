@@ -0,0 +1,127 @@
+/*
+ * orbis_fiq.c
+ * FIQ-routed McSPI0 interrupt path for the Orbis rotary encoder driver
+ *
+ * On the IRQ path the McSPI0 interrupt goes through StarterWare's IRQ handler, which saves
+ * the context, reads the active interrupt from the AINTC, raises the priority threshold,
+ * re-enables IRQ and dispatches through the RAM vector table, and it shares all of that
+ * with every other interrupt of the firmware.
+ *
+ * With ORBIS_USE_FIQ set, SYS_INT_SPI0INT is routed to FIQ instead, and orbisFIQHandler()
+ * is put straight into the FIQ vector. It is compiled as an FIQ handler, so it works in the
+ * banked r8-r12 and saves next to nothing. It fills the Tx FIFO, or drains the response
+ * into the frame buffer with OrbisBusService(), and that is all it does at FIQ level.
+ *
+ * FIQ is not masked by IntDisable(), so the FIQ handler must not touch anything that the IRQ
+ * level guards that way: the deadlines, the sample ring, the callbacks. Once the response is
+ * in, it sets ORBIS_FIQ_COMPLETION_INT in software, and orbisFIQCompletionIsr() completes the
+ * capture at IRQ level, as the McSPI IRQ handler would have done. A capture that times out
+ * first is taken back with OrbisFIQCompletionCancel(), so its completion is never taken for
+ * that of the next one.
+ *
+ * The completion, the CRC check and the publishing of the sample stay at IRQ level, behind
+ * whatever other interrupt handler is running: FIQ keeps the response from waiting in the Rx
+ * FIFO, not the sample from waiting to be published.
+ *
+ * The gain shows in the latency histograms (ORBIS_LATENCY): the "transfer" stage includes the
+ * time to enter the handler that drains the FIFO, and the "FIFO drain" stage the time to
+ * drain it. Compare them with and without ORBIS_USE_FIQ.
+ *
+ * Only McSPI0 is served from FIQ; McSPI1 stays on IRQ.
+ *
+ *  Created on: 16 Oct 2026
+ */
+#include <stdint.h>
+#include <stddef.h>
+#include "hw_types.h"
+#include "soc_AM335x.h"
+#include "hw_intc.h"
+#include "interrupt.h"
+#include "orbis.h"
+#include "orbis_fiq.h"
+#include "orbis_load.h"
+#include "orbis_memory.h"
+
+#if ORBIS_USE_FIQ
+
+// The encoder whose response the FIQ handler has drained, for orbisFIQCompletionIsr()
+static OrbisEncoder* volatile orbisFIQDrained;
+
+#if defined(__TI_COMPILER_VERSION__)
+#pragma INTERRUPT(orbisFIQHandler, FIQ)
+#if ORBIS_PERFORMANCE
+#pragma CODE_SECTION(orbisFIQHandler, ORBIS_SECTION_FAST_TEXT)
+#endif
+#define ORBIS_FIQ_ATTRIBUTE
+#elif defined(__GNUC__) && defined(__arm__)
+#define ORBIS_FIQ_ATTRIBUTE                  __attribute__((interrupt("FIQ")))
+#else
+#define ORBIS_FIQ_ATTRIBUTE
+#endif
+
+//
+// Route the McSPI0 interrupt to FIQ and put orbisFIQHandler() in the FIQ vector, in place of
+// StarterWare's FIQ dispatch. Call after InterruptSetup() has initialised the AINTC and after
+// OrbisSetup(), instead of registering orbisMcSPIIsr().
+//
+void OrbisFIQSetup(void)
+{
+    HWREG(ORBIS_FIQ_VECTOR_LITERAL) = (unsigned int) (uintptr_t) orbisFIQHandler;
+
+    // Also registered with StarterWare, which is what its own FIQ dispatch would call
+    IntRegister(SYS_INT_SPI0INT, orbisFIQHandler);
+    IntPrioritySet(SYS_INT_SPI0INT, 0, AINTC_HOSTINT_ROUTE_FIQ);
+    IntSystemEnable(SYS_INT_SPI0INT);
+
+    IntRegister(ORBIS_FIQ_COMPLETION_INT, orbisFIQCompletionIsr);
+    IntPrioritySet(ORBIS_FIQ_COMPLETION_INT, 0, AINTC_HOSTINT_ROUTE_IRQ);
+    IntSystemEnable(ORBIS_FIQ_COMPLETION_INT);
+
+    IntMasterFIQEnable();
+}
+
+// McSPI0 FIQ handler
+ORBIS_FIQ_ATTRIBUTE void orbisFIQHandler(void)
+{
+    OrbisEncoder* encoder = OrbisBusService(&orbisBus[0]);
+
+    if (encoder != NULL) {
+        orbisFIQDrained = encoder;
+        HWREG(SOC_AINTC_REGS + INTC_ISR_SET(ORBIS_FIQ_COMPLETION_INT >> 5)) =
+            1u << (ORBIS_FIQ_COMPLETION_INT & 31u);
+    }
+
+    // Let the AINTC raise the next FIQ
+    HWREG(SOC_AINTC_REGS + INTC_CONTROL) = INTC_CONTROL_NEWFIQAGR;
+}
+
+// Completes the capture drained by the FIQ handler, at IRQ level
+void orbisFIQCompletionIsr(void)
+{
+    OrbisEncoder* encoder = orbisFIQDrained;
+
+    ORBIS_LOAD_ISR_ENTER();
+
+    HWREG(SOC_AINTC_REGS + INTC_ISR_CLEAR(ORBIS_FIQ_COMPLETION_INT >> 5)) =
+        1u << (ORBIS_FIQ_COMPLETION_INT & 31u);
+    orbisFIQDrained = NULL;
+
+    // Unless the capture has timed out in the meantime, and the bus gone on to the next one
+    if (encoder != NULL && encoder == orbisBus[0].active && encoder->captureState == ORBIS_CAPTURE_BUSY)
+        OrbisCaptureComplete(encoder);
+
+    ORBIS_LOAD_ISR_EXIT();
+}
+
+//
+// Take back the completion the FIQ handler has set, if orbisFIQCompletionIsr() has not been
+// taken yet. Called by OrbisBusPoll() with IRQ disabled, when it abandons the capture on McSPI0.
+//
+void OrbisFIQCompletionCancel(void)
+{
+    HWREG(SOC_AINTC_REGS + INTC_ISR_CLEAR(ORBIS_FIQ_COMPLETION_INT >> 5)) =
+        1u << (ORBIS_FIQ_COMPLETION_INT & 31u);
+    orbisFIQDrained = NULL;
+}
+
+#endif
@@ -0,0 +1,36 @@
+/*
+ * orbis_fiq.h
+ * FIQ-routed McSPI0 interrupt path for the Orbis rotary encoder driver
+ *
+ * The functions and global data structures are documented
+ * in the source code file to avoid saying the same thing twice.
+ * Use the source code file as a primary reference.
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#ifndef ORBIS_FIQ_H_
+#define ORBIS_FIQ_H_
+
+#include "hw_types.h"
+#include "soc_AM335x.h"
+#include "interrupt.h"
+#include "orbis.h"
+
+// Literal of the FIQ vector in the table StarterWare copies to the top of OCMC RAM: the FIQ
+// entry at 0x1C is LDR pc, [pc, #0x10], which loads the handler address from 0x34.
+#define ORBIS_FIQ_VECTOR_BASE                0x4030FC00u
+#define ORBIS_FIQ_VECTOR_LITERAL             (ORBIS_FIQ_VECTOR_BASE + 0x34u)
+
+// Interrupt that the FIQ handler sets in software to complete the capture at IRQ level.
+// The PMU (benchmark) interrupt is not otherwise used by the firmware.
+#ifndef ORBIS_FIQ_COMPLETION_INT
+#define ORBIS_FIQ_COMPLETION_INT             SYS_INT_BENCH
+#endif
+
+void OrbisFIQSetup(void);
+void orbisFIQHandler(void);
+void orbisFIQCompletionIsr(void);
+void OrbisFIQCompletionCancel(void);
+
+#endif /* ORBIS_FIQ_H_ */
@@ -0,0 +1,173 @@
+/*
+ * orbis_latency.c
+ * Per-stage latency histograms of the Orbis capture
+ *
+ * The driver stamps each stage of a capture as it passes it (ORBIS_LATENCY_STAMP()),
+ * and on completion the time spent in each stage goes into a histogram of its own.
+ * The stages are listed in orbis_latency.h. A stage that a capture does not pass through,
+ * such as the TX_EMPTY interrupt on the EDMA3 path, is left out and the next one is timed
+ * from the one before it. Captures that time out are not recorded.
+ *
+ * The histograms have fixed, quarter-octave buckets in static memory, so recording is
+ * a few operations in the interrupt handler and never fails. The percentiles are read off
+ * the buckets and are the upper bound of the bucket, which is within 25% of the real value.
+ *
+ * The stamps are in CPU cycles from the Cortex-A8 PMU cycle counter, which OrbisLatencySetup()
+ * starts, or DMTimer4 ticks when the compiler cannot read the counter (on the host, for one).
+ *
+ * All of it is compiled only with ORBIS_LATENCY set.
+ *
+ *  Created on: 16 Oct 2026
+ */
+#include <stdint.h>
+#include "consoleUtils.h"
+#include "interrupt.h"
+#include "orbis.h"
+#include "orbis_latency.h"
+
+#if ORBIS_LATENCY
+
+OrbisLatencyHistogram orbisLatency[ORBIS_STAGE_COUNT];
+
+static const char* const orbisLatencyNames[ORBIS_STAGE_COUNT] = {
+    "total", "bus wait", "CS setup", "Tx interrupt", "transfer", "FIFO drain", "CRC"
+};
+
+// Start the PMU cycle counter, if that is the clock, and clear the histograms
+void OrbisLatencySetup(void)
+{
+    ORBIS_LATENCY_CLOCK_START();
+
+    OrbisLatencyReset();
+}
+
+void OrbisLatencyReset(void)
+{
+    unsigned char irq = IntDisable();
+
+    for (uint32_t i = 0; i < ORBIS_STAGE_COUNT; i++) {
+        OrbisLatencyHistogram* histogram = &orbisLatency[i];
+
+        histogram->count = 0;
+        histogram->min = UINT32_MAX;
+        histogram->max = 0;
+        histogram->sum = 0;
+        for (uint32_t j = 0; j < ORBIS_LATENCY_BUCKETS; j++)
+            histogram->buckets[j] = 0;
+    }
+
+    IntEnable(irq);
+}
+
+// Bucket of a duration: the duration itself below 4, then the power of two and the next two bits
+static uint32_t OrbisLatencyBucket(uint32_t duration)
+{
+    uint32_t shift = 0;
+
+    if (duration < 4)
+        return duration;
+
+    while ((duration >> shift) >= 8)
+        shift++;
+
+    return 4 + 4 * shift + ((duration >> shift) & 3);
+}
+
+// Largest duration that goes into the bucket
+static uint32_t OrbisLatencyBucketLimit(uint32_t bucket)
+{
+    uint32_t shift;
+
+    if (bucket < 4)
+        return bucket;
+
+    shift = (bucket - 4) / 4;
+    return (((4 + (bucket & 3)) + 1) << shift) - 1;
+}
+
+static void OrbisLatencyAdd(OrbisLatencyHistogram* histogram, uint32_t duration)
+{
+    histogram->count++;
+    histogram->sum += duration;
+    if (duration < histogram->min)
+        histogram->min = duration;
+    if (duration > histogram->max)
+        histogram->max = duration;
+    histogram->buckets[OrbisLatencyBucket(duration)]++;
+}
+
+//
+// Put the stages of the completed capture into the histograms. Called by the driver
+// from the interrupt handler that completes the capture.
+//
+void OrbisLatencyRecord(OrbisEncoder* encoder)
+{
+    uint32_t previous = encoder->latencyStamps[ORBIS_STAGE_REQUEST];
+
+    if (!(encoder->latencyMask & (1u << ORBIS_STAGE_REQUEST)))
+        return;
+
+    for (uint32_t stage = ORBIS_STAGE_REQUEST + 1; stage < ORBIS_STAGE_COUNT; stage++) {
+        if (encoder->latencyMask & (1u << stage)) {
+            OrbisLatencyAdd(&orbisLatency[stage], encoder->latencyStamps[stage] - previous);
+            previous = encoder->latencyStamps[stage];
+        }
+    }
+
+    OrbisLatencyAdd(&orbisLatency[ORBIS_STAGE_REQUEST], previous - encoder->latencyStamps[ORBIS_STAGE_REQUEST]);
+    encoder->latencyMask = 0;
+}
+
+//
+// Duration that permille thousandths of the recorded durations do not exceed,
+// to the resolution of the buckets. Returns 0 if nothing has been recorded.
+//
+uint32_t OrbisLatencyPercentile(const OrbisLatencyHistogram* histogram, uint32_t permille)
+{
+    uint64_t rank = ((uint64_t) histogram->count * permille + 999) / 1000;
+    uint64_t seen = 0;
+
+    if (histogram->count == 0)
+        return 0;
+
+    for (uint32_t bucket = 0; bucket < ORBIS_LATENCY_BUCKETS; bucket++) {
+        seen += histogram->buckets[bucket];
+        if (seen >= rank && seen > 0) {
+            uint32_t limit = OrbisLatencyBucketLimit(bucket);
+            return (limit < histogram->max) ? limit : histogram->max;
+        }
+    }
+
+    return histogram->max;
+}
+
+// Print the histograms on the console, one line per stage
+void OrbisLatencyReport(void)
+{
+#if ORBIS_LATENCY_PMU
+    ConsoleUtilsPrintf("Orbis capture latency, CPU cycles:\n");
+#else
+    ConsoleUtilsPrintf("Orbis capture latency, DMTimer4 ticks:\n");
+#endif
+    ConsoleUtilsPrintf("stage\tcount\tmin\tmean\tp50\tp90\tp99\tmax\n");
+
+    for (uint32_t i = 0; i < ORBIS_STAGE_COUNT; i++) {
+        // Copied with IRQ disabled, so the line is consistent
+        OrbisLatencyHistogram histogram;
+        unsigned char irq = IntDisable();
+        histogram = orbisLatency[i];
+        IntEnable(irq);
+
+        if (histogram.count == 0) {
+            ConsoleUtilsPrintf("%s\t0\n", orbisLatencyNames[i]);
+            continue;
+        }
+
+        ConsoleUtilsPrintf("%s\t%u\t%u\t%u\t%u\t%u\t%u\t%u\n", orbisLatencyNames[i], histogram.count,
+                           histogram.min, (uint32_t) (histogram.sum / histogram.count),
+                           OrbisLatencyPercentile(&histogram, 500), OrbisLatencyPercentile(&histogram, 900),
+                           OrbisLatencyPercentile(&histogram, 990), histogram.max);
+    }
+}
+
+#endif /* ORBIS_LATENCY */
@@ -0,0 +1,88 @@
+/*
+ * orbis_latency.h
+ * Per-stage latency histograms of the Orbis capture
+ *
+ * The functions and global data structures are documented
+ * in the source code file to avoid saying the same thing twice.
+ * Use the source code file as a primary reference.
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#ifndef ORBIS_LATENCY_H_
+#define ORBIS_LATENCY_H_
+
+#include <stdint.h>
+#include "util.h"
+
+// Instrumentation of the capture. When 0, the stamps compile to nothing and neither the
+// encoders nor the driver carry any of it. See orbis_latency.c.
+#ifndef ORBIS_LATENCY
+#define ORBIS_LATENCY                        0
+#endif
+
+// Stages of a capture, in the order they happen. The histogram of each stage is of the time
+// since the previous stage, except for ORBIS_STAGE_REQUEST which holds the whole capture.
+#define ORBIS_STAGE_REQUEST                  0u    // Capture requested
+#define ORBIS_STAGE_CS                       1u    // CS asserted, after waiting for the bus
+#define ORBIS_STAGE_SETUP                    2u    // CS setup delay over
+#define ORBIS_STAGE_TX                       3u    // TX_EMPTY interrupt taken, or Tx FIFO filled if polled or with EOW
+#define ORBIS_STAGE_RX                       4u    // RX_FULL (EDMA3 completion, EOW) interrupt taken, or the first word in if polled
+#define ORBIS_STAGE_DRAIN                    5u    // Response read out of the FIFO
+#define ORBIS_STAGE_CRC                      6u    // CRC validated
+#define ORBIS_STAGE_COUNT                    7u
+
+// Quarter-octave buckets: exact below 4, then four per power of two up to 2^32
+#define ORBIS_LATENCY_BUCKETS              124u
+
+// Clock of the stamps: the Cortex-A8 PMU cycle counter where the compiler can read it,
+// DMTimer4 (TIME) otherwise. ORBIS_LATENCY_CLOCK_START() starts the cycle counter:
+// PMNC enables the counters and resets the cycle counter, CNTENS enables the cycle counter.
+#if defined(__TI_COMPILER_VERSION__) && defined(__TI_ARM__)
+#define ORBIS_LATENCY_PMU                    1
+#define ORBIS_LATENCY_CLOCK()                __MRC(15, 0, 9, 13, 0)
+#define ORBIS_LATENCY_CLOCK_START()          do { __MCR(15, 0, 0x5u, 9, 12, 0); \
+                                                  __MCR(15, 0, 0x80000000u, 9, 12, 1); } while (0)
+#elif defined(__GNUC__) && defined(__arm__)
+#define ORBIS_LATENCY_PMU                    1
+#define ORBIS_LATENCY_CLOCK()                ({ uint32_t ccnt; __asm__ volatile ("mrc p15, 0, %0, c9, c13, 0" : "=r" (ccnt)); ccnt; })
+#define ORBIS_LATENCY_CLOCK_START()          do { __asm__ volatile ("mcr p15, 0, %0, c9, c12, 0" : : "r" (0x5u)); \
+                                                  __asm__ volatile ("mcr p15, 0, %0, c9, c12, 1" : : "r" (0x80000000u)); } while (0)
+#else
+#define ORBIS_LATENCY_PMU                    0
+#define ORBIS_LATENCY_CLOCK()                TIME
+#define ORBIS_LATENCY_CLOCK_START()
+#endif
+
+#if ORBIS_LATENCY
+// Start the stamps of a new capture of the encoder
+#define ORBIS_LATENCY_BEGIN(encoder)         do { (encoder)->latencyMask = 1u << ORBIS_STAGE_REQUEST; \
+                                                  (encoder)->latencyStamps[ORBIS_STAGE_REQUEST] = ORBIS_LATENCY_CLOCK(); } while (0)
+#define ORBIS_LATENCY_STAMP(encoder, stage)  do { (encoder)->latencyStamps[stage] = ORBIS_LATENCY_CLOCK(); \
+                                                  (encoder)->latencyMask |= 1u << (stage); } while (0)
+#define ORBIS_LATENCY_END(encoder)           OrbisLatencyRecord(encoder)
+#else
+#define ORBIS_LATENCY_BEGIN(encoder)
+#define ORBIS_LATENCY_STAMP(encoder, stage)
+#define ORBIS_LATENCY_END(encoder)
+#endif
+
+typedef struct {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+    uint32_t buckets[ORBIS_LATENCY_BUCKETS];
+} OrbisLatencyHistogram;
+
+struct OrbisEncoder;
+
+extern OrbisLatencyHistogram orbisLatency[ORBIS_STAGE_COUNT];
+
+void OrbisLatencySetup(void);
+void OrbisLatencyReset(void);
+void OrbisLatencyRecord(struct OrbisEncoder* encoder);
+uint32_t OrbisLatencyPercentile(const OrbisLatencyHistogram* histogram, uint32_t permille);
+void OrbisLatencyReport(void);
+
+#endif /* ORBIS_LATENCY_H_ */
@@ -0,0 +1,188 @@
+/*
+ * orbis_load.c
+ * WFI idle and CPU load accounting
+ *
+ * Waiting for an interrupt by spinning on a flag or on the timer keeps the CPU busy, and
+ * there is no telling how much room is left for more work. OrbisLoadSleep() waits with WFI
+ * instead: the core stops until an interrupt is pending, and the time asleep is counted
+ * as idle. It is called with IRQ disabled, after the caller has checked that there is still
+ * something to wait for, and the interrupt that wakes it is taken once IRQ is enabled again.
+ * The blocking interrupt-driven captures (see OrbisEncoderRequestInterrupt()) and the main
+ * loop of the scheduler (see OrbisSchedIdle()) sleep this way.
+ *
+ * Along with the idle time, with ORBIS_LOAD set, the time is counted in
+ *
+ *   - the IRQ handlers, which mark their entry and exit with ORBIS_LOAD_ISR_ENTER() and
+ *     ORBIS_LOAD_ISR_EXIT(). Nested handlers are counted once, from the outermost. The FIQ
+ *     handler is not counted, its time goes to whatever it interrupted.
+ *
+ *   - the blocking captures, between ORBIS_LOAD_CAPTURE_BEGIN() and ORBIS_LOAD_CAPTURE_END(),
+ *     less the time in the interrupt handlers and asleep in the meantime. A polled capture
+ *     never sleeps, so all of it is capture time.
+ *
+ * and the rest is application time. OrbisLoadGet() takes the totals at any time, and
+ * OrbisLoadDifference() the load over the window between two of them.
+ *
+ * All of it is in DMTimer4 ticks. The elapsed time is brought up to date on every sleep and
+ * every OrbisLoadGet(), and one of them has to come at least every 2^31 ticks (89 s).
+ *
+ *  Created on: 16 Oct 2026
+ */
+#include <stdint.h>
+#include "consoleUtils.h"
+#include "interrupt.h"
+#include "orbis_load.h"
+#include "orbis_memory.h"
+#include "util.h"
+
+#if ORBIS_LOAD
+
+// The interrupt handlers count from OCMC RAM in the performance build profile, see orbis_memory.c
+#if ORBIS_PERFORMANCE && defined(__TI_COMPILER_VERSION__)
+#pragma CODE_SECTION(OrbisLoadIsrEnter, ORBIS_SECTION_FAST_TEXT)
+#pragma CODE_SECTION(OrbisLoadIsrExit, ORBIS_SECTION_FAST_TEXT)
+#endif
+
+static uint32_t orbisLoadLast;             // TIME the elapsed time has been brought up to
+static uint64_t orbisLoadElapsed;
+static uint64_t orbisLoadCapture;
+static uint64_t orbisLoadIdle;
+
+static volatile uint64_t orbisLoadIsr;
+static volatile uint32_t orbisLoadIsrDepth;
+static uint32_t orbisLoadIsrStart;
+
+// Start of the blocking capture in progress, and the interrupt and idle times then
+static uint32_t orbisLoadCaptureStart;
+static uint64_t orbisLoadCaptureIsr;
+static uint64_t orbisLoadCaptureIdle;
+
+// Bring the elapsed time up to now. Called with IRQ disabled.
+static void OrbisLoadElapse(uint32_t now)
+{
+    orbisLoadElapsed += now - orbisLoadLast;
+    orbisLoadLast = now;
+}
+
+// Clear the counters and start counting from now
+void OrbisLoadStart(void)
+{
+    unsigned char irq = IntDisable();
+
+    orbisLoadLast = TIME;
+    orbisLoadElapsed = 0;
+    orbisLoadCapture = 0;
+    orbisLoadIdle = 0;
+    orbisLoadIsr = 0;
+
+    IntEnable(irq);
+}
+
+#endif
+
+//
+// Sleep until an interrupt is pending. Must be called with IRQ disabled, and the interrupt
+// is taken when the caller enables IRQ again.
+//
+void OrbisLoadSleep(void)
+{
+#if ORBIS_LOAD
+    uint32_t start = TIME;
+    uint32_t end;
+
+    ORBIS_WFI();
+
+    end = TIME;
+    orbisLoadIdle += end - start;
+    OrbisLoadElapse(end);
+#else
+    ORBIS_WFI();
+#endif
+}
+
+#if ORBIS_LOAD
+
+// An IRQ handler has been entered, see ORBIS_LOAD_ISR_ENTER()
+void OrbisLoadIsrEnter(void)
+{
+    if (orbisLoadIsrDepth++ == 0)
+        orbisLoadIsrStart = TIME;
+}
+
+// An IRQ handler is about to return, see ORBIS_LOAD_ISR_EXIT()
+void OrbisLoadIsrExit(void)
+{
+    if (--orbisLoadIsrDepth == 0)
+        orbisLoadIsr += TIME - orbisLoadIsrStart;
+}
+
+// A blocking capture has started, see ORBIS_LOAD_CAPTURE_BEGIN()
+void OrbisLoadCaptureBegin(void)
+{
+    unsigned char irq = IntDisable();
+
+    orbisLoadCaptureStart = TIME;
+    orbisLoadCaptureIsr = orbisLoadIsr;
+    orbisLoadCaptureIdle = orbisLoadIdle;
+
+    IntEnable(irq);
+}
+
+// The blocking capture has finished, see ORBIS_LOAD_CAPTURE_END()
+void OrbisLoadCaptureEnd(void)
+{
+    unsigned char irq = IntDisable();
+
+    orbisLoadCapture += (uint64_t) (TIME - orbisLoadCaptureStart) -
+                        (orbisLoadIsr - orbisLoadCaptureIsr) - (orbisLoadIdle - orbisLoadCaptureIdle);
+
+    IntEnable(irq);
+}
+
+// The time elapsed since OrbisLoadStart(), and where it has gone
+void OrbisLoadGet(OrbisLoadTimes* times)
+{
+    unsigned char irq = IntDisable();
+
+    OrbisLoadElapse(TIME);
+
+    times->elapsed = orbisLoadElapsed;
+    times->capture = orbisLoadCapture;
+    times->isr = orbisLoadIsr;
+    times->idle = orbisLoadIdle;
+
+    IntEnable(irq);
+
+    times->application = times->elapsed - times->capture - times->isr - times->idle;
+}
+
+// Where the time has gone between two OrbisLoadGet(), before and now
+void OrbisLoadDifference(const OrbisLoadTimes* now, const OrbisLoadTimes* before, OrbisLoadTimes* window)
+{
+    window->elapsed = now->elapsed - before->elapsed;
+    window->capture = now->capture - before->capture;
+    window->isr = now->isr - before->isr;
+    window->idle = now->idle - before->idle;
+    window->application = now->application - before->application;
+}
+
+// Share of the elapsed time, in tenths of a percent
+static uint32_t OrbisLoadPermille(uint64_t ticks, uint64_t elapsed)
+{
+    return (elapsed == 0) ? 0 : (uint32_t) ((ticks * 1000u + elapsed / 2) / elapsed);
+}
+
+// Print the shares of the time to the console
+void OrbisLoadReport(const OrbisLoadTimes* times)
+{
+    uint32_t capture = OrbisLoadPermille(times->capture, times->elapsed);
+    uint32_t isr = OrbisLoadPermille(times->isr, times->elapsed);
+    uint32_t application = OrbisLoadPermille(times->application, times->elapsed);
+    uint32_t idle = OrbisLoadPermille(times->idle, times->elapsed);
+
+    ConsoleUtilsPrintf("CPU over %u ms: capture %u.%u%%, ISR %u.%u%%, application %u.%u%%, idle %u.%u%%\n",
+                       (uint32_t) (times->elapsed / TIMER_1MS), capture / 10, capture % 10, isr / 10, isr % 10,
+                       application / 10, application % 10, idle / 10, idle % 10);
+}
+
+#endif
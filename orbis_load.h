@@ -0,0 +1,67 @@
+/*
+ * orbis_load.h
+ * WFI idle and CPU load accounting
+ *
+ * The functions and global data structures are documented
+ * in the source code file to avoid saying the same thing twice.
+ * Use the source code file as a primary reference.
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#ifndef ORBIS_LOAD_H_
+#define ORBIS_LOAD_H_
+
+#include <stdint.h>
+#include "util.h"
+
+// CPU load accounting. When set to 1, the time in the interrupt handlers, in the blocking
+// captures and asleep is counted, see OrbisLoadGet(). The idle wait uses WFI either way.
+#ifndef ORBIS_LOAD
+#define ORBIS_LOAD                           1
+#endif
+
+// Wait for an interrupt. WFI wakes on an interrupt that is pending but masked too, so with IRQ
+// disabled around the check of the condition and the WFI, no interrupt can slip in between.
+#if defined(__TI_COMPILER_VERSION__)
+#define ORBIS_WFI()                          __asm(" WFI")
+#elif defined(__GNUC__) && defined(__arm__)
+#define ORBIS_WFI()                          __asm__ volatile ("wfi" : : : "memory")
+#else
+// The host build: the simulated interrupt controller moves time on to the next interrupt, see host/sim.c
+void SimWaitForInterrupt(void);
+#define ORBIS_WFI()                          SimWaitForInterrupt()
+#endif
+
+#if ORBIS_LOAD
+#define ORBIS_LOAD_ISR_ENTER()               OrbisLoadIsrEnter()
+#define ORBIS_LOAD_ISR_EXIT()                OrbisLoadIsrExit()
+#define ORBIS_LOAD_CAPTURE_BEGIN()           OrbisLoadCaptureBegin()
+#define ORBIS_LOAD_CAPTURE_END()             OrbisLoadCaptureEnd()
+#else
+#define ORBIS_LOAD_ISR_ENTER()
+#define ORBIS_LOAD_ISR_EXIT()
+#define ORBIS_LOAD_CAPTURE_BEGIN()
+#define ORBIS_LOAD_CAPTURE_END()
+#endif
+
+// Where the CPU time has gone, in DMTimer4 ticks, see OrbisLoadGet()
+typedef struct {
+    uint64_t elapsed;                      // Since OrbisLoadStart()
+    uint64_t capture;                      // In the blocking captures, less the interrupts and the sleep
+    uint64_t isr;                          // In the IRQ handlers
+    uint64_t idle;                         // Asleep in WFI
+    uint64_t application;                  // The rest
+} OrbisLoadTimes;
+
+void OrbisLoadStart(void);
+void OrbisLoadSleep(void);
+void OrbisLoadIsrEnter(void);
+void OrbisLoadIsrExit(void);
+void OrbisLoadCaptureBegin(void);
+void OrbisLoadCaptureEnd(void);
+void OrbisLoadGet(OrbisLoadTimes* times);
+void OrbisLoadDifference(const OrbisLoadTimes* now, const OrbisLoadTimes* before, OrbisLoadTimes* window);
+void OrbisLoadReport(const OrbisLoadTimes* times);
+
+#endif /* ORBIS_LOAD_H_ */
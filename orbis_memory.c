@@ -0,0 +1,113 @@
+/*
+ * orbis_memory.c
+ * Memory placement and cache/MMU set-up of the performance build profile
+ *
+ * Out of reset the Cortex-A8 runs with the MMU and the caches off, so every fetch of the
+ * interrupt handlers and every lookup in the CRC table goes out to DDR. With ORBIS_PERFORMANCE
+ * set:
+ *
+ *   - the capture interrupt path, the CRC routine and its table are placed in their own
+ *     sections (ORBIS_SECTION_FAST_...), which Linker.cmd loads into DDR with the rest of the
+ *     image and runs from OCMC RAM. OrbisMemorySetup() copies them across.
+ *
+ *   - OrbisCacheEnable() maps DDR and OCMC RAM as normal write-back cacheable memory, the
+ *     L4 peripherals as device memory, and the L4_PER sections with McSPI and DMTimer as
+ *     strongly ordered, so that the CS assertion, the FIFO accesses and the TIME reads happen
+ *     in program order. Then it enables the MMU, both caches and the branch prediction.
+ *
+ *   - EDMA3 writes around the data cache, so with ORBIS_USE_EDMA the frame buffers it fills
+ *     (orbisEncoder and the sample ring) are placed in ORBIS_SECTION_DMA, a DDR section mapped
+ *     uncached. Other encoders used with EDMA3 must be placed there too.
+ *
+ * The last 1 KB of OCMC RAM holds the exception vectors and is left alone.
+ *
+ *  Created on: 16 Oct 2026
+ */
+#include <stdint.h>
+#include <string.h>
+#include "mmu.h"
+#include "cache.h"
+#include "cp15.h"
+#include "orbis_memory.h"
+
+#if ORBIS_PERFORMANCE
+
+// Section boundaries, defined by Linker.cmd. The address of each symbol is the value.
+extern uint8_t orbisFastLoad;
+extern uint8_t orbisFastRun;
+extern uint8_t orbisFastSize;
+extern uint8_t orbisDMAStart;
+extern uint8_t orbisDMASize;
+
+// First-level page table, one entry per 1 MB section
+#ifdef __TI_COMPILER_VERSION__
+#pragma DATA_ALIGN(orbisPageTable, MMU_PAGETABLE_ALIGN_SIZE)
+static volatile unsigned int orbisPageTable[MMU_PAGETABLE_NUM_ENTRY];
+#else
+static volatile unsigned int orbisPageTable[MMU_PAGETABLE_NUM_ENTRY]
+    __attribute__((aligned(MMU_PAGETABLE_ALIGN_SIZE)));
+#endif
+
+#endif
+
+//
+// Move the hot path into OCMC RAM and clear the uncached DMA section, which is not part of
+// .bss. Must be the first thing main() does, before any interrupt handler is registered
+// or the encoder is touched. Does nothing unless ORBIS_PERFORMANCE is set.
+//
+void OrbisMemorySetup(void)
+{
+#if ORBIS_PERFORMANCE
+    memcpy(&orbisFastRun, &orbisFastLoad, (size_t) &orbisFastSize);
+    memset(&orbisDMAStart, 0, (size_t) &orbisDMASize);
+#endif
+}
+
+//
+// Map the memory, then enable the MMU, the instruction and data caches and the branch
+// prediction. Does nothing unless ORBIS_PERFORMANCE is set.
+//
+void OrbisCacheEnable(void)
+{
+#if ORBIS_PERFORMANCE
+    REGION ddr = {
+        MMU_PGTYPE_SECTION, ORBIS_MEMORY_DDR_START, ORBIS_MEMORY_DDR_SECTIONS,
+        MMU_MEMTYPE_NORMAL_NON_SHAREABLE(MMU_CACHE_WT_NOWA, MMU_CACHE_WB_WA),
+        MMU_REGION_NON_SECURE, MMU_AP_PRV_RW_USR_RW, (unsigned int*) orbisPageTable
+    };
+    REGION dma = {
+        MMU_PGTYPE_SECTION, ORBIS_MEMORY_DMA_START, 1,
+        MMU_MEMTYPE_NORMAL_NON_SHAREABLE(MMU_NON_CACHEABLE, MMU_NON_CACHEABLE),
+        MMU_REGION_NON_SECURE, MMU_AP_PRV_RW_USR_RW, (unsigned int*) orbisPageTable
+    };
+    REGION ocmc = {
+        MMU_PGTYPE_SECTION, ORBIS_MEMORY_OCMC_START, 1,
+        MMU_MEMTYPE_NORMAL_NON_SHAREABLE(MMU_CACHE_WT_NOWA, MMU_CACHE_WB_WA),
+        MMU_REGION_NON_SECURE, MMU_AP_PRV_RW_USR_RW, (unsigned int*) orbisPageTable
+    };
+    REGION device = {
+        MMU_PGTYPE_SECTION, ORBIS_MEMORY_DEVICE_START, ORBIS_MEMORY_DEVICE_SECTIONS,
+        MMU_MEMTYPE_DEVICE_SHAREABLE,
+        MMU_REGION_NON_SECURE, MMU_AP_PRV_RW_USR_RW | MMU_SECTION_EXEC_NEVER, (unsigned int*) orbisPageTable
+    };
+    REGION l4per = {
+        MMU_PGTYPE_SECTION, ORBIS_MEMORY_L4_PER_START, ORBIS_MEMORY_L4_PER_SECTIONS,
+        MMU_MEMTYPE_STRONG_ORD_SHAREABLE,
+        MMU_REGION_NON_SECURE, MMU_AP_PRV_RW_USR_RW | MMU_SECTION_EXEC_NEVER, (unsigned int*) orbisPageTable
+    };
+
+    MMUInit((unsigned int*) orbisPageTable);
+
+    // The later regions override the earlier ones where they overlap
+    MMUMemRegionMap(&ddr);
+    MMUMemRegionMap(&dma);
+    MMUMemRegionMap(&ocmc);
+    MMUMemRegionMap(&device);
+    MMUMemRegionMap(&l4per);
+
+    MMUEnable((unsigned int*) orbisPageTable);
+
+    CacheEnable(CACHE_ALL);
+    CP15BranchPredictionEnable();
+#endif
+}
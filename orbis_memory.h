@@ -0,0 +1,41 @@
+/*
+ * orbis_memory.h
+ * Memory placement and cache/MMU set-up of the performance build profile
+ *
+ * The functions and global data structures are documented
+ * in the source code file to avoid saying the same thing twice.
+ * Use the source code file as a primary reference.
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#ifndef ORBIS_MEMORY_H_
+#define ORBIS_MEMORY_H_
+
+#include <stdint.h>
+
+// Performance build profile: the hot path runs from OCMC RAM, and the MMU, the caches and
+// the branch prediction are enabled. When 0, everything runs uncached from DDR as before.
+#ifndef ORBIS_PERFORMANCE
+#define ORBIS_PERFORMANCE                    0
+#endif
+
+// Sections of the profile, placed by Linker.cmd
+#define ORBIS_SECTION_FAST_TEXT              ".orbis_fast_text"    // Hot code, runs from OCMC RAM
+#define ORBIS_SECTION_FAST_CONST             ".orbis_fast_const"   // Its lookup tables, ditto
+#define ORBIS_SECTION_DMA                    ".orbis_dma"          // EDMA3 destinations, DDR, uncached
+
+// Memory map, in 1 MB MMU sections
+#define ORBIS_MEMORY_DDR_START               0x80000000u
+#define ORBIS_MEMORY_DDR_SECTIONS            512u
+#define ORBIS_MEMORY_DMA_START               0x87E00000u
+#define ORBIS_MEMORY_OCMC_START              0x40300000u
+#define ORBIS_MEMORY_DEVICE_START            0x44000000u
+#define ORBIS_MEMORY_DEVICE_SECTIONS         960u
+#define ORBIS_MEMORY_L4_PER_START            0x48000000u   // McSPI0, DMTimer2..7, the interrupt controller
+#define ORBIS_MEMORY_L4_PER_SECTIONS         3u            // ... and McSPI1 at 0x481A0000
+
+void OrbisMemorySetup(void);
+void OrbisCacheEnable(void);
+
+#endif /* ORBIS_MEMORY_H_ */
@@ -0,0 +1,122 @@
+/*
+ * orbis_protocol.c
+ * Orbis SPI protocol: commands, frame layout, CRC check and decoding
+ *
+ * A transfer with Orbis is a single frame, as long as the response: the command byte goes out
+ * first, padded with ORBIS_CMD_NONE, while the response comes back. The response starts with
+ * the position, see OrbisPositionDecode(), followed by the data asked for by the command, if any,
+ * and ends with the CRC of the rest, inverted. The layout is fixed by the encoder variant in
+ * orbis_protocol.h.
+ *
+ * This is the part of the driver that has nothing to do with the McSPI: how a frame is made
+ * up, checked and decoded. The bare-metal driver (orbis.c) moves the frames through the McSPI
+ * FIFOs, the Linux spidev backend (linux/orbis_spidev.c) through the kernel, and both
+ * leave the rest to the functions here. OrbisCRCInit() must have been called before any
+ * frame is validated.
+ *
+ *  Created on: 16 Oct 2026
+ */
+#include <stdint.h>
+#include "orbis_protocol.h"
+#include "orbis_crc.h"
+#include "orbis_memory.h"
+
+// The CRC check of the acquisition runs in the capture interrupt path, from OCMC RAM in the
+// performance build profile, see orbis_memory.c
+#if ORBIS_PERFORMANCE && defined(__TI_COMPILER_VERSION__)
+#pragma CODE_SECTION(OrbisFrameValidate, ORBIS_SECTION_FAST_TEXT)
+#endif
+
+// Command and frame length of each request, indexed by ORBIS_REQ_...
+const OrbisFrameFormat orbisFrames[ORBIS_REQ_COUNT] = {
+    { ORBIS_CMD_NONE,        ORBIS_LENGTH_POSITION },
+    { ORBIS_CMD_SERIAL,      ORBIS_LENGTH_SERIAL },
+    { ORBIS_CMD_SPEED,       ORBIS_LENGTH_SPEED },
+    { ORBIS_CMD_TEMPERATURE, ORBIS_LENGTH_TEMPERATURE },
+    { ORBIS_CMD_STATUS,      ORBIS_LENGTH_STATUS }
+};
+
+//
+// Put together the frame sent for the request: the command byte, then ORBIS_CMD_NONE
+// up to the length of the response. tx must have room for ORBIS_SIZE_BUFFER bytes.
+//
+// Returns the length of the frame.
+//
+uint32_t OrbisFrameRequest(uint8_t request, uint8_t* tx)
+{
+    uint32_t length = orbisFrames[request].length;
+
+    tx[0] = orbisFrames[request].command;
+    for (uint32_t i = 1; i < length; i++)
+        tx[i] = ORBIS_CMD_NONE;
+
+    return length;
+}
+
+//
+// Check the CRC in the last byte of a response of length bytes against the rest of it.
+//
+// Returns ORBIS_CRC_OK if they match, ORBIS_CRC_FAIL otherwise.
+//
+uint8_t OrbisFrameValidate(const volatile uint8_t* frame, uint32_t length)
+{
+    uint8_t receivedCRC = (uint8_t) ~frame[length - 1];
+
+    return (receivedCRC == OrbisCRCFrame(frame, length - 1)) ? ORBIS_CRC_OK : ORBIS_CRC_FAIL;
+}
+
+//
+// Decode the position part of a response: the turn count, if multi-turn, and the position
+// word. The layout is fixed by the encoder variant in orbis_protocol.h, so there is nothing
+// to decide here at run time.
+//
+void OrbisPositionDecode(const volatile uint8_t* frame, OrbisPosition* position)
+{
+    uint16_t word = (uint16_t) ((frame[ORBIS_SIZE_TURNS] << 8) | frame[ORBIS_SIZE_TURNS + 1]);
+
+    position->position = (word >> ORBIS_POSITION_SHIFT) & ORBIS_POSITION_MASK;
+    position->error = (word & ORBIS_ERROR_MASK) ? 0 : 1;
+    position->warning = (word & ORBIS_WARNING_MASK) ? 0 : 1;
+#if ORBIS_MULTITURN
+    position->turns = (uint16_t) ((frame[0] << 8) | frame[1]);
+#else
+    position->turns = 0;
+#endif
+}
+
+//
+// Decode the response to the request from the frame. The position comes first, see
+// OrbisPositionDecode(). The data asked for by the command comes right after it,
+// most significant byte first.
+//
+void OrbisDecode(uint8_t request, volatile uint8_t* frame, OrbisResponse* response)
+{
+    OrbisPosition position;
+    volatile uint8_t* data = &frame[ORBIS_SIZE_HEADER];
+
+    OrbisPositionDecode(frame, &position);
+
+    response->request = request;
+    response->position = (uint16_t) position.position;
+    response->turns = (uint16_t) position.turns;
+    response->error = (uint8_t) position.error;
+    response->warning = (uint8_t) position.warning;
+
+    switch (request) {
+    case ORBIS_REQ_SERIAL:
+        for (uint32_t i = 0; i < ORBIS_SIZE_SERIAL; i++)
+            response->data.serial[i] = data[i];
+        break;
+    case ORBIS_REQ_SPEED:
+        response->data.speed = (int16_t) ((data[0] << 8) | data[1]);
+        break;
+    case ORBIS_REQ_TEMPERATURE:
+        response->data.temperature = (int16_t) ((data[0] << 8) | data[1]);
+        break;
+    case ORBIS_REQ_STATUS:
+        response->data.status = data[0];
+        break;
+    default:
+        break;
+    }
+}
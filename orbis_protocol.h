@@ -0,0 +1,136 @@
+/*
+ * orbis_protocol.h
+ * Orbis SPI protocol: commands, frame layout, CRC check and decoding
+ *
+ * The functions and global data structures are documented
+ * in the source code file to avoid saying the same thing twice.
+ * Use the source code file as a primary reference.
+ *
+ * Nothing here depends on the McSPI or on StarterWare, so the protocol layer is shared
+ * by the bare-metal driver (orbis.h) and the Linux spidev backend (linux/orbis_spidev.h).
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#ifndef ORBIS_PROTOCOL_H_
+#define ORBIS_PROTOCOL_H_
+
+#include <stdint.h>
+
+#define ORBIS_CRC_OK    0u
+#define ORBIS_CRC_FAIL  1u
+#define ORBIS_TIMEOUT   2u
+
+//
+// Orbis command set
+//
+#define ORBIS_CMD_NONE          0x00u
+#define ORBIS_CMD_SERIAL        0x76u
+#define ORBIS_CMD_SPEED         0x73u
+#define ORBIS_CMD_TEMPERATURE   0x74u
+#define ORBIS_CMD_STATUS        0x64u
+
+//
+// The sizes of parts of responses supported by Orbis,
+// both single- and multi- turn. In bytes. Each byte is 8 bits.
+// This information closely follows page 14 of Orbis datasheet.
+//
+#define ORBIS_SIZE_MULTITURN     2
+#define ORBIS_SIZE_POSITION      2
+#define ORBIS_SIZE_SERIAL        6
+#define ORBIS_SIZE_SPEED         2
+#define ORBIS_SIZE_TEMPERATURE   2
+#define ORBIS_SIZE_STATUS        1
+#define ORBIS_SIZE_CRC           1
+
+//
+// Encoder variant, fixed at compile time. Every response starts with the turn count
+// (multi-turn only), then the position word: the position left-aligned in ORBIS_RESOLUTION
+// bits, followed by the error and warning bits, both active low. The frame lengths,
+// transfer levels and masks below all follow from this description.
+//
+#ifndef ORBIS_MULTITURN
+#define ORBIS_MULTITURN                      0
+#endif
+#ifndef ORBIS_RESOLUTION
+#define ORBIS_RESOLUTION                    14
+#endif
+#ifndef ORBIS_STATUS_ERROR_BIT
+#define ORBIS_STATUS_ERROR_BIT               1
+#endif
+#ifndef ORBIS_STATUS_WARNING_BIT
+#define ORBIS_STATUS_WARNING_BIT             0
+#endif
+
+#if ORBIS_RESOLUTION < 8 || ORBIS_RESOLUTION > 14
+#error "ORBIS_RESOLUTION must be between 8 and 14 bits"
+#endif
+
+#if ORBIS_MULTITURN
+#define ORBIS_SIZE_TURNS         ORBIS_SIZE_MULTITURN
+#else
+#define ORBIS_SIZE_TURNS         0
+#endif
+#define ORBIS_SIZE_HEADER        (ORBIS_SIZE_TURNS + ORBIS_SIZE_POSITION)
+#define ORBIS_SIZE_BUFFER        (ORBIS_SIZE_HEADER + ORBIS_SIZE_SERIAL + ORBIS_SIZE_CRC)
+
+#define ORBIS_TURN_BITS          (8 * ORBIS_SIZE_TURNS)
+#define ORBIS_POSITION_SHIFT     (16 - ORBIS_RESOLUTION)
+#define ORBIS_POSITION_MASK      ((1u << ORBIS_RESOLUTION) - 1u)
+#define ORBIS_ERROR_MASK         (1u << ORBIS_STATUS_ERROR_BIT)
+#define ORBIS_WARNING_MASK       (1u << ORBIS_STATUS_WARNING_BIT)
+
+//
+// Requests, each a command and the response it brings. These index orbisFrames[],
+// and the driver's orbisXferLevels[].
+//
+#define ORBIS_REQ_POSITION       0u
+#define ORBIS_REQ_SERIAL         1u
+#define ORBIS_REQ_SPEED          2u
+#define ORBIS_REQ_TEMPERATURE    3u
+#define ORBIS_REQ_STATUS         4u
+#define ORBIS_REQ_COUNT          5u
+
+// Frame length of each request, in bytes: the response, CRC included, and so the whole transfer
+#define ORBIS_LENGTH_POSITION    (ORBIS_SIZE_HEADER + ORBIS_SIZE_CRC)
+#define ORBIS_LENGTH_SERIAL      (ORBIS_SIZE_HEADER + ORBIS_SIZE_SERIAL + ORBIS_SIZE_CRC)
+#define ORBIS_LENGTH_SPEED       (ORBIS_SIZE_HEADER + ORBIS_SIZE_SPEED + ORBIS_SIZE_CRC)
+#define ORBIS_LENGTH_TEMPERATURE (ORBIS_SIZE_HEADER + ORBIS_SIZE_TEMPERATURE + ORBIS_SIZE_CRC)
+#define ORBIS_LENGTH_STATUS      (ORBIS_SIZE_HEADER + ORBIS_SIZE_STATUS + ORBIS_SIZE_CRC)
+
+typedef struct {
+    uint8_t command;                       // Command byte sent to Orbis
+    uint8_t length;                        // Response length, including the CRC
+} OrbisFrameFormat;
+
+// Position part of a response, packed into 32 bits by OrbisPositionDecode()
+typedef struct {
+    uint32_t position : ORBIS_RESOLUTION;  // Single-turn position
+    uint32_t error    : 1;                 // 1 if Orbis reports an error, the position is not valid then
+    uint32_t warning  : 1;                 // 1 if Orbis reports a warning, the position is still valid
+    uint32_t turns    : 16;                // Turn count, 0 for single-turn
+} OrbisPosition;
+
+// Response decoded by OrbisDecode(). Which member of data is valid depends on the request.
+typedef struct {
+    uint8_t request;                       // ORBIS_REQ_...
+    uint8_t error;                         // 1 if Orbis reports an error, the position is not valid then
+    uint8_t warning;                       // 1 if Orbis reports a warning, the position is still valid
+    uint16_t position;                     // Single-turn position, ORBIS_RESOLUTION bits
+    uint16_t turns;                        // Turn count, 0 for single-turn
+    union {
+        uint8_t serial[ORBIS_SIZE_SERIAL]; // Serial number, as sent
+        int16_t speed;                     // Signed speed, in the units of the datasheet
+        int16_t temperature;               // Signed temperature, in the units of the datasheet
+        uint8_t status;                    // Detailed status bits
+    } data;
+} OrbisResponse;
+
+extern const OrbisFrameFormat orbisFrames[ORBIS_REQ_COUNT];
+
+uint32_t OrbisFrameRequest(uint8_t request, uint8_t* tx);
+uint8_t OrbisFrameValidate(const volatile uint8_t* frame, uint32_t length);
+void OrbisDecode(uint8_t request, volatile uint8_t* frame, OrbisResponse* response);
+void OrbisPositionDecode(const volatile uint8_t* frame, OrbisPosition* position);
+
+#endif /* ORBIS_PROTOCOL_H_ */
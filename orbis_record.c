@@ -0,0 +1,167 @@
+/*
+ * orbis_record.c
+ * Recorder of raw Orbis frames, for offline analysis
+ *
+ * The counters say how many captures have failed, not what came over the wire. The recorder
+ * keeps the last ORBIS_RECORD_FRAMES responses as they were read from the FIFO, with their
+ * length, the time of the capture, the CRC verdict and the encoder they came from, so that
+ * a failure in the field can be looked at afterwards, see host/orbis_replay.c.
+ *
+ * Every capture goes through OrbisRecordCapture(): the completed ones from
+ * OrbisCaptureComplete(), in the interrupt handler, whichever way they were captured, and the
+ * ones that have timed out from OrbisBusPoll(). Nothing is recorded until OrbisRecordStart().
+ *
+ * In the continuous mode the recording keeps going and holds the latest frames. In the triggered
+ * mode it stops by itself some frames after the first failure, a CRC error or a timeout, so
+ * that the frames before and after it are kept for as long as it takes to collect them.
+ *
+ * The recording is kept in memory in the recording format, see orbis_record.h. OrbisRecordDump()
+ * prints it to the console in hex, or it can be saved from the debugger as it is: the header
+ * and the first OrbisRecordLength() bytes of orbisRecording.
+ *
+ *  Created on: 16 Oct 2026
+ */
+#include <stdint.h>
+#include <stddef.h>
+#include "consoleUtils.h"
+#include "interrupt.h"
+#include "orbis.h"
+#include "orbis_memory.h"
+#include "orbis_record.h"
+
+#if ORBIS_RECORD
+
+// The recorder runs in the capture interrupt path, from OCMC RAM in the performance build profile
+#if ORBIS_PERFORMANCE && defined(__TI_COMPILER_VERSION__)
+#pragma CODE_SECTION(OrbisRecordCapture, ORBIS_SECTION_FAST_TEXT)
+#endif
+
+// The recording format is the memory layout, so the structures must not be padded
+typedef char OrbisRecordHeaderSizeCheck[(sizeof(OrbisRecordHeader) == ORBIS_RECORD_HEADER_SIZE) ? 1 : -1];
+typedef char OrbisRecordFrameSizeCheck[(sizeof(OrbisRecordFrame) == ORBIS_RECORD_FRAME_SIZE) ? 1 : -1];
+
+// Bytes of the dump on each line
+#define ORBIS_RECORD_DUMP_LINE              32u
+
+OrbisRecording orbisRecording;
+
+// Frames to keep after the failure in the triggered mode
+static uint32_t orbisRecordAfter;
+
+//
+// Start a new recording. In the continuous mode (ORBIS_RECORD_CONTINUOUS) it goes on until
+// OrbisRecordStop(). In the triggered mode (ORBIS_RECORD_TRIGGERED) it stops by itself after
+// the first failure and after more frames, at most ORBIS_RECORD_FRAMES - 1, which leaves
+// the rest of the recording to the frames before the failure.
+//
+void OrbisRecordStart(uint8_t mode, uint32_t after)
+{
+    OrbisRecordHeader* header = &orbisRecording.header;
+    unsigned char irq = IntDisable();
+
+    header->magic = ORBIS_RECORD_MAGIC;
+    header->version = ORBIS_RECORD_VERSION;
+    header->frameSize = ORBIS_RECORD_FRAME_SIZE;
+    header->capacity = ORBIS_RECORD_FRAMES;
+    header->written = 0;
+    header->trigger = ORBIS_RECORD_NO_TRIGGER;
+    header->resolution = ORBIS_RESOLUTION;
+    header->multiturn = ORBIS_MULTITURN;
+    header->mode = mode;
+    header->state = ORBIS_RECORD_RUNNING;
+
+    orbisRecordAfter = (after < ORBIS_RECORD_FRAMES) ? after : ORBIS_RECORD_FRAMES - 1;
+
+    IntEnable(irq);
+}
+
+// Stop the recording, and keep what has been recorded
+void OrbisRecordStop(void)
+{
+    if (orbisRecording.header.state == ORBIS_RECORD_RUNNING)
+        orbisRecording.header.state = ORBIS_RECORD_STOPPED;
+}
+
+//
+// Record the capture of the encoder with the verdict on it, ORBIS_CRC_OK, ORBIS_CRC_FAIL or
+// ORBIS_TIMEOUT. The frame is the response, NULL if it has timed out. Called by the driver,
+// see ORBIS_RECORD_CAPTURE().
+//
+void OrbisRecordCapture(const OrbisEncoder* encoder, const volatile uint8_t* frame, uint8_t verdict)
+{
+    OrbisRecordHeader* header = &orbisRecording.header;
+    OrbisRecordFrame* record;
+    uint32_t length;
+    unsigned char irq;
+
+    if (header->state != ORBIS_RECORD_RUNNING)
+        return;
+
+    // From the interrupt handler or, for a timeout, from the application
+    irq = IntDisable();
+
+    record = &orbisRecording.frames[header->written % ORBIS_RECORD_FRAMES];
+    length = (frame == NULL) ? 0 : encoder->dataRxLength;
+
+    record->timestamp = encoder->captureStartTime;
+    record->verdict = verdict;
+    record->length = (uint8_t) length;
+    record->source = ORBIS_RECORD_SOURCE(encoder->bus - orbisBus, encoder->channel);
+    record->request = encoder->request;
+    for (uint32_t i = 0; i < length; i++)
+        record->data[i] = frame[i];
+
+    if (ORBIS_RECORD_TRIGGERED == header->mode) {
+        if (header->trigger == ORBIS_RECORD_NO_TRIGGER && verdict != ORBIS_CRC_OK)
+            header->trigger = header->written;
+        if (header->trigger != ORBIS_RECORD_NO_TRIGGER && header->written - header->trigger >= orbisRecordAfter)
+            header->state = ORBIS_RECORD_DONE;
+    }
+
+    header->written++;
+
+    IntEnable(irq);
+}
+
+// Length of the recording in bytes: the header and the frames written, up to the capacity
+uint32_t OrbisRecordLength(void)
+{
+    uint32_t written = orbisRecording.header.written;
+
+    return ORBIS_RECORD_HEADER_SIZE +
+           ((written < ORBIS_RECORD_FRAMES) ? written : ORBIS_RECORD_FRAMES) * ORBIS_RECORD_FRAME_SIZE;
+}
+
+//
+// Stop the recording and print it to the console in hex, ORBIS_RECORD_DUMP_LINE bytes to
+// a line, between a line starting with "# recording" and one with "# end". The lines in between
+// converted back to binary, e.g. with xxd -r -p, are the recording.
+//
+void OrbisRecordDump(void)
+{
+    static const char digits[] = "0123456789abcdef";
+    const uint8_t* image = (const uint8_t*) &orbisRecording;
+    uint32_t length;
+    char line[2 * ORBIS_RECORD_DUMP_LINE + 1];
+
+    OrbisRecordStop();
+    length = OrbisRecordLength();
+
+    ConsoleUtilsPrintf("# recording, %u frames written, %u bytes\n", orbisRecording.header.written, length);
+
+    for (uint32_t offset = 0; offset < length; offset += ORBIS_RECORD_DUMP_LINE) {
+        uint32_t n = (length - offset < ORBIS_RECORD_DUMP_LINE) ? length - offset : ORBIS_RECORD_DUMP_LINE;
+
+        for (uint32_t i = 0; i < n; i++) {
+            line[2 * i] = digits[image[offset + i] >> 4];
+            line[2 * i + 1] = digits[image[offset + i] & 0x0Fu];
+        }
+        line[2 * n] = '\0';
+
+        ConsoleUtilsPrintf("%s\n", line);
+    }
+
+    ConsoleUtilsPrintf("# end\n");
+}
+
+#endif
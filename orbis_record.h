@@ -0,0 +1,121 @@
+/*
+ * orbis_record.h
+ * Recorder of raw Orbis frames, for offline analysis
+ *
+ * The functions and global data structures are documented
+ * in the source code file to avoid saying the same thing twice.
+ * Use the source code file as a primary reference.
+ *
+ * The recording format is defined here, as the host replay tool shares it.
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#ifndef ORBIS_RECORD_H_
+#define ORBIS_RECORD_H_
+
+#include <stdint.h>
+#include "orbis.h"
+
+// Capture recorder. When 0, the driver has no hooks and there is no recording.
+#ifndef ORBIS_RECORD
+#define ORBIS_RECORD                         1
+#endif
+
+// Frames the recording holds, the oldest are overwritten after that
+#ifndef ORBIS_RECORD_FRAMES
+#define ORBIS_RECORD_FRAMES               1024u
+#endif
+
+//
+// Recording format. A recording is
+//
+//   header (24) | frames (20 each)
+//
+// and the header is
+//
+//   magic (4) | version (2) | frame size (2) | capacity (4) | written (4) | trigger (4) |
+//   resolution (1) | multi-turn (1) | mode (1) | state (1)
+//
+// and a frame is
+//
+//   timestamp (4) | verdict (1) | length (1) | source (1) | request (1) | data (12)
+//
+// Multi-byte fields are little-endian, as the target keeps them in memory. The frames are
+// a ring of capacity frames, of which written have been written so far: the oldest frame
+// is at written % capacity once the ring has wrapped, at 0 before that. Only the frames
+// written are in the recording, never more than capacity. Trigger is the frame number (counted
+// as written) of the failure that stopped a triggered recording, ORBIS_RECORD_NO_TRIGGER if none.
+//
+// The timestamp is the DMTimer4 time of the CS assertion, the verdict is ORBIS_CRC_OK,
+// ORBIS_CRC_FAIL or ORBIS_TIMEOUT, and data is the response as read from the FIFO, CRC
+// included, length bytes of it. A capture that has timed out has no data.
+//
+#define ORBIS_RECORD_MAGIC          0x5242524Fu     // "ORBR"
+#define ORBIS_RECORD_VERSION                 1u
+#define ORBIS_RECORD_HEADER_SIZE            24u
+#define ORBIS_RECORD_FRAME_SIZE             20u
+#define ORBIS_RECORD_DATA_SIZE              12u
+#define ORBIS_RECORD_NO_TRIGGER     0xFFFFFFFFu
+
+// Source of a frame: the McSPI module in the high nibble, the chip select in the low one
+#define ORBIS_RECORD_SOURCE(bus, channel)   ((uint8_t) (((bus) << 4) | ((channel) & 0x0Fu)))
+#define ORBIS_RECORD_BUS(source)            ((source) >> 4)
+#define ORBIS_RECORD_CHANNEL(source)        ((source) & 0x0Fu)
+
+#if ORBIS_SIZE_BUFFER > ORBIS_RECORD_DATA_SIZE
+#error "The longest Orbis response does not fit in a recorded frame"
+#endif
+
+// Recording modes, see OrbisRecordStart()
+#define ORBIS_RECORD_CONTINUOUS              0u
+#define ORBIS_RECORD_TRIGGERED               1u
+
+// Recorder states
+#define ORBIS_RECORD_STOPPED                 0u
+#define ORBIS_RECORD_RUNNING                 1u
+#define ORBIS_RECORD_DONE                    2u     // Triggered, and the frames after the failure are in
+
+typedef struct {
+    uint32_t timestamp;
+    uint8_t verdict;
+    uint8_t length;
+    uint8_t source;
+    uint8_t request;
+    uint8_t data[ORBIS_RECORD_DATA_SIZE];
+} OrbisRecordFrame;
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t frameSize;
+    uint32_t capacity;
+    volatile uint32_t written;
+    volatile uint32_t trigger;
+    uint8_t resolution;
+    uint8_t multiturn;
+    uint8_t mode;
+    volatile uint8_t state;
+} OrbisRecordHeader;
+
+// The recording as it is kept in memory, which is the recording format
+typedef struct {
+    OrbisRecordHeader header;
+    OrbisRecordFrame frames[ORBIS_RECORD_FRAMES];
+} OrbisRecording;
+
+#if ORBIS_RECORD
+#define ORBIS_RECORD_CAPTURE(encoder, frame, verdict)   OrbisRecordCapture(encoder, frame, verdict)
+#else
+#define ORBIS_RECORD_CAPTURE(encoder, frame, verdict)
+#endif
+
+extern OrbisRecording orbisRecording;
+
+void OrbisRecordStart(uint8_t mode, uint32_t after);
+void OrbisRecordStop(void);
+void OrbisRecordCapture(const OrbisEncoder* encoder, const volatile uint8_t* frame, uint8_t verdict);
+uint32_t OrbisRecordLength(void);
+void OrbisRecordDump(void);
+
+#endif /* ORBIS_RECORD_H_ */
@@ -0,0 +1,157 @@
+/*
+ * orbis_recovery.c
+ * Capture failure recovery for the Orbis rotary encoder driver
+ *
+ * OrbisEncoderCaptureGet() reports a failed capture and leaves the corrupted frame in dataRx
+ * for the caller to deal with. OrbisRecoveryCapture() deals with it instead, and only ever
+ * hands out a good position:
+ *
+ *   - a capture that fails the CRC check, times out or has the Orbis error bit set is retried
+ *     straight away, as long as the latency budget of the capture allows. Each attempt gets
+ *     no more than the budget has left, so the whole capture never takes much longer than
+ *     the budget, whatever the encoder does.
+ *
+ *   - when the budget runs out, the last good position is held and handed out again, flagged
+ *     as such and with its age, so the caller can tell how stale it is.
+ *
+ *   - after escalateAfter consecutive failed captures the failure is escalated: the sample is
+ *     flagged, and stays flagged until a capture succeeds. What to do about it is up to the
+ *     caller; main.c reports it and leaves the clock to the watchdog, see orbis_calib.c.
+ *
+ * Every failed attempt is counted by its class: CRC, timeout, or the Orbis error bit. The
+ * warning bit is counted too, but the position is still good with it.
+ *
+ * The attempts use the blocking capture backend of the build, interrupt-driven or polled.
+ *
+ *  Created on: 16 Oct 2026
+ */
+#include <stdint.h>
+#include "consoleUtils.h"
+#include "orbis.h"
+#include "orbis_recovery.h"
+#include "util.h"
+
+//
+// Set up the recovery of the encoder: the attempts of each capture have budget DMTimer4 ticks
+// between them, and escalateAfter consecutive failed captures escalate. The budget should fit
+// at least one frame at the encoder's clock, or no capture will ever succeed.
+//
+void OrbisRecoveryInit(OrbisRecovery* recovery, OrbisEncoder* encoder, uint32_t budget,
+                       uint32_t escalateAfter)
+{
+    OrbisRecoveryStats zero = { 0 };
+    OrbisPosition none = { 0 };
+
+    recovery->encoder = encoder;
+    recovery->budget = budget;
+    recovery->escalateAfter = escalateAfter;
+    recovery->consecutive = 0;
+    recovery->hasGood = 0;
+    recovery->good = none;
+    recovery->goodTime = 0;
+    recovery->stats = zero;
+}
+
+//
+// Capture the position from the encoder, retrying within the budget, and fill in the sample
+// with a fresh position, the last good one held, or nothing if there has never been a good one.
+// Must not be called while the encoder has a capture in progress.
+//
+// Returns the state of the sample, ORBIS_RECOVERY_FRESH, ORBIS_RECOVERY_HELD or ORBIS_RECOVERY_NONE.
+//
+uint8_t OrbisRecoveryCapture(OrbisRecovery* recovery, OrbisRecoverySample* sample)
+{
+    OrbisEncoder* encoder = recovery->encoder;
+    OrbisRecoveryStats* stats = &recovery->stats;
+    uint32_t start = TIME;
+    uint32_t elapsed = 0;
+    uint8_t attempts = 0;
+
+    stats->captures++;
+
+    do {
+        uint32_t timeout = recovery->budget - elapsed;
+        uint8_t result = ORBIS_TIMEOUT;
+        OrbisPosition position;
+
+        if (timeout > ORBIS_CAPTURE_TIMEOUT_DEFAULT)
+            timeout = ORBIS_CAPTURE_TIMEOUT_DEFAULT;
+
+        if (attempts > 0)
+            stats->retries++;
+
+        if (OrbisEncoderRequestWait(encoder, ORBIS_REQ_POSITION, timeout) == ORBIS_CAPTURE_DONE)
+            result = encoder->captureCRC;
+
+        if (attempts++ == 0)
+            sample->firstResult = result;
+
+        if (ORBIS_TIMEOUT == result) {
+            stats->timeouts++;
+        } else if (ORBIS_CRC_OK != result) {
+            stats->crcErrors++;
+        } else {
+            OrbisPositionDecode(encoder->dataRx, &position);
+
+            if (position.warning)
+                stats->encoderWarnings++;
+
+            if (!position.error) {
+                recovery->good = position;
+                recovery->goodTime = encoder->captureStartTime;
+                recovery->hasGood = 1;
+                recovery->consecutive = 0;
+
+                stats->fresh++;
+                if (attempts > 1)
+                    stats->recovered++;
+
+                sample->state = ORBIS_RECOVERY_FRESH;
+                sample->escalated = 0;
+                sample->attempts = attempts;
+                sample->position = position;
+                sample->timestamp = recovery->goodTime;
+                sample->age = TIME - recovery->goodTime;
+                return sample->state;
+            }
+
+            stats->encoderErrors++;
+        }
+
+        elapsed = TIME - start;
+    } while (elapsed < recovery->budget);
+
+    // Out of budget, fall back on the last good position
+    recovery->consecutive++;
+    if (recovery->consecutive == recovery->escalateAfter)
+        stats->escalations++;
+
+    sample->escalated = (recovery->consecutive >= recovery->escalateAfter);
+    sample->attempts = attempts;
+    sample->position = recovery->good;
+    sample->timestamp = recovery->goodTime;
+    sample->age = TIME - recovery->goodTime;
+
+    if (recovery->hasGood) {
+        stats->held++;
+        sample->state = ORBIS_RECOVERY_HELD;
+    } else {
+        stats->none++;
+        sample->state = ORBIS_RECOVERY_NONE;
+    }
+
+    return sample->state;
+}
+
+// Print the counters to the console
+void OrbisRecoveryReport(const OrbisRecovery* recovery)
+{
+    const OrbisRecoveryStats* stats = &recovery->stats;
+
+    ConsoleUtilsPrintf("Orbis recovery: %u captures, %u fresh (%u after a retry), %u held, %u none, "
+                       "%u escalations\n", stats->captures, stats->fresh, stats->recovered, stats->held,
+                       stats->none, stats->escalations);
+    ConsoleUtilsPrintf("Orbis failed attempts: %u CRC, %u timeout, %u encoder error; %u warnings, "
+                       "%u retries\n", stats->crcErrors, stats->timeouts, stats->encoderErrors,
+                       stats->encoderWarnings, stats->retries);
+}
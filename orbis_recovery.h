@@ -0,0 +1,78 @@
+/*
+ * orbis_recovery.h
+ * Capture failure recovery for the Orbis rotary encoder driver
+ *
+ * The functions and global data structures are documented
+ * in the source code file to avoid saying the same thing twice.
+ * Use the source code file as a primary reference.
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#ifndef ORBIS_RECOVERY_H_
+#define ORBIS_RECOVERY_H_
+
+#include <stdint.h>
+#include "orbis.h"
+#include "util.h"
+
+// Time allowed for the attempts of one capture, from the start of the first, in DMTimer4 ticks.
+// A position frame at 3 MHz takes about 15 us, so this leaves room for two retries.
+#ifndef ORBIS_RECOVERY_BUDGET_DEFAULT
+#define ORBIS_RECOVERY_BUDGET_DEFAULT        (5 * TIMER_10US)
+#endif
+
+// Consecutive failed captures after which the failure is escalated
+#ifndef ORBIS_RECOVERY_ESCALATE_DEFAULT
+#define ORBIS_RECOVERY_ESCALATE_DEFAULT      10u
+#endif
+
+// What OrbisRecoveryCapture() has to offer
+#define ORBIS_RECOVERY_FRESH                 0u    // A position captured just now
+#define ORBIS_RECOVERY_HELD                  1u    // The last good position, captured age ticks ago
+#define ORBIS_RECOVERY_NONE                  2u    // No good position yet, the position is not valid
+
+// Counters of OrbisRecovery, by capture and by failed attempt
+typedef struct {
+    uint32_t captures;                     // Calls to OrbisRecoveryCapture()
+    uint32_t fresh;                        // ... with a fresh position
+    uint32_t recovered;                    // ... of them after a retry
+    uint32_t held;                         // ... with the last good position held
+    uint32_t none;                         // ... with no good position to hold
+    uint32_t escalations;                  // Times the consecutive failures reached the limit
+    uint32_t retries;                      // Attempts after the first one
+    uint32_t crcErrors;                    // Attempts failed on CRC
+    uint32_t timeouts;                     // Attempts timed out
+    uint32_t encoderErrors;                // Attempts with the error bit set by Orbis
+    uint32_t encoderWarnings;              // Attempts with the warning bit set, the position is good
+} OrbisRecoveryStats;
+
+// Recovery state of an encoder, see OrbisRecoveryInit()
+typedef struct {
+    OrbisEncoder* encoder;
+    uint32_t budget;                       // DMTimer4 ticks for the attempts of a capture
+    uint32_t escalateAfter;                // Consecutive failed captures that escalate
+    uint32_t consecutive;                  // Failed captures since the last good one
+    uint8_t hasGood;                       // 1 once there is a good position to hold
+    OrbisPosition good;                    // The last good position
+    uint32_t goodTime;                     // ... and its DMTimer4 timestamp
+    OrbisRecoveryStats stats;
+} OrbisRecovery;
+
+// Position handed out by OrbisRecoveryCapture()
+typedef struct {
+    uint8_t state;                         // ORBIS_RECOVERY_...
+    uint8_t escalated;                     // 1 while the consecutive failures are at the limit or over
+    uint8_t attempts;                      // Attempts made
+    uint8_t firstResult;                   // Result of the first attempt, for OrbisWatchdogUpdate()
+    OrbisPosition position;                // Not valid with ORBIS_RECOVERY_NONE
+    uint32_t timestamp;                    // DMTimer4 time the position was latched
+    uint32_t age;                          // DMTimer4 ticks since then
+} OrbisRecoverySample;
+
+void OrbisRecoveryInit(OrbisRecovery* recovery, OrbisEncoder* encoder, uint32_t budget,
+                       uint32_t escalateAfter);
+uint8_t OrbisRecoveryCapture(OrbisRecovery* recovery, OrbisRecoverySample* sample);
+void OrbisRecoveryReport(const OrbisRecovery* recovery);
+
+#endif /* ORBIS_RECOVERY_H_ */
@@ -0,0 +1,109 @@
+/*
+ * orbis_ring.c
+ * Lock-free single-producer/single-consumer ring buffer of timestamped Orbis samples
+ *
+ * The producer is the interrupt handler which completes the capture; it writes the
+ * response straight into a slot obtained with OrbisRingSlotAcquire() and publishes it
+ * with OrbisRingSlotCommit(). The consumer is the application, which drains the samples
+ * in batches with OrbisRingRead().
+ *
+ * The head index is only ever written by the producer and the tail index only by the
+ * consumer, so no locking is needed. Both indices run freely and wrap around at 2^32;
+ * their difference is the number of samples in the buffer. The slots and the indices
+ * are volatile, so the compiler keeps the slot writes ahead of the head update, which
+ * is all the ordering a single core needs.
+ *
+ * When the buffer is full, the new sample is dropped (the unread ones are kept) and
+ * counted in orbisRingOverruns.
+ *
+ *  Created on: 16 Oct 2026
+ */
+#include <stdint.h>
+#include <stddef.h>
+#include "orbis.h"
+#include "orbis_ring.h"
+#include "orbis_memory.h"
+
+// Sample storage. Kept uncached when EDMA3 may fill it with the caches on, see orbis_memory.c
+#if ORBIS_PERFORMANCE && ORBIS_USE_EDMA && defined(__TI_COMPILER_VERSION__)
+#pragma DATA_SECTION(orbisRing, ORBIS_SECTION_DMA)
+#endif
+static volatile OrbisSample orbisRing[ORBIS_RING_SIZE];
+
+// Index of the next slot to be written (producer) and read (consumer)
+static volatile uint32_t orbisRingHead;
+static volatile uint32_t orbisRingTail;
+
+// Number of samples dropped because the consumer did not keep up
+volatile uint32_t orbisRingOverruns;
+
+// Empty the buffer and clear the overrun counter. Not to be called while the producer is active.
+void OrbisRingReset(void)
+{
+    orbisRingHead = 0;
+    orbisRingTail = 0;
+    orbisRingOverruns = 0;
+}
+
+//
+// Producer: get the slot for the next sample. The slot is not visible to the consumer
+// until OrbisRingSlotCommit() is called. Returns NULL, and counts an overrun, if the
+// buffer is full.
+//
+volatile OrbisSample* OrbisRingSlotAcquire(void)
+{
+    uint32_t head = orbisRingHead;
+
+    if ((head - orbisRingTail) >= ORBIS_RING_SIZE) {
+        orbisRingOverruns++;
+        return NULL;
+    }
+
+    return &orbisRing[head & ORBIS_RING_MASK];
+}
+
+// Producer: publish the sample written into the slot from OrbisRingSlotAcquire()
+void OrbisRingSlotCommit(void)
+{
+    orbisRingHead = orbisRingHead + 1;
+}
+
+// Consumer: the number of samples waiting to be read
+uint32_t OrbisRingCount(void)
+{
+    return orbisRingHead - orbisRingTail;
+}
+
+//
+// Consumer: copy up to maxCount oldest samples into the samples array and release their slots.
+// Returns the number of samples copied.
+//
+uint32_t OrbisRingRead(OrbisSample* samples, uint32_t maxCount)
+{
+    uint32_t tail = orbisRingTail;
+    uint32_t count = orbisRingHead - tail;
+
+    if (count > maxCount)
+        count = maxCount;
+
+    for (uint32_t i = 0; i < count; i++) {
+        volatile OrbisSample* slot = &orbisRing[(tail + i) & ORBIS_RING_MASK];
+
+        samples[i].timestamp = slot->timestamp;
+        samples[i].position = slot->position;
+        samples[i].turns = slot->turns;
+        samples[i].error = slot->error;
+        samples[i].warning = slot->warning;
+        samples[i].length = slot->length;
+        samples[i].crc = slot->crc;
+        samples[i].velocity = slot->velocity;
+        samples[i].acceleration = slot->acceleration;
+        for (uint32_t j = 0; j < ORBIS_SIZE_BUFFER; j++)
+            samples[i].data[j] = slot->data[j];
+    }
+
+    // Only now can the producer reuse the slots
+    orbisRingTail = tail + count;
+
+    return count;
+}
@@ -0,0 +1,45 @@
+/*
+ * orbis_ring.h
+ * Lock-free single-producer/single-consumer ring buffer of timestamped Orbis samples
+ *
+ * The functions and global data structures are documented
+ * in the source code file to avoid saying the same thing twice.
+ * Use the source code file as a primary reference.
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#ifndef ORBIS_RING_H_
+#define ORBIS_RING_H_
+
+#include <stdint.h>
+#include "orbis.h"
+
+// Number of samples in the ring buffer. Must be a power of two.
+#ifndef ORBIS_RING_SIZE
+#define ORBIS_RING_SIZE                    256u
+#endif
+#define ORBIS_RING_MASK                    (ORBIS_RING_SIZE - 1u)
+
+typedef struct OrbisSample {
+    uint32_t timestamp;                    // DMTimer4 counter at CS assertion
+    uint16_t position;                     // Single-turn position, if the CRC is OK, else 0
+    uint16_t turns;                        // Turn count, 0 for single-turn, likewise
+    uint8_t error;                         // 1 if Orbis reports an error, the position is not valid then
+    uint8_t warning;                       // 1 if Orbis reports a warning, the position is still valid
+    uint8_t data[ORBIS_SIZE_BUFFER];       // Response as read from the FIFO, including the CRC
+    uint8_t length;                        // Response length, including the CRC
+    uint8_t crc;                           // ORBIS_CRC_OK or ORBIS_CRC_FAIL
+    int32_t velocity;                      // Counts per second, if the encoder has an estimator, else 0
+    int32_t acceleration;                  // Counts per second squared, likewise
+} OrbisSample;
+
+extern volatile uint32_t orbisRingOverruns;
+
+void OrbisRingReset(void);
+volatile OrbisSample* OrbisRingSlotAcquire(void);
+void OrbisRingSlotCommit(void);
+uint32_t OrbisRingCount(void);
+uint32_t OrbisRingRead(OrbisSample* samples, uint32_t maxCount);
+
+#endif /* ORBIS_RING_H_ */
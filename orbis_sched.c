@@ -0,0 +1,191 @@
+/*
+ * orbis_sched.c
+ * Fixed-rate cooperative task scheduler
+ *
+ * The scheduler keeps a tick count, advanced by a DMTimer4 deadline every tickPeriod
+ * DMTimer4 ticks. The deadline is re-armed from its own due time rather than from the time
+ * the callback ran, so the ticks do not drift whatever the interrupt latency.
+ *
+ * Each task is declared with its period and phase in scheduler ticks, and a priority.
+ * OrbisSchedRun() is called over and over from the main loop: it runs the highest priority
+ * task whose release has come, once, and returns, so the priorities are looked at again
+ * after every task. The tasks run to completion in the main loop, not in the interrupt,
+ * and a task is never preempted by another one. A task that has waited for so long that
+ * its next release has come as well runs only once, and the missed release is counted as
+ * an overrun.
+ *
+ * When no task is due, OrbisSchedIdle() sleeps with WFI until the next interrupt, which is
+ * the next tick at the latest, see orbis_load.c.
+ *
+ * For every task the scheduler keeps the execution time and the lateness, from the release
+ * to the start of the run. The spread of the lateness is the release jitter of the task.
+ * All of it is in DMTimer4 ticks.
+ *
+ * The host simulation drives the scheduler from the simulated DMTimer4, see orbis-sim -S.
+ *
+ *  Created on: 16 Oct 2026
+ */
+#include <stdint.h>
+#include <stddef.h>
+#include "consoleUtils.h"
+#include "interrupt.h"
+#include "orbis_load.h"
+#include "orbis_sched.h"
+#include "util.h"
+
+// Set up the scheduler with no tasks and a tick of tickPeriod DMTimer4 ticks
+void OrbisSchedInit(OrbisScheduler* sched, uint32_t tickPeriod)
+{
+    sched->count = 0;
+    sched->tickPeriod = tickPeriod;
+    sched->ticks = 0;
+    sched->seen = 0;
+    sched->startTime = 0;
+    sched->due = 0;
+    sched->tickDeadline.armed = 0;
+}
+
+//
+// Add the task, behind the tasks of the same or higher priority. Must be called before
+// OrbisSchedStart().
+//
+// Returns 1 if the task has been added, 0 if the scheduler is full or the period is 0.
+//
+uint8_t OrbisSchedAdd(OrbisScheduler* sched, OrbisTask* task)
+{
+    uint32_t i;
+
+    if (sched->count == ORBIS_SCHED_TASKS || task->period == 0)
+        return 0;
+
+    for (i = sched->count; i > 0 && sched->tasks[i - 1]->priority > task->priority; i--)
+        sched->tasks[i] = sched->tasks[i - 1];
+
+    sched->tasks[i] = task;
+    sched->count++;
+
+    return 1;
+}
+
+// Advance the tick count, and any ticks that have passed while the interrupt was held up
+static void OrbisSchedTick(void* context)
+{
+    OrbisScheduler* sched = (OrbisScheduler*) context;
+
+    do {
+        sched->ticks++;
+        sched->due += sched->tickPeriod;
+    } while (TIME_REACHED(TIME, sched->due));
+
+    TimerDeadlineArm(&sched->tickDeadline, sched->due, OrbisSchedTick, sched);
+}
+
+// Start the ticks from now, with every task's statistics cleared and its first release at its phase
+void OrbisSchedStart(OrbisScheduler* sched)
+{
+    for (uint32_t i = 0; i < sched->count; i++) {
+        OrbisTask* task = sched->tasks[i];
+
+        task->release = task->phase;
+        task->runs = 0;
+        task->overruns = 0;
+        task->execLast = 0;
+        task->execMax = 0;
+        task->execTotal = 0;
+        task->latenessMin = UINT32_MAX;
+        task->latenessMax = 0;
+    }
+
+    sched->ticks = 0;
+    sched->seen = 0;
+    sched->startTime = TIME;
+    sched->due = sched->startTime + sched->tickPeriod;
+
+    TimerDeadlineArm(&sched->tickDeadline, sched->due, OrbisSchedTick, sched);
+}
+
+void OrbisSchedStop(OrbisScheduler* sched)
+{
+    TimerDeadlineCancel(&sched->tickDeadline);
+}
+
+//
+// Run the highest priority task that is due, if any. Call from the main loop, as often as
+// there is nothing else to do.
+//
+// Returns 1 if a task has run, 0 if none was due.
+//
+uint8_t OrbisSchedRun(OrbisScheduler* sched)
+{
+    uint32_t now = sched->ticks;
+
+    for (uint32_t i = 0; i < sched->count; i++) {
+        OrbisTask* task = sched->tasks[i];
+        uint32_t missed, release, start, lateness;
+
+        if (!TIME_REACHED(now, task->release))
+            continue;
+
+        // Only the latest release is served, the ones before it are overruns
+        missed = (now - task->release) / task->period;
+        release = task->release + missed * task->period;
+        task->overruns += missed;
+        task->release = release + task->period;
+
+        start = TIME;
+        task->function(task->context);
+        task->execLast = TIME - start;
+
+        lateness = start - (sched->startTime + release * sched->tickPeriod);
+
+        task->runs++;
+        task->execTotal += task->execLast;
+        if (task->execLast > task->execMax)
+            task->execMax = task->execLast;
+        if (lateness < task->latenessMin)
+            task->latenessMin = lateness;
+        if (lateness > task->latenessMax)
+            task->latenessMax = lateness;
+
+        return 1;
+    }
+
+    sched->seen = now;
+
+    return 0;
+}
+
+//
+// Sleep until the next interrupt, unless a tick has come since OrbisSchedRun() last found
+// nothing due. Call when OrbisSchedRun() returns 0.
+//
+void OrbisSchedIdle(OrbisScheduler* sched)
+{
+    unsigned char irq = IntDisable();
+
+    if (sched->ticks == sched->seen)
+        OrbisLoadSleep();
+
+    IntEnable(irq);
+}
+
+// Release jitter of the task: the spread of its lateness, in DMTimer4 ticks
+uint32_t OrbisSchedJitter(const OrbisTask* task)
+{
+    return (task->runs == 0) ? 0 : task->latenessMax - task->latenessMin;
+}
+
+// Print the statistics of every task to the console
+void OrbisSchedReport(const OrbisScheduler* sched)
+{
+    ConsoleUtilsPrintf("task\tperiod\truns\toverrun\texec\texecmax\tlatemax\tjitter (DMTimer4 ticks)\n");
+
+    for (uint32_t i = 0; i < sched->count; i++) {
+        const OrbisTask* task = sched->tasks[i];
+
+        ConsoleUtilsPrintf("%s\t%u\t%u\t%u\t%u\t%u\t%u\t%u\n", task->name,
+                           task->period * sched->tickPeriod, task->runs, task->overruns,
+                           (task->runs == 0) ? 0 : (uint32_t) (task->execTotal / task->runs),
+                           task->execMax, task->latenessMax, OrbisSchedJitter(task));
+    }
+}
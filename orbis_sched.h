@@ -0,0 +1,73 @@
+/*
+ * orbis_sched.h
+ * Fixed-rate cooperative task scheduler
+ *
+ * The functions and global data structures are documented
+ * in the source code file to avoid saying the same thing twice.
+ * Use the source code file as a primary reference.
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#ifndef ORBIS_SCHED_H_
+#define ORBIS_SCHED_H_
+
+#include <stdint.h>
+#include "util.h"
+
+// Scheduler tick, in DMTimer4 ticks: 10 kHz
+#ifndef ORBIS_SCHED_TICK_DEFAULT
+#define ORBIS_SCHED_TICK_DEFAULT             TIMER_100US
+#endif
+
+// Tasks a scheduler can hold
+#define ORBIS_SCHED_TASKS                    8u
+
+typedef void (*OrbisTaskFunction)(void* context);
+
+//
+// A periodic task. Fill in the declaration, the rest is kept by the scheduler.
+//
+typedef struct {
+    // Declaration
+    const char* name;
+    OrbisTaskFunction function;
+    void* context;
+    uint32_t period;                       // Scheduler ticks between releases
+    uint32_t phase;                        // Scheduler tick of the first release
+    uint8_t priority;                      // 0 is the highest; tasks due together run in this order
+
+    // State
+    uint32_t release;                      // Scheduler tick of the next release
+
+    // Statistics, in DMTimer4 ticks
+    uint32_t runs;
+    uint32_t overruns;                     // Releases missed, the task was still waiting to run
+    uint32_t execLast;
+    uint32_t execMax;
+    uint64_t execTotal;
+    uint32_t latenessMin;                  // From the release to the start of the run
+    uint32_t latenessMax;
+} OrbisTask;
+
+typedef struct {
+    OrbisTask* tasks[ORBIS_SCHED_TASKS];   // In the order of priority
+    uint32_t count;
+    uint32_t tickPeriod;                   // DMTimer4 ticks per scheduler tick
+    volatile uint32_t ticks;               // Scheduler ticks since OrbisSchedStart()
+    uint32_t seen;                         // ticks when OrbisSchedRun() last found nothing due
+    uint32_t startTime;                    // DMTimer4 time of tick 0
+    uint32_t due;                          // DMTimer4 time of the next tick
+    TimerDeadline tickDeadline;
+} OrbisScheduler;
+
+void OrbisSchedInit(OrbisScheduler* sched, uint32_t tickPeriod);
+uint8_t OrbisSchedAdd(OrbisScheduler* sched, OrbisTask* task);
+void OrbisSchedStart(OrbisScheduler* sched);
+void OrbisSchedStop(OrbisScheduler* sched);
+uint8_t OrbisSchedRun(OrbisScheduler* sched);
+void OrbisSchedIdle(OrbisScheduler* sched);
+uint32_t OrbisSchedJitter(const OrbisTask* task);
+void OrbisSchedReport(const OrbisScheduler* sched);
+
+#endif /* ORBIS_SCHED_H_ */
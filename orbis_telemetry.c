@@ -0,0 +1,225 @@
+/*
+ * orbis_telemetry.c
+ * Binary telemetry of Orbis samples over UART0
+ *
+ * Formatted text cannot keep up with the capture rate, so in telemetry mode the samples
+ * go out as 9-byte binary records, batched into framed and checksummed frames (the format
+ * is in orbis_telemetry.h). host/orbis_decode.c turns the stream back into records.
+ *
+ * OrbisTelemetryPut() only copies the record into the frame being filled and returns,
+ * so it does not hold up the capture loop. A full frame is queued and sent from the UART
+ * Tx FIFO interrupt, ORBIS_TELEMETRY_TX_TRIGGER bytes at a time, while the next one fills.
+ * OrbisTelemetryPoll() sends a part-filled frame whenever the line is idle, so the records
+ * do not wait for a batch to fill at low rates, and batch up when the line is busy.
+ *
+ * Backpressure: when all ORBIS_TELEMETRY_FRAMES frames are queued, the records are dropped,
+ * OrbisTelemetryPut() says so, and the count goes both into orbisTelemetryDropped and into
+ * the next frame, so the receiving end knows too.
+ *
+ * UART0 is the console as well. Once OrbisTelemetrySetup() has been called, the console
+ * must not be written to.
+ *
+ *  Created on: 16 Oct 2026
+ */
+#include <stdint.h>
+#include "hw_types.h"
+#include "soc_AM335x.h"
+#include "interrupt.h"
+#include "uart_irda_cir.h"
+#include "orbis_telemetry.h"
+#include "orbis_load.h"
+
+// Records dropped for want of buffer space, and frames queued, since OrbisTelemetrySetup()
+volatile uint32_t orbisTelemetryDropped;
+volatile uint32_t orbisTelemetryFrames;
+
+static uint8_t orbisTelemetryFrame[ORBIS_TELEMETRY_FRAMES][ORBIS_TELEMETRY_FRAME_MAX];
+static uint32_t orbisTelemetryLength[ORBIS_TELEMETRY_FRAMES];
+
+// Frame being filled and frame being sent. Both run freely; the frames from the tail
+// up to the head are queued for sending.
+static volatile uint32_t orbisTelemetryHead;
+static volatile uint32_t orbisTelemetryTail;
+
+static uint32_t orbisTelemetryRecords;     // Records in the frame being filled
+static uint32_t orbisTelemetryOffset;      // Bytes of the frame at the tail already in the Tx FIFO
+static uint32_t orbisTelemetryLost;        // Records dropped since the last frame
+static uint8_t orbisTelemetrySequence;
+static volatile uint8_t orbisTelemetryBusy;
+
+// Switch UART0 over to the telemetry bit rate with the Tx FIFO interrupt, and start afresh
+void OrbisTelemetrySetup(void)
+{
+    orbisTelemetryHead = 0;
+    orbisTelemetryTail = 0;
+    orbisTelemetryRecords = 0;
+    orbisTelemetryOffset = 0;
+    orbisTelemetryLost = 0;
+    orbisTelemetrySequence = 0;
+    orbisTelemetryBusy = 0;
+    orbisTelemetryDropped = 0;
+    orbisTelemetryFrames = 0;
+
+    UARTIntDisable(ORBIS_TELEMETRY_UART_REGS, UART_INT_THR);
+    UARTOperatingModeSelect(ORBIS_TELEMETRY_UART_REGS, UART_DISABLED_MODE);
+
+    UARTFIFOConfig(ORBIS_TELEMETRY_UART_REGS,
+                   UART_FIFO_CONFIG(UART_TRIG_LVL_GRANULARITY_1, UART_TRIG_LVL_GRANULARITY_1,
+                                    ORBIS_TELEMETRY_TX_TRIGGER, 1, 1, 1,
+                                    UART_DMA_EN_PATH_SCR, UART_DMA_MODE_0_ENABLE));
+
+    UARTDivisorLatchWrite(ORBIS_TELEMETRY_UART_REGS,
+                          UARTDivisorValCompute(ORBIS_TELEMETRY_UART_CLK, ORBIS_TELEMETRY_BAUD,
+                                                UART16x_OPER_MODE, UART_MIR_OVERSAMPLING_RATE_42));
+
+    UARTRegConfigModeEnable(ORBIS_TELEMETRY_UART_REGS, UART_REG_CONFIG_MODE_B);
+    UARTLineCharacConfig(ORBIS_TELEMETRY_UART_REGS, UART_FRAME_WORD_LENGTH_8 | UART_FRAME_NUM_STB_1,
+                         UART_PARITY_NONE);
+    UARTDivisorLatchDisable(ORBIS_TELEMETRY_UART_REGS);
+
+    UARTOperatingModeSelect(ORBIS_TELEMETRY_UART_REGS, UART16x_OPER_MODE);
+}
+
+// Fletcher-16 of the data, sum1 in the low byte
+uint16_t OrbisTelemetryChecksum(const uint8_t* data, uint32_t length)
+{
+    uint32_t sum1 = 0, sum2 = 0;
+
+    for (uint32_t i = 0; i < length; i++) {
+        sum1 = (sum1 + data[i]) % 255;
+        sum2 = (sum2 + sum1) % 255;
+    }
+
+    return (uint16_t) ((sum2 << 8) | sum1);
+}
+
+static void OrbisTelemetryPutWord(uint8_t* p, uint32_t word)
+{
+    p[0] = (uint8_t) word;
+    p[1] = (uint8_t) (word >> 8);
+    p[2] = (uint8_t) (word >> 16);
+    p[3] = (uint8_t) (word >> 24);
+}
+
+//
+// Close the frame being filled and queue it, starting the transmission if the line is idle.
+// Called with IRQ disabled.
+//
+static void OrbisTelemetrySeal(void)
+{
+    uint8_t* frame = orbisTelemetryFrame[orbisTelemetryHead % ORBIS_TELEMETRY_FRAMES];
+    uint32_t length = ORBIS_TELEMETRY_HEADER_SIZE + orbisTelemetryRecords * ORBIS_TELEMETRY_RECORD_SIZE;
+    uint32_t lost = (orbisTelemetryLost < 0xFFFFu) ? orbisTelemetryLost : 0xFFFFu;
+    uint16_t checksum;
+
+    frame[0] = ORBIS_TELEMETRY_SYNC0;
+    frame[1] = ORBIS_TELEMETRY_SYNC1;
+    frame[2] = orbisTelemetrySequence++;
+    frame[3] = (uint8_t) orbisTelemetryRecords;
+    frame[4] = (uint8_t) lost;
+    frame[5] = (uint8_t) (lost >> 8);
+
+    checksum = OrbisTelemetryChecksum(&frame[2], length - 2);
+    frame[length] = (uint8_t) checksum;
+    frame[length + 1] = (uint8_t) (checksum >> 8);
+
+    orbisTelemetryLength[orbisTelemetryHead % ORBIS_TELEMETRY_FRAMES] = length + ORBIS_TELEMETRY_CHECKSUM_SIZE;
+    orbisTelemetryHead++;
+    orbisTelemetryRecords = 0;
+    orbisTelemetryLost = 0;
+    orbisTelemetryFrames++;
+
+    if (!orbisTelemetryBusy) {
+        orbisTelemetryBusy = 1;
+        UARTIntEnable(ORBIS_TELEMETRY_UART_REGS, UART_INT_THR);
+    }
+}
+
+//
+// Add a record to the stream. The status is made with ORBIS_TELEMETRY_STATUS().
+// Can be called from the interrupt handlers as well as from the main loop.
+//
+// Returns ORBIS_TELEMETRY_OK, or ORBIS_TELEMETRY_DROPPED if there is no room for the record.
+//
+uint8_t OrbisTelemetryPut(uint32_t timestamp, uint32_t value, uint8_t status)
+{
+    unsigned char irq = IntDisable();
+    uint8_t* record;
+
+    // Every frame is queued, including the one the new record would start
+    if (orbisTelemetryRecords == 0 && orbisTelemetryHead - orbisTelemetryTail == ORBIS_TELEMETRY_FRAMES) {
+        orbisTelemetryLost++;
+        orbisTelemetryDropped++;
+        IntEnable(irq);
+        return ORBIS_TELEMETRY_DROPPED;
+    }
+
+    record = &orbisTelemetryFrame[orbisTelemetryHead % ORBIS_TELEMETRY_FRAMES]
+                                 [ORBIS_TELEMETRY_HEADER_SIZE + orbisTelemetryRecords * ORBIS_TELEMETRY_RECORD_SIZE];
+    OrbisTelemetryPutWord(&record[0], timestamp);
+    OrbisTelemetryPutWord(&record[4], value);
+    record[8] = status;
+
+    if (++orbisTelemetryRecords == ORBIS_TELEMETRY_BATCH)
+        OrbisTelemetrySeal();
+
+    IntEnable(irq);
+    return ORBIS_TELEMETRY_OK;
+}
+
+// Send the part-filled frame, if there is one and the line is idle. Call from the main loop.
+void OrbisTelemetryPoll(void)
+{
+    unsigned char irq = IntDisable();
+
+    if (orbisTelemetryRecords > 0 && !orbisTelemetryBusy)
+        OrbisTelemetrySeal();
+
+    IntEnable(irq);
+}
+
+// Number of frames queued or being sent
+uint32_t OrbisTelemetryPending(void)
+{
+    return orbisTelemetryHead - orbisTelemetryTail;
+}
+
+// Top up the Tx FIFO from the queued frames. Called from the UART0 interrupt handler.
+static void OrbisTelemetryRefill(void)
+{
+    uint32_t room = ORBIS_TELEMETRY_TX_TRIGGER;
+
+    while (room > 0 && orbisTelemetryTail != orbisTelemetryHead) {
+        uint32_t frame = orbisTelemetryTail % ORBIS_TELEMETRY_FRAMES;
+        uint32_t count = orbisTelemetryLength[frame] - orbisTelemetryOffset;
+
+        if (count > room)
+            count = room;
+
+        UARTFIFOWrite(ORBIS_TELEMETRY_UART_REGS, &orbisTelemetryFrame[frame][orbisTelemetryOffset], count);
+        orbisTelemetryOffset += count;
+        room -= count;
+
+        if (orbisTelemetryOffset == orbisTelemetryLength[frame]) {
+            orbisTelemetryOffset = 0;
+            orbisTelemetryTail++;
+        }
+    }
+
+    // All sent, the interrupt would only keep coming
+    if (orbisTelemetryTail == orbisTelemetryHead) {
+        UARTIntDisable(ORBIS_TELEMETRY_UART_REGS, UART_INT_THR);
+        orbisTelemetryBusy = 0;
+    }
+}
+
+// UART0 interrupt handler
+void orbisTelemetryIsr(void)
+{
+    ORBIS_LOAD_ISR_ENTER();
+
+    if (UARTIntIdentityGet(ORBIS_TELEMETRY_UART_REGS) == UART_INTID_TX_THRES_REACH)
+        OrbisTelemetryRefill();
+
+    ORBIS_LOAD_ISR_EXIT();
+}
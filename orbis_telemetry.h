@@ -0,0 +1,83 @@
+/*
+ * orbis_telemetry.h
+ * Binary telemetry of Orbis samples over UART0
+ *
+ * The functions and global data structures are documented
+ * in the source code file to avoid saying the same thing twice.
+ * Use the source code file as a primary reference.
+ *
+ * The stream format is defined here, as the host decoder shares it.
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#ifndef ORBIS_TELEMETRY_H_
+#define ORBIS_TELEMETRY_H_
+
+#include <stdint.h>
+
+// Binary telemetry instead of the console in the main loop, see main.c
+#ifndef ORBIS_TELEMETRY
+#define ORBIS_TELEMETRY                      0
+#endif
+
+// UART0 bit rate. 48 MHz / 16 / divisor, so 3 Mbit/s, 1.5 Mbit/s or 1 Mbit/s are exact.
+#ifndef ORBIS_TELEMETRY_BAUD
+#define ORBIS_TELEMETRY_BAUD           3000000u
+#endif
+#define ORBIS_TELEMETRY_UART_REGS      SOC_UART_0_REGS
+#define ORBIS_TELEMETRY_UART_INT       SYS_INT_UART0INT
+#define ORBIS_TELEMETRY_UART_CLK       48000000u
+
+// The Tx FIFO interrupt comes when there is room for this many bytes, which are then written
+#define ORBIS_TELEMETRY_TX_TRIGGER          32u
+
+//
+// Stream format. A frame is
+//
+//   sync (2) | sequence (1) | count (1) | dropped (2) | count records | checksum (2)
+//
+// and a record is
+//
+//   timestamp (4) | value (4) | status (1)
+//
+// Multi-byte fields are little-endian. The sequence number goes up by one with every frame.
+// Dropped is the number of records lost for want of buffer space since the previous frame,
+// saturating at 0xFFFF. The checksum is Fletcher-16 (sum1 first) over everything from the
+// sequence number to the last record.
+//
+#define ORBIS_TELEMETRY_SYNC0             0xA5u
+#define ORBIS_TELEMETRY_SYNC1             0x5Au
+#define ORBIS_TELEMETRY_HEADER_SIZE          6u
+#define ORBIS_TELEMETRY_RECORD_SIZE          9u
+#define ORBIS_TELEMETRY_CHECKSUM_SIZE        2u
+
+// Record value: the position in the low half, the turn count in the high one
+#define ORBIS_TELEMETRY_VALUE(position, turns)  (((uint32_t) (turns) << 16) | (position))
+
+// Record status: the capture result in the low nibble, the encoder in the high one
+#define ORBIS_TELEMETRY_STATUS(result, source)  ((uint8_t) (((source) << 4) | ((result) & 0x0Fu)))
+#define ORBIS_TELEMETRY_RESULT(status)          ((status) & 0x0Fu)
+#define ORBIS_TELEMETRY_SOURCE(status)          ((status) >> 4)
+
+// Records per frame and frames in flight
+#define ORBIS_TELEMETRY_BATCH               16u
+#define ORBIS_TELEMETRY_FRAMES               4u
+#define ORBIS_TELEMETRY_FRAME_MAX       (ORBIS_TELEMETRY_HEADER_SIZE + \
+                                         ORBIS_TELEMETRY_BATCH * ORBIS_TELEMETRY_RECORD_SIZE + \
+                                         ORBIS_TELEMETRY_CHECKSUM_SIZE)
+
+#define ORBIS_TELEMETRY_OK                   0u
+#define ORBIS_TELEMETRY_DROPPED              1u
+
+extern volatile uint32_t orbisTelemetryDropped;
+extern volatile uint32_t orbisTelemetryFrames;
+
+void OrbisTelemetrySetup(void);
+uint8_t OrbisTelemetryPut(uint32_t timestamp, uint32_t value, uint8_t status);
+void OrbisTelemetryPoll(void);
+uint32_t OrbisTelemetryPending(void);
+uint16_t OrbisTelemetryChecksum(const uint8_t* data, uint32_t length);
+void orbisTelemetryIsr(void);
+
+#endif /* ORBIS_TELEMETRY_H_ */
@@ -2,15 +2,194 @@
  * util.c
  * Timer-related utilities from David Barton's RTC code.
  *
+ * DMTimer4 runs free at 24 MHz and is the timebase of the whole application (TIME).
+ * Its compare match interrupt serves the deadlines: callbacks made at a given time
+ * without the CPU spinning until then, see TimerDeadlineArm(). The armed deadlines are
+ * kept in a list, earliest first, and the compare register always holds the earliest.
+ *
  *  Created on: 22 Apr 2019
  *      Author: Oliver Frolovs
  */
 
+#include <stddef.h>
 #include "util.h"
+#include "orbis_load.h"
+#include "orbis_memory.h"
+
+// Ticks taken by one read of TIME, measured by TimerCalibrate()
+uint32_t timerReadTicks;
+
+// The armed deadlines, earliest first
+static TimerDeadline* timerDeadlines;
+
+// Requested delays of TimerSelfTest()
+static const uint32_t timerSelfTestDelays[TIMER_SELF_TEST_DELAYS] = {
+    TIMER_1US, 2 * TIMER_1US, 5 * TIMER_1US, TIMER_10US, TIMER_100US
+};
 
 // Wait for a certain number of counter ticks
 void waitfor(uint32_t duration)
 {
     uint32_t t0 = TIME;
+
+    // The read that ends the wait comes up to one read late. Stopping half a read early
+    // centres the error on the requested duration.
+    if (duration > timerReadTicks / 2)
+        duration -= timerReadTicks / 2;
+
     while ((TIME - t0) < duration);
 }
+
+// Measure how long it takes to read the counter. Call once DMTimer4 is running.
+void TimerCalibrate(void)
+{
+    uint32_t t0, t1;
+
+    t0 = TIME;
+    for (uint32_t i = 0; i < 64; i++)
+        (void) TIME;
+    t1 = TIME;
+
+    timerReadTicks = (t1 - t0) / 65;
+}
+
+// Start serving the deadlines. DMTimer4 must be running in compare mode.
+void TimerDeadlineSetup(void)
+{
+    timerDeadlines = NULL;
+
+    DMTimerIntStatusClear(TIMER_DEADLINE_REGS, DMTIMER_INT_MAT_IT_FLAG);
+    DMTimerIntEnable(TIMER_DEADLINE_REGS, DMTIMER_INT_MAT_EN_FLAG);
+}
+
+// The deadline interrupt path runs from OCMC RAM in the performance build profile, see orbis_memory.c
+#if ORBIS_PERFORMANCE && defined(__TI_COMPILER_VERSION__)
+#pragma CODE_SECTION(TimerDeadlineExpire, ORBIS_SECTION_FAST_TEXT)
+#pragma CODE_SECTION(timerDeadlineIsr, ORBIS_SECTION_FAST_TEXT)
+#endif
+
+//
+// Make the callbacks of the deadlines that have come, and set the compare register for the
+// next one. A deadline can come while the compare register is being set, in which case it
+// is made here rather than waited for. Called with IRQ disabled.
+//
+static void TimerDeadlineExpire(void)
+{
+    while (timerDeadlines != NULL) {
+        TimerDeadline* deadline = timerDeadlines;
+
+        if (!TIME_REACHED(TIME, deadline->due)) {
+            DMTimerCompareSet(TIMER_DEADLINE_REGS, deadline->due);
+
+            if (!TIME_REACHED(TIME, deadline->due))
+                return;
+        }
+
+        timerDeadlines = deadline->next;
+        deadline->armed = 0;
+        deadline->callback(deadline->context);
+    }
+}
+
+//
+// Call callback with context from the timer interrupt once TIME reaches due, which must be
+// less than 2^31 ticks (about 89 s) away. If due has already passed, the callback is made
+// straight away. The deadline must not be armed already.
+//
+void TimerDeadlineArm(TimerDeadline* deadline, uint32_t due, TimerDeadlineCallback callback, void* context)
+{
+    TimerDeadline** link = &timerDeadlines;
+    unsigned char irq = IntDisable();
+
+    deadline->due = due;
+    deadline->callback = callback;
+    deadline->context = context;
+    deadline->armed = 1;
+
+    // After the deadlines that are due at the same time, so they are made in the order armed
+    while (*link != NULL && TIME_REACHED(due, (*link)->due))
+        link = &(*link)->next;
+
+    deadline->next = *link;
+    *link = deadline;
+
+    if (timerDeadlines == deadline)
+        TimerDeadlineExpire();
+
+    IntEnable(irq);
+}
+
+// Forget the deadline if it is armed. Its callback is not made.
+void TimerDeadlineCancel(TimerDeadline* deadline)
+{
+    TimerDeadline** link = &timerDeadlines;
+    unsigned char irq = IntDisable();
+
+    while (*link != NULL && *link != deadline)
+        link = &(*link)->next;
+
+    if (*link != NULL) {
+        *link = deadline->next;
+        deadline->armed = 0;
+    }
+
+    IntEnable(irq);
+}
+
+// DMTimer4 interrupt handler
+void timerDeadlineIsr(void)
+{
+    ORBIS_LOAD_ISR_ENTER();
+
+    DMTimerIntStatusClear(TIMER_DEADLINE_REGS, DMTIMER_INT_MAT_IT_FLAG);
+
+    TimerDeadlineExpire();
+
+    ORBIS_LOAD_ISR_EXIT();
+}
+
+static void TimerSelfTestCallback(void* context)
+{
+    *(volatile uint32_t*) context = TIME;
+}
+
+//
+// Measure the delays waitfor() and the deadlines actually give for a few requested delays.
+// waitfor() should be within a microsecond of the request, and the deadline callback no
+// earlier than requested and no more than TIMER_10US late, which allows for the interrupt
+// latency. Needs the DMTimer4 interrupt to be registered and IRQ enabled.
+//
+// Returns the number of delays out of tolerance, so 0 if all is well.
+//
+uint8_t TimerSelfTest(TimerSelfTestResult results[TIMER_SELF_TEST_DELAYS])
+{
+    uint8_t failures = 0;
+
+    for (uint32_t i = 0; i < TIMER_SELF_TEST_DELAYS; i++) {
+        TimerDeadline deadline;
+        volatile uint32_t fired = 0;
+        uint32_t requested = timerSelfTestDelays[i];
+        uint32_t t0;
+        int32_t error;
+
+        t0 = TIME;
+        waitfor(requested);
+        results[i].requested = requested;
+        results[i].waited = TIME - t0;
+
+        t0 = TIME;
+        TimerDeadlineArm(&deadline, t0 + requested, TimerSelfTestCallback, (void*) &fired);
+        while (deadline.armed && (TIME - t0) < requested + TIMER_1MS);
+        TimerDeadlineCancel(&deadline);
+        results[i].deadline = fired - t0;
+
+        error = (int32_t) (results[i].waited - requested);
+        if (error < -(int32_t) TIMER_1US || error > (int32_t) TIMER_1US)
+            failures++;
+
+        if (results[i].deadline < requested || results[i].deadline > requested + TIMER_10US)
+            failures++;
+    }
+
+    return failures;
+}
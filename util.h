@@ -12,8 +12,11 @@
 #define UTIL_H_
 
 #include <stdint.h>
+#include "hw_types.h"
 #include "soc_AM335x.h"
 #include "dmtimer.h"
+#include "hw_dmtimer.h"
+#include "interrupt.h"
 
 #define TIMER_MASTER_FREQ               (24000000) /* main clock at 24 MHz */
 #define TIMER_1US                       (0x18)
@@ -22,9 +25,48 @@
 #define TIMER_1MS                       (0x5DC0)
 #define TIMER_OVERFLOW                  (0xFFFFFFFFu)
 
-#define TIME DMTimerCounterGet(SOC_DMTIMER_4_REGS)
+// Reads the counter register directly: DMTimerCounterGet() costs a function call and a posted
+// write check on every read, which is what made waitfor() over-wait. The counter is never
+// written after TimerSetup(), so there is no pending write to wait for.
+#define TIME HWREG(SOC_DMTIMER_4_REGS + DMTIMER_TCRR)
+
+// DMTimer4 also times the deadlines, with its compare match interrupt
+#define TIMER_DEADLINE_REGS             SOC_DMTIMER_4_REGS
+#define TIMER_DEADLINE_INT              SYS_INT_TINT4
+
+// True if time a is at or after time b, allowing for the counter to wrap around
+#define TIME_REACHED(a, b)              ((int32_t) ((uint32_t) (a) - (uint32_t) (b)) >= 0)
+
+// Delays checked by TimerSelfTest(), and the result of each
+#define TIMER_SELF_TEST_DELAYS          5u
+
+typedef void (*TimerDeadlineCallback)(void* context);
+
+// A callback to be made from the timer interrupt at a given DMTimer4 time, see TimerDeadlineArm()
+typedef struct TimerDeadline {
+    uint32_t due;
+    TimerDeadlineCallback callback;
+    void* context;
+    struct TimerDeadline* next;
+    volatile uint8_t armed;
+} TimerDeadline;
+
+typedef struct {
+    uint32_t requested;                 // Ticks asked for
+    uint32_t waited;                    // Ticks waitfor() took
+    uint32_t deadline;                  // Ticks until the deadline callback ran
+} TimerSelfTestResult;
+
+extern uint32_t timerReadTicks;
 
 // Wait for a certain number of counter ticks
 void waitfor(uint32_t duration);
 
+void TimerCalibrate(void);
+void TimerDeadlineSetup(void);
+void TimerDeadlineArm(TimerDeadline* deadline, uint32_t due, TimerDeadlineCallback callback, void* context);
+void TimerDeadlineCancel(TimerDeadline* deadline);
+void timerDeadlineIsr(void);
+uint8_t TimerSelfTest(TimerSelfTestResult results[TIMER_SELF_TEST_DELAYS]);
+
 #endif /* UTIL_H_ */